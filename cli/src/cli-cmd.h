@@ -66,6 +66,9 @@ typedef struct cli_profile_info_ {
     double avg_latency;
     char *fop_name;
     double percentage_avg_latency;
+    double p50_latency;
+    double p99_latency;
+    double p999_latency;
 } cli_profile_info_t;
 
 typedef struct cli_cmd_volume_get_ctx_ cli_cmd_volume_get_ctx_t;
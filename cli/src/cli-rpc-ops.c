@@ -1512,6 +1512,8 @@ gf_cli_print_rebalance_status(dict_t *dict, enum gf_task_types task_type)
     time_t max_time = 0;
     time_t max_elapsed = 0;
     time_t time_left = 0;
+    uint64_t throughput = 0;
+    uint64_t total_throughput = 0;
     gf_boolean_t show_estimates = _gf_false;
 
     ret = dict_get_int32_sizen(dict, "count", &count);
@@ -1570,6 +1572,7 @@ gf_cli_print_rebalance_status(dict_t *dict, enum gf_task_types task_type)
         status_str = NULL;
         elapsed = 0;
         time_left = 0;
+        throughput = 0;
 
         /* Check if status is NOT_STARTED, and continue early */
         keylen = snprintf(key, sizeof(key), "status-%d", i);
@@ -1640,6 +1643,11 @@ gf_cli_print_rebalance_status(dict_t *dict, enum gf_task_types task_type)
         if (ret)
             gf_log("cli", GF_LOG_TRACE, "failed to get time left");
 
+        /* Not sent by older nodes */
+        snprintf(key, sizeof(key), "throughput-%d", i);
+        if (dict_get_uint64(dict, key, &throughput) == 0)
+            total_throughput += throughput;
+
         if (elapsed > max_elapsed)
             max_elapsed = elapsed;
 
@@ -1680,6 +1688,17 @@ gf_cli_print_rebalance_status(dict_t *dict, enum gf_task_types task_type)
         GF_FREE(size_str);
     }
 
+    if (!fix_layout && total_throughput) {
+        size_str = gf_uint64_2human_readable(total_throughput);
+        if (size_str) {
+            cli_out("Rebalance throughput : %s/sec", size_str);
+            GF_FREE(size_str);
+        } else {
+            cli_out("Rebalance throughput : %" PRIu64 " bytes/sec",
+                    total_throughput);
+        }
+    }
+
     /* Max time will be non-zero if rebalance is still running */
     if (max_time) {
         hrs = max_time / 3600;
@@ -5489,6 +5508,7 @@ cmd_profile_volume_brick_out(dict_t *dict, int count, int interval)
     char write_blocks[128] = {0};
     int index = 0;
     int is_header_printed = 0;
+    int has_percentiles = 0;
     int ret = 0;
     double total_percentage_latency = 0;
 
@@ -5543,6 +5563,24 @@ cmd_profile_volume_brick_out(dict_t *dict, int count, int interval)
         if (ret) {
             gf_log("cli", GF_LOG_DEBUG, "failed to get %s from dict", key);
         }
+
+        /* Bricks running older versions don't send the percentiles. */
+        snprintf(key, sizeof(key), "%d-%d-%d-p50latency", count, interval, i);
+        if (dict_get_double(dict, key, &profile_info[i].p50_latency) == 0) {
+            has_percentiles = 1;
+        }
+
+        snprintf(key, sizeof(key), "%d-%d-%d-p99latency", count, interval, i);
+        ret = dict_get_double(dict, key, &profile_info[i].p99_latency);
+        if (ret) {
+            gf_log("cli", GF_LOG_DEBUG, "failed to get %s from dict", key);
+        }
+
+        snprintf(key, sizeof(key), "%d-%d-%d-p999latency", count, interval, i);
+        ret = dict_get_double(dict, key, &profile_info[i].p999_latency);
+        if (ret) {
+            gf_log("cli", GF_LOG_DEBUG, "failed to get %s from dict", key);
+        }
         profile_info[i].fop_name = (char *)gf_fop_list[i];
 
         total_percentage_latency += (profile_info[i].fop_hits *
@@ -5651,7 +5689,7 @@ cmd_profile_volume_brick_out(dict_t *dict, int count, int interval)
             continue;
         if (upcall_info[i].fop_hits) {
             cli_out(
-                "%10.2lf %10.2lf us %10.2lf us %10.2lf us"
+                "%10.2lf %10.2lf ns %10.2lf ns %10.2lf ns"
                 " %14" PRId64 " %11s",
                 upcall_info[i].percentage_avg_latency,
                 upcall_info[i].avg_latency, upcall_info[i].min_latency,
@@ -5660,6 +5698,21 @@ cmd_profile_volume_brick_out(dict_t *dict, int count, int interval)
         }
     }
 
+    if (has_percentiles) {
+        cli_out(" ");
+        cli_out("%13s %13s %13s %11s", "P50-Latency", "P99-Latency",
+                "P99.9-Latency", "Fop");
+        cli_out("%13s %13s %13s %11s", "-----------", "-----------",
+                "-------------", "----");
+        for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+            if (profile_info[i].fop_hits == 0)
+                continue;
+            cli_out("%10.2lf ns %10.2lf ns %10.2lf ns %11s",
+                    profile_info[i].p50_latency, profile_info[i].p99_latency,
+                    profile_info[i].p999_latency, profile_info[i].fop_name);
+        }
+    }
+
     cli_out(" ");
     cli_out("%12s: %" PRId64 " seconds", "Duration", sec);
     cli_out("%12s: %" PRId64 " bytes", "Data Read", r_count);
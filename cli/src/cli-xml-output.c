@@ -1927,11 +1927,16 @@ cli_xml_output_vol_profile_stats(xmlTextWriterPtr writer, dict_t *dict,
     double avg_latency = 0.0;
     double max_latency = 0.0;
     double min_latency = 0.0;
+    double pct_latency = 0.0;
+    static const char *pct_keys[] = {"p50", "p99", "p999"};
+    static const char *pct_elements[] = {"p50Latency", "p99Latency",
+                                         "p999Latency"};
     uint64_t duration = 0;
     uint64_t total_read = 0;
     uint64_t total_write = 0;
     char key[1024] = {0};
     int i = 0;
+    int j = 0;
 
     /* <cumulativeStats> || <intervalStats> */
     if (interval == -1)
@@ -2032,6 +2037,18 @@ cli_xml_output_vol_profile_stats(xmlTextWriterPtr writer, dict_t *dict,
                                               "%f", max_latency);
         XML_RET_CHECK_AND_GOTO(ret, out);
 
+        /* Percentiles are only sent by bricks running newer versions. */
+        for (j = 0; j < 3; j++) {
+            snprintf(key, sizeof(key), "%d-%d-%d-%slatency", brick_index,
+                     interval, i, pct_keys[j]);
+            if (dict_get_double(dict, key, &pct_latency) != 0)
+                continue;
+
+            ret = xmlTextWriterWriteFormatElement(
+                writer, (xmlChar *)pct_elements[j], "%f", pct_latency);
+            XML_RET_CHECK_AND_GOTO(ret, out);
+        }
+
         /* </fop> */
         ret = xmlTextWriterEndElement(writer);
         XML_RET_CHECK_AND_GOTO(ret, out);
@@ -2932,6 +2949,8 @@ cli_xml_output_vol_rebalance_status(xmlTextWriterPtr writer, dict_t *dict,
     uint64_t total_lookups = 0;
     uint64_t total_failures = 0;
     uint64_t total_skipped = 0;
+    uint64_t throughput = 0;
+    uint64_t total_throughput = 0;
     char key[1024] = {
         0,
     };
@@ -3062,6 +3081,15 @@ cli_xml_output_vol_rebalance_status(xmlTextWriterPtr writer, dict_t *dict,
             overall_elapsed = elapsed;
         }
 
+        /* Not sent by older nodes */
+        snprintf(key, sizeof(key), "throughput-%d", i);
+        if (dict_get_uint64(dict, key, &throughput) == 0) {
+            total_throughput += throughput;
+            ret = xmlTextWriterWriteFormatElement(
+                writer, (xmlChar *)"throughput", "%" PRIu64, throughput);
+            XML_RET_CHECK_AND_GOTO(ret, out);
+        }
+
         /* Rebalance has 5 states,
          * NOT_STARTED, STARTED, STOPPED, COMPLETE, FAILED
          * The precedence used to determine the aggregate status is as
@@ -3132,6 +3160,10 @@ cli_xml_output_vol_rebalance_status(xmlTextWriterPtr writer, dict_t *dict,
                                           overall_elapsed);
     XML_RET_CHECK_AND_GOTO(ret, out);
 
+    ret = xmlTextWriterWriteFormatElement(writer, (xmlChar *)"throughput",
+                                          "%" PRIu64, total_throughput);
+    XML_RET_CHECK_AND_GOTO(ret, out);
+
     /* </aggregate> */
     ret = xmlTextWriterEndElement(writer);
     XML_RET_CHECK_AND_GOTO(ret, out);
@@ -0,0 +1,243 @@
+/*
+   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* Microbenchmark of dict_t. It only uses the public API of libglusterfs, so
+ * building it against two versions of the library compares their dict_t
+ * implementations. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <argp.h>
+
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/globals.h>
+#include <glusterfs/dict.h>
+#include <glusterfs/mem-pool.h>
+
+struct state {
+    long count;
+    int keys;
+    char **names;
+};
+
+/* Keys similar to the ones that are found in the xdata of a fop. */
+static char *xdata_keys[] = {GF_CONTENT_KEY,
+                             GLUSTERFS_INODELK_COUNT,
+                             GLUSTERFS_ENTRYLK_COUNT,
+                             GLUSTERFS_OPEN_FD_COUNT,
+                             GF_AFR_DIRTY,
+                             "trusted.afr.patchy-client-0",
+                             "trusted.afr.patchy-client-1",
+                             "trusted.ec.version",
+                             "trusted.ec.size",
+                             "gfid-req",
+                             NULL};
+
+static double
+elapsed(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) +
+           (now.tv_nsec - start->tv_nsec) / 1000000000.0;
+}
+
+static void
+report(char *name, long ops, double secs)
+{
+    fprintf(stdout, "%-12s: ops=%ld, time=%.3fs, %.1f ns/op\n", name, ops,
+            secs, secs * 1000000000.0 / ops);
+}
+
+static dict_t *
+fill(struct state *state)
+{
+    dict_t *dict;
+    int i;
+
+    dict = dict_new();
+    if (dict == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < state->keys; i++) {
+        if (dict_set_int64(dict, state->names[i], i) != 0) {
+            dict_unref(dict);
+            return NULL;
+        }
+    }
+
+    return dict;
+}
+
+static int
+run(struct state *state)
+{
+    struct timespec start;
+    dict_t *dict, *copy;
+    char *buf;
+    u_int len;
+    int64_t value;
+    long n;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (n = 0; n < state->count; n++) {
+        dict = fill(state);
+        if (dict == NULL) {
+            return -1;
+        }
+        dict_unref(dict);
+    }
+    report("set", state->count * state->keys, elapsed(&start));
+
+    dict = fill(state);
+    if (dict == NULL) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (n = 0; n < state->count; n++) {
+        for (i = 0; i < state->keys; i++) {
+            if (dict_get_int64(dict, state->names[i], &value) != 0) {
+                return -1;
+            }
+        }
+    }
+    report("get", state->count * state->keys, elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (n = 0; n < state->count; n++) {
+        if (dict_allocate_and_serialize(dict, &buf, &len) != 0) {
+            return -1;
+        }
+        GF_FREE(buf);
+    }
+    report("serialize", state->count, elapsed(&start));
+
+    if (dict_allocate_and_serialize(dict, &buf, &len) != 0) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (n = 0; n < state->count; n++) {
+        copy = dict_new();
+        if ((copy == NULL) || (dict_unserialize(buf, len, &copy) != 0)) {
+            return -1;
+        }
+        dict_unref(copy);
+    }
+    report("unserialize", state->count, elapsed(&start));
+
+    GF_FREE(buf);
+    dict_unref(dict);
+
+    return 0;
+}
+
+static int
+init(struct state *state)
+{
+    glusterfs_ctx_t *ctx;
+    int i, n;
+
+    mem_pools_init();
+
+    ctx = glusterfs_ctx_new();
+    if (ctx == NULL) {
+        return -1;
+    }
+    if (glusterfs_globals_init(ctx) != 0) {
+        return -1;
+    }
+    THIS->ctx = ctx;
+
+    ctx->dict_pool = mem_pool_new(dict_t, 32);
+    ctx->dict_pair_pool = mem_pool_new(data_pair_t, 512);
+    ctx->dict_data_pool = mem_pool_new(data_t, 512);
+    if (!ctx->dict_pool || !ctx->dict_pair_pool || !ctx->dict_data_pool) {
+        return -1;
+    }
+
+    state->names = calloc(state->keys, sizeof(char *));
+    if (state->names == NULL) {
+        return -1;
+    }
+    for (i = 0, n = 0; i < state->keys; i++) {
+        if (xdata_keys[n] != NULL) {
+            state->names[i] = xdata_keys[n++];
+        } else if (asprintf(&state->names[i], "trusted.glusterfs.key-%d", i) <
+                   0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static error_t
+parse_opts(int key, char *arg, struct argp_state *_state)
+{
+    struct state *state = _state->input;
+
+    switch (key) {
+        case 'k':
+            state->keys = atoi(arg);
+            if (state->keys <= 0) {
+                fprintf(stderr, "incorrect number of keys: %s\n", arg);
+                return -1;
+            }
+            break;
+        case 'c':
+            state->count = atol(arg);
+            if (state->count <= 0) {
+                fprintf(stderr, "incorrect count: %s\n", arg);
+                return -1;
+            }
+            break;
+        case ARGP_KEY_NO_ARGS:
+            break;
+        case ARGP_KEY_ARG:
+            break;
+    }
+
+    return 0;
+}
+
+static struct argp_option options[] = {
+    {"keys", 'k', "KEYS", 0, "number of keys per dictionary - defaults to 4"},
+    {"count", 'c', "COUNT", 0,
+     "number of iterations of each test - defaults to 1000000"},
+    {0, 0, 0, 0, 0}};
+
+static struct argp argp = {options, parse_opts, "",
+                           "dict-bm - microbenchmark of dict_t"};
+
+int
+main(int argc, char *argv[])
+{
+    struct state state = {.count = 1000000, .keys = 4};
+
+    if (argp_parse(&argp, argc, argv, 0, 0, &state) != 0) {
+        return 1;
+    }
+
+    if (init(&state) != 0) {
+        fprintf(stderr, "initialization failed\n");
+        return 1;
+    }
+
+    fprintf(stdout, "keys=%d, count=%ld\n", state.keys, state.count);
+
+    return (run(&state) == 0) ? 0 : 1;
+}
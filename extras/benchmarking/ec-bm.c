@@ -0,0 +1,265 @@
+/*
+   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* Microbenchmark of the encode and decode functions of the disperse xlator.
+ * It's built together with the sources of the galois field code of ec (see
+ * README) and measures each of the code generators that the CPU supports. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <argp.h>
+
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/globals.h>
+#include <glusterfs/mem-pool.h>
+
+#include "ec-method.h"
+
+struct state {
+    long count;
+    uint32_t fragments;
+    uint32_t redundancy;
+    uint32_t stripes;
+    char *gen;
+};
+
+/* Same names that the "cpu-extensions" option accepts. */
+static char *generators[] = {"none", "x64", "sse", "avx", "avx512", NULL};
+
+static double
+elapsed(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) +
+           (now.tv_nsec - start->tv_nsec) / 1000000000.0;
+}
+
+static void
+report(char *gen, char *name, long bytes, double secs)
+{
+    fprintf(stdout, "%-8s %-8s: bytes=%ld, time=%.3fs, %.2f GB/s\n", gen,
+            name, bytes, secs, bytes / secs / 1000000000.0);
+}
+
+static int
+run(struct state *state, char *gen)
+{
+    struct timespec start;
+    ec_matrix_list_t list;
+    uint32_t nodes = state->fragments + state->redundancy;
+    uint32_t rows[state->fragments];
+    void *fragments[nodes];
+    void *in[state->fragments];
+    void *out[nodes];
+    uint64_t size, fsize, pos;
+    uintptr_t mask;
+    char *data, *ptr;
+    char *used;
+    uint32_t i;
+    long n;
+    int ret = -1;
+
+    memset(&list, 0, sizeof(list));
+    if (ec_method_init(THIS, &list, state->fragments, nodes, nodes * 2, gen) !=
+        0) {
+        fprintf(stderr, "%s: initialization failed\n", gen);
+        return -1;
+    }
+
+    /* ec_code_detect() picks the next best generator when the requested one
+     * is not supported, and the dynamic code is disabled if it fails. */
+    used = (list.code->gen != NULL) ? list.code->gen->name : "none";
+    if (strcmp(used, gen) != 0) {
+        fprintf(stdout, "%-8s: not available\n", gen);
+        ec_method_fini(&list);
+        return 0;
+    }
+
+    size = (uint64_t)EC_METHOD_CHUNK_SIZE * state->fragments * state->stripes;
+    fsize = size / state->fragments;
+
+    if (posix_memalign((void **)&data, EC_METHOD_WORD_SIZE,
+                       size * 2 + fsize * nodes) != 0) {
+        fprintf(stderr, "%s: unable to allocate buffers\n", gen);
+        goto out;
+    }
+    for (pos = 0; pos < size; pos++) {
+        data[pos] = random();
+    }
+    ptr = data + size * 2;
+    for (i = 0; i < nodes; i++) {
+        fragments[i] = ptr;
+        ptr += fsize;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (n = 0; n < state->count; n++) {
+        memcpy(out, fragments, sizeof(out));
+        ec_method_encode(&list, size, data, out);
+    }
+    report(gen, "encode", size * state->count, elapsed(&start));
+
+    /* Decode using the last fragments so that the redundancy is actually
+     * needed to rebuild the data. */
+    mask = 0;
+    for (i = 0; i < state->fragments; i++) {
+        rows[i] = state->redundancy + i + 1;
+        in[i] = fragments[state->redundancy + i];
+        mask |= 1ULL << (state->redundancy + i);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (n = 0; n < state->count; n++) {
+        if (ec_method_decode(&list, fsize, mask, rows, in, data + size) != 0) {
+            fprintf(stderr, "%s: decode failed\n", gen);
+            goto out_free;
+        }
+    }
+    report(gen, "decode", size * state->count, elapsed(&start));
+
+    if (memcmp(data, data + size, size) != 0) {
+        fprintf(stderr, "%s: decoded data doesn't match\n", gen);
+        goto out_free;
+    }
+
+    ret = 0;
+
+out_free:
+    free(data);
+out:
+    ec_method_fini(&list);
+
+    return ret;
+}
+
+static int
+init(void)
+{
+    glusterfs_ctx_t *ctx;
+
+    mem_pools_init();
+
+    ctx = glusterfs_ctx_new();
+    if (ctx == NULL) {
+        return -1;
+    }
+    if (glusterfs_globals_init(ctx) != 0) {
+        return -1;
+    }
+    THIS->ctx = ctx;
+
+    return 0;
+}
+
+static error_t
+parse_opts(int key, char *arg, struct argp_state *_state)
+{
+    struct state *state = _state->input;
+
+    switch (key) {
+        case 'f':
+            state->fragments = atoi(arg);
+            if ((state->fragments < 1) ||
+                (state->fragments > EC_METHOD_MAX_FRAGMENTS)) {
+                fprintf(stderr, "incorrect number of fragments: %s\n", arg);
+                return -1;
+            }
+            break;
+        case 'r':
+            state->redundancy = atoi(arg);
+            if (state->redundancy < 1) {
+                fprintf(stderr, "incorrect redundancy: %s\n", arg);
+                return -1;
+            }
+            break;
+        case 's':
+            state->stripes = atoi(arg);
+            if (state->stripes < 1) {
+                fprintf(stderr, "incorrect number of stripes: %s\n", arg);
+                return -1;
+            }
+            break;
+        case 'c':
+            state->count = atol(arg);
+            if (state->count <= 0) {
+                fprintf(stderr, "incorrect count: %s\n", arg);
+                return -1;
+            }
+            break;
+        case 'g':
+            state->gen = arg;
+            break;
+        case ARGP_KEY_NO_ARGS:
+            break;
+        case ARGP_KEY_ARG:
+            break;
+    }
+
+    return 0;
+}
+
+static struct argp_option options[] = {
+    {"fragments", 'f', "FRAGMENTS", 0,
+     "number of data fragments - defaults to 4"},
+    {"redundancy", 'r', "REDUNDANCY", 0,
+     "number of redundancy fragments - defaults to 2"},
+    {"stripes", 's', "STRIPES", 0,
+     "number of stripes encoded or decoded on each call - defaults to 64"},
+    {"count", 'c', "COUNT", 0,
+     "number of iterations of each test - defaults to 10000"},
+    {"generator", 'g', "GENERATOR", 0,
+     "only test the given code generator - defaults to all"},
+    {0, 0, 0, 0, 0}};
+
+static struct argp argp = {options, parse_opts, "",
+                           "ec-bm - microbenchmark of the ec code generators"};
+
+int
+main(int argc, char *argv[])
+{
+    struct state state = {
+        .count = 10000, .fragments = 4, .redundancy = 2, .stripes = 64};
+    char **gen;
+    int ret = 0;
+
+    if (argp_parse(&argp, argc, argv, 0, 0, &state) != 0) {
+        return 1;
+    }
+
+    if (state.fragments + state.redundancy > EC_METHOD_MAX_NODES) {
+        fprintf(stderr, "too many fragments\n");
+        return 1;
+    }
+
+    if (init() != 0) {
+        fprintf(stderr, "initialization failed\n");
+        return 1;
+    }
+
+    fprintf(stdout, "fragments=%u, redundancy=%u, size=%u, count=%ld\n",
+            state.fragments, state.redundancy,
+            EC_METHOD_CHUNK_SIZE * state.fragments * state.stripes,
+            state.count);
+
+    for (gen = generators; *gen != NULL; gen++) {
+        if ((state.gen == NULL) || (strcmp(state.gen, *gen) == 0)) {
+            if (run(&state, *gen) != 0) {
+                ret = 1;
+            }
+        }
+    }
+
+    return ret;
+}
@@ -13,6 +13,11 @@
 #include <zlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
+#include "glusterfs/checksum.h"
 
 /*
  * The "weak" checksum required for the rsync algorithm.
@@ -42,3 +47,32 @@ gf_rsync_md5_checksum(unsigned char *data, size_t len, unsigned char *md5)
 {
     MD5(data, len, md5);
 }
+
+/*
+ * Fast alternative to the strong checksums, used when both ends of the
+ * rchecksum negotiate it. It's not XXH3-128: the 128 bits digest is made of
+ * two XXH64 hashes of the data with different seeds, hence its name. XXH64
+ * is available in every version of xxhash, including the one in contrib, so
+ * all bricks compute it and return the same digest for the same data
+ * whatever library they are built with.
+ */
+#define GF_XXH64X2_SEED_LOW 0
+#define GF_XXH64X2_SEED_HIGH 0x9e3779b97f4a7c15ULL
+
+int
+gf_rsync_xxh64x2_checksum(unsigned char *data, size_t len,
+                          unsigned char *xxh)
+{
+    XXH64_canonical_t canonical;
+
+    XXH64_canonicalFromHash(&canonical,
+                            XXH64(data, len, GF_XXH64X2_SEED_HIGH));
+    memcpy(xxh, canonical.digest, sizeof(canonical.digest));
+
+    XXH64_canonicalFromHash(&canonical,
+                            XXH64(data, len, GF_XXH64X2_SEED_LOW));
+    memcpy(xxh + sizeof(canonical.digest), canonical.digest,
+           sizeof(canonical.digest));
+
+    return 0;
+}
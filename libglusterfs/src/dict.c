@@ -15,18 +15,11 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <fnmatch.h>
-
-/* dict_t is always initialized with hash_size = 1
- * with this usage it's implemented as a doubly-linked list
- * and the hash calculation done per operation is not necessary.
- * using this macro to delimit blocks related to hash imp */
-#define DICT_LIST_IMP 1
+#include <stdarg.h>
 
 #include "glusterfs/dict.h"
-#if !DICT_LIST_IMP
 #define XXH_INLINE_ALL
 #include "xxhash.h"
-#endif
 #include "glusterfs/compat.h"
 #include "glusterfs/compat-errno.h"
 #include "glusterfs/statedump.h"
@@ -54,6 +47,155 @@ struct dict_cmp {
         }                                                                      \
     } while (0)
 
+/* Keys that are used very frequently are not copied into the pairs. Lookups
+ * of these keys also benefit from comparing the pointers before comparing the
+ * contents. */
+static const char *dict_interned_keys[] = {GF_CONTENT_KEY,
+                                           GFID_XATTR_KEY,
+                                           "gfid-req",
+                                           GLUSTERFS_INTERNAL_FOP_KEY,
+                                           GLUSTERFS_WRITE_IS_APPEND,
+                                           GLUSTERFS_WRITE_UPDATE_ATOMIC,
+                                           GLUSTERFS_OPEN_FD_COUNT,
+                                           GLUSTERFS_INODELK_COUNT,
+                                           GLUSTERFS_ENTRYLK_COUNT,
+                                           GLUSTERFS_POSIXLK_COUNT,
+                                           GLUSTERFS_PARENT_ENTRYLK,
+                                           GLUSTERFS_INODELK_DOM_COUNT,
+                                           GF_XATTR_LINKINFO_KEY,
+                                           GF_XATTR_MDATA_KEY,
+                                           GF_XATTR_SHARD_FILE_SIZE,
+                                           GF_AFR_DIRTY,
+                                           GF_PRESTAT,
+                                           GF_POSTSTAT,
+                                           GF_REQUEST_LINK_COUNT_XDATA,
+                                           GF_RESPONSE_LINK_COUNT_XDATA,
+                                           DHT_IATT_IN_XDATA_KEY,
+                                           DHT_MODE_IN_XDATA_KEY,
+                                           QUOTA_SIZE_KEY,
+                                           GF_SELINUX_XATTR_KEY,
+                                           "trusted.glusterfs.dht",
+                                           "trusted.glusterfs.dht.linkto",
+                                           "trusted.ec.version",
+                                           "trusted.ec.size",
+                                           "trusted.ec.config",
+                                           "trusted.ec.dirty",
+                                           NULL};
+
+/* Table of the interned keys, indexed by length, so that checking a key
+ * doesn't need to hash it. */
+#define DICT_INTERNED_MAX_LEN 64
+#define DICT_INTERNED_PER_LEN 4
+
+static const char *dict_interned[DICT_INTERNED_MAX_LEN][DICT_INTERNED_PER_LEN];
+
+static pthread_once_t dict_interned_once = PTHREAD_ONCE_INIT;
+
+/* Keys are only hashed when the dictionary has an index. Most dictionaries
+ * never get one, so setting a key usually doesn't compute any hash. */
+static inline uint32_t
+dict_key_hash(const char *key, uint32_t len)
+{
+    return (uint32_t)XXH64(key, len, 0);
+}
+
+static void
+dict_interned_init(void)
+{
+    uint32_t len;
+    int32_t i, j;
+
+    for (i = 0; dict_interned_keys[i] != NULL; i++) {
+        len = strlen(dict_interned_keys[i]);
+        if (len >= DICT_INTERNED_MAX_LEN)
+            continue;
+        /* If there are too many keys of the same length, the last ones are
+         * simply not interned. */
+        for (j = 0; j < DICT_INTERNED_PER_LEN; j++) {
+            if (dict_interned[len][j] == NULL) {
+                dict_interned[len][j] = dict_interned_keys[i];
+                break;
+            }
+        }
+    }
+}
+
+static const char *
+dict_key_interned(const char *key, uint32_t keylen)
+{
+    const char *interned;
+    int32_t i;
+
+    if (keylen >= DICT_INTERNED_MAX_LEN)
+        return NULL;
+
+    (void)pthread_once(&dict_interned_once, dict_interned_init);
+
+    for (i = 0; i < DICT_INTERNED_PER_LEN; i++) {
+        interned = dict_interned[keylen][i];
+        if (interned == NULL)
+            break;
+        if (memcmp(interned, key, keylen) == 0)
+            return interned;
+    }
+
+    return NULL;
+}
+
+/* Stores a copy of @value inside @data. Small values don't need any
+ * additional allocation. */
+static int32_t
+data_set_copy(data_t *data, const void *value, uint32_t len)
+{
+    if (len <= DICT_DATA_INLINE_SIZE) {
+        data->data = data->inline_data;
+        data->is_static = _gf_true;
+    } else {
+        data->data = GF_MALLOC(len, gf_common_mt_char);
+        if (data->data == NULL) {
+            return -1;
+        }
+        data->is_static = _gf_false;
+    }
+    memcpy(data->data, value, len);
+    data->len = len;
+
+    return 0;
+}
+
+/* Formats a number into @data. The terminating NULL is accounted in the
+ * length of the value. */
+static int32_t
+data_set_number(data_t *data, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(data->inline_data, DICT_DATA_INLINE_SIZE, fmt, ap);
+    va_end(ap);
+
+    data->data = NULL;
+    data->is_static = _gf_true;
+    if (len < 0)
+        return -1;
+
+    if (len < DICT_DATA_INLINE_SIZE) {
+        data->data = data->inline_data;
+    } else {
+        /* Only very big doubles don't fit. */
+        va_start(ap, fmt);
+        len = gf_vasprintf(&data->data, fmt, ap);
+        va_end(ap);
+        if (len < 0)
+            return -1;
+        data->is_static = _gf_false;
+    }
+    data->len = len + 1;
+
+    return 0;
+}
+
 static data_t *
 get_new_data()
 {
@@ -75,43 +217,25 @@ get_new_data()
 }
 
 static dict_t *
-get_new_dict_full(int size_hint)
+get_new_dict_full(void)
 {
-    dict_t *dict = mem_get0(THIS->ctx->dict_pool);
+    dict_t *dict = mem_get(THIS->ctx->dict_pool);
 
     if (!dict) {
         return NULL;
     }
 
-    dict->hash_size = size_hint;
-#if DICT_LIST_IMP
-    /*
-     * This is the only case we ever see currently.  If we ever
-     * need to support resizing the hash table, the resize function
-     * will have to take into account the possibility that
-     * "members" is not separately allocated (i.e. don't just call
-     * realloc() blindly.
-     */
-    dict->members = &dict->members_internal;
-#else
-    /*
-     * We actually need to allocate space for size_hint *pointers*
-     * but we actually allocate space for one *structure*.  Since
-     * a data_pair_t consists of five pointers, we're wasting four
-     * pointers' worth for N=1, and will overrun what we allocated
-     * for N>5.  If anybody ever starts using size_hint, we'll need
-     * to fix this.
-     */
-    GF_ASSERT(size_hint <= (sizeof(data_pair_t) / sizeof(data_pair_t *)));
-    dict->members = mem_get0(THIS->ctx->dict_pair_pool);
-    if (!dict->members) {
-        mem_put(dict);
-        return NULL;
-    }
-#endif
-
-    dict->free_pair.key = NULL;
+    /* The inline pairs are initialized when they are used, so there's no
+     * need to clear the whole structure. */
+    dict->max_count = 0;
+    dict->hash_size = 0;
+    dict->count = 0;
+    GF_ATOMIC_INIT(dict->refcount, 0);
+    dict->members = NULL;
+    dict->members_list = NULL;
+    dict->inline_used = 0;
     dict->totkvlen = 0;
+    dict->extra_stdfree = NULL;
     LOCK_INIT(&dict->lock);
 
     return dict;
@@ -120,7 +244,7 @@ get_new_dict_full(int size_hint)
 dict_t *
 dict_new(void)
 {
-    dict_t *dict = get_new_dict_full(DICT_LIST_IMP);
+    dict_t *dict = get_new_dict_full();
 
     if (dict)
         dict_ref(dict);
@@ -337,8 +461,7 @@ data_copy(data_t *old)
 
     newdata->len = old->len;
     if (old->data) {
-        newdata->data = gf_memdup(old->data, old->len);
-        if (!newdata->data)
+        if (data_set_copy(newdata, old->data, old->len) != 0)
             goto err_out;
     }
     newdata->data_type = old->data_type;
@@ -351,31 +474,254 @@ err_out:
     return NULL;
 }
 
+static inline gf_boolean_t
+dict_key_match(const data_pair_t *pair, const char *key, const uint32_t keylen)
+{
+    return (pair->key_len == keylen) &&
+           ((pair->key == key) || (memcmp(pair->key, key, keylen) == 0));
+}
+
 /* Always need to be called under lock
  * Always this and key variables are not null -
  * checked by callers.
  */
 static data_pair_t *
-dict_lookup_common(const dict_t *this, const char *key, const uint32_t hash)
+dict_lookup_common(const dict_t *this, const char *key, const uint32_t keylen)
 {
-    int hashval = 0;
     data_pair_t *pair;
+    uint32_t hash, mask, idx;
+
+    if (this->members == NULL) {
+        /* Small dictionaries are faster to scan linearly, without even
+         * computing the hash of the key. */
+        for (pair = this->members_list; pair != NULL; pair = pair->next) {
+            if (dict_key_match(pair, key, keylen))
+                return pair;
+        }
 
-    /* If the divisor is 1, the modulo is always 0,
-     * in such case avoid hash calculation.
-     */
-#if !DICT_LIST_IMP
-    hashval = hash % this->hash_size;
-#endif
+        return NULL;
+    }
 
-    for (pair = this->members[hashval]; pair != NULL; pair = pair->hash_next) {
-        if (pair->key && (hash == pair->key_hash) && !strcmp(pair->key, key))
+    hash = dict_key_hash(key, keylen);
+    mask = this->hash_size - 1;
+    for (idx = hash & mask; (pair = this->members[idx]) != NULL;
+         idx = (idx + 1) & mask) {
+        if ((pair->key_hash == hash) && dict_key_match(pair, key, keylen))
             return pair;
     }
 
     return NULL;
 }
 
+/* Adds @pair to the index of @this. The index must have at least one free
+ * slot. */
+static void
+dict_index_add(dict_t *this, data_pair_t *pair)
+{
+    uint32_t mask = this->hash_size - 1;
+    uint32_t idx = pair->key_hash & mask;
+
+    while (this->members[idx] != NULL) {
+        idx = (idx + 1) & mask;
+    }
+    this->members[idx] = pair;
+}
+
+/* Removes @pair from the index of @this, moving back the entries that follow
+ * it so that no tombstones are needed. */
+static void
+dict_index_del(dict_t *this, data_pair_t *pair)
+{
+    uint32_t mask = this->hash_size - 1;
+    uint32_t idx = pair->key_hash & mask;
+    uint32_t next, home;
+
+    while (this->members[idx] != pair) {
+        idx = (idx + 1) & mask;
+    }
+
+    next = idx;
+    for (;;) {
+        next = (next + 1) & mask;
+        if (this->members[next] == NULL)
+            break;
+
+        /* The entry at 'next' can be moved to the hole only if its home slot
+         * is not cyclically placed in (idx, next]. */
+        home = this->members[next]->key_hash & mask;
+        if ((idx <= next) ? ((idx < home) && (home <= next))
+                          : ((idx < home) || (home <= next)))
+            continue;
+
+        this->members[idx] = this->members[next];
+        idx = next;
+    }
+    this->members[idx] = NULL;
+}
+
+/* Makes sure that the index has room for one more pair, creating or growing
+ * it as needed. The load factor is kept at or below 50%. Has to be called
+ * with this->lock held. */
+static int32_t
+dict_index_reserve(dict_t *this)
+{
+    data_pair_t **members;
+    data_pair_t *pair;
+    int32_t size;
+
+    if (this->members == NULL) {
+        if (this->count + 1 < DICT_INDEX_MIN_COUNT)
+            return 0;
+        size = DICT_INDEX_MIN_COUNT * 4;
+    } else {
+        if ((this->count + 1) * 2 <= this->hash_size)
+            return 0;
+        size = this->hash_size * 2;
+    }
+
+    members = GF_CALLOC(size, sizeof(data_pair_t *), gf_common_mt_dict_index);
+    if (members == NULL) {
+        /* Lookups will be slower, but the dict is still usable while there
+         * are free slots. */
+        if ((this->members == NULL) || (this->count + 1 < this->hash_size))
+            return 0;
+        return -1;
+    }
+
+    /* The pairs added before the index existed have no hash yet. */
+    if (this->members == NULL) {
+        for (pair = this->members_list; pair != NULL; pair = pair->next) {
+            pair->key_hash = dict_key_hash(pair->key, pair->key_len);
+        }
+    }
+
+    GF_FREE(this->members);
+    this->members = members;
+    this->hash_size = size;
+
+    for (pair = this->members_list; pair != NULL; pair = pair->next) {
+        dict_index_add(this, pair);
+    }
+
+    return 0;
+}
+
+static data_pair_t *
+dict_pair_get(dict_t *this)
+{
+    data_pair_t *pair;
+    uint32_t idx;
+
+    if (this->inline_used != (1U << DICT_INLINE_PAIRS) - 1) {
+        idx = __builtin_ctz(~this->inline_used);
+        this->inline_used |= 1U << idx;
+
+        return &this->inline_pairs[idx];
+    }
+
+    pair = mem_get(THIS->ctx->dict_pair_pool);
+
+    return pair;
+}
+
+static void
+dict_pair_put(dict_t *this, data_pair_t *pair)
+{
+    if (pair->key_alloc)
+        GF_FREE(pair->key);
+    pair->key = NULL;
+
+    if ((pair >= this->inline_pairs) &&
+        (pair < this->inline_pairs + DICT_INLINE_PAIRS)) {
+        this->inline_used &= ~(1U << (pair - this->inline_pairs));
+    } else {
+        mem_put(pair);
+    }
+}
+
+/* Stores the key into the pair. Interned keys are just referenced, short
+ * keys are kept inside the pair and only long keys need an allocation. If
+ * @key_owned is set, @key has been allocated by the caller and the pair takes
+ * its ownership. */
+static int32_t
+dict_pair_set_key(data_pair_t *pair, char *key, const uint32_t keylen,
+                  gf_boolean_t key_owned)
+{
+    const char *interned;
+
+    pair->key_len = keylen;
+    pair->key_alloc = _gf_false;
+
+    if (key_owned) {
+        pair->key = key;
+        pair->key_alloc = _gf_true;
+
+        return 0;
+    }
+
+    interned = dict_key_interned(key, keylen);
+    if (interned != NULL) {
+        pair->key = (char *)interned;
+    } else if (keylen < DICT_KEY_INLINE_SIZE) {
+        pair->key = pair->key_inline;
+        memcpy(pair->key, key, keylen);
+        pair->key[keylen] = '\0';
+    } else {
+        pair->key = GF_MALLOC(keylen + 1, gf_common_mt_char);
+        if (pair->key == NULL)
+            return -1;
+        memcpy(pair->key, key, keylen);
+        pair->key[keylen] = '\0';
+        pair->key_alloc = _gf_true;
+    }
+
+    return 0;
+}
+
+/* Links a new pair to the dictionary. Has to be called with this->lock held
+ * and after having called dict_index_reserve(). */
+static void
+dict_pair_link(dict_t *this, data_pair_t *pair)
+{
+    pair->prev = NULL;
+    pair->next = this->members_list;
+    if (this->members_list != NULL)
+        this->members_list->prev = pair;
+    this->members_list = pair;
+
+    if (this->members != NULL) {
+        pair->key_hash = dict_key_hash(pair->key, pair->key_len);
+        dict_index_add(this, pair);
+    }
+
+    this->count++;
+    this->totkvlen += pair->key_len + 1 + pair->value->len;
+
+    if (this->max_count < this->count)
+        this->max_count = this->count;
+}
+
+/* Unlinks and releases a pair. Has to be called with this->lock held. */
+static void
+dict_pair_unlink(dict_t *this, data_pair_t *pair)
+{
+    if (this->members != NULL)
+        dict_index_del(this, pair);
+
+    if (pair->prev != NULL)
+        pair->prev->next = pair->next;
+    else
+        this->members_list = pair->next;
+    if (pair->next != NULL)
+        pair->next->prev = pair->prev;
+
+    this->count--;
+    this->totkvlen -= pair->key_len + 1 + pair->value->len;
+
+    data_unref(pair->value);
+    dict_pair_put(this, pair);
+}
+
 int32_t
 dict_lookup(dict_t *this, char *key, data_t **data)
 {
@@ -387,16 +733,11 @@ dict_lookup(dict_t *this, char *key, data_t **data)
     }
 
     data_pair_t *tmp = NULL;
-
-    uint32_t hash = 0;
-
-#if !DICT_LIST_IMP
-    hash = (uint32_t)XXH64(key, strlen(key), 0);
-#endif
+    uint32_t keylen = strlen(key);
 
     LOCK(&this->lock);
     {
-        tmp = dict_lookup_common(this, key, hash);
+        tmp = dict_lookup_common(this, key, keylen);
     }
     UNLOCK(&this->lock);
 
@@ -408,13 +749,11 @@ dict_lookup(dict_t *this, char *key, data_t **data)
 }
 
 static int32_t
-dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
-            const uint32_t hash, gf_boolean_t replace)
+dict_set_lk(dict_t *this, char *key, const uint32_t key_len, data_t *value,
+            gf_boolean_t replace)
 {
-    int hashval = 0;
     data_pair_t *pair;
     int key_free = 0;
-    uint32_t key_hash = 0;
     int keylen;
 
     if (!key) {
@@ -423,17 +762,13 @@ dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
             return -1;
         }
         key_free = 1;
-#if !DICT_LIST_IMP
-        key_hash = (uint32_t)XXH64(key, keylen, 0);
-#endif
     } else {
         keylen = key_len;
-        key_hash = hash;
     }
 
     /* Search for a existing key if 'replace' is asked for */
     if (replace) {
-        pair = dict_lookup_common(this, key, key_hash);
+        pair = dict_lookup_common(this, key, keylen);
         if (pair) {
             data_t *unref_data = pair->value;
             pair->value = data_ref(value);
@@ -446,70 +781,40 @@ dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
         }
     }
 
-    if (this->free_pair.key) { /* the free_pair is used */
-        pair = mem_get(THIS->ctx->dict_pair_pool);
-        if (!pair) {
-            if (key_free)
-                GF_FREE(key);
-            return -1;
-        }
-    } else { /* assign the pair to the free pair */
-        pair = &this->free_pair;
-    }
+    if (dict_index_reserve(this) != 0)
+        goto err;
 
-    if (key_free) {
-        /* It's ours.  Use it. */
-        pair->key = key;
-        key_free = 0;
-    } else {
-        pair->key = (char *)GF_MALLOC(keylen + 1, gf_common_mt_char);
-        if (!pair->key) {
-            if (pair != &this->free_pair) {
-                mem_put(pair);
-            }
-            return -1;
-        }
-        strcpy(pair->key, key);
+    pair = dict_pair_get(this);
+    if (!pair)
+        goto err;
+
+    if (dict_pair_set_key(pair, key, keylen, key_free) != 0) {
+        dict_pair_put(this, pair);
+        goto err;
     }
-    pair->key_hash = key_hash;
-    pair->value = data_ref(value);
-    this->totkvlen += (keylen + 1 + value->len);
 
-    /* If the divisor is 1, the modulo is always 0,
-     * in such case avoid hash calculation.
-     */
-#if !DICT_LIST_IMP
-    hashval = (key_hash % this->hash_size);
-#endif
-    pair->hash_next = this->members[hashval];
-    this->members[hashval] = pair;
+    pair->value = data_ref(value);
+    dict_pair_link(this, pair);
 
-    pair->next = this->members_list;
-    this->members_list = pair;
-    this->count++;
+    return 0;
 
+err:
     if (key_free)
         GF_FREE(key);
 
-    if (this->max_count < this->count)
-        this->max_count = this->count;
-    return 0;
+    return -1;
 }
 
 int32_t
 dict_set(dict_t *this, char *key, data_t *value)
 {
-    if (key)
-        return dict_setn(this, key, strlen(key), value);
-    else
-        return dict_setn(this, NULL, 0, value);
+    return dict_setn(this, key, key ? strlen(key) : 0, value);
 }
 
 int32_t
 dict_setn(dict_t *this, char *key, const int keylen, data_t *value)
 {
     int32_t ret;
-    uint32_t key_hash = 0;
 
     if (!this || !value) {
         gf_msg_callingfn("dict", GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
@@ -519,15 +824,9 @@ dict_setn(dict_t *this, char *key, const int keylen, data_t *value)
         return -1;
     }
 
-#if !DICT_LIST_IMP
-    if (key) {
-        key_hash = (uint32_t)XXH64(key, keylen, 0);
-    }
-#endif
-
     LOCK(&this->lock);
 
-    ret = dict_set_lk(this, key, keylen, value, key_hash, 1);
+    ret = dict_set_lk(this, key, keylen, value, 1);
 
     UNLOCK(&this->lock);
 
@@ -537,17 +836,13 @@ dict_setn(dict_t *this, char *key, const int keylen, data_t *value)
 int32_t
 dict_add(dict_t *this, char *key, data_t *value)
 {
-    if (key)
-        return dict_addn(this, key, strlen(key), value);
-    else
-        return dict_addn(this, NULL, 0, value);
+    return dict_addn(this, key, key ? strlen(key) : 0, value);
 }
 
 int32_t
 dict_addn(dict_t *this, char *key, const int keylen, data_t *value)
 {
     int32_t ret;
-    uint32_t key_hash = 0;
 
     if (!this || !value) {
         gf_msg_callingfn("dict", GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
@@ -555,15 +850,9 @@ dict_addn(dict_t *this, char *key, const int keylen, data_t *value)
         return -1;
     }
 
-#if !DICT_LIST_IMP
-    if (key) {
-        key_hash = (uint32_t)XXH64(key, keylen, 0);
-    }
-#endif
-
     LOCK(&this->lock);
 
-    ret = dict_set_lk(this, key, keylen, value, key_hash, 0);
+    ret = dict_set_lk(this, key, keylen, value, 0);
 
     UNLOCK(&this->lock);
 
@@ -578,18 +867,14 @@ dict_get(dict_t *this, char *key)
                          "!this || key=%s", (key) ? key : "()");
         return NULL;
     }
-#if !DICT_LIST_IMP
+
     return dict_getn(this, key, strlen(key));
-#else
-    return dict_getn(this, key, 0);
-#endif
 }
 
 data_t *
 dict_getn(dict_t *this, char *key, const int keylen)
 {
     data_pair_t *pair;
-    uint32_t hash = 0;
 
     if (!this || !key) {
         gf_msg_callingfn("dict", GF_LOG_DEBUG, EINVAL, LG_MSG_INVALID_ARG,
@@ -597,13 +882,9 @@ dict_getn(dict_t *this, char *key, const int keylen)
         return NULL;
     }
 
-#if !DICT_LIST_IMP
-    hash = (uint32_t)XXH64(key, keylen, 0);
-#endif
-
     LOCK(&this->lock);
     {
-        pair = dict_lookup_common(this, key, hash);
+        pair = dict_lookup_common(this, key, keylen);
     }
     UNLOCK(&this->lock);
 
@@ -641,18 +922,14 @@ dict_del(dict_t *this, char *key)
                          "!this || key=%s", key);
         return _gf_false;
     }
-#if !DICT_LIST_IMP
+
     return dict_deln(this, key, strlen(key));
-#else
-    return dict_deln(this, key, 0);
-#endif
 }
 
 gf_boolean_t
 dict_deln(dict_t *this, char *key, const int keylen)
 {
-    int hashval = 0;
-    uint32_t hash = 0;
+    data_pair_t *pair;
     gf_boolean_t rc = _gf_false;
 
     if (!this || !key) {
@@ -661,51 +938,12 @@ dict_deln(dict_t *this, char *key, const int keylen)
         return rc;
     }
 
-#if !DICT_LIST_IMP
-    hash = (uint32_t)XXH64(key, keylen, 0);
-#endif
-
     LOCK(&this->lock);
 
-    /* If the divisor is 1, the modulo is always 0,
-     * in such case avoid hash calculation.
-     */
-#if !DICT_LIST_IMP
-    hashval = hash % this->hash_size;
-#endif
-
-    data_pair_t *pair = this->members[hashval];
-    data_pair_t *prev = NULL;
-
-    while (pair) {
-        if ((hash == pair->key_hash) && strcmp(pair->key, key) == 0) {
-            if (prev)
-                prev->hash_next = pair->hash_next;
-            else
-                this->members[hashval] = pair->hash_next;
-
-            this->totkvlen -= pair->value->len;
-            data_unref(pair->value);
-
-            if (prev)
-                prev->next = pair->next;
-            else
-                this->members_list = pair->next;
-
-            this->totkvlen -= (keylen + 1);
-            GF_FREE(pair->key);
-            if (pair == &this->free_pair) {
-                this->free_pair.key = NULL;
-            } else {
-                mem_put(pair);
-            }
-            this->count--;
-            rc = _gf_true;
-            break;
-        }
-
-        prev = pair;
-        pair = pair->hash_next;
+    pair = dict_lookup_common(this, key, keylen);
+    if (pair) {
+        dict_pair_unlink(this, pair);
+        rc = _gf_true;
     }
 
     UNLOCK(&this->lock);
@@ -724,15 +962,15 @@ dict_clear_data(dict_t *this)
     while (curr != NULL) {
         next = curr->next;
         data_unref(curr->value);
-        GF_FREE(curr->key);
-        if (curr == &this->free_pair) {
-            this->free_pair.key = NULL;
-        } else {
-            mem_put(curr);
-        }
+        dict_pair_put(this, curr);
         curr = next;
     }
+    this->members_list = NULL;
     this->count = this->totkvlen = 0;
+
+    GF_FREE(this->members);
+    this->members = NULL;
+    this->hash_size = 0;
 }
 
 static void
@@ -751,9 +989,6 @@ dict_destroy(dict_t *this)
     LOCK_DESTROY(&this->lock);
 
     dict_clear_data(this);
-    if (this->members != &this->members_internal) {
-        mem_put(this->members);
-    }
 
     free(this->extra_stdfree);
 
@@ -850,13 +1085,11 @@ int_to_data(int64_t value)
         return NULL;
     }
 
-    data->len = gf_asprintf(&data->data, "%" PRId64, value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%" PRId64, value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_INT;
 
     return data;
@@ -870,13 +1103,11 @@ data_from_int64(int64_t value)
     if (!data) {
         return NULL;
     }
-    data->len = gf_asprintf(&data->data, "%" PRId64, value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%" PRId64, value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_INT;
 
     return data;
@@ -890,14 +1121,11 @@ data_from_int32(int32_t value)
     if (!data) {
         return NULL;
     }
-    data->len = gf_asprintf(&data->data, "%" PRId32, value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%" PRId32, value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_INT;
 
     return data;
@@ -911,14 +1139,11 @@ data_from_int16(int16_t value)
     if (!data) {
         return NULL;
     }
-    data->len = gf_asprintf(&data->data, "%" PRId16, value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%" PRId16, value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_INT;
 
     return data;
@@ -932,14 +1157,11 @@ data_from_int8(int8_t value)
     if (!data) {
         return NULL;
     }
-    data->len = gf_asprintf(&data->data, "%d", value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%d", value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_INT;
 
     return data;
@@ -953,14 +1175,11 @@ data_from_uint64(uint64_t value)
     if (!data) {
         return NULL;
     }
-    data->len = gf_asprintf(&data->data, "%" PRIu64, value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%" PRIu64, value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_UINT;
 
     return data;
@@ -975,13 +1194,11 @@ data_from_double(double value)
         return NULL;
     }
 
-    data->len = gf_asprintf(&data->data, "%f", value);
-    if (data->len == -1) {
+    if (data_set_number(data, "%f", value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_DOUBLE;
 
     return data;
@@ -995,14 +1212,11 @@ data_from_uint32(uint32_t value)
     if (!data) {
         return NULL;
     }
-    data->len = gf_asprintf(&data->data, "%" PRIu32, value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%" PRIu32, value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_UINT;
 
     return data;
@@ -1016,14 +1230,11 @@ data_from_uint16(uint16_t value)
     if (!data) {
         return NULL;
     }
-    data->len = gf_asprintf(&data->data, "%" PRIu16, value);
-    if (-1 == data->len) {
+    if (data_set_number(data, "%" PRIu16, value) != 0) {
         gf_msg_debug("dict", 0, "asprintf failed");
         data_destroy(data);
         return NULL;
     }
-
-    data->len++; /* account for terminating NULL */
     data->data_type = GF_DATA_TYPE_UINT;
 
     return data;
@@ -1482,7 +1693,7 @@ dict_copy(dict_t *dict, dict_t *new)
     }
 
     if (!new)
-        new = get_new_dict_full(dict->hash_size);
+        new = get_new_dict_full();
 
     dict_foreach(dict, dict_copy_one, new);
 
@@ -1499,13 +1710,9 @@ dict_reset(dict_t *dict)
         goto out;
     }
 
-    int i;
     LOCK(&dict->lock);
 
     dict_clear_data(dict);
-    for (i = 0; i < dict->hash_size; i++)
-        dict->members[i] = NULL;
-    dict->members_list = NULL;
 
     UNLOCK(&dict->lock);
     ret = 0;
@@ -1547,15 +1754,10 @@ dict_get_with_refn(dict_t *this, char *key, const int keylen, data_t **data)
 {
     data_pair_t *pair = NULL;
     int ret = -ENOENT;
-    uint32_t hash = 0;
-
-#if !DICT_LIST_IMP
-    hash = (uint32_t)XXH64(key, keylen, 0);
-#endif
 
     LOCK(&this->lock);
     {
-        pair = dict_lookup_common(this, key, hash);
+        pair = dict_lookup_common(this, key, keylen);
 
         if (pair) {
             ret = 0;
@@ -1585,11 +1787,7 @@ dict_get_with_ref(dict_t *this, char *key, data_t **data)
 
         return -EINVAL;
     }
-#if !DICT_LIST_IMP
     return dict_get_with_refn(this, key, strlen(key), data);
-#else
-    return dict_get_with_refn(this, key, 0, data);
-#endif
 }
 
 static int
@@ -2163,8 +2361,7 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
     int ret = 0;
     data_pair_t *pair = NULL;
     char *ptr = NULL;
-    int hashval = 0;
-    uint32_t hash = 0;
+    uint32_t keylen = 0;
 
     if (!this || !key) {
         gf_msg_callingfn("dict", GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
@@ -2179,13 +2376,11 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
      */
     GF_ASSERT(flag >= 0 && flag < DICT_MAX_FLAGS);
 
-#if !DICT_LIST_IMP
-    hash = (uint32_t)XXH64(key, strlen(key), 0);
-#endif
+    keylen = strlen(key);
 
     LOCK(&this->lock);
     {
-        pair = dict_lookup_common(this, key, hash);
+        pair = dict_lookup_common(this, key, keylen);
 
         if (pair) {
             data = pair->value;
@@ -2217,41 +2412,29 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
             else
                 BIT_CLEAR((unsigned char *)(data->data), flag);
 
-            if (this->free_pair.key) { /* the free pair is in use */
-                pair = mem_get0(THIS->ctx->dict_pair_pool);
-                if (!pair) {
-                    gf_smsg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
-                            "dict pair", NULL);
-                    ret = -ENOMEM;
-                    goto err;
-                }
-            } else { /* use the free pair */
-                pair = &this->free_pair;
+            if (dict_index_reserve(this) != 0) {
+                gf_smsg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
+                        "dict index", NULL);
+                ret = -ENOMEM;
+                goto err;
+            }
+
+            pair = dict_pair_get(this);
+            if (!pair) {
+                gf_smsg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
+                        "dict pair", NULL);
+                ret = -ENOMEM;
+                goto err;
             }
 
-            pair->key = (char *)GF_MALLOC(strlen(key) + 1, gf_common_mt_char);
-            if (!pair->key) {
+            if (dict_pair_set_key(pair, key, keylen, _gf_false) != 0) {
                 gf_smsg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
                         "dict pair", NULL);
                 ret = -ENOMEM;
                 goto err;
             }
-            strcpy(pair->key, key);
-            pair->key_hash = hash;
             pair->value = data_ref(data);
-            this->totkvlen += (strlen(key) + 1 + data->len);
-#if !DICT_LIST_IMP
-            hashval = hash % this->hash_size;
-#endif
-            pair->hash_next = this->members[hashval];
-            this->members[hashval] = pair;
-
-            pair->next = this->members_list;
-            this->members_list = pair;
-            this->count++;
-
-            if (this->max_count < this->count)
-                this->max_count = this->count;
+            dict_pair_link(this, pair);
         }
     }
 
@@ -2259,19 +2442,14 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
     return 0;
 
 err:
+    /* The pair belongs to the dict, so it must be released with the lock
+     * still held. */
+    if (pair)
+        dict_pair_put(this, pair);
+
     if (key && this)
         UNLOCK(&this->lock);
 
-    if (pair) {
-        if (pair->key) {
-            GF_FREE(pair->key);
-            pair->key = NULL;
-        }
-        if (pair != &this->free_pair) {
-            mem_put(pair);
-        }
-    }
-
     if (data)
         data_destroy(data);
 
@@ -2905,8 +3083,6 @@ dict_rename_key(dict_t *this, char *key, char *replace_key)
 {
     data_pair_t *pair = NULL;
     int ret = -EINVAL;
-    uint32_t hash = 0;
-    uint32_t replacekey_hash = 0;
     int replacekey_len = 0;
 
     /* replacing a key by itself is a NO-OP */
@@ -2920,20 +3096,16 @@ dict_rename_key(dict_t *this, char *key, char *replace_key)
     }
 
     replacekey_len = strlen(replace_key);
-#if !DICT_LIST_IMP
-    hash = (uint32_t)XXH64(key, strlen(key), 0);
-    replacekey_hash = (uint32_t)XXH64(replace_key, replacekey_len, 0);
-#endif
 
     LOCK(&this->lock);
     {
         /* no need to data_ref(pair->value), dict_set_lk() does it */
-        pair = dict_lookup_common(this, key, hash);
+        pair = dict_lookup_common(this, key, strlen(key));
         if (!pair)
             ret = -ENODATA;
         else
             ret = dict_set_lk(this, replace_key, replacekey_len, pair->value,
-                              replacekey_hash, 1);
+                              1);
     }
     UNLOCK(&this->lock);
 
@@ -3027,7 +3199,7 @@ dict_serialize_lk(dict_t *this, char *buf)
             goto out;
         }
 
-        keylen = strlen(pair->key);
+        keylen = pair->key_len;
         netword = htobe32(keylen);
         memcpy(buf, &netword, sizeof(netword));
         buf += DICT_DATA_HDR_KEY_LEN;
@@ -3246,10 +3418,12 @@ dict_unserialize(char *orig_buf, int32_t size, dict_t **fill)
             ret = -1;
             goto out;
         }
-        value->len = vallen;
-        value->data = gf_memdup(buf, vallen);
+        if (data_set_copy(value, buf, vallen) != 0) {
+            data_destroy(value);
+            ret = -1;
+            goto out;
+        }
         value->data_type = GF_DATA_TYPE_STR_OLD;
-        value->is_static = _gf_false;
         buf += vallen;
 
         ret = dict_addn(*fill, key, keylen, value);
@@ -3533,7 +3707,6 @@ int
 dict_has_key_from_array(dict_t *dict, char **strings, gf_boolean_t *result)
 {
     int i = 0;
-    uint32_t hash = 0;
 
     if (!dict || !strings || !result)
         return -EINVAL;
@@ -3541,10 +3714,7 @@ dict_has_key_from_array(dict_t *dict, char **strings, gf_boolean_t *result)
     LOCK(&dict->lock);
     {
         for (i = 0; strings[i]; i++) {
-#if !DICT_LIST_IMP
-            hash = (uint32_t)XXH64(strings[i], strlen(strings[i]), 0);
-#endif
-            if (dict_lookup_common(dict, strings[i], hash)) {
+            if (dict_lookup_common(dict, strings[i], strlen(strings[i]))) {
                 *result = _gf_true;
                 goto unlock;
             }
@@ -3681,10 +3851,12 @@ dict_unserialize_specific_keys(char *orig_buf, int32_t size, dict_t **fill,
             ret = -1;
             goto out;
         }
-        value->len = vallen;
-        value->data = gf_memdup(buf, vallen);
+        if (data_set_copy(value, buf, vallen) != 0) {
+            data_destroy(value);
+            ret = -1;
+            goto out;
+        }
         value->data_type = GF_DATA_TYPE_STR_OLD;
-        value->is_static = _gf_false;
         buf += vallen;
 
         ret = dict_addn(*fill, key, keylen, value);
@@ -11,50 +11,106 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/socket.h>
 
 #include "glusterfs/gf-event.h"
 #include "glusterfs/common-utils.h"
 #include "glusterfs/syscall.h"
 #include "glusterfs/libglusterfs-messages.h"
+#include "glusterfs/gf-numa.h"
 
 #ifdef HAVE_SYS_EPOLL_H
 #include <sys/epoll.h>
 
 struct event_slot_epoll {
-    int slots_used;
     int fd;
     int events;
+    int armed; /* events currently armed in the epoll instance */
     int gen;
     int idx;
+    int shard; /* shard the fd is assigned to, -1 for the shared epoll */
     gf_atomic_t ref;
     int do_close;
     int in_handler;
     int handled_error;
+    int notify_poller_death;
     void *data;
     event_handler_t handler;
     struct list_head poller_death;
     gf_lock_t lock;
 };
 
+/* Allocations and releases of slots only need the lock of the table they
+ * belong to. Sharded event threads start searching for free slots in
+ * different tables, so they don't contend with each other. */
+struct event_slot_table {
+    pthread_mutex_t lock;
+    int slots_used;
+    struct event_slot_epoll slots[EVENT_EPOLL_SLOTS];
+};
+
+/*
+ * In sharded mode each event thread waits on its own epoll instance. An fd
+ * assigned to a shard is only ever returned to the owner of the shard, so it
+ * doesn't need EPOLLONESHOT, and it doesn't have to be re-armed with a
+ * system call after each event.
+ *
+ * The shared epoll instance is nested inside one of the shards. This way
+ * fds registered before the mode was enabled, or while no shard was
+ * available, are still processed. Nesting it in a single shard avoids
+ * waking up all the sharded threads for each event of a shared fd. When the
+ * owner of that shard terminates, it's moved to another active shard.
+ */
+struct event_shard {
+    int fd;     /* epoll instance, -1 if not created yet */
+    int count;  /* number of fds assigned to this shard */
+    int active; /* set while the owner thread is processing events */
+};
+
+/* Events returned by a shard for the nested shared epoll instance. */
+#define EVENT_EPOLL_NESTED_IDX -1
+
+/* Sharded threads can't be woken up through the shared epoll instance, so
+ * they periodically check if they have to terminate. */
+#define EVENT_EPOLL_SHARD_TIMEOUT 1000
+
 struct event_thread_data {
     struct event_pool *event_pool;
     int event_index;
 };
 
-static struct event_slot_epoll *
-__event_newtable(struct event_pool *event_pool, int table_idx)
+static struct event_slot_table *
+event_table_get(struct event_pool *event_pool, int table_idx)
 {
-    struct event_slot_epoll *table = NULL;
+    return __atomic_load_n(&event_pool->ereg[table_idx], __ATOMIC_ACQUIRE);
+}
+
+static struct event_slot_table *
+event_newtable(struct event_pool *event_pool, int table_idx)
+{
+    struct event_slot_table *table = NULL;
+    struct event_slot_table *old = NULL;
     int i;
 
-    table = GF_CALLOC(sizeof(*table), EVENT_EPOLL_SLOTS, gf_common_mt_ereg);
+    table = GF_CALLOC(1, sizeof(*table), gf_common_mt_ereg);
     if (!table)
         return NULL;
 
+    pthread_mutex_init(&table->lock, NULL);
     for (i = 0; i < EVENT_EPOLL_SLOTS; i++)
-        table[i].fd = -1;
-
-    event_pool->ereg[table_idx] = table;
+        table->slots[i].fd = -1;
+
+    if (!__atomic_compare_exchange_n(&event_pool->ereg[table_idx], &old, table,
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) {
+        /* Another thread has created it first. */
+        pthread_mutex_destroy(&table->lock);
+        GF_FREE(table);
+        table = old;
+    }
 
     return table;
 }
@@ -67,93 +123,102 @@ event_slot_ref(struct event_slot_epoll *slot)
 }
 
 static int
-__event_slot_alloc(struct event_pool *event_pool, int fd,
-                   int notify_poller_death, struct event_slot_epoll **slot)
+event_slot_epfd(struct event_pool *event_pool, struct event_slot_epoll *slot)
 {
-    int i = 0;
-    int j = 0;
-    int table_idx;
-    int gen;
-    struct event_slot_epoll *table = NULL;
-
-retry:
+    if (slot->shard < 0)
+        return event_pool->fd;
 
-    while (i < EVENT_EPOLL_TABLES) {
-        table = event_pool->ereg[i];
-        if (table) {
-            if (table->slots_used == EVENT_EPOLL_SLOTS)
-                return -1;
-            else
-                break; /* break out of the loop */
-        } else {
-            table = __event_newtable(event_pool, i);
-            if (!table)
-                return -1;
-            else
-                break; /* break out of the loop */
-        }
+    return event_pool->shards[slot->shard].fd;
+}
 
-        i++;
-    }
+static int
+__event_slot_alloc(struct event_slot_table *table, int table_idx, int fd,
+                   int shard, struct event_slot_epoll **slot)
+{
+    int j = 0;
+    int gen;
 
-    table_idx = i;
+    if (table->slots_used == EVENT_EPOLL_SLOTS)
+        return -1;
 
     for (j = 0; j < EVENT_EPOLL_SLOTS; j++) {
-        if (table[j].fd == -1) {
+        if (table->slots[j].fd == -1) {
             /* wipe everything except bump the generation */
-            gen = table[j].gen;
-            memset(&table[j], 0, sizeof(table[j]));
-            table[j].fd = fd;
-            table[j].gen = gen + 1;
-
-            INIT_LIST_HEAD(&table[j].poller_death);
-            LOCK_INIT(&table[j].lock);
-
-            if (notify_poller_death) {
-                table[j].idx = table_idx * EVENT_EPOLL_SLOTS + j;
-                list_add_tail(&table[j].poller_death,
-                              &event_pool->poller_death);
-            }
+            gen = table->slots[j].gen;
+            memset(&table->slots[j], 0, sizeof(table->slots[j]));
+            table->slots[j].fd = fd;
+            table->slots[j].gen = gen + 1;
+            table->slots[j].shard = shard;
 
-            event_pool->ereg[table_idx]->slots_used++;
+            INIT_LIST_HEAD(&table->slots[j].poller_death);
+            LOCK_INIT(&table->slots[j].lock);
 
-            break;
+            table->slots_used++;
+
+            (*slot) = &table->slots[j];
+            event_slot_ref(*slot);
+
+            return table_idx * EVENT_EPOLL_SLOTS + j;
         }
     }
 
-    if (j == EVENT_EPOLL_SLOTS) {
-        table = NULL;
-        i++;
-        goto retry;
-    } else {
-        (*slot) = &table[j];
-        event_slot_ref(*slot);
-        return table_idx * EVENT_EPOLL_SLOTS + j;
-    }
+    return -1;
 }
 
 static int
 event_slot_alloc(struct event_pool *event_pool, int fd, int notify_poller_death,
-                 struct event_slot_epoll **slot)
+                 int shard, struct event_slot_epoll **slot)
 {
-    int idx;
+    struct event_slot_table *table = NULL;
+    int table_idx;
+    int idx = -1;
+    int i;
 
-    pthread_mutex_lock(&event_pool->mutex);
-    {
-        idx = __event_slot_alloc(event_pool, fd, notify_poller_death, slot);
+    for (i = 0; (idx < 0) && (i < EVENT_EPOLL_TABLES); i++) {
+        table_idx = (i + ((shard < 0) ? 0 : shard)) % EVENT_EPOLL_TABLES;
+
+        table = event_table_get(event_pool, table_idx);
+        if (!table) {
+            table = event_newtable(event_pool, table_idx);
+            if (!table)
+                return -1;
+        }
+
+        pthread_mutex_lock(&table->lock);
+        {
+            idx = __event_slot_alloc(table, table_idx, fd, shard, slot);
+        }
+        pthread_mutex_unlock(&table->lock);
+    }
+
+    if (idx < 0)
+        return -1;
+
+    if (shard >= 0)
+        __atomic_fetch_add(&event_pool->shards[shard].count, 1,
+                           __ATOMIC_RELAXED);
+
+    if (notify_poller_death) {
+        pthread_mutex_lock(&event_pool->mutex);
+        {
+            (*slot)->idx = idx;
+            (*slot)->notify_poller_death = 1;
+            list_add_tail(&(*slot)->poller_death, &event_pool->poller_death);
+        }
+        pthread_mutex_unlock(&event_pool->mutex);
     }
-    pthread_mutex_unlock(&event_pool->mutex);
 
     return idx;
 }
 
 static void
-__event_slot_dealloc(struct event_slot_epoll *table, int offset)
+__event_slot_dealloc(struct event_pool *event_pool,
+                     struct event_slot_table *table, int offset)
 {
     struct event_slot_epoll *slot = NULL;
     int fd;
 
-    slot = &table[offset];
+    slot = &table->slots[offset];
     slot->gen++;
 
     fd = slot->fd;
@@ -161,48 +226,72 @@ __event_slot_dealloc(struct event_slot_epoll *table, int offset)
     slot->handled_error = 0;
     slot->in_handler = 0;
     LOCK_DESTROY(&slot->lock);
-    list_del_init(&slot->poller_death);
-    if (fd != -1)
+    if (fd != -1) {
         table->slots_used--;
+        if (slot->shard >= 0)
+            __atomic_fetch_sub(&event_pool->shards[slot->shard].count, 1,
+                               __ATOMIC_RELAXED);
+    }
 }
 
+/* Must be called with event_pool->mutex held if the slot is in the
+ * poller_death list. */
 static void
-event_slot_dealloc(struct event_pool *event_pool, int idx)
+event_slot_dealloc_locked(struct event_pool *event_pool, int idx,
+                          int poller_death_locked)
 {
     int table_idx = idx / EVENT_EPOLL_SLOTS;
     int offset;
-    struct event_slot_epoll *table = NULL;
+    struct event_slot_table *table = NULL;
+    struct event_slot_epoll *slot = NULL;
 
-    table = event_pool->ereg[table_idx];
+    table = event_table_get(event_pool, table_idx);
     if (!table)
         return;
 
     offset = idx % EVENT_EPOLL_SLOTS;
-    pthread_mutex_lock(&event_pool->mutex);
+    slot = &table->slots[offset];
+
+    if (slot->notify_poller_death) {
+        if (!poller_death_locked)
+            pthread_mutex_lock(&event_pool->mutex);
+        list_del_init(&slot->poller_death);
+        slot->notify_poller_death = 0;
+        if (!poller_death_locked)
+            pthread_mutex_unlock(&event_pool->mutex);
+    }
+
+    pthread_mutex_lock(&table->lock);
     {
-        __event_slot_dealloc(table, offset);
+        __event_slot_dealloc(event_pool, table, offset);
     }
-    pthread_mutex_unlock(&event_pool->mutex);
+    pthread_mutex_unlock(&table->lock);
 
     return;
 }
 
+static void
+event_slot_dealloc(struct event_pool *event_pool, int idx)
+{
+    event_slot_dealloc_locked(event_pool, idx, 0);
+}
+
 static struct event_slot_epoll *
 event_slot_get(struct event_pool *event_pool, int idx)
 {
     struct event_slot_epoll *slot = NULL;
-    struct event_slot_epoll *table = NULL;
+    struct event_slot_table *table = NULL;
     int table_idx = 0;
     int offset = 0;
 
     table_idx = idx / EVENT_EPOLL_SLOTS;
     offset = idx % EVENT_EPOLL_SLOTS;
 
-    table = event_pool->ereg[table_idx];
+    table = event_table_get(event_pool, table_idx);
     if (!table)
         goto out;
 
-    slot = &table[offset];
+    slot = &table->slots[offset];
 
     event_slot_ref(slot);
 
@@ -217,8 +306,6 @@ __event_slot_unref(struct event_pool *event_pool, struct event_slot_epoll *slot,
     int64_t ref;
     int fd;
     int do_close = 0;
-    int table_idx, offset;
-    struct event_slot_epoll *table = NULL;
 
     ref = GF_ATOMIC_DEC(slot->ref);
     if (ref)
@@ -233,13 +320,8 @@ __event_slot_unref(struct event_pool *event_pool, struct event_slot_epoll *slot,
     }
     UNLOCK(&slot->lock);
 
-    table_idx = idx / EVENT_EPOLL_SLOTS;
+    event_slot_dealloc_locked(event_pool, idx, 1);
 
-    table = event_pool->ereg[table_idx];
-    if (table) {
-        offset = idx % EVENT_EPOLL_SLOTS;
-        __event_slot_dealloc(table, offset);
-    }
     if (do_close)
         sys_close(fd);
 done:
@@ -275,22 +357,84 @@ done:
     return;
 }
 
+/* Builds the map of CPUs to event threads used by the 'incoming-cpu'
+ * balance. Only the CPUs the process can run on are numbered, in order, so
+ * gaps in the CPU numbers don't leave threads without CPUs. */
+static void
+event_cpu_map_init(struct event_pool *event_pool)
+{
+    cpu_set_t cpus;
+    int count = 0;
+    int cpu;
+
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+        gf_msg_debug("epoll", errno, "unable to get the CPU affinity");
+        CPU_ZERO(&cpus);
+    }
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        event_pool->cpu_pos[cpu] = -1;
+        if (CPU_ISSET(cpu, &cpus))
+            event_pool->cpu_pos[cpu] = count++;
+    }
+}
+
+/* Returns the event thread that processes the connections whose packets are
+ * received by @cpu, or -1 if it's not known. This is the only mapping
+ * between CPUs and threads: event_thread_bind_cpu() binds each thread to the
+ * CPUs that this function assigns to it. */
+static int
+event_cpu_thread(struct event_pool *event_pool, int cpu, int threads)
+{
+    if ((cpu < 0) || (cpu >= CPU_SETSIZE) || (event_pool->cpu_pos[cpu] < 0))
+        return -1;
+
+    return event_pool->cpu_pos[cpu] % threads;
+}
+
 static struct event_pool *
 event_pool_new_epoll(int count, int eventthreadcount)
 {
     struct event_pool *event_pool = NULL;
     int epfd;
+    int i;
 
     event_pool = GF_CALLOC(1, sizeof(*event_pool), gf_common_mt_event_pool);
 
     if (!event_pool)
         goto out;
 
+    event_pool->shards = GF_CALLOC(EVENT_MAX_THREADS,
+                                   sizeof(*event_pool->shards),
+                                   gf_common_mt_event_pool);
+    if (!event_pool->shards) {
+        GF_FREE(event_pool);
+        event_pool = NULL;
+        goto out;
+    }
+
+    for (i = 0; i < EVENT_MAX_THREADS; i++)
+        event_pool->shards[i].fd = -1;
+    event_pool->nested_shard = -1;
+
+    event_pool->cpu_pos = GF_CALLOC(CPU_SETSIZE, sizeof(*event_pool->cpu_pos),
+                                    gf_common_mt_event_pool);
+    if (!event_pool->cpu_pos) {
+        GF_FREE(event_pool->shards);
+        GF_FREE(event_pool);
+        event_pool = NULL;
+        goto out;
+    }
+    event_cpu_map_init(event_pool);
+
     epfd = epoll_create(count);
 
     if (epfd < 0) {
         gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_CREATE_FAILED,
                 NULL);
+        GF_FREE(event_pool->cpu_pos);
+        GF_FREE(event_pool->shards);
         GF_FREE(event_pool->reg);
         GF_FREE(event_pool);
         event_pool = NULL;
@@ -346,6 +490,318 @@ __slot_update_events(struct event_slot_epoll *slot, int poll_in, int poll_out)
     }
 }
 
+static int
+event_shard_threads(struct event_pool *event_pool)
+{
+    int threads = event_pool->eventthreadcount;
+
+    if (threads > EVENT_MAX_THREADS)
+        threads = EVENT_MAX_THREADS;
+    if (threads <= 0)
+        threads = 1;
+
+    return threads;
+}
+
+static int
+event_shard_least_loaded(struct event_pool *event_pool)
+{
+    struct event_shard *shard = NULL;
+    int threads = event_shard_threads(event_pool);
+    int best = -1;
+    int min = INT_MAX;
+    int count;
+    int i;
+
+    for (i = 0; i < threads; i++) {
+        shard = &event_pool->shards[i];
+        if (!__atomic_load_n(&shard->active, __ATOMIC_ACQUIRE))
+            continue;
+
+        count = __atomic_load_n(&shard->count, __ATOMIC_RELAXED);
+        if (count < min) {
+            min = count;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/* Selects the shard for a new fd. Returns -1 if no thread is using its shard
+ * yet, in which case the shared epoll instance is used. */
+static int
+event_shard_pick(struct event_pool *event_pool, int fd)
+{
+    int threads = event_shard_threads(event_pool);
+    int start = -1;
+    int shard;
+    int i;
+#ifdef SO_INCOMING_CPU
+    socklen_t len;
+    int cpu;
+#endif
+
+    if (event_pool->balance == EVENT_BALANCE_LEAST_LOADED)
+        return event_shard_least_loaded(event_pool);
+
+#ifdef SO_INCOMING_CPU
+    if (event_pool->balance == EVENT_BALANCE_INCOMING_CPU) {
+        /* This fails for fds that are not sockets. Round-robin is used
+         * for them. */
+        len = sizeof(cpu);
+        if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0)
+            start = event_cpu_thread(event_pool, cpu, threads);
+    }
+#endif
+
+    if (start < 0)
+        start = __atomic_fetch_add(&event_pool->shard_rr, 1,
+                                   __ATOMIC_RELAXED) %
+                threads;
+
+    for (i = 0; i < threads; i++) {
+        shard = (start + i) % threads;
+        if (__atomic_load_n(&event_pool->shards[shard].active,
+                            __ATOMIC_ACQUIRE))
+            return shard;
+    }
+
+    return -1;
+}
+
+/* Reassigns a registered fd to another shard (or to the shared epoll
+ * instance if @shard is -1). Must be called with slot->lock held. */
+static void
+__event_slot_move(struct event_pool *event_pool, struct event_slot_epoll *slot,
+                  int idx, int shard)
+{
+    struct epoll_event epoll_event = {
+        0,
+    };
+    struct event_data *ev_data = (void *)&epoll_event.data;
+    int epfd;
+
+    epfd = event_slot_epfd(event_pool, slot);
+    if (epoll_ctl(epfd, EPOLL_CTL_DEL, slot->fd, NULL) == -1) {
+        gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_DEL_FAILED,
+                "fd=%d", slot->fd, "epoll_fd=%d", epfd, NULL);
+    }
+
+    if (slot->shard >= 0)
+        __atomic_fetch_sub(&event_pool->shards[slot->shard].count, 1,
+                           __ATOMIC_RELAXED);
+    if (shard >= 0)
+        __atomic_fetch_add(&event_pool->shards[shard].count, 1,
+                           __ATOMIC_RELAXED);
+    slot->shard = shard;
+
+    slot->events &= ~EPOLLONESHOT;
+    if (shard < 0)
+        slot->events |= EPOLLONESHOT;
+
+    /* If a handler is still running, the fd will be armed when it
+     * finishes. */
+    slot->armed = 0;
+    epoll_event.events = EPOLLONESHOT;
+    if (slot->in_handler == 0) {
+        slot->armed = slot->events;
+        epoll_event.events = slot->events;
+    }
+    ev_data->idx = idx;
+    ev_data->gen = slot->gen;
+
+    epfd = event_slot_epfd(event_pool, slot);
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, slot->fd, &epoll_event) == -1) {
+        gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_ADD_FAILED,
+                "fd=%d", slot->fd, "epoll_fd=%d", epfd, NULL);
+    }
+}
+
+/* Stops an fd assigned to a shard from being reported until
+ * event_handled_epoll() is called. Must be called with slot->lock held. */
+static void
+__event_slot_disarm(struct event_pool *event_pool,
+                    struct event_slot_epoll *slot, int idx)
+{
+    struct epoll_event epoll_event = {
+        0,
+    };
+    struct event_data *ev_data = (void *)&epoll_event.data;
+
+    if ((slot->shard < 0) || (slot->armed == 0))
+        return;
+
+    /* EPOLLERR and EPOLLHUP can't be disabled. With EPOLLONESHOT they are
+     * reported at most once more. */
+    epoll_event.events = EPOLLONESHOT;
+    ev_data->idx = idx;
+    ev_data->gen = slot->gen;
+
+    if (epoll_ctl(event_slot_epfd(event_pool, slot), EPOLL_CTL_MOD, slot->fd,
+                  &epoll_event) == -1) {
+        gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_MODIFY_FAILED,
+                "fd=%d", slot->fd, "events=%d", epoll_event.events, NULL);
+    }
+
+    slot->armed = 0;
+}
+
+/* Nests the shared epoll instance inside the epoll instance of a shard.
+ * Must be called with event_pool->mutex held. */
+static int
+__event_shard_nest(struct event_pool *event_pool, int index)
+{
+    struct epoll_event epoll_event = {
+        0,
+    };
+    struct event_data *ev_data = (void *)&epoll_event.data;
+    int epfd = event_pool->shards[index].fd;
+
+    epoll_event.events = EPOLLIN;
+    ev_data->idx = EVENT_EPOLL_NESTED_IDX;
+    ev_data->gen = 0;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, event_pool->fd, &epoll_event) == -1) {
+        gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_ADD_FAILED,
+                "fd=%d", event_pool->fd, "epoll_fd=%d", epfd, NULL);
+        return -1;
+    }
+
+    event_pool->nested_shard = index;
+
+    return 0;
+}
+
+/* Removes the shared epoll instance from the shard where it's nested, and
+ * nests it in the least loaded active shard, if any. Must be called with
+ * event_pool->mutex held. */
+static void
+__event_shard_unnest(struct event_pool *event_pool)
+{
+    int epfd = event_pool->shards[event_pool->nested_shard].fd;
+    int next;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_DEL, event_pool->fd, NULL) == -1) {
+        gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_DEL_FAILED,
+                "fd=%d", event_pool->fd, "epoll_fd=%d", epfd, NULL);
+    }
+    event_pool->nested_shard = -1;
+
+    next = event_shard_least_loaded(event_pool);
+    if (next >= 0)
+        (void)__event_shard_nest(event_pool, next);
+}
+
+/* Called by an event thread to start waiting on its own epoll instance. */
+static struct event_shard *
+event_shard_start(struct event_pool *event_pool, int index)
+{
+    struct event_shard *shard = &event_pool->shards[index];
+    int epfd;
+
+    /* The epoll instance is kept when the thread terminates, so that a new
+     * thread with the same index can reuse it. */
+    if (shard->fd < 0) {
+        epfd = epoll_create(event_pool->count);
+        if (epfd < 0) {
+            gf_smsg("epoll", GF_LOG_ERROR, errno,
+                    LG_MSG_EPOLL_FD_CREATE_FAILED, NULL);
+            return NULL;
+        }
+
+        shard->fd = epfd;
+    }
+
+    pthread_mutex_lock(&event_pool->mutex);
+    {
+        /* The first shard takes care of the fds of the shared epoll
+         * instance. If that fails, this thread keeps using the shared
+         * instance directly. */
+        if ((event_pool->nested_shard < 0) &&
+            (__event_shard_nest(event_pool, index) != 0))
+            shard = NULL;
+        else
+            __atomic_store_n(&shard->active, 1, __ATOMIC_SEQ_CST);
+    }
+    pthread_mutex_unlock(&event_pool->mutex);
+
+    return shard;
+}
+
+/* Called by an event thread that is terminating, with event_pool->mutex
+ * held. The fds of its shard are given to other threads, or to the shared
+ * epoll instance if there are no other threads left. */
+static void
+event_shard_stop(struct event_pool *event_pool, int index)
+{
+    struct event_shard *shard = &event_pool->shards[index];
+    struct event_slot_table *table = NULL;
+    struct event_slot_epoll *slot = NULL;
+    int table_idx;
+    int j;
+
+    /* No new fds will be assigned to this shard. Registrations that
+     * already picked it check this flag after adding the fd (see
+     * event_register_epoll()). */
+    __atomic_store_n(&shard->active, 0, __ATOMIC_SEQ_CST);
+
+    if (event_pool->nested_shard == index)
+        __event_shard_unnest(event_pool);
+
+    for (table_idx = 0; table_idx < EVENT_EPOLL_TABLES; table_idx++) {
+        if (__atomic_load_n(&shard->count, __ATOMIC_RELAXED) == 0)
+            break;
+
+        table = event_table_get(event_pool, table_idx);
+        if (!table)
+            continue;
+
+        pthread_mutex_lock(&table->lock);
+        {
+            for (j = 0; j < EVENT_EPOLL_SLOTS; j++) {
+                slot = &table->slots[j];
+                if ((slot->fd == -1) || (slot->shard != index))
+                    continue;
+
+                LOCK(&slot->lock);
+                {
+                    /* Registrations in progress move the fd themselves. */
+                    if ((slot->shard == index) && (slot->handler != NULL))
+                        __event_slot_move(
+                            event_pool, slot,
+                            table_idx * EVENT_EPOLL_SLOTS + j,
+                            event_shard_least_loaded(event_pool));
+                }
+                UNLOCK(&slot->lock);
+            }
+        }
+        pthread_mutex_unlock(&table->lock);
+    }
+}
+
+/* Restricts the calling thread to the CPUs whose connections are assigned
+ * to it based on SO_INCOMING_CPU (see event_cpu_thread()), so that they are
+ * processed on the CPUs that receive their packets. Threads without CPUs,
+ * when there are more threads than CPUs, are left unbound. */
+static void
+event_thread_bind_cpu(struct event_pool *event_pool, int index, int threads)
+{
+    cpu_set_t cpus;
+    int found = 0;
+    int cpu;
+
+    CPU_ZERO(&cpus);
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (event_cpu_thread(event_pool, cpu, threads) == index) {
+            CPU_SET(cpu, &cpus);
+            found = 1;
+        }
+    }
+
+    if (found)
+        (void)pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
 int
 event_register_epoll(struct event_pool *event_pool, int fd,
                      event_handler_t handler, void *data, int poll_in,
@@ -354,11 +810,13 @@ event_register_epoll(struct event_pool *event_pool, int fd,
     int idx = -1;
     int ret = -1;
     int destroy = 0;
+    int epfd = -1;
     struct epoll_event epoll_event = {
         0,
     };
     struct event_data *ev_data = (void *)&epoll_event.data;
     struct event_slot_epoll *slot = NULL;
+    int shard = -1;
 
     GF_VALIDATE_OR_GOTO("event", event_pool, out);
 
@@ -380,7 +838,10 @@ event_register_epoll(struct event_pool *event_pool, int fd,
     if (destroy == 1)
         goto out;
 
-    idx = event_slot_alloc(event_pool, fd, notify_poller_death, &slot);
+    if (event_pool->sharded)
+        shard = event_shard_pick(event_pool, fd);
+
+    idx = event_slot_alloc(event_pool, fd, notify_poller_death, shard, &slot);
     if (idx == -1) {
         gf_smsg("epoll", GF_LOG_ERROR, 0, LG_MSG_SLOT_NOT_FOUND, "fd=%d", fd,
                 NULL);
@@ -398,9 +859,14 @@ event_register_epoll(struct event_pool *event_pool, int fd,
            thread has picked up and is processing an event,
            another poller will not try to pick this at the same
            time as well.
+
+           This is not needed if the fd belongs to a shard: only
+           the owner of the shard waits on it.
         */
 
-        slot->events = EPOLLPRI | EPOLLHUP | EPOLLERR | EPOLLONESHOT;
+        slot->events = EPOLLPRI | EPOLLHUP | EPOLLERR;
+        if (slot->shard < 0)
+            slot->events |= EPOLLONESHOT;
         slot->handler = handler;
         slot->data = data;
 
@@ -410,7 +876,19 @@ event_register_epoll(struct event_pool *event_pool, int fd,
         ev_data->idx = idx;
         ev_data->gen = slot->gen;
 
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_ADD, fd, &epoll_event);
+        epfd = event_slot_epfd(event_pool, slot);
+        ret = epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &epoll_event);
+        if (ret == 0) {
+            slot->armed = slot->events;
+
+            /* The owner of the shard may have terminated after the shard
+             * was picked and before the fd was added. */
+            if ((slot->shard >= 0) &&
+                !__atomic_load_n(&event_pool->shards[slot->shard].active,
+                                 __ATOMIC_SEQ_CST))
+                __event_slot_move(event_pool, slot, idx,
+                                  event_shard_pick(event_pool, fd));
+        }
         /* check ret after UNLOCK() to avoid deadlock in
            event_slot_unref()
         */
@@ -419,7 +897,7 @@ event_register_epoll(struct event_pool *event_pool, int fd,
 
     if (ret == -1) {
         gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_ADD_FAILED,
-                "fd=%d", fd, "epoll_fd=%d", event_pool->fd, NULL);
+                "fd=%d", fd, "epoll_fd=%d", epfd, NULL);
         event_slot_unref(event_pool, slot, idx);
         idx = -1;
     }
@@ -457,11 +935,13 @@ event_unregister_epoll_common(struct event_pool *event_pool, int fd, int idx,
 
     LOCK(&slot->lock);
     {
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_DEL, fd, NULL);
+        ret = epoll_ctl(event_slot_epfd(event_pool, slot), EPOLL_CTL_DEL, fd,
+                        NULL);
 
         if (ret == -1) {
             gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_DEL_FAILED,
-                    "fd=%d", fd, "epoll_fd=%d", event_pool->fd, NULL);
+                    "fd=%d", fd, "epoll_fd=%d",
+                    event_slot_epfd(event_pool, slot), NULL);
             goto unlock;
         }
 
@@ -535,10 +1015,17 @@ event_select_on_epoll(struct event_pool *event_pool, int fd, int idx,
              */
             goto unlock;
 
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_MOD, fd, &epoll_event);
+        if (slot->armed == slot->events)
+            /* Nothing has changed. */
+            goto unlock;
+
+        ret = epoll_ctl(event_slot_epfd(event_pool, slot), EPOLL_CTL_MOD, fd,
+                        &epoll_event);
         if (ret == -1) {
             gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_MODIFY_FAILED,
                     "fd=%d", fd, "events=%d", epoll_event.events, NULL);
+        } else {
+            slot->armed = slot->events;
         }
     }
 unlock:
@@ -568,6 +1055,14 @@ event_dispatch_epoll_handler(struct event_pool *event_pool,
     handler = NULL;
     data = NULL;
 
+    if (ev_data->idx == EVENT_EPOLL_NESTED_IDX) {
+        /* The shared epoll instance has events. Other threads may have
+         * been woken up too, so it's not an error if there's none left. */
+        ret = epoll_wait(event_pool->fd, event, 1, 0);
+        if (ret <= 0)
+            return 0;
+    }
+
     idx = ev_data->idx;
     gen = ev_data->gen;
 
@@ -597,17 +1092,24 @@ event_dispatch_epoll_handler(struct event_pool *event_pool,
             goto pre_unlock;
         }
 
+        if (slot->shard < 0) {
+            /* EPOLLONESHOT has disarmed the fd. */
+            slot->armed = 0;
+        }
+
         handler = slot->handler;
         data = slot->data;
 
         if (slot->in_handler > 0) {
             /* Another handler is inprogress, skip this one. */
             handler = NULL;
+            __event_slot_disarm(event_pool, slot, idx);
             goto pre_unlock;
         }
 
         if (slot->handled_error) {
             handled_error_previously = _gf_true;
+            __event_slot_disarm(event_pool, slot, idx);
         } else {
             slot->handled_error = (event->events & (EPOLLERR | EPOLLHUP));
             slot->in_handler++;
@@ -641,6 +1143,9 @@ event_dispatch_epoll_worker(void *data)
     struct event_pool *event_pool;
     int myindex;
     int timetodie = 0, gen = 0;
+    int pinned = 0, cpu_pinned = 0;
+    int shard_failed = 0;
+    struct event_shard *shard = NULL;
     struct list_head poller_death_notify;
     struct event_slot_epoll *slot = NULL, *tmp = NULL;
 
@@ -678,6 +1183,11 @@ event_dispatch_epoll_worker(void *data)
                     INIT_LIST_HEAD(&poller_death_notify);
                     /* if found true in critical section,
                      * die */
+                    /* Done before clearing pollers[] so that a new
+                     * thread with the same index can't start using
+                     * the shard while it's being emptied. */
+                    if (shard)
+                        event_shard_stop(event_pool, myindex - 1);
                     event_pool->pollers[myindex - 1] = 0;
                     event_pool->activethreadcount--;
                     timetodie = 1;
@@ -723,7 +1233,34 @@ event_dispatch_epoll_worker(void *data)
             }
         }
 
-        ret = epoll_wait(event_pool->fd, &event, 1, -1);
+        /* Once the thread is using its shard it never goes back to the
+         * shared epoll instance, which may be nested inside another shard.
+         * Disabling the sharded mode only stops assigning new fds to the
+         * shards. */
+        if (caa_unlikely(event_pool->sharded && !shard && !shard_failed)) {
+            shard = event_shard_start(event_pool, myindex - 1);
+            shard_failed = (shard == NULL);
+        }
+
+        /* The CPUs of each thread depend on the number of threads, so they
+         * are bound again when it changes. This binding takes precedence
+         * over NUMA pinning, which is skipped for these threads. */
+        if (caa_unlikely(shard &&
+                         (event_pool->balance == EVENT_BALANCE_INCOMING_CPU) &&
+                         (cpu_pinned != event_shard_threads(event_pool)))) {
+            cpu_pinned = event_shard_threads(event_pool);
+            event_thread_bind_cpu(event_pool, myindex - 1, cpu_pinned);
+        }
+
+        if (caa_unlikely(event_pool->numa_pin && !pinned && !cpu_pinned)) {
+            (void)gf_numa_thread_bind((myindex - 1) % gf_numa_node_count());
+            pinned = 1;
+        }
+
+        if (shard)
+            ret = epoll_wait(shard->fd, &event, 1, EVENT_EPOLL_SHARD_TIMEOUT);
+        else
+            ret = epoll_wait(event_pool->fd, &event, 1, -1);
 
         if (ret == 0)
             /* timeout */
@@ -922,7 +1459,14 @@ static int
 event_pool_destroy_epoll(struct event_pool *event_pool)
 {
     int ret = 0, i = 0, j = 0;
-    struct event_slot_epoll *table = NULL;
+    struct event_slot_table *table = NULL;
+
+    for (i = 0; i < EVENT_MAX_THREADS; i++) {
+        if (event_pool->shards[i].fd != -1)
+            sys_close(event_pool->shards[i].fd);
+    }
+    GF_FREE(event_pool->shards);
+    GF_FREE(event_pool->cpu_pos);
 
     ret = sys_close(event_pool->fd);
 
@@ -931,9 +1475,10 @@ event_pool_destroy_epoll(struct event_pool *event_pool)
             table = event_pool->ereg[i];
             event_pool->ereg[i] = NULL;
             for (j = 0; j < EVENT_EPOLL_SLOTS; j++) {
-                if (table[j].fd != -1)
-                    LOCK_DESTROY(&table[j].lock);
+                if (table->slots[j].fd != -1)
+                    LOCK_DESTROY(&table->slots[j].lock);
             }
+            pthread_mutex_destroy(&table->lock);
             GF_FREE(table);
         }
     }
@@ -987,12 +1532,17 @@ event_handled_epoll(struct event_pool *event_pool, int fd, int idx, int gen)
            thread calling event_select_on_epoll() while this
            thread was busy in handler()
         */
-        else if (slot->in_handler == 0) {
+        else if ((slot->in_handler == 0) && (slot->armed != slot->events)) {
+            /* fds of a shard remain armed while the handler runs, so
+               normally nothing needs to be done for them. */
             epoll_event.events = slot->events;
             ev_data->idx = idx;
             ev_data->gen = gen;
 
-            ret = epoll_ctl(event_pool->fd, EPOLL_CTL_MOD, fd, &epoll_event);
+            ret = epoll_ctl(event_slot_epfd(event_pool, slot), EPOLL_CTL_MOD,
+                            fd, &epoll_event);
+            if (ret == 0)
+                slot->armed = slot->events;
         }
     }
 unlock:
@@ -79,6 +79,25 @@ gf_io_legacy_callback(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
     return 0;
 }
 
+/* Filesystem requests are executed synchronously in the context of the
+ * caller. The callback is also executed immediately. */
+#define GF_IO_LEGACY_FS(_name, _type)                                          \
+    static uint64_t gf_io_legacy_##_name(uint64_t seq, uint64_t id,            \
+                                         gf_io_op_t *op, uint32_t count)       \
+    {                                                                          \
+        gf_io_legacy_cbk(id, gf_io_fs_sync(_type, op));                        \
+                                                                               \
+        return 0;                                                              \
+    }
+
+GF_IO_LEGACY_FS(openat, GF_IO_FS_OPENAT)
+GF_IO_LEGACY_FS(statx, GF_IO_FS_STATX)
+GF_IO_LEGACY_FS(fgetxattr, GF_IO_FS_FGETXATTR)
+GF_IO_LEGACY_FS(fsetxattr, GF_IO_FS_FSETXATTR)
+GF_IO_LEGACY_FS(fallocate, GF_IO_FS_FALLOCATE)
+GF_IO_LEGACY_FS(unlinkat, GF_IO_FS_UNLINKAT)
+GF_IO_LEGACY_FS(renameat, GF_IO_FS_RENAMEAT)
+
 const gf_io_engine_t gf_io_engine_legacy = {
     .name = "legacy",
     .mode = GF_IO_MODE_LEGACY,
@@ -95,5 +114,16 @@ const gf_io_engine_t gf_io_engine_legacy = {
     .flush = gf_io_legacy_flush,
 
     .cancel = gf_io_legacy_cancel,
-    .callback = gf_io_legacy_callback
+    .callback = gf_io_legacy_callback,
+
+    .personality_register = NULL,
+    .personality_unregister = NULL,
+
+    .openat = gf_io_legacy_openat,
+    .statx = gf_io_legacy_statx,
+    .fgetxattr = gf_io_legacy_fgetxattr,
+    .fsetxattr = gf_io_legacy_fsetxattr,
+    .fallocate = gf_io_legacy_fallocate,
+    .unlinkat = gf_io_legacy_unlinkat,
+    .renameat = gf_io_legacy_renameat
 };
@@ -58,6 +58,11 @@
  * different operations to cancel a normal operation or a timer. */
 #define GF_IO_URING_FLAG_TIMER GF_IO_ID_FLAG_1
 
+/* Private flag to identify requests that have been executed synchronously
+ * because the kernel doesn't support them. A NOP is sent instead and the
+ * real result is taken from the request itself when it completes. */
+#define GF_IO_URING_FLAG_EMULATED GF_IO_ID_FLAG_2
+
 /* Helper macro to define names of bits. */
 #define GF_IO_BITNAME(_prefix, _name) { _prefix##_##_name, #_name }
 
@@ -110,6 +115,9 @@ typedef struct _gf_io_uring {
 /* Global io_uring state. */
 static gf_io_uring_t gf_io_uring = {};
 
+/* Bitmap of the operations supported by the kernel. */
+static uint64_t gf_io_uring_ops[256 / 64];
+
 /* io_uring_setup() system call. */
 static int32_t
 io_uring_setup(uint32_t entries, struct io_uring_params *params)
@@ -240,7 +248,15 @@ gf_io_uring_dump_ops(struct io_uring_probe *probe)
         [IORING_OP_TEE] = "TEE",
         [IORING_OP_SHUTDOWN] = "SHUTDOWN",
         [IORING_OP_RENAMEAT] = "RENAMEAT",
-        [IORING_OP_UNLINKAT] = "UNLINKAT"
+        [IORING_OP_UNLINKAT] = "UNLINKAT",
+        [IORING_OP_MKDIRAT] = "MKDIRAT",
+        [IORING_OP_SYMLINKAT] = "SYMLINKAT",
+        [IORING_OP_LINKAT] = "LINKAT",
+        [IORING_OP_MSG_RING] = "MSG_RING",
+        [IORING_OP_FSETXATTR] = "FSETXATTR",
+        [IORING_OP_SETXATTR] = "SETXATTR",
+        [IORING_OP_FGETXATTR] = "FGETXATTR",
+        [IORING_OP_GETXATTR] = "GETXATTR"
     };
 
     char names[4096];
@@ -387,7 +403,7 @@ static int32_t
 gf_io_uring_setup(void)
 {
     struct io_uring_probe *probe;
-    uint32_t i, count, feats;
+    uint32_t i, op, count, feats;
     int32_t fd, res;
 
     memset(&gf_io_uring.params, 0, sizeof(gf_io_uring.params));
@@ -455,6 +471,16 @@ gf_io_uring_setup(void)
     /* TODO: we may check if the system supports the required subset of
      *       operations. */
 
+    /* Remember which operations are supported. Unsupported filesystem
+     * operations will be executed synchronously. */
+    memset(gf_io_uring_ops, 0, sizeof(gf_io_uring_ops));
+    for (i = 0; i < probe->ops_len; i++) {
+        if ((probe->ops[i].flags & IO_URING_OP_SUPPORTED) != 0) {
+            op = probe->ops[i].op;
+            gf_io_uring_ops[op / 64] |= 1ULL << (op % 64);
+        }
+    }
+
     gf_io_uring.fd = fd;
 
     /* Preinitialize the SQ array. The mapping with SQEs is fixed. */
@@ -575,6 +601,11 @@ gf_io_uring_cq_process(gf_io_worker_t *worker)
 
         head = uatomic_cmpxchg(gf_io_uring.cq.head, current, current + 1);
         if (caa_likely(head == current)) {
+            if (caa_unlikely((cqe.user_data & GF_IO_URING_FLAG_EMULATED) !=
+                             0)) {
+                cqe.res = gf_io.op_pool[cqe.user_data & GF_IO_ID_REQ_MASK]
+                              .fs.res;
+            }
             gf_io_cbk(worker, current, cqe.user_data, cqe.res);
 
             return true;
@@ -835,6 +866,7 @@ gf_io_uring_cancel(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
     sqe->addr = ref;
     sqe->len = 0;
     sqe->timeout_flags = 0;
+    sqe->personality = 0;
 
     return gf_io_uring_common(seq, id, sqe, count);
 }
@@ -854,6 +886,194 @@ gf_io_uring_callback(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
     sqe->addr = 0;
     sqe->len = 0;
     sqe->rw_flags = 0;
+    sqe->personality = 0;
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+/* A personality is a snapshot of the credentials of the caller taken by the
+ * kernel. Requests that reference it are executed with those credentials,
+ * independently of which thread flushes the SQ. */
+static int32_t
+gf_io_uring_personality_register(void)
+{
+    return gf_io_call_errno(io_uring_register, gf_io_uring.fd,
+                            IORING_REGISTER_PERSONALITY, NULL, 0);
+}
+
+static void
+gf_io_uring_personality_unregister(uint16_t personality)
+{
+    gf_io_call_errno0(io_uring_register, gf_io_uring.fd,
+                      IORING_UNREGISTER_PERSONALITY, NULL, personality);
+}
+
+/* Check if the kernel supports a given operation. */
+static bool
+gf_io_uring_supported(uint32_t opcode)
+{
+    return (gf_io_uring_ops[opcode / 64] & (1ULL << (opcode % 64))) != 0;
+}
+
+/* Prepare a SQE for a filesystem operation. If the kernel doesn't support
+ * it, the operation is executed synchronously and a NOP is sent instead so
+ * that the completion is still processed through the CQ. Returns false in
+ * that case. */
+static bool
+gf_io_uring_fs_prepare(struct io_uring_sqe *sqe, uint64_t *id, gf_io_op_t *op,
+                       gf_io_fs_type_t type, uint32_t opcode)
+{
+    sqe->flags = 0;
+    sqe->ioprio = 0;
+
+    if (caa_likely(gf_io_uring_supported(opcode))) {
+        sqe->opcode = opcode;
+        sqe->fd = op->fs.fd;
+        sqe->personality = op->fs.personality;
+
+        return true;
+    }
+
+    /* The request is executed by the submitter, so the personality is not
+     * used. The caller must have switched to the same credentials. */
+    op->fs.res = gf_io_fs_sync(type, op);
+    *id |= GF_IO_URING_FLAG_EMULATED;
+
+    sqe->opcode = IORING_OP_NOP;
+    sqe->personality = 0;
+    sqe->fd = -1;
+    sqe->off = 0;
+    sqe->addr = 0;
+    sqe->len = 0;
+    sqe->rw_flags = 0;
+
+    return false;
+}
+
+/* All the operation specific '*_flags' fields of a SQE are aliases of
+ * 'rw_flags'. It's used in all cases to not depend on recent kernel
+ * headers. */
+
+static uint64_t
+gf_io_uring_openat(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+    if (gf_io_uring_fs_prepare(sqe, &id, op, GF_IO_FS_OPENAT,
+                               IORING_OP_OPENAT)) {
+        sqe->off = 0;
+        sqe->addr = (uintptr_t)op->fs.path;
+        sqe->len = op->fs.open.mode;
+        sqe->rw_flags = op->fs.flags;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_statx(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+    if (gf_io_uring_fs_prepare(sqe, &id, op, GF_IO_FS_STATX,
+                               IORING_OP_STATX)) {
+        sqe->off = (uintptr_t)op->fs.statx.buf;
+        sqe->addr = (uintptr_t)op->fs.path;
+        sqe->len = op->fs.statx.mask;
+        sqe->rw_flags = op->fs.flags;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_fgetxattr(uint64_t seq, uint64_t id, gf_io_op_t *op,
+                      uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+    if (gf_io_uring_fs_prepare(sqe, &id, op, GF_IO_FS_FGETXATTR,
+                               IORING_OP_FGETXATTR)) {
+        sqe->off = (uintptr_t)op->fs.xattr.value;
+        sqe->addr = (uintptr_t)op->fs.path;
+        sqe->len = op->fs.xattr.size;
+        sqe->rw_flags = 0;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_fsetxattr(uint64_t seq, uint64_t id, gf_io_op_t *op,
+                      uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+    if (gf_io_uring_fs_prepare(sqe, &id, op, GF_IO_FS_FSETXATTR,
+                               IORING_OP_FSETXATTR)) {
+        sqe->off = (uintptr_t)op->fs.xattr.value;
+        sqe->addr = (uintptr_t)op->fs.path;
+        sqe->len = op->fs.xattr.size;
+        sqe->rw_flags = op->fs.flags;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_fallocate(uint64_t seq, uint64_t id, gf_io_op_t *op,
+                      uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+    if (gf_io_uring_fs_prepare(sqe, &id, op, GF_IO_FS_FALLOCATE,
+                               IORING_OP_FALLOCATE)) {
+        sqe->off = op->fs.fallocate.offset;
+        sqe->addr = op->fs.fallocate.length;
+        sqe->len = op->fs.fallocate.mode;
+        sqe->rw_flags = 0;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_unlinkat(uint64_t seq, uint64_t id, gf_io_op_t *op,
+                     uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+    if (gf_io_uring_fs_prepare(sqe, &id, op, GF_IO_FS_UNLINKAT,
+                               IORING_OP_UNLINKAT)) {
+        sqe->off = 0;
+        sqe->addr = (uintptr_t)op->fs.path;
+        sqe->len = 0;
+        sqe->rw_flags = op->fs.flags;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_renameat(uint64_t seq, uint64_t id, gf_io_op_t *op,
+                     uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+    if (gf_io_uring_fs_prepare(sqe, &id, op, GF_IO_FS_RENAMEAT,
+                               IORING_OP_RENAMEAT)) {
+        sqe->off = (uintptr_t)op->fs.rename.path;
+        sqe->addr = (uintptr_t)op->fs.path;
+        sqe->len = op->fs.rename.fd;
+        sqe->rw_flags = op->fs.flags;
+    }
 
     return gf_io_uring_common(seq, id, sqe, count);
 }
@@ -874,5 +1094,16 @@ const gf_io_engine_t gf_io_engine_io_uring = {
     .flush = gf_io_uring_flush,
 
     .cancel = gf_io_uring_cancel,
-    .callback = gf_io_uring_callback
+    .callback = gf_io_uring_callback,
+
+    .personality_register = gf_io_uring_personality_register,
+    .personality_unregister = gf_io_uring_personality_unregister,
+
+    .openat = gf_io_uring_openat,
+    .statx = gf_io_uring_statx,
+    .fgetxattr = gf_io_uring_fgetxattr,
+    .fsetxattr = gf_io_uring_fsetxattr,
+    .fallocate = gf_io_uring_fallocate,
+    .unlinkat = gf_io_uring_unlinkat,
+    .renameat = gf_io_uring_renameat
 };
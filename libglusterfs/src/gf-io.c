@@ -538,3 +538,66 @@ gf_io_run(const char *name, gf_io_handlers_t *handlers, void *data)
 
     return -ENXIO;
 }
+
+/* Synchronous execution of filesystem requests for engines that can't
+ * process them natively. */
+int32_t
+gf_io_fs_sync(gf_io_fs_type_t type, gf_io_op_t *op)
+{
+    switch (type) {
+        case GF_IO_FS_OPENAT:
+            return gf_io_convert_from_errno(sys_openat(
+                op->fs.fd, op->fs.path, op->fs.flags, op->fs.open.mode));
+        case GF_IO_FS_STATX:
+            return gf_io_convert_from_errno0(
+                sys_statx(op->fs.fd, op->fs.path, op->fs.flags,
+                          op->fs.statx.mask, op->fs.statx.buf));
+        case GF_IO_FS_FGETXATTR:
+            return gf_io_convert_from_errno(
+                sys_fgetxattr(op->fs.fd, op->fs.path, op->fs.xattr.value,
+                              op->fs.xattr.size));
+        case GF_IO_FS_FSETXATTR:
+            return gf_io_convert_from_errno0(
+                sys_fsetxattr(op->fs.fd, op->fs.path, op->fs.xattr.value,
+                              op->fs.xattr.size, op->fs.flags));
+        case GF_IO_FS_FALLOCATE:
+            return gf_io_convert_from_errno0(sys_fallocate(
+                op->fs.fd, op->fs.fallocate.mode, op->fs.fallocate.offset,
+                op->fs.fallocate.length));
+        case GF_IO_FS_UNLINKAT:
+            if (op->fs.flags != 0) {
+                return -EINVAL;
+            }
+            return gf_io_convert_from_errno0(
+                sys_unlinkat(op->fs.fd, op->fs.path));
+        case GF_IO_FS_RENAMEAT:
+            if (op->fs.flags != 0) {
+                return -EINVAL;
+            }
+            return gf_io_convert_from_errno0(
+                sys_renameat(op->fs.fd, op->fs.path, op->fs.rename.fd,
+                             op->fs.rename.path));
+        default:
+            break;
+    }
+
+    return -ENOSYS;
+}
+
+int32_t
+gf_io_personality_register(void)
+{
+    if (gf_io.engine.personality_register == NULL) {
+        return 0;
+    }
+
+    return gf_io.engine.personality_register();
+}
+
+void
+gf_io_personality_unregister(uint16_t personality)
+{
+    if ((personality != 0) && (gf_io.engine.personality_unregister != NULL)) {
+        gf_io.engine.personality_unregister(personality);
+    }
+}
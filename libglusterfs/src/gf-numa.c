@@ -0,0 +1,304 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <https://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#ifdef GF_LINUX_HOST_OS
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include "glusterfs/gf-numa.h"
+#include "glusterfs/syscall.h"
+#include "glusterfs/logging.h"
+#include "glusterfs/libglusterfs-messages.h"
+
+#define GF_NUMA_SYSFS_PATH "/sys/devices/system/node"
+
+static pthread_once_t gf_numa_once = PTHREAD_ONCE_INIT;
+
+static int gf_numa_nodes = 1;
+
+#ifdef GF_LINUX_HOST_OS
+
+/* Highest node id that can be used in a memory policy. */
+#define GF_NUMA_MAX_NODE_ID 1023
+
+/* Nodes are identified by a dense index from 0 to gf_numa_nodes - 1, in
+ * the order of their ids. Only online nodes with CPUs get an index, since
+ * no thread can be local to a memory-only node. Node ids can be sparse, so
+ * the index of a node is not always the same as its id. */
+
+/* Index of the node of each CPU. CPUs not found in sysfs are assumed to be
+ * in the first node. */
+static unsigned char gf_numa_cpu_node[CPU_SETSIZE];
+
+static cpu_set_t gf_numa_node_cpus[GF_NUMA_MAX_NODES];
+
+/* Id of the node used for memory allocations of each index. */
+static int gf_numa_node_id[GF_NUMA_MAX_NODES];
+
+static unsigned int gf_numa_rr = 0;
+
+/* Node the thread has been bound to, plus one (0 means not bound). */
+static __thread int gf_numa_thread_node = 0;
+
+static ssize_t
+gf_numa_read(const char *path, char *buffer, size_t size)
+{
+    ssize_t len;
+    int fd;
+
+    fd = sys_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    len = sys_read(fd, buffer, size - 1);
+    if (len < 0) {
+        len = -errno;
+    } else {
+        buffer[len] = 0;
+    }
+
+    sys_close(fd);
+
+    return len;
+}
+
+/* Parses a list in sysfs format ("0-3,8,10-11") and calls @fn for each of
+ * the numbers it contains. */
+static void
+gf_numa_parse_list(char *list, void (*fn)(void *, int), void *data)
+{
+    char *ptr = list;
+    long first, last;
+
+    while (*ptr != 0) {
+        first = strtol(ptr, &ptr, 10);
+        last = first;
+        if (*ptr == '-') {
+            last = strtol(ptr + 1, &ptr, 10);
+        }
+        while ((first <= last) && (first >= 0)) {
+            fn(data, first++);
+        }
+
+        while ((*ptr != 0) && ((*ptr < '0') || (*ptr > '9'))) {
+            ptr++;
+        }
+    }
+}
+
+struct gf_numa_scan {
+    int index; /* index of the node being scanned */
+    int cpus;  /* number of CPUs found in the node */
+};
+
+static void
+gf_numa_add_cpu(void *data, int cpu)
+{
+    struct gf_numa_scan *scan = data;
+    int node = scan->index % GF_NUMA_MAX_NODES;
+
+    if (cpu < CPU_SETSIZE) {
+        gf_numa_cpu_node[cpu] = node;
+        CPU_SET(cpu, &gf_numa_node_cpus[node]);
+        scan->cpus++;
+    }
+}
+
+static void
+gf_numa_add_node(void *data, int id)
+{
+    struct gf_numa_scan *scan = data;
+    char path[64];
+    char buffer[4096];
+
+    if (id > GF_NUMA_MAX_NODE_ID) {
+        return;
+    }
+
+    snprintf(path, sizeof(path), GF_NUMA_SYSFS_PATH "/node%d/cpulist", id);
+    if (gf_numa_read(path, buffer, sizeof(buffer)) <= 0) {
+        return;
+    }
+
+    scan->cpus = 0;
+    gf_numa_parse_list(buffer, gf_numa_add_cpu, scan);
+    if (scan->cpus == 0) {
+        return;
+    }
+
+    /* Nodes beyond the limit share the index of a lower node, and its
+     * memory. */
+    if (scan->index < GF_NUMA_MAX_NODES) {
+        gf_numa_node_id[scan->index] = id;
+    }
+    scan->index++;
+}
+
+/* This can be called from the memory pools code, so it must not log nor
+ * allocate memory. */
+static void
+gf_numa_init(void)
+{
+    struct gf_numa_scan scan = {
+        0,
+    };
+    char buffer[4096];
+
+    if (gf_numa_read(GF_NUMA_SYSFS_PATH "/online", buffer, sizeof(buffer)) <=
+        0) {
+        return;
+    }
+    gf_numa_parse_list(buffer, gf_numa_add_node, &scan);
+
+    if (scan.index > GF_NUMA_MAX_NODES) {
+        scan.index = GF_NUMA_MAX_NODES;
+    }
+    if (scan.index > 0) {
+        gf_numa_nodes = scan.index;
+    }
+}
+
+int
+gf_numa_node_count(void)
+{
+    (void)pthread_once(&gf_numa_once, gf_numa_init);
+
+    return gf_numa_nodes;
+}
+
+int
+gf_numa_node_current(void)
+{
+    int cpu;
+
+    if (gf_numa_node_count() == 1) {
+        return 0;
+    }
+
+    if (gf_numa_thread_node != 0) {
+        return gf_numa_thread_node - 1;
+    }
+
+    cpu = sched_getcpu();
+    if ((cpu < 0) || (cpu >= CPU_SETSIZE)) {
+        return 0;
+    }
+
+    return gf_numa_cpu_node[cpu];
+}
+
+int
+gf_numa_node_next(void)
+{
+    int count = gf_numa_node_count();
+
+    return __atomic_fetch_add(&gf_numa_rr, 1, __ATOMIC_RELAXED) % count;
+}
+
+int
+gf_numa_thread_bind(int node)
+{
+    int ret;
+
+    if (gf_numa_node_count() == 1) {
+        return 0;
+    }
+
+    node %= gf_numa_nodes;
+
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                 &gf_numa_node_cpus[node]);
+    if (ret != 0) {
+        gf_smsg("numa", GF_LOG_WARNING, ret, LG_MSG_NUMA_BIND_FAILED,
+                "node=%d", node, NULL);
+        return -ret;
+    }
+
+    gf_numa_thread_node = node + 1;
+
+    return 0;
+}
+
+int
+gf_numa_memory_bind(void *addr, size_t size, int node)
+{
+    unsigned long mask[(GF_NUMA_MAX_NODE_ID + 1) / (sizeof(long) * 8)] = {
+        0,
+    };
+    int id;
+
+    if (gf_numa_node_count() == 1) {
+        return 0;
+    }
+
+    id = gf_numa_node_id[node % gf_numa_nodes];
+    mask[id / (sizeof(long) * 8)] = 1UL << (id % (sizeof(long) * 8));
+
+    /* MPOL_PREFERRED lets the kernel fall back to other nodes when the
+     * preferred one is out of memory. */
+    if (syscall(SYS_mbind, addr, size, MPOL_PREFERRED, mask,
+                sizeof(mask) * 8, 0) < 0) {
+        return -errno;
+    }
+
+    return 0;
+}
+
+#else /* !GF_LINUX_HOST_OS */
+
+static void
+gf_numa_init(void)
+{
+}
+
+int
+gf_numa_node_count(void)
+{
+    (void)pthread_once(&gf_numa_once, gf_numa_init);
+
+    return gf_numa_nodes;
+}
+
+int
+gf_numa_node_current(void)
+{
+    return 0;
+}
+
+int
+gf_numa_node_next(void)
+{
+    return 0;
+}
+
+int
+gf_numa_thread_bind(int node)
+{
+    return 0;
+}
+
+int
+gf_numa_memory_bind(void *addr, size_t size, int node)
+{
+    return 0;
+}
+
+#endif /* GF_LINUX_HOST_OS */
@@ -301,6 +301,8 @@ glusterfs_cleanup(void *ptr)
     }
 
     mem_pool_thread_destructor(NULL);
+    iobuf_cache_thread_destructor();
+    gf_pipe_thread_destructor();
 }
 
 void
@@ -11,6 +11,14 @@
 #ifndef __CHECKSUM_H__
 #define __CHECKSUM_H__
 
+#define GF_XXH64X2_DIGEST_LENGTH 16
+
+/* Key of the rchecksum xdata used to request a type of strong checksum. The
+ * answer contains the same key with the type that has been used, if it's
+ * not the default one. */
+#define GF_RCHECKSUM_TYPE "rchecksum-type"
+#define GF_RCHECKSUM_XXH64X2 "xxh64x2"
+
 uint32_t
 gf_rsync_weak_checksum(unsigned char *buf, size_t len);
 
@@ -19,4 +27,8 @@ gf_rsync_strong_checksum(unsigned char *buf, size_t len, unsigned char *sum);
 
 void
 gf_rsync_md5_checksum(unsigned char *data, size_t len, unsigned char *md5);
+
+int
+gf_rsync_xxh64x2_checksum(unsigned char *data, size_t len,
+                          unsigned char *xxh);
 #endif /* __CHECKSUM_H__ */
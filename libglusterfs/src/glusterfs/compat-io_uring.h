@@ -85,6 +85,16 @@
 #define IORING_FEAT_NATIVE_WORKERS  (1U << 9)
 #endif
 
+/* Register opcodes are also defined as an enum. */
+
+#ifndef IORING_REGISTER_PERSONALITY
+#define IORING_REGISTER_PERSONALITY   9U
+#endif
+
+#ifndef IORING_UNREGISTER_PERSONALITY
+#define IORING_UNREGISTER_PERSONALITY 10U
+#endif
+
 /* The operations are defined as an enum, so we don't have any way to check
  * their existence during preprocessing, but we need to have them. So here
  * are duplicated all the ops. The '#ifndef' shouldn't be necessary, but
@@ -238,4 +248,36 @@
 #define IORING_OP_UNLINKAT         36U
 #endif
 
+#ifndef IORING_OP_MKDIRAT
+#define IORING_OP_MKDIRAT          37U
+#endif
+
+#ifndef IORING_OP_SYMLINKAT
+#define IORING_OP_SYMLINKAT        38U
+#endif
+
+#ifndef IORING_OP_LINKAT
+#define IORING_OP_LINKAT           39U
+#endif
+
+#ifndef IORING_OP_MSG_RING
+#define IORING_OP_MSG_RING         40U
+#endif
+
+#ifndef IORING_OP_FSETXATTR
+#define IORING_OP_FSETXATTR        41U
+#endif
+
+#ifndef IORING_OP_SETXATTR
+#define IORING_OP_SETXATTR         42U
+#endif
+
+#ifndef IORING_OP_FGETXATTR
+#define IORING_OP_FGETXATTR        43U
+#endif
+
+#ifndef IORING_OP_GETXATTR
+#define IORING_OP_GETXATTR         44U
+#endif
+
 #endif /* __COMPAT_IO_URING_H__ */
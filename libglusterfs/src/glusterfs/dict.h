@@ -90,35 +90,59 @@ typedef struct _data_pair data_pair_t;
 #define DICT_DATA_HDR_KEY_LEN 4
 #define DICT_DATA_HDR_VAL_LEN 4
 
+/* Values up to this size are stored inside the data_t itself. This is enough
+ * for any 64-bit number in decimal and for a binary gfid, which are most of
+ * the values of xdata. A separate GF_MALLOC() of such a value costs a
+ * malloc()/free() pair plus GF_MEM_HEADER_SIZE and a trailer, which already
+ * take more memory than the inline buffer. */
+#define DICT_DATA_INLINE_SIZE 32
+/* Keys shorter than this are stored inside the data_pair_t itself. */
+#define DICT_KEY_INLINE_SIZE 32
+/* Number of pairs embedded in the dict_t. Most of the dictionaries used as
+ * xdata never need any other pair. */
+#define DICT_INLINE_PAIRS 4
+/* Dictionaries with at least this number of keys use an open addressing
+ * index to find them instead of walking the list of members. */
+#define DICT_INDEX_MIN_COUNT 16
+
 struct _data {
     char *data;
     gf_atomic_t refcount;
     gf_dict_data_type_t data_type;
     uint32_t len;
     uint32_t is_static;
+    char inline_data[DICT_DATA_INLINE_SIZE];
 };
 
 struct _data_pair {
-    struct _data_pair *hash_next;
+    struct _data_pair *prev;
     struct _data_pair *next;
     data_t *value;
     char *key;
     uint32_t key_hash;
+    uint32_t key_len;
+    /* The key has been allocated and needs to be released. */
+    gf_boolean_t key_alloc;
+    char key_inline[DICT_KEY_INLINE_SIZE];
 };
 
 struct _dict {
     uint64_t max_count;
+    /* Number of slots of the index (0 if there is no index). */
     int32_t hash_size;
     int32_t count;
     gf_atomic_t refcount;
     gf_lock_t lock;
+    /* Open addressing index of the pairs. Only allocated for dictionaries
+     * with many keys. */
     data_pair_t **members;
     data_pair_t *members_list;
-    data_pair_t free_pair;
-    data_pair_t *members_internal;
-    char *extra_stdfree;
+    /* Bitmap of the entries of inline_pairs currently in use. */
+    uint32_t inline_used;
     /* Variable to store total keylen + value->len */
     uint32_t totkvlen;
+    char *extra_stdfree;
+    data_pair_t inline_pairs[DICT_INLINE_PAIRS];
 };
 
 typedef gf_boolean_t (*dict_match_t)(dict_t *d, char *k, data_t *v, void *data);
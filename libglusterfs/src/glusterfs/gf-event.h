@@ -18,7 +18,8 @@
 struct event_pool;
 struct event_ops;
 struct event_slot_poll;
-struct event_slot_epoll;
+struct event_slot_table;
+struct event_shard;
 struct event_data {
     int idx;
     int gen;
@@ -32,6 +33,14 @@ typedef void (*event_handler_t)(int fd, int idx, int gen, void *data,
 #define EVENT_EPOLL_SLOTS 1024
 #define EVENT_MAX_THREADS 1024
 
+/* How new connections are distributed among the event threads when each
+ * thread has its own epoll instance. */
+typedef enum {
+    EVENT_BALANCE_ROUND_ROBIN,
+    EVENT_BALANCE_LEAST_LOADED,
+    EVENT_BALANCE_INCOMING_CPU, /* thread of the CPU given by SO_INCOMING_CPU */
+} event_balance_t;
+
 /* See rpcsvc.h to check why. */
 GF_STATIC_ASSERT(EVENT_MAX_THREADS % __BITS_PER_LONG == 0);
 
@@ -79,7 +88,25 @@ struct event_pool {
      */
     int auto_thread_count;
 
-    struct event_slot_epoll *ereg[EVENT_EPOLL_TABLES];
+    /* When set, each epoll worker restricts itself to the CPUs of one NUMA
+     * node, spreading the workers evenly across all the nodes. Workers bound
+     * to CPUs by the 'incoming-cpu' balance are not pinned to a node. */
+    gf_boolean_t numa_pin;
+
+    /* When set, each epoll worker waits on its own epoll instance, and new
+     * fds are assigned to one of the workers based on 'balance'. */
+    gf_boolean_t sharded;
+    event_balance_t balance;
+    unsigned int shard_rr;
+    struct event_shard *shards;
+    int nested_shard; /* shard where the shared epoll instance is nested,
+                         -1 if none. Protected by 'mutex'. */
+
+    /* Position of each CPU among the ones the process can run on, or -1.
+     * Maps CPUs to workers with the 'incoming-cpu' balance. */
+    short *cpu_pos;
+
+    struct event_slot_table *ereg[EVENT_EPOLL_TABLES];
     pthread_t pollers[EVENT_MAX_THREADS]; /* poller thread_id store, and live
                                              status */
 };
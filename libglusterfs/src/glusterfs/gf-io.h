@@ -22,6 +22,9 @@
 #include <glusterfs/gf-io-common.h>
 #include <glusterfs/syscall.h>
 
+/* Only used through pointers. It's defined in <sys/stat.h> on Linux. */
+struct statx;
+
 /* Some macros to deal with request IDs. */
 
 /* A request ID has 3 fields:
@@ -95,6 +98,18 @@ typedef struct _gf_io_op gf_io_op_t;
 struct _gf_io_request;
 typedef struct _gf_io_request gf_io_request_t;
 
+/* Enumeration of filesystem operations. */
+typedef enum _gf_io_fs_type {
+    GF_IO_FS_OPENAT,
+    GF_IO_FS_STATX,
+    GF_IO_FS_FGETXATTR,
+    GF_IO_FS_FSETXATTR,
+    GF_IO_FS_FALLOCATE,
+    GF_IO_FS_UNLINKAT,
+    GF_IO_FS_RENAMEAT,
+    GF_IO_FS_COUNT
+} gf_io_fs_type_t;
+
 /* Enumeration of all defined engines. */
 typedef enum _gf_io_mode {
     GF_IO_MODE_LEGACY,
@@ -198,6 +213,55 @@ struct _gf_io_op {
             /* Id of the request to cancel. */
             uint64_t id;
         } cancel;
+
+        /* Arguments of filesystem operations. */
+        struct {
+            /* File descriptor, or directory descriptor for path based
+             * operations. */
+            int32_t fd;
+
+            /* Flags of the operation. */
+            int32_t flags;
+
+            /* Credentials to use, as returned by
+             * gf_io_personality_register(). 0 means the credentials of the
+             * thread that submits the request. */
+            uint16_t personality;
+
+            /* Path of the file, or the name of the xattr. */
+            const char *path;
+
+            union {
+                struct {
+                    uint32_t mode;
+                } open;
+
+                struct {
+                    struct statx *buf;
+                    uint32_t mask;
+                } statx;
+
+                struct {
+                    uint64_t offset;
+                    uint64_t length;
+                    int32_t mode;
+                } fallocate;
+
+                struct {
+                    void *value;
+                    uint64_t size;
+                } xattr;
+
+                struct {
+                    const char *path;
+                    int32_t fd;
+                } rename;
+            };
+
+            /* Result of the operation when the engine needs to execute it
+             * synchronously. */
+            int32_t res;
+        } fs;
     };
 };
 
@@ -287,6 +351,23 @@ typedef struct _gf_io_engine {
     /* Function to call a callback in the background. */
     gf_io_engine_op_t callback;
 
+    /* Function to register the current credentials of the calling thread.
+     * It can be NULL if the engine always executes filesystem requests in
+     * the context of the submitter. */
+    int32_t (*personality_register)(void);
+
+    /* Function to release credentials previously registered. */
+    void (*personality_unregister)(uint16_t personality);
+
+    /* Filesystem operations. */
+    gf_io_engine_op_t openat;
+    gf_io_engine_op_t statx;
+    gf_io_engine_op_t fgetxattr;
+    gf_io_engine_op_t fsetxattr;
+    gf_io_engine_op_t fallocate;
+    gf_io_engine_op_t unlinkat;
+    gf_io_engine_op_t renameat;
+
     /* Mode of operation of the engine. */
     gf_io_mode_t mode;
 } gf_io_engine_t;
@@ -335,6 +416,20 @@ gf_io_mode(void)
     return gf_io.engine.mode;
 }
 
+/* Check if the I/O framework has been started in this process. */
+static inline bool
+gf_io_running(void)
+{
+    return (gf_io.engine.name != NULL) && !gf_io.shutdown;
+}
+
+/* Make sure that all requests already submitted are sent to the engine. */
+static inline void
+gf_io_flush(void)
+{
+    gf_io.engine.flush();
+}
+
 /* Main entry point to the I/O framework. It starts everything and controls
  * execution. It doesn't return until the process is going to terminate. */
 int32_t
@@ -602,4 +697,268 @@ gf_io_async_prepare(gf_io_request_t *req, gf_io_async_t async, void *data,
     gf_io_async_common(&req->op, async, cbk, data);
 }
 
+/* Common initialization of filesystem operations. */
+static inline void
+gf_io_fs_common(gf_io_op_t *op, int32_t fd, const char *path, int32_t flags)
+{
+    op->fs.fd = fd;
+    op->fs.flags = flags;
+    op->fs.personality = 0;
+    op->fs.path = path;
+    op->fs.res = 0;
+}
+
+/* Execute a filesystem request with the credentials of a personality. It
+ * must be called after preparing the request. */
+static inline void
+gf_io_request_personality(gf_io_request_t *req, uint16_t personality)
+{
+    req->op.fs.personality = personality;
+}
+
+/* Operation 'openat' */
+
+static inline void
+gf_io_openat_common(gf_io_op_t *op, int32_t dfd, const char *path,
+                    int32_t flags, uint32_t mode)
+{
+    gf_io_fs_common(op, dfd, path, flags);
+    op->fs.open.mode = mode;
+}
+
+static inline uint64_t
+gf_io_openat(gf_io_callback_t cbk, int32_t dfd, const char *path,
+             int32_t flags, uint32_t mode, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_openat_common(op, dfd, path, flags, mode);
+
+    return gf_io.engine.openat(seq, id, op, 1);
+}
+
+static inline void
+gf_io_openat_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t dfd,
+                     const char *path, int32_t flags, uint32_t mode,
+                     void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.openat, cbk, data);
+    gf_io_openat_common(&req->op, dfd, path, flags, mode);
+}
+
+/* Operation 'statx' */
+
+static inline void
+gf_io_statx_common(gf_io_op_t *op, int32_t dfd, const char *path,
+                   int32_t flags, uint32_t mask, struct statx *buf)
+{
+    gf_io_fs_common(op, dfd, path, flags);
+    op->fs.statx.buf = buf;
+    op->fs.statx.mask = mask;
+}
+
+static inline uint64_t
+gf_io_statx(gf_io_callback_t cbk, int32_t dfd, const char *path,
+            int32_t flags, uint32_t mask, struct statx *buf, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_statx_common(op, dfd, path, flags, mask, buf);
+
+    return gf_io.engine.statx(seq, id, op, 1);
+}
+
+static inline void
+gf_io_statx_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t dfd,
+                    const char *path, int32_t flags, uint32_t mask,
+                    struct statx *buf, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.statx, cbk, data);
+    gf_io_statx_common(&req->op, dfd, path, flags, mask, buf);
+}
+
+/* Operations 'fgetxattr' and 'fsetxattr' */
+
+static inline void
+gf_io_xattr_common(gf_io_op_t *op, int32_t fd, const char *name, void *value,
+                   uint64_t size, int32_t flags)
+{
+    gf_io_fs_common(op, fd, name, flags);
+    op->fs.xattr.value = value;
+    op->fs.xattr.size = size;
+}
+
+static inline uint64_t
+gf_io_fgetxattr(gf_io_callback_t cbk, int32_t fd, const char *name,
+                void *value, uint64_t size, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_xattr_common(op, fd, name, value, size, 0);
+
+    return gf_io.engine.fgetxattr(seq, id, op, 1);
+}
+
+static inline void
+gf_io_fgetxattr_prepare(gf_io_request_t *req, gf_io_callback_t cbk,
+                        int32_t fd, const char *name, void *value,
+                        uint64_t size, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.fgetxattr, cbk, data);
+    gf_io_xattr_common(&req->op, fd, name, value, size, 0);
+}
+
+static inline uint64_t
+gf_io_fsetxattr(gf_io_callback_t cbk, int32_t fd, const char *name,
+                const void *value, uint64_t size, int32_t flags, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_xattr_common(op, fd, name, (void *)value, size, flags);
+
+    return gf_io.engine.fsetxattr(seq, id, op, 1);
+}
+
+static inline void
+gf_io_fsetxattr_prepare(gf_io_request_t *req, gf_io_callback_t cbk,
+                        int32_t fd, const char *name, const void *value,
+                        uint64_t size, int32_t flags, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.fsetxattr, cbk, data);
+    gf_io_xattr_common(&req->op, fd, name, (void *)value, size, flags);
+}
+
+/* Operation 'fallocate' */
+
+static inline void
+gf_io_fallocate_common(gf_io_op_t *op, int32_t fd, int32_t mode,
+                       uint64_t offset, uint64_t length)
+{
+    gf_io_fs_common(op, fd, NULL, 0);
+    op->fs.fallocate.offset = offset;
+    op->fs.fallocate.length = length;
+    op->fs.fallocate.mode = mode;
+}
+
+static inline uint64_t
+gf_io_fallocate(gf_io_callback_t cbk, int32_t fd, int32_t mode,
+                uint64_t offset, uint64_t length, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_fallocate_common(op, fd, mode, offset, length);
+
+    return gf_io.engine.fallocate(seq, id, op, 1);
+}
+
+static inline void
+gf_io_fallocate_prepare(gf_io_request_t *req, gf_io_callback_t cbk,
+                        int32_t fd, int32_t mode, uint64_t offset,
+                        uint64_t length, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.fallocate, cbk, data);
+    gf_io_fallocate_common(&req->op, fd, mode, offset, length);
+}
+
+/* Operation 'unlinkat' */
+
+static inline uint64_t
+gf_io_unlinkat(gf_io_callback_t cbk, int32_t dfd, const char *path,
+               int32_t flags, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_fs_common(op, dfd, path, flags);
+
+    return gf_io.engine.unlinkat(seq, id, op, 1);
+}
+
+static inline void
+gf_io_unlinkat_prepare(gf_io_request_t *req, gf_io_callback_t cbk,
+                       int32_t dfd, const char *path, int32_t flags,
+                       void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.unlinkat, cbk, data);
+    gf_io_fs_common(&req->op, dfd, path, flags);
+}
+
+/* Operation 'renameat' */
+
+static inline void
+gf_io_renameat_common(gf_io_op_t *op, int32_t old_dfd, const char *old_path,
+                      int32_t new_dfd, const char *new_path, int32_t flags)
+{
+    gf_io_fs_common(op, old_dfd, old_path, flags);
+    op->fs.rename.fd = new_dfd;
+    op->fs.rename.path = new_path;
+}
+
+static inline uint64_t
+gf_io_renameat(gf_io_callback_t cbk, int32_t old_dfd, const char *old_path,
+               int32_t new_dfd, const char *new_path, int32_t flags,
+               void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_renameat_common(op, old_dfd, old_path, new_dfd, new_path, flags);
+
+    return gf_io.engine.renameat(seq, id, op, 1);
+}
+
+static inline void
+gf_io_renameat_prepare(gf_io_request_t *req, gf_io_callback_t cbk,
+                       int32_t old_dfd, const char *old_path, int32_t new_dfd,
+                       const char *new_path, int32_t flags, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.renameat, cbk, data);
+    gf_io_renameat_common(&req->op, old_dfd, old_path, new_dfd, new_path,
+                          flags);
+}
+
+/* Register the current credentials (fsuid, fsgid and groups) of the calling
+ * thread so that filesystem requests can later be executed with them from
+ * any thread. Returns the personality to use in the requests, 0 if the
+ * engine doesn't need it, or a negative error code. */
+int32_t
+gf_io_personality_register(void);
+
+/* Release a personality returned by gf_io_personality_register(). There must
+ * not be pending requests using it. */
+void
+gf_io_personality_unregister(uint16_t personality);
+
+/* Synchronous implementation of filesystem operations. It's used by engines
+ * that don't support a given operation natively. Returns the result of the
+ * operation (negative errno on failure). */
+int32_t
+gf_io_fs_sync(gf_io_fs_type_t type, gf_io_op_t *op);
+
 #endif /* __GF_IO_H__ */
@@ -0,0 +1,47 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <https://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __GF_NUMA_H__
+#define __GF_NUMA_H__
+
+#include <stddef.h>
+
+/* Maximum number of NUMA nodes that are handled separately. Nodes beyond this
+ * limit are folded into the existing ones. */
+#define GF_NUMA_MAX_NODES 16
+
+/* Number of NUMA nodes of the system (at least 1). Only online nodes with
+ * CPUs are counted. All the functions identify nodes by their index, from
+ * 0 to the number of nodes minus 1, which doesn't need to match the node id
+ * used by the kernel. */
+int
+gf_numa_node_count(void);
+
+/* Node of the CPU where the calling thread is running right now, or the node
+ * the thread has been bound to with gf_numa_thread_bind(). */
+int
+gf_numa_node_current(void);
+
+/* Returns the next node in a round-robin sequence. Useful to spread a set of
+ * worker threads across all the nodes. */
+int
+gf_numa_node_next(void);
+
+/* Restricts the calling thread to the CPUs of @node. */
+int
+gf_numa_thread_bind(int node);
+
+/* Makes the pages of the given memory range to be allocated from @node if
+ * possible. It must be called before the memory is touched for the first
+ * time. */
+int
+gf_numa_memory_bind(void *addr, size_t size, int node);
+
+#endif /* __GF_NUMA_H__ */
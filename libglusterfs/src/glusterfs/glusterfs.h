@@ -196,6 +196,9 @@ enum gf_internal_fop_indicator {
 
 #define GLUSTERFS_WRITE_IS_APPEND "glusterfs.write-is-append"
 #define GLUSTERFS_WRITE_UPDATE_ATOMIC "glusterfs.write-update-atomic"
+/* Set by the server in readv requests when the reply can be sent from a pipe
+ * attached to the iobref (see iobref_set_pipe()) instead of from memory. */
+#define GLUSTERFS_READV_PIPE_PAYLOAD "glusterfs.readv-pipe-payload"
 #define GLUSTERFS_OPEN_FD_COUNT "glusterfs.open-fd-count"
 #define GLUSTERFS_ACTIVE_FD_COUNT "glusterfs.open-active-fd-count"
 #define GLUSTERFS_INODELK_COUNT "glusterfs.inodelk-count"
@@ -253,6 +256,19 @@ enum gf_internal_fop_indicator {
 #define GF_XATTROP_ENTRY_OUT "glusterfs.xattrop-entry-delete"
 #define GF_XATTROP_PURGE_INDEX "glusterfs.xattrop-purge-index"
 
+/* xdata of a GF_IPC_TARGET_XATTROP_BATCH ipc. The request carries COUNT
+ * xattrops, each one with the GFID of the inode, the OPTYPE and the XATTR
+ * dict serialized. FD is set for the ones to send as fxattrops on an
+ * anonymous fd. The reply has the RET, ERRNO and XATTR of each one. */
+#define GF_XATTROP_BATCH_MAX 256
+#define GF_XATTROP_BATCH_COUNT "glusterfs.xattrop-batch.count"
+#define GF_XATTROP_BATCH_GFID "glusterfs.xattrop-batch.%d.gfid"
+#define GF_XATTROP_BATCH_OPTYPE "glusterfs.xattrop-batch.%d.optype"
+#define GF_XATTROP_BATCH_XATTR "glusterfs.xattrop-batch.%d.xattr"
+#define GF_XATTROP_BATCH_FD "glusterfs.xattrop-batch.%d.fd"
+#define GF_XATTROP_BATCH_RET "glusterfs.xattrop-batch.%d.ret"
+#define GF_XATTROP_BATCH_ERRNO "glusterfs.xattrop-batch.%d.errno"
+
 #define GF_GFIDLESS_LOOKUP "gfidless-lookup"
 #define GF_UNLINKED_LOOKUP "unlinked-lookup"
 
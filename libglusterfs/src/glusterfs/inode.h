@@ -28,20 +28,22 @@ typedef struct _inode inode_t;
 struct _dentry;
 typedef struct _dentry dentry_t;
 
+struct cds_lfht;
+
 #include "glusterfs/iatt.h"
 #include "glusterfs/compat-uuid.h"
 #include "glusterfs/fd.h"
 
 struct _inode_table {
     pthread_mutex_t lock;
-    size_t dentry_hashsize; /* Number of buckets for dentry hash*/
-    size_t inode_hashsize;  /* Size of inode hash table */
+    size_t dentry_hashsize; /* Initial number of buckets for dentry hash */
+    size_t inode_hashsize;  /* Initial size of inode hash table */
     char *name;             /* name of the inode table, just for gf_log() */
     inode_t *root;          /* root directory inode, with number 1 */
     xlator_t *xl;           /* xlator to be called to do purge */
     uint32_t lru_limit;     /* maximum LRU cache size */
-    struct list_head *inode_hash; /* buckets for inode hash table */
-    struct list_head *name_hash;  /* buckets for dentry hash table */
+    struct cds_lfht *inode_hash; /* RCU hash table of inodes by gfid */
+    struct cds_lfht *name_hash;  /* RCU hash table of dentries by name */
     struct list_head active; /* list of inodes currently active (in an fop) */
     uint32_t active_size;    /* count of inodes in active list */
     struct list_head lru;    /* list of inodes recently used.
@@ -69,10 +71,10 @@ struct _inode_table {
 
 struct _dentry {
     struct list_head inode_list; /* list of dentries of inode */
-    struct list_head hash;       /* hash table pointers */
     inode_t *inode;              /* inode of this directory entry */
     char *name;                  /* name of the directory entry */
     inode_t *parent;             /* directory of the entry */
+    bool hashed;                 /* Set if dentry is in name hash */
 };
 
 struct _inode_ctx {
@@ -108,7 +110,6 @@ struct _inode {
     ia_type_t ia_type;            /* what kind of file */
     struct list_head fd_list;     /* list of open files on this inode */
     struct list_head dentry_list; /* list of directory entries for this inode */
-    struct list_head hash;        /* hash table pointers */
     struct list_head list;        /* active/lru/purge */
 
     struct _inode *ns_inode; /* This inode would point to namespace inode */
@@ -116,6 +117,7 @@ struct _inode {
     bool in_invalidate_list; /* Set if inode is in table invalidate list */
     bool invalidate_sent;    /* Set it if invalidator_fn is called for inode */
     bool in_lru_list;        /* Set if inode is in table lru list */
+    bool hashed;             /* Set if inode is in table inode hash */
 };
 
 #define UUID0_STR "00000000-0000-0000-0000-000000000000"
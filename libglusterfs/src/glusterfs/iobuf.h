@@ -17,6 +17,7 @@
 #include <sys/uio.h>            // for struct iovec
 #include "glusterfs/locking.h"  // for gf_lock_t
 #include "glusterfs/list.h"
+#include "glusterfs/gf-numa.h"
 
 #define GF_VARIABLE_IOBUF_COUNT 32
 
@@ -37,6 +38,13 @@
 #define GF_IOBUF_ALIGN_SIZE 512
 #define USE_IOBUF_POOL_IF_SIZE_GREATER_THAN 131072
 
+/* Maximum number of mmapped arenas that get a stable slot number. The slot
+ * is what consumers use to register the arena memory with the kernel (for
+ * example as io_uring fixed buffers), so it must not change during the
+ * lifetime of the arena. Arenas allocated beyond this limit simply don't
+ * have a slot. */
+#define GF_IOBUF_ARENA_SLOTS 256
+
 /* one allocatable unit for the consumers of the IOBUF API */
 /* each unit hosts @page_size bytes of memory */
 struct iobuf;
@@ -89,6 +97,61 @@ struct iobuf_arena {
     int active_cnt;
     int passive_cnt;
     int max_active; /* max active buffers at a given time */
+    int slot;       /* index in iobuf_pool->slots, -1 if none */
+    int node;       /* NUMA node the memory is bound to */
+};
+
+/* Maximum number of free iobufs of each page size that a thread can keep in
+ * its own cache, and maximum amount of memory they can take. */
+#define GF_IOBUF_MAGAZINE_SIZE 16
+#define GF_IOBUF_MAGAZINE_BYTES (2 * 1024 * 1024)
+
+struct iobuf_magazine {
+    struct iobuf *iobufs[GF_IOBUF_MAGAZINE_SIZE];
+    int count;
+    int max;
+    uint64_t hits;   /* allocations served from the magazine */
+    uint64_t misses; /* allocations that needed the pool */
+};
+
+/* Per-thread cache of free iobufs for each NUMA node and page size.
+ * Allocations and releases only take the pool mutex when a magazine needs to
+ * be refilled or flushed, and then they move several iobufs at once. Cached
+ * iobufs are still accounted as active in their arenas. A thread that moves
+ * to another node uses the magazines of the new node, so it never gets
+ * iobufs cached while it was running on the old one. */
+struct iobuf_cache {
+    struct list_head list; /* linked into iobuf_pool->caches */
+    struct iobuf_pool *iobuf_pool;
+    pthread_spinlock_t lock; /* only contended while detaching */
+    int node_count;
+    /* node_count * GF_VARIABLE_IOBUF_COUNT magazines, see iobuf_cache_mag */
+    struct iobuf_magazine mags[];
+};
+
+#define iobuf_cache_mag(cache, node, index)                                    \
+    (&(cache)->mags[(node)*GF_VARIABLE_IOBUF_COUNT + (index)])
+
+/* Counters of each NUMA node, protected by the pool mutex. Allocations done
+ * through thread caches are only counted when the magazine is refilled. */
+struct iobuf_node_stats {
+    uint64_t allocs;      /* iobufs taken from the arenas of the node */
+    uint64_t remote_puts; /* iobufs released by threads of another node */
+    int arena_cnt;
+};
+
+/* Called whenever an arena gets a slot (@base and @size describe the mapped
+ * memory) or releases it (@base is NULL and @size is 0). It's called without
+ * the pool mutex held, but calls are serialized, and a released slot is not
+ * given to another arena until its release has been delivered. It must not
+ * add or remove notifiers. */
+typedef void (*iobuf_arena_notify_t)(void *data, int slot, void *base,
+                                     size_t size);
+
+struct iobuf_arena_notifier {
+    struct list_head list;
+    iobuf_arena_notify_t fn;
+    void *data;
 };
 
 struct iobuf_pool {
@@ -97,19 +160,47 @@ struct iobuf_pool {
                                  arena */
     size_t default_page_size; /* default size of iobuf */
 
-    struct list_head arenas[GF_VARIABLE_IOBUF_COUNT];
-    /* array of arenas. Each element of the array is a list of arenas
-       holding iobufs of particular page_size */
+    struct list_head arenas[GF_NUMA_MAX_NODES][GF_VARIABLE_IOBUF_COUNT];
+    /* array of arenas for each NUMA node. Each element of the array is a
+       list of arenas holding iobufs of particular page_size */
 
-    struct list_head filled[GF_VARIABLE_IOBUF_COUNT];
+    struct list_head filled[GF_NUMA_MAX_NODES][GF_VARIABLE_IOBUF_COUNT];
     /* array of arenas without free iobufs */
 
-    struct list_head purge[GF_VARIABLE_IOBUF_COUNT];
+    struct list_head purge[GF_NUMA_MAX_NODES][GF_VARIABLE_IOBUF_COUNT];
     /* array of of arenas which can be purged */
 
+    int node_count; /* number of NUMA nodes with their own arenas */
+
+    struct iobuf_node_stats node_stats[GF_NUMA_MAX_NODES];
+
     uint64_t request_misses; /* mostly the requests for higher
                                value of iobufs */
     int arena_cnt;
+
+    struct iobuf_arena *slots[GF_IOBUF_ARENA_SLOTS];
+    /* arenas indexed by their slot number */
+
+    uint32_t slot_gen[GF_IOBUF_ARENA_SLOTS];
+    uint32_t slot_notified[GF_IOBUF_ARENA_SLOTS];
+    /* number of changes of each slot, and how many of them have been
+       delivered to the notifiers */
+
+    gf_atomic_t notify_pending;
+    /* changes not yet delivered to the notifiers */
+
+    pthread_mutex_t notify_mutex;
+    /* serializes the delivery of changes and protects 'notifiers' */
+
+    struct list_head notifiers;
+    /* consumers interested in arena slot changes */
+
+    struct list_head caches;
+    /* per-thread caches holding iobufs of this pool */
+
+    uint64_t cache_hits[GF_VARIABLE_IOBUF_COUNT];
+    uint64_t cache_misses[GF_VARIABLE_IOBUF_COUNT];
+    /* counters of thread caches already detached */
 };
 
 struct iobuf_pool *
@@ -130,12 +221,35 @@ iobuf_to_iovec(struct iobuf *iob, struct iovec *iov);
 #define iobuf_ptr(iob) ((iob)->ptr)
 #define iobuf_pagesize(iob) (iob->page_size)
 
+/* Pipes are reused through a pool with a small cache per thread. The number
+ * of pipes open at the same time is limited to a fraction of RLIMIT_NOFILE.
+ * gf_pipe_get() fails when the limit is reached, and callers are expected to
+ * fall back to a regular copy of the data. */
+#define GF_PIPE_CACHE_SIZE 8
+#define GF_PIPE_SHARED_SIZE 64
+#define GF_PIPE_MAX 4096
+
+struct gf_pipe {
+    int fds[2]; /* read and write ends, -1 if none */
+    int size;   /* capacity of the pipe */
+};
+
+int
+gf_pipe_get(struct gf_pipe *gpipe, size_t capacity);
+void
+gf_pipe_put(struct gf_pipe *gpipe);
+void
+gf_pipe_thread_destructor(void);
+
 struct iobref {
     gf_lock_t lock;
     gf_atomic_t ref;
     struct iobuf **iobrefs;
     int allocated;
     int used;
+    struct gf_pipe pipe; /* pipe holding the data of the vector whose base is
+                            NULL. Given back to the pool when the iobref is
+                            destroyed. */
 };
 
 struct iobref *
@@ -150,6 +264,10 @@ int
 iobref_merge(struct iobref *to, struct iobref *from);
 void
 iobref_clear(struct iobref *iobref);
+int
+iobref_set_pipe(struct iobref *iobref, struct gf_pipe *gpipe);
+int
+iobref_pipe(struct iobref *iobref);
 
 size_t
 iobuf_size(struct iobuf *iobuf);
@@ -170,4 +288,24 @@ iobuf_copy(struct iobuf_pool *iobuf_pool, const struct iovec *iovec_src,
            int iovcnt, struct iobref **iobref, struct iobuf **iobuf,
            struct iovec *iov_dst);
 
+struct iobuf *
+iobuf_get_from_arena(struct iobuf_pool *iobuf_pool, size_t page_size);
+
+int
+iobuf_arena_slot(struct iobuf *iobuf);
+
+int
+iobref_arena_slot(struct iobref *iobref, const void *ptr, size_t size);
+
+struct iobuf_arena_notifier *
+iobuf_pool_notifier_add(struct iobuf_pool *iobuf_pool, iobuf_arena_notify_t fn,
+                        void *data);
+
+void
+iobuf_pool_notifier_del(struct iobuf_pool *iobuf_pool,
+                        struct iobuf_arena_notifier *notifier);
+
+void
+iobuf_cache_thread_destructor(void);
+
 #endif /* !_IOBUF_H_ */
@@ -14,20 +14,59 @@
 #include <inttypes.h>
 #include <time.h>
 
+/* Latencies are also accumulated in a log-linear histogram: values are
+ * grouped by their most significant bit and each group is divided into
+ * GF_LATENCY_SUB_BUCKETS linear buckets, so the relative error of any
+ * percentile computed from it is below 1 / GF_LATENCY_SUB_BUCKETS. Values
+ * over 2^GF_LATENCY_MAX_BITS ns (~68 seconds) are counted in the last
+ * bucket. */
+#define GF_LATENCY_SUB_BITS 4
+#define GF_LATENCY_SUB_BUCKETS (1 << GF_LATENCY_SUB_BITS)
+#define GF_LATENCY_MAX_BITS 36
+#define GF_LATENCY_BUCKETS                                                     \
+    ((GF_LATENCY_MAX_BITS - GF_LATENCY_SUB_BITS + 1) * GF_LATENCY_SUB_BUCKETS)
+
+/* Number of copies of the histogram. Each thread always updates the same
+ * copy, so threads running on different CPUs don't contend for the same
+ * cache lines. The copies are merged when the histogram is read. */
+#define GF_LATENCY_STRIPES 4
+
+typedef struct _gf_latency_hist {
+    uint64_t buckets[GF_LATENCY_BUCKETS];
+} gf_latency_hist_t;
+
 typedef struct _gf_latency {
     uint64_t min;   /* min time for the call (nanoseconds) */
     uint64_t max;   /* max time for the call (nanoseconds) */
     uint64_t total; /* total time (nanoseconds) */
     uint64_t count;
+    /* Allocated on first use, so that fops that are never called don't
+     * take any memory. */
+    gf_latency_hist_t *hist[GF_LATENCY_STRIPES];
 } gf_latency_t;
 
 gf_latency_t *
 gf_latency_new(size_t n);
 
+void
+gf_latency_free(gf_latency_t *lat, size_t n);
+
+void
+gf_latency_destroy(gf_latency_t *lat);
+
 void
 gf_latency_reset(gf_latency_t *lat);
 
 void
 gf_latency_update(gf_latency_t *lat, struct timespec *begin,
                   struct timespec *end);
+
+void
+gf_latency_add(gf_latency_t *lat, uint64_t elapsed);
+
+/* Computes the latencies (in nanoseconds) below which the fractions @pct
+ * (0 < pct[i] <= 1) of the calls fall. */
+void
+gf_latency_percentiles(gf_latency_t *lat, const double *pct, uint64_t *values,
+                       int count);
 #endif /* __LATENCY_H__ */
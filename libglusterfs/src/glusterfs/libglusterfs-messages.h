@@ -126,7 +126,7 @@ GLFS_MSGID(
     LG_MSG_IO_URING_NOT_SUPPORTED, LG_MSG_IO_URING_INVALID,
     LG_MSG_IO_URING_MISSING_FEAT, LG_MSG_IO_URING_TOO_SMALL,
     LG_MSG_IO_URING_ENTER_FAILED, LG_MSG_IO_SYNC_TIMEOUT,
-    LG_MSG_IO_SYNC_ABORTED, LG_MSG_IO_SYNC_COMPLETED);
+    LG_MSG_IO_SYNC_ABORTED, LG_MSG_IO_SYNC_COMPLETED, LG_MSG_NUMA_BIND_FAILED);
 
 #define LG_MSG_EPOLL_FD_CREATE_FAILED_STR "epoll fd creation failed"
 #define LG_MSG_INVALID_POLL_IN_STR "invalid poll_in value"
@@ -246,5 +246,6 @@ GLFS_MSGID(
 #define LG_MSG_DICT_ERROR_STR "dict error"
 #define LG_MSG_STRUCT_MISS_STR "struct missing"
 #define LG_MSG_METHOD_MISS_STR "method missing(init)"
+#define LG_MSG_NUMA_BIND_FAILED_STR "failed to bind thread to NUMA node"
 
 #endif /* !_LG_MESSAGES_H_ */
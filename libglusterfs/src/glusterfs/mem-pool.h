@@ -292,6 +292,14 @@ typedef struct per_thread_pool_list {
      * placed into its original pool_list or directly destroyed. */
     bool poison;
 
+    /* NUMA node of the thread that created the objects of this pool_list.
+     * Unused pool_lists are only reused by threads of the same node. */
+    int node;
+
+    /* Protected by lock, like the hot/cold lists. */
+    uint64_t allocs;      /* objects served from the pools */
+    uint64_t remote_puts; /* objects released by threads of another node */
+
     /*
      * There's really more than one pool, but the actual number is hidden
      * in the implementation code so we just make it a single-element array
@@ -312,6 +320,16 @@ mem_pools_fini(void); /* cleanup memory pools */
 void
 mem_pool_thread_destructor(per_thread_pool_list_t *pool_list);
 
+struct mem_pool_node_stats {
+    uint64_t threads;     /* live threads with objects on the node */
+    uint64_t free_lists;  /* pool_lists not owned by any thread */
+    uint64_t allocs;      /* objects served from the pools of the node */
+    uint64_t remote_puts; /* ... that were released from another node */
+};
+
+void
+mem_pools_node_stats(int node, struct mem_pool_node_stats *stats);
+
 #endif /* GF_DISABLE_MEMPOOL */
 
 struct mem_pool *
@@ -51,4 +51,8 @@ int
 syncop_gfid_to_path_hard(inode_table_t *itable, xlator_t *subvol, uuid_t gfid,
                          inode_t *inode, char **path_p,
                          gf_boolean_t hard_resolve);
+
+int
+syncop_seek_data_segment(xlator_t *subvol, fd_t *fd, off_t *offset,
+                         size_t *size);
 #endif /* _SYNCOP_H */
@@ -110,6 +110,9 @@ sys_symlinkat(const char *oldpath, int dirfd, const char *newpath);
 int
 sys_rename(const char *oldpath, const char *newpath);
 
+int
+sys_renameat(int olddfd, const char *oldpath, int newdfd, const char *newpath);
+
 int
 sys_link(const char *oldpath, const char *newpath);
 
@@ -276,6 +279,14 @@ ssize_t
 sys_copy_file_range(int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
                     size_t len, unsigned int flags);
 
+/* 'struct statx' is only defined on Linux. Other platforms will always get
+ * ENOSYS from sys_statx(). */
+struct statx;
+
+int
+sys_statx(int dirfd, const char *path, int flags, unsigned int mask,
+          struct statx *buf);
+
 int
 sys_kill(pid_t pid, int sig);
 
@@ -16,6 +16,11 @@
 #include "glusterfs/list.h"
 #include <assert.h>
 #include "glusterfs/libglusterfs-messages.h"
+#include <urcu-bp.h>
+#include <urcu/rculfhash.h>
+
+#define XXH_INLINE_ALL
+#include "xxhash.h"
 
 /* TODO:
    move latest accessed dentry to list_head of inode
@@ -137,61 +142,126 @@ inode_table_prune(inode_table_t *table);
 void
 fd_dump(struct list_head *head, char *prefix);
 
-static int
-hash_dentry(inode_t *parent, const char *name, int mod)
+/*
+ * Both hash tables are RCU lock-free hash tables from liburcu-cds. Lookups
+ * only need to be inside an RCU read-side critical section, so inode_find()
+ * and inode_grep() don't take the table lock unless the inode they find is
+ * not referenced by anyone (moving it out of the lru list needs the lock).
+ *
+ * Additions and removals are still done with the table lock held because
+ * they always come together with changes in the inode lists. Since readers
+ * can still be looking at an inode or dentry after it has been removed from
+ * the hash table, the memory is released after a grace period.
+ *
+ * The hash table nodes and the RCU heads are kept in wrappers private to this
+ * file, so that users of inode.h don't depend on the liburcu flavor used here.
+ * Inodes and dentries are always allocated from the pools of the table, which
+ * hold the whole wrapper.
+ */
+
+typedef struct {
+    inode_t inode;
+    struct cds_lfht_node hash; /* hash table node */
+    struct rcu_head rcu;       /* deferred release */
+} inode_rcu_t;
+
+typedef struct {
+    dentry_t dentry;
+    struct cds_lfht_node hash; /* hash table node */
+    struct rcu_head rcu;       /* deferred release */
+} dentry_rcu_t;
+
+#define INODE_RCU(_inode) caa_container_of(_inode, inode_rcu_t, inode)
+#define DENTRY_RCU(_dentry) caa_container_of(_dentry, dentry_rcu_t, dentry)
+
+struct dentry_key {
+    inode_t *parent;
+    const char *name;
+};
+
+static uint64_t
+hash_dentry(inode_t *parent, const char *name)
 {
-    int hash = 0;
-    int ret = 0;
+    return XXH64(name, strlen(name), (uint64_t)(uintptr_t)parent);
+}
 
-    hash = *name;
-    if (hash) {
-        for (name += 1; *name != '\0'; name++) {
-            hash = (hash << 5) - hash + *name;
-        }
-    }
-    ret = (hash + (unsigned long)parent) % mod;
+static uint64_t
+hash_gfid(uuid_t uuid)
+{
+    return XXH64(uuid, sizeof(uuid_t), 0);
+}
 
-    return ret;
+static int
+dentry_match(struct cds_lfht_node *node, const void *data)
+{
+    const struct dentry_key *key = data;
+    dentry_t *dentry = &caa_container_of(node, dentry_rcu_t, hash)->dentry;
+
+    return (dentry->parent == key->parent) && !strcmp(dentry->name, key->name);
 }
 
 static int
-hash_gfid(uuid_t uuid, int mod)
+inode_match(struct cds_lfht_node *node, const void *data)
 {
-    return ((uuid[15] + (uuid[14] << 8)) % mod);
+    inode_t *inode = &caa_container_of(node, inode_rcu_t, hash)->inode;
+
+    return gf_uuid_compare(inode->gfid, (unsigned char *)data) == 0;
 }
 
 static void
-__dentry_hash(dentry_t *dentry, const int hash)
+__dentry_hash(dentry_t *dentry, const uint64_t hash)
 {
     inode_table_t *table = NULL;
 
+    if (dentry->hashed)
+        return;
+
     table = dentry->inode->table;
 
-    list_del_init(&dentry->hash);
-    list_add(&dentry->hash, &table->name_hash[hash]);
+    rcu_read_lock();
+    cds_lfht_add(table->name_hash, hash, &DENTRY_RCU(dentry)->hash);
+    rcu_read_unlock();
+
+    dentry->hashed = true;
 }
 
 static int
 __is_dentry_hashed(dentry_t *dentry)
 {
-    return !list_empty(&dentry->hash);
+    return dentry->hashed;
 }
 
 static void
 __dentry_unhash(dentry_t *dentry)
 {
-    list_del_init(&dentry->hash);
+    if (!dentry->hashed)
+        return;
+
+    rcu_read_lock();
+    cds_lfht_del(dentry->inode->table->name_hash, &DENTRY_RCU(dentry)->hash);
+    rcu_read_unlock();
+
+    dentry->hashed = false;
 }
 
 static void
-dentry_destroy(dentry_t *dentry)
+dentry_free(struct rcu_head *head)
 {
-    if (!dentry)
-        return;
+    dentry_t *dentry = &caa_container_of(head, dentry_rcu_t, rcu)->dentry;
 
     GF_FREE(dentry->name);
     dentry->name = NULL;
     mem_put(dentry);
+}
+
+static void
+dentry_destroy(dentry_t *dentry)
+{
+    if (!dentry)
+        return;
+
+    /* A lock-free lookup could still be comparing the name. */
+    call_rcu(&DENTRY_RCU(dentry)->rcu, dentry_free);
 
     return;
 }
@@ -285,22 +355,35 @@ __is_dentry_cyclic(dentry_t *dentry)
 static void
 __inode_unhash(inode_t *inode)
 {
-    list_del_init(&inode->hash);
+    if (!inode->hashed)
+        return;
+
+    rcu_read_lock();
+    cds_lfht_del(inode->table->inode_hash, &INODE_RCU(inode)->hash);
+    rcu_read_unlock();
+
+    inode->hashed = false;
 }
 
 static int
 __is_inode_hashed(inode_t *inode)
 {
-    return !list_empty(&inode->hash);
+    return inode->hashed;
 }
 
 static void
-__inode_hash(inode_t *inode, const int hash)
+__inode_hash(inode_t *inode, const uint64_t hash)
 {
     inode_table_t *table = inode->table;
 
-    list_del_init(&inode->hash);
-    list_add(&inode->hash, &table->inode_hash[hash]);
+    if (inode->hashed)
+        return;
+
+    rcu_read_lock();
+    cds_lfht_add(table->inode_hash, hash, &INODE_RCU(inode)->hash);
+    rcu_read_unlock();
+
+    inode->hashed = true;
 }
 
 static dentry_t *
@@ -360,16 +443,25 @@ noctx:
 }
 
 static void
-__inode_destroy(inode_t *inode)
+inode_free(struct rcu_head *head)
 {
-    inode_unref(inode->ns_inode);
-    __inode_ctx_free(inode);
+    inode_t *inode = &caa_container_of(head, inode_rcu_t, rcu)->inode;
 
     LOCK_DESTROY(&inode->lock);
     //  memset (inode, 0xb, sizeof (*inode));
     mem_put(inode);
 }
 
+static void
+__inode_destroy(inode_t *inode)
+{
+    inode_unref(inode->ns_inode);
+    __inode_ctx_free(inode);
+
+    /* A lock-free lookup could still be checking the reference count. */
+    call_rcu(&INODE_RCU(inode)->rcu, inode_free);
+}
+
 void
 inode_ctx_merge(fd_t *fd, inode_t *inode, inode_t *linked_inode)
 {
@@ -462,12 +554,77 @@ out:
     return set_idx;
 }
 
+static void
+inode_ref_account(inode_t *inode, int delta)
+{
+    int index = 0;
+
+    index = __inode_get_xl_index(inode, THIS);
+    if (index >= 0) {
+        __atomic_fetch_add(&inode->_ctx[index].ref, delta, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * Changes the reference count of an inode without taking the table lock. This
+ * is only possible while the count stays above 0. Transitions to or from 0
+ * references move the inode between the lists of the table, so they still
+ * need the table lock. Returns false when the caller must take the lock.
+ */
+static bool
+inode_ref_change(inode_t *inode, int delta)
+{
+    uint32_t ref = __atomic_load_n(&inode->ref, __ATOMIC_RELAXED);
+
+    /*
+     * Root inode should always be in active list of inode table. So unrefs
+     * on root inode are no-ops, and refs don't change its count either
+     * (see __inode_ref()).
+     */
+    if (__is_root_gfid(inode->gfid) && ((delta < 0) || (ref != 0)))
+        return true;
+
+    do {
+        if ((ref == 0) || (ref + delta == 0))
+            return false;
+    } while (!__atomic_compare_exchange_n(&inode->ref, &ref, ref + delta, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    inode_ref_account(inode, delta);
+
+    return true;
+}
+
+/*
+ * Removes @nref references from an inode, or all of them if @nref is 0, and
+ * returns the new count. Has to be called with the table lock held. Other
+ * threads can still change the count without the lock, so it needs a CAS
+ * loop even under the lock. Only this function takes the count to 0, which
+ * lock-free changes never do (see inode_ref_change()).
+ */
+static uint32_t
+__inode_ref_sub(inode_t *inode, uint32_t nref)
+{
+    uint32_t ref = __atomic_load_n(&inode->ref, __ATOMIC_RELAXED);
+    uint32_t new_ref;
+
+    do {
+        GF_ASSERT(ref >= nref);
+        if ((nref == 0) || (ref <= nref))
+            new_ref = 0;
+        else
+            new_ref = ref - nref;
+    } while (!__atomic_compare_exchange_n(&inode->ref, &ref, new_ref, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    return new_ref;
+}
+
 static inode_t *
 __inode_unref(inode_t *inode, bool clear)
 {
-    int index = 0;
-    xlator_t *this = NULL;
     uint64_t nlookup = 0;
+    uint32_t ref = 0;
 
     /*
      * Root inode should always be in active list of inode table. So unrefs
@@ -511,8 +668,6 @@ __inode_unref(inode_t *inode, bool clear)
          */
         return inode;
 
-    this = THIS;
-
     if (clear && inode->in_invalidate_list) {
         inode->in_invalidate_list = false;
         inode->table->invalidate_size--;
@@ -520,15 +675,11 @@ __inode_unref(inode_t *inode, bool clear)
     }
     GF_ASSERT(inode->ref);
 
-    --inode->ref;
+    ref = __inode_ref_sub(inode, 1);
 
-    index = __inode_get_xl_index(inode, this);
-    if (index >= 0) {
-        inode->_ctx[index].xl_key = this;
-        inode->_ctx[index].ref--;
-    }
+    inode_ref_account(inode, -1);
 
-    if (!inode->ref && !inode->in_invalidate_list) {
+    if (!ref && !inode->in_invalidate_list) {
         inode->table->active_size--;
 
         nlookup = GF_ATOMIC_GET(inode->nlookup);
@@ -544,14 +695,9 @@ __inode_unref(inode_t *inode, bool clear)
 static inode_t *
 __inode_ref(inode_t *inode, bool is_invalidate)
 {
-    int index = 0;
-    xlator_t *this = NULL;
-
     if (!inode)
         return NULL;
 
-    this = THIS;
-
     /*
      * Root inode should always be in active list of inode table. So unrefs
      * on root inode are no-ops. If we do not allow unrefs but allow refs,
@@ -582,13 +728,9 @@ __inode_ref(inode_t *inode, bool is_invalidate)
         }
     }
 
-    inode->ref++;
+    __atomic_fetch_add(&inode->ref, 1, __ATOMIC_ACQ_REL);
 
-    index = __inode_get_xl_index(inode, this);
-    if (index >= 0) {
-        inode->_ctx[index].xl_key = this;
-        inode->_ctx[index].ref++;
-    }
+    inode_ref_account(inode, 1);
 
     return inode;
 }
@@ -601,6 +743,12 @@ inode_unref(inode_t *inode)
     if (!inode)
         return NULL;
 
+    /* If the inode stays referenced, nothing changes in the table, so it
+     * doesn't need to be pruned either. The last reference is always
+     * released with the table lock held, and then the table is pruned. */
+    if (inode_ref_change(inode, -1))
+        return inode;
+
     table = inode->table;
 
     pthread_mutex_lock(&table->lock);
@@ -622,6 +770,9 @@ inode_ref(inode_t *inode)
     if (!inode)
         return NULL;
 
+    if (inode_ref_change(inode, 1))
+        return inode;
+
     table = inode->table;
 
     pthread_mutex_lock(&table->lock);
@@ -644,7 +795,7 @@ dentry_create(inode_t *inode, inode_t *parent, const char *name)
     }
 
     INIT_LIST_HEAD(&newd->inode_list);
-    INIT_LIST_HEAD(&newd->hash);
+    cds_lfht_node_init(&DENTRY_RCU(newd)->hash);
 
     newd->name = gf_strdup(name);
     if (newd->name == NULL) {
@@ -675,7 +826,7 @@ inode_create(inode_table_t *table)
 
     INIT_LIST_HEAD(&newi->fd_list);
     INIT_LIST_HEAD(&newi->list);
-    INIT_LIST_HEAD(&newi->hash);
+    cds_lfht_node_init(&INODE_RCU(newi)->hash);
     INIT_LIST_HEAD(&newi->dentry_list);
 
     GF_ATOMIC_INIT(newi->kids, 0);
@@ -739,15 +890,11 @@ static inode_t *
 __inode_ref_reduce_by_n(inode_t *inode, uint64_t nref)
 {
     uint64_t nlookup = 0;
+    uint32_t ref = 0;
 
-    GF_ASSERT(inode->ref >= nref);
-
-    inode->ref -= nref;
-
-    if (!nref)
-        inode->ref = 0;
+    ref = __inode_ref_sub(inode, nref);
 
-    if (!inode->ref) {
+    if (!ref) {
         inode->table->active_size--;
 
         nlookup = GF_ATOMIC_GET(inode->nlookup);
@@ -778,22 +925,25 @@ inode_forget_atomic(inode_t *inode, uint64_t nlookup)
     return inode;
 }
 
+/* Must be called with the table lock held or inside an RCU read-side
+ * critical section. */
 dentry_t *
 __dentry_grep(inode_table_t *table, inode_t *parent, const char *name,
-              const int hash)
+              const uint64_t hash)
 {
-    dentry_t *dentry = NULL;
-    dentry_t *tmp = NULL;
+    struct dentry_key key = {.parent = parent, .name = name};
+    struct cds_lfht_iter iter;
+    struct cds_lfht_node *node = NULL;
 
-    list_for_each_entry(tmp, &table->name_hash[hash], hash)
-    {
-        if (tmp->parent == parent && !strcmp(tmp->name, name)) {
-            dentry = tmp;
-            break;
-        }
-    }
+    rcu_read_lock();
+    cds_lfht_lookup(table->name_hash, hash, dentry_match, &key, &iter);
+    node = cds_lfht_iter_get_node(&iter);
+    rcu_read_unlock();
 
-    return dentry;
+    if (node == NULL)
+        return NULL;
+
+    return &caa_container_of(node, dentry_rcu_t, hash)->dentry;
 }
 
 inode_t *
@@ -801,6 +951,7 @@ inode_grep(inode_table_t *table, inode_t *parent, const char *name)
 {
     inode_t *inode = NULL;
     dentry_t *dentry = NULL;
+    bool referenced = false;
 
     if (!table || !parent || !name) {
         gf_msg_callingfn(THIS->name, GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
@@ -809,7 +960,24 @@ inode_grep(inode_table_t *table, inode_t *parent, const char *name)
         return NULL;
     }
 
-    int hash = hash_dentry(parent, name, table->dentry_hashsize);
+    uint64_t hash = hash_dentry(parent, name);
+
+    rcu_read_lock();
+    {
+        dentry = __dentry_grep(table, parent, name, hash);
+        if (dentry)
+            inode = dentry->inode;
+        if (inode)
+            referenced = inode_ref_change(inode, 1);
+    }
+    rcu_read_unlock();
+
+    if (!inode || referenced)
+        return inode;
+
+    /* The inode is not referenced. Taking the first reference needs the
+     * table lock, and the dentry may be gone by then. */
+    inode = NULL;
 
     pthread_mutex_lock(&table->lock);
     {
@@ -885,9 +1053,9 @@ inode_grep_for_gfid(inode_table_t *table, inode_t *parent, const char *name,
         return ret;
     }
 
-    int hash = hash_dentry(parent, name, table->dentry_hashsize);
+    uint64_t hash = hash_dentry(parent, name);
 
-    pthread_mutex_lock(&table->lock);
+    rcu_read_lock();
     {
         dentry = __dentry_grep(table, parent, name, hash);
         if (dentry) {
@@ -899,7 +1067,7 @@ inode_grep_for_gfid(inode_table_t *table, inode_t *parent, const char *name,
             }
         }
     }
-    pthread_mutex_unlock(&table->lock);
+    rcu_read_unlock();
 
     return ret;
 }
@@ -916,30 +1084,33 @@ __is_root_gfid(uuid_t gfid)
     return _gf_false;
 }
 
+/* Must be called with the table lock held or inside an RCU read-side
+ * critical section. */
 inode_t *
-__inode_find(inode_table_t *table, uuid_t gfid, const int hash)
+__inode_find(inode_table_t *table, uuid_t gfid, const uint64_t hash)
 {
-    inode_t *inode = NULL;
-    inode_t *tmp = NULL;
+    struct cds_lfht_iter iter;
+    struct cds_lfht_node *node = NULL;
 
     if (__is_root_gfid(gfid))
         return table->root;
 
-    list_for_each_entry(tmp, &table->inode_hash[hash], hash)
-    {
-        if (gf_uuid_compare(tmp->gfid, gfid) == 0) {
-            inode = tmp;
-            break;
-        }
-    }
+    rcu_read_lock();
+    cds_lfht_lookup(table->inode_hash, hash, inode_match, gfid, &iter);
+    node = cds_lfht_iter_get_node(&iter);
+    rcu_read_unlock();
 
-    return inode;
+    if (node == NULL)
+        return NULL;
+
+    return &caa_container_of(node, inode_rcu_t, hash)->inode;
 }
 
 inode_t *
 inode_find(inode_table_t *table, uuid_t gfid)
 {
     inode_t *inode = NULL;
+    bool referenced = false;
 
     if (!table) {
         gf_msg_callingfn(THIS->name, GF_LOG_WARNING, 0,
@@ -949,8 +1120,21 @@ inode_find(inode_table_t *table, uuid_t gfid)
         return NULL;
     }
 
-    int hash = hash_gfid(gfid, table->inode_hashsize);
+    uint64_t hash = hash_gfid(gfid);
 
+    rcu_read_lock();
+    {
+        inode = __inode_find(table, gfid, hash);
+        if (inode)
+            referenced = inode_ref_change(inode, 1);
+    }
+    rcu_read_unlock();
+
+    if (!inode || referenced)
+        return inode;
+
+    /* The inode is not referenced. Taking the first reference needs the
+     * table lock, and the inode may have been retired by then. */
     pthread_mutex_lock(&table->lock);
     {
         inode = __inode_find(table, gfid, hash);
@@ -964,7 +1148,7 @@ inode_find(inode_table_t *table, uuid_t gfid)
 
 static inode_t *
 __inode_link(inode_t *inode, inode_t *parent, const char *name,
-             struct iatt *iatt, const int dhash)
+             struct iatt *iatt, const uint64_t dhash)
 {
     dentry_t *dentry = NULL;
     dentry_t *old_dentry = NULL;
@@ -1011,7 +1195,7 @@ __inode_link(inode_t *inode, inode_t *parent, const char *name,
             return NULL;
         }
 
-        int ihash = hash_gfid(iatt->ia_gfid, table->inode_hashsize);
+        uint64_t ihash = hash_gfid(iatt->ia_gfid);
 
         old_inode = __inode_find(table, iatt->ia_gfid, ihash);
 
@@ -1080,7 +1264,7 @@ __inode_link(inode_t *inode, inode_t *parent, const char *name,
 inode_t *
 inode_link(inode_t *inode, inode_t *parent, const char *name, struct iatt *iatt)
 {
-    int hash = 0;
+    uint64_t hash = 0;
     inode_table_t *table = NULL;
     inode_t *linked_inode = NULL;
 
@@ -1093,7 +1277,7 @@ inode_link(inode_t *inode, inode_t *parent, const char *name, struct iatt *iatt)
     table = inode->table;
 
     if (parent && name) {
-        hash = hash_dentry(parent, name, table->dentry_hashsize);
+        hash = hash_dentry(parent, name);
     }
 
     if (name && strchr(name, '/')) {
@@ -1297,7 +1481,7 @@ inode_rename(inode_table_t *table, inode_t *srcdir, const char *srcname,
              inode_t *dstdir, const char *dstname, inode_t *inode,
              struct iatt *iatt)
 {
-    int hash = 0;
+    uint64_t hash = 0;
     dentry_t *dentry = NULL;
     inode_t *linked_inode = NULL;
 
@@ -1315,7 +1499,7 @@ inode_rename(inode_table_t *table, inode_t *srcdir, const char *srcname,
     }
 
     if (dstdir && dstname) {
-        hash = hash_dentry(dstdir, dstname, table->dentry_hashsize);
+        hash = hash_dentry(dstdir, dstname);
     }
 
     pthread_mutex_lock(&table->lock);
@@ -1696,7 +1880,6 @@ inode_table_with_invalidator(uint32_t lru_limit, xlator_t *xl,
     inode_table_t *new = NULL;
     uint32_t mem_pool_size = lru_limit;
     int ret = -1;
-    int i = 0;
 
     new = (void *)GF_CALLOC(1, sizeof(*new), gf_common_mt_inode_table_t);
     if (!new)
@@ -1709,39 +1892,43 @@ inode_table_with_invalidator(uint32_t lru_limit, xlator_t *xl,
     new->invalidator_fn = invalidator_fn;
     new->invalidator_xl = invalidator_xl;
 
+    /* The hash tables grow and shrink as needed. These are only the initial
+     * sizes, which also are the minimum ones. They must be powers of 2. */
     if (dentry_hashsize == 0) {
-        /* Prime number for uniform distribution */
-        new->dentry_hashsize = 14057;
+        new->dentry_hashsize = 16384;
     } else {
-        new->dentry_hashsize = dentry_hashsize;
+        new->dentry_hashsize = gf_roundup_power_of_two(dentry_hashsize);
     }
 
     if (inode_hashsize == 0) {
-        /* The size of hash table always should be power of 2 */
         new->inode_hashsize = 65536;
     } else {
-        new->inode_hashsize = inode_hashsize;
+        new->inode_hashsize = gf_roundup_power_of_two(inode_hashsize);
     }
 
     /* In case FUSE is initing the inode table. */
     if (!mem_pool_size || (mem_pool_size > DEFAULT_INODE_MEMPOOL_ENTRIES))
         mem_pool_size = DEFAULT_INODE_MEMPOOL_ENTRIES;
 
-    new->inode_pool = mem_pool_new(inode_t, mem_pool_size);
+    new->inode_pool = mem_pool_new_fn(THIS->ctx, sizeof(inode_rcu_t),
+                                      mem_pool_size, "inode_t");
     if (!new->inode_pool)
         goto out;
 
-    new->dentry_pool = mem_pool_new(dentry_t, mem_pool_size);
+    new->dentry_pool = mem_pool_new_fn(THIS->ctx, sizeof(dentry_rcu_t),
+                                       mem_pool_size, "dentry_t");
     if (!new->dentry_pool)
         goto out;
 
-    new->inode_hash = (void *)GF_CALLOC(
-        new->inode_hashsize, sizeof(struct list_head), gf_common_mt_list_head);
+    new->inode_hash = cds_lfht_new(new->inode_hashsize, new->inode_hashsize, 0,
+                                   CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING,
+                                   NULL);
     if (!new->inode_hash)
         goto out;
 
-    new->name_hash = (void *)GF_CALLOC(
-        new->dentry_hashsize, sizeof(struct list_head), gf_common_mt_list_head);
+    new->name_hash = cds_lfht_new(new->dentry_hashsize, new->dentry_hashsize, 0,
+                                  CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING,
+                                  NULL);
     if (!new->name_hash)
         goto out;
 
@@ -1752,14 +1939,6 @@ inode_table_with_invalidator(uint32_t lru_limit, xlator_t *xl,
     if (!new->fd_mem_pool)
         goto out;
 
-    for (i = 0; i < new->inode_hashsize; i++) {
-        INIT_LIST_HEAD(&new->inode_hash[i]);
-    }
-
-    for (i = 0; i < new->dentry_hashsize; i++) {
-        INIT_LIST_HEAD(&new->name_hash[i]);
-    }
-
     INIT_LIST_HEAD(&new->active);
     INIT_LIST_HEAD(&new->lru);
     INIT_LIST_HEAD(&new->purge);
@@ -1781,8 +1960,10 @@ inode_table_with_invalidator(uint32_t lru_limit, xlator_t *xl,
 out:
     if (ret) {
         if (new) {
-            GF_FREE(new->inode_hash);
-            GF_FREE(new->name_hash);
+            if (new->inode_hash)
+                cds_lfht_destroy(new->inode_hash, NULL);
+            if (new->name_hash)
+                cds_lfht_destroy(new->name_hash, NULL);
             if (new->dentry_pool)
                 mem_pool_destroy(new->dentry_pool);
             if (new->inode_pool)
@@ -1893,6 +2074,20 @@ out:
     return;
 }
 
+static void
+inode_hash_drain(struct cds_lfht *ht)
+{
+    struct cds_lfht_iter iter;
+    struct cds_lfht_node *node = NULL;
+
+    rcu_read_lock();
+    cds_lfht_for_each(ht, &iter, node)
+    {
+        cds_lfht_del(ht, node);
+    }
+    rcu_read_unlock();
+}
+
 void
 inode_table_destroy(inode_table_t *inode_table)
 {
@@ -1974,8 +2169,17 @@ inode_table_destroy(inode_table_t *inode_table)
 
     inode_table_prune(inode_table);
 
-    GF_FREE(inode_table->inode_hash);
-    GF_FREE(inode_table->name_hash);
+    /* Leaked inodes and dentries may still be in the hash tables. They
+     * need to be removed before the tables can be destroyed. */
+    inode_hash_drain(inode_table->inode_hash);
+    inode_hash_drain(inode_table->name_hash);
+    cds_lfht_destroy(inode_table->inode_hash, NULL);
+    cds_lfht_destroy(inode_table->name_hash, NULL);
+
+    /* Wait until all deferred releases of inodes and dentries have
+     * returned their memory to the pools. */
+    rcu_barrier();
+
     if (inode_table->dentry_pool)
         mem_pool_destroy(inode_table->dentry_pool);
     if (inode_table->inode_pool)
@@ -11,6 +11,11 @@
 #include "glusterfs/iobuf.h"
 #include "glusterfs/statedump.h"
 #include "glusterfs/libglusterfs-messages.h"
+#include "glusterfs/syscall.h"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
 
 /*
   TODO: implement destroy margins and prefetching of arenas
@@ -113,11 +118,124 @@ __iobuf_arena_destroy_iobufs(struct iobuf_arena *iobuf_arena)
     GF_FREE(iobuf_arena->iobufs);
 }
 
+/* Always called under the iobuf_pool mutex lock. The change is delivered
+ * to the notifiers by iobuf_pool_notify() once the lock is released. */
+static void
+__iobuf_arena_slot_changed(struct iobuf_pool *iobuf_pool, int slot)
+{
+    iobuf_pool->slot_gen[slot]++;
+    GF_ATOMIC_INC(iobuf_pool->notify_pending);
+}
+
+/* Delivers the pending slot changes to the notifiers. Consumers may need
+ * slow system calls to apply them (like updating the fixed buffers of an
+ * io_uring), so this is done without holding the pool mutex. It must be
+ * called after releasing the mutex by anyone that may have created or
+ * destroyed arenas. */
+static void
+iobuf_pool_notify(struct iobuf_pool *iobuf_pool)
+{
+    struct iobuf_arena_notifier *notifier = NULL;
+    struct iobuf_arena *iobuf_arena = NULL;
+    struct {
+        void *base;
+        size_t size;
+        uint32_t gen;
+        int slot;
+    } changes[GF_IOBUF_ARENA_SLOTS];
+    int count = 0;
+    int slot = 0;
+    int i = 0;
+
+    if (GF_ATOMIC_GET(iobuf_pool->notify_pending) == 0)
+        return;
+
+    pthread_mutex_lock(&iobuf_pool->notify_mutex);
+    {
+        pthread_mutex_lock(&iobuf_pool->mutex);
+        {
+            for (i = 0; i < GF_IOBUF_ARENA_SLOTS; i++) {
+                if (iobuf_pool->slot_gen[i] == iobuf_pool->slot_notified[i])
+                    continue;
+
+                iobuf_arena = iobuf_pool->slots[i];
+                changes[count].slot = i;
+                changes[count].gen = iobuf_pool->slot_gen[i];
+                changes[count].base = NULL;
+                changes[count].size = 0;
+                if (iobuf_arena) {
+                    changes[count].base = iobuf_arena->mem_base;
+                    changes[count].size = iobuf_arena->arena_size;
+                }
+                count++;
+            }
+        }
+        pthread_mutex_unlock(&iobuf_pool->mutex);
+
+        for (i = 0; i < count; i++) {
+            list_for_each_entry(notifier, &iobuf_pool->notifiers, list)
+            {
+                notifier->fn(notifier->data, changes[i].slot,
+                             changes[i].base, changes[i].size);
+            }
+        }
+
+        pthread_mutex_lock(&iobuf_pool->mutex);
+        {
+            for (i = 0; i < count; i++) {
+                slot = changes[i].slot;
+                GF_ATOMIC_SUB(iobuf_pool->notify_pending,
+                              changes[i].gen -
+                                  iobuf_pool->slot_notified[slot]);
+                iobuf_pool->slot_notified[slot] = changes[i].gen;
+            }
+        }
+        pthread_mutex_unlock(&iobuf_pool->mutex);
+    }
+    pthread_mutex_unlock(&iobuf_pool->notify_mutex);
+}
+
+/* Always called under the iobuf_pool mutex lock */
+static void
+__iobuf_arena_slot_get(struct iobuf_pool *iobuf_pool,
+                       struct iobuf_arena *iobuf_arena)
+{
+    int i = 0;
+
+    for (i = 0; i < GF_IOBUF_ARENA_SLOTS; i++) {
+        /* A released slot is not reused until the notifiers know it. */
+        if ((iobuf_pool->slots[i] == NULL) &&
+            (iobuf_pool->slot_gen[i] == iobuf_pool->slot_notified[i])) {
+            iobuf_pool->slots[i] = iobuf_arena;
+            iobuf_arena->slot = i;
+
+            __iobuf_arena_slot_changed(iobuf_pool, i);
+            break;
+        }
+    }
+}
+
+/* Always called under the iobuf_pool mutex lock */
+static void
+__iobuf_arena_slot_put(struct iobuf_pool *iobuf_pool,
+                       struct iobuf_arena *iobuf_arena)
+{
+    if (iobuf_arena->slot < 0)
+        return;
+
+    __iobuf_arena_slot_changed(iobuf_pool, iobuf_arena->slot);
+
+    iobuf_pool->slots[iobuf_arena->slot] = NULL;
+    iobuf_arena->slot = -1;
+}
+
 static void
 __iobuf_arena_destroy(struct iobuf_arena *iobuf_arena)
 {
     GF_VALIDATE_OR_GOTO("iobuf", iobuf_arena, out);
 
+    __iobuf_arena_slot_put(iobuf_arena->iobuf_pool, iobuf_arena);
+
     __iobuf_arena_destroy_iobufs(iobuf_arena);
 
     if (iobuf_arena->mem_base && iobuf_arena->mem_base != MAP_FAILED)
@@ -130,7 +248,7 @@ out:
 
 static struct iobuf_arena *
 __iobuf_arena_alloc(struct iobuf_pool *iobuf_pool, size_t page_size,
-                    int32_t num_iobufs)
+                    int32_t num_iobufs, const int node)
 {
     struct iobuf_arena *iobuf_arena = NULL;
     size_t rounded_size = 0;
@@ -146,6 +264,8 @@ __iobuf_arena_alloc(struct iobuf_pool *iobuf_pool, size_t page_size,
     INIT_LIST_HEAD(&iobuf_arena->passive_list);
     INIT_LIST_HEAD(&iobuf_arena->active_list);
     iobuf_arena->iobuf_pool = iobuf_pool;
+    iobuf_arena->slot = -1;
+    iobuf_arena->node = node;
 
     rounded_size = gf_iobuf_get_pagesize(page_size, &index);
 
@@ -162,13 +282,22 @@ __iobuf_arena_alloc(struct iobuf_pool *iobuf_pool, size_t page_size,
         goto err;
     }
 
+    /* Nothing has touched the memory yet, so all the pages will come from
+     * the node of the threads that will use them. */
+    if (iobuf_pool->node_count > 1)
+        (void)gf_numa_memory_bind(iobuf_arena->mem_base,
+                                  iobuf_arena->arena_size, node);
+
     __iobuf_arena_init_iobufs(iobuf_arena);
     if (!iobuf_arena->iobufs) {
         gf_smsg(THIS->name, GF_LOG_ERROR, 0, LG_MSG_INIT_IOBUF_FAILED, NULL);
         goto err;
     }
 
+    __iobuf_arena_slot_get(iobuf_pool, iobuf_arena);
+
     iobuf_pool->arena_cnt++;
+    iobuf_pool->node_stats[node].arena_cnt++;
 
     return iobuf_arena;
 
@@ -180,14 +309,15 @@ out:
 }
 
 static struct iobuf_arena *
-__iobuf_arena_unprune(struct iobuf_pool *iobuf_pool, const int index)
+__iobuf_arena_unprune(struct iobuf_pool *iobuf_pool, const int node,
+                      const int index)
 {
     struct iobuf_arena *iobuf_arena = NULL;
     struct iobuf_arena *tmp = NULL;
 
     GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
 
-    list_for_each_entry(tmp, &iobuf_pool->purge[index], list)
+    list_for_each_entry(tmp, &iobuf_pool->purge[node][index], list)
     {
         list_del_init(&tmp->list);
         iobuf_arena = tmp;
@@ -199,74 +329,362 @@ out:
 
 static struct iobuf_arena *
 __iobuf_pool_add_arena(struct iobuf_pool *iobuf_pool, const size_t page_size,
-                       const int32_t num_pages, const int index)
+                       const int32_t num_pages, const int node, const int index)
 {
     struct iobuf_arena *iobuf_arena = NULL;
 
-    iobuf_arena = __iobuf_arena_unprune(iobuf_pool, index);
+    iobuf_arena = __iobuf_arena_unprune(iobuf_pool, node, index);
 
     if (!iobuf_arena) {
-        iobuf_arena = __iobuf_arena_alloc(iobuf_pool, page_size, num_pages);
+        iobuf_arena = __iobuf_arena_alloc(iobuf_pool, page_size, num_pages,
+                                          node);
         if (!iobuf_arena) {
             gf_smsg(THIS->name, GF_LOG_WARNING, 0, LG_MSG_ARENA_NOT_FOUND,
                     NULL);
             return NULL;
         }
     }
-    list_add(&iobuf_arena->list, &iobuf_pool->arenas[index]);
+    list_add(&iobuf_arena->list, &iobuf_pool->arenas[node][index]);
 
     return iobuf_arena;
 }
 
+static struct iobuf *
+__iobuf_get(struct iobuf_pool *iobuf_pool, const size_t page_size,
+            const int node, const int index);
+
+static void
+__iobuf_put(struct iobuf *iobuf, struct iobuf_arena *iobuf_arena);
+
+/* Protects the binding between thread caches and pools. */
+static pthread_mutex_t iobuf_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread struct iobuf_cache *thread_iobuf_cache = NULL;
+
+/* Returns all the cached iobufs to the pool. Called with iobuf_cache_lock
+ * held, either by the owner thread when it terminates, or when the pool is
+ * destroyed. */
+static void
+__iobuf_cache_detach(struct iobuf_cache *cache)
+{
+    struct iobuf_pool *iobuf_pool = cache->iobuf_pool;
+    struct iobuf_magazine *mag = NULL;
+    struct iobuf *iobuf = NULL;
+    int node = 0;
+    int i = 0;
+
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    pthread_spin_lock(&cache->lock);
+    {
+        for (node = 0; node < cache->node_count; node++) {
+            for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
+                mag = iobuf_cache_mag(cache, node, i);
+                while (mag->count > 0) {
+                    iobuf = mag->iobufs[--mag->count];
+                    __iobuf_put(iobuf, iobuf->iobuf_arena);
+                }
+                iobuf_pool->cache_hits[i] += mag->hits;
+                iobuf_pool->cache_misses[i] += mag->misses;
+                mag->hits = 0;
+                mag->misses = 0;
+            }
+        }
+        list_del_init(&cache->list);
+        cache->iobuf_pool = NULL;
+    }
+    pthread_spin_unlock(&cache->lock);
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+}
+
+static void
+iobuf_pool_detach_caches(struct iobuf_pool *iobuf_pool)
+{
+    struct iobuf_cache *cache = NULL;
+    struct iobuf_cache *tmp = NULL;
+
+    pthread_mutex_lock(&iobuf_cache_lock);
+    {
+        list_for_each_entry_safe(cache, tmp, &iobuf_pool->caches, list)
+        {
+            __iobuf_cache_detach(cache);
+        }
+    }
+    pthread_mutex_unlock(&iobuf_cache_lock);
+
+    iobuf_pool_notify(iobuf_pool);
+}
+
+void
+iobuf_cache_thread_destructor(void)
+{
+    struct iobuf_cache *cache = thread_iobuf_cache;
+    struct iobuf_pool *iobuf_pool = NULL;
+
+    if (!cache)
+        return;
+
+    thread_iobuf_cache = NULL;
+
+    pthread_mutex_lock(&iobuf_cache_lock);
+    {
+        iobuf_pool = cache->iobuf_pool;
+        if (iobuf_pool)
+            __iobuf_cache_detach(cache);
+    }
+    pthread_mutex_unlock(&iobuf_cache_lock);
+
+    if (iobuf_pool)
+        iobuf_pool_notify(iobuf_pool);
+
+    pthread_spin_destroy(&cache->lock);
+    FREE(cache);
+}
+
+/* Returns the cache of the current thread for @iobuf_pool, or NULL if the
+ * thread cache is already being used for another pool. */
+static struct iobuf_cache *
+iobuf_cache_get(struct iobuf_pool *iobuf_pool)
+{
+    struct iobuf_cache *cache = thread_iobuf_cache;
+    struct iobuf_magazine *mag = NULL;
+    size_t page_size = 0;
+    int node_count = 0;
+    int node = 0;
+    int i = 0;
+
+#ifdef GF_DISABLE_MEMPOOL
+    /* Keep every allocation visible to memory debugging tools. */
+    return NULL;
+#endif
+
+    if (cache) {
+        if (cache->iobuf_pool == iobuf_pool)
+            return cache;
+        if (cache->iobuf_pool)
+            return NULL;
+    } else {
+        /* All the pools use the same number of nodes. */
+        node_count = iobuf_pool->node_count;
+        cache = CALLOC(1, sizeof(*cache) + node_count *
+                                               GF_VARIABLE_IOBUF_COUNT *
+                                               sizeof(struct iobuf_magazine));
+        if (!cache)
+            return NULL;
+
+        INIT_LIST_HEAD(&cache->list);
+        (void)pthread_spin_init(&cache->lock, PTHREAD_PROCESS_PRIVATE);
+        cache->node_count = node_count;
+        for (node = 0; node < node_count; node++) {
+            for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
+                mag = iobuf_cache_mag(cache, node, i);
+                page_size = gf_iobuf_init_config[i].pagesize;
+                mag->max = GF_IOBUF_MAGAZINE_BYTES / page_size;
+                if (mag->max > GF_IOBUF_MAGAZINE_SIZE)
+                    mag->max = GF_IOBUF_MAGAZINE_SIZE;
+                if (mag->max < 1)
+                    mag->max = 1;
+            }
+        }
+
+        thread_iobuf_cache = cache;
+
+        /* Make sure that the cached iobufs are returned to the pool when the
+         * thread terminates. */
+        gf_thread_needs_cleanup();
+    }
+
+    pthread_mutex_lock(&iobuf_cache_lock);
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    {
+        cache->iobuf_pool = iobuf_pool;
+        list_add_tail(&cache->list, &iobuf_pool->caches);
+    }
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+    pthread_mutex_unlock(&iobuf_cache_lock);
+
+    return cache;
+}
+
+/* Gets an iobuf from the magazine of the current thread. When it's empty, it
+ * is refilled with up to half of its capacity taking the pool mutex once. */
+static struct iobuf *
+iobuf_cache_alloc(struct iobuf_pool *iobuf_pool, const size_t page_size,
+                  const int node, const int index)
+{
+    struct iobuf_cache *cache = NULL;
+    struct iobuf_magazine *mag = NULL;
+    struct iobuf *iobufs[GF_IOBUF_MAGAZINE_SIZE];
+    struct iobuf *iobuf = NULL;
+    int count = 0;
+    int i = 0;
+
+    cache = iobuf_cache_get(iobuf_pool);
+    if (!cache)
+        return NULL;
+
+    mag = iobuf_cache_mag(cache, node, index);
+
+    pthread_spin_lock(&cache->lock);
+    {
+        if (mag->count > 0) {
+            iobuf = mag->iobufs[--mag->count];
+            mag->hits++;
+        } else {
+            mag->misses++;
+        }
+    }
+    pthread_spin_unlock(&cache->lock);
+
+    if (iobuf)
+        return iobuf;
+
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    {
+        iobuf = __iobuf_get(iobuf_pool, page_size, node, index);
+        /* Only take what is already available, don't map new arenas just
+         * to fill the magazine. */
+        while (iobuf && (count < mag->max / 2) &&
+               !list_empty(&iobuf_pool->arenas[node][index])) {
+            iobufs[count] = __iobuf_get(iobuf_pool, page_size, node, index);
+            if (!iobufs[count])
+                break;
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+
+    iobuf_pool_notify(iobuf_pool);
+
+    if (count > 0) {
+        pthread_spin_lock(&cache->lock);
+        {
+            for (i = 0; i < count; i++)
+                mag->iobufs[mag->count++] = iobufs[i];
+        }
+        pthread_spin_unlock(&cache->lock);
+    }
+
+    return iobuf;
+}
+
+/* Puts @iobuf into the magazine of the current thread. When it's full, half
+ * of it is returned to the pool taking the pool mutex once. Returns false if
+ * the iobuf can't be cached. iobufs from other NUMA nodes are never cached,
+ * so that they are not handed out again to threads of this node. */
+static gf_boolean_t
+iobuf_cache_free(struct iobuf_pool *iobuf_pool, struct iobuf *iobuf,
+                 const int node, const int index)
+{
+    struct iobuf_cache *cache = NULL;
+    struct iobuf_magazine *mag = NULL;
+    struct iobuf *iobufs[GF_IOBUF_MAGAZINE_SIZE];
+    int count = 0;
+    int i = 0;
+
+    if (iobuf->iobuf_arena->node != node)
+        return _gf_false;
+
+    cache = iobuf_cache_get(iobuf_pool);
+    if (!cache)
+        return _gf_false;
+
+    mag = iobuf_cache_mag(cache, node, index);
+
+    if (iobuf->free_ptr) {
+        iobuf->ptr = iobuf->free_ptr;
+        iobuf->free_ptr = NULL;
+    }
+
+    pthread_spin_lock(&cache->lock);
+    {
+        if (mag->count == mag->max) {
+            count = mag->count - mag->max / 2;
+            mag->count -= count;
+            memcpy(iobufs, &mag->iobufs[mag->count], count * sizeof(*iobufs));
+        }
+        mag->iobufs[mag->count++] = iobuf;
+    }
+    pthread_spin_unlock(&cache->lock);
+
+    if (count > 0) {
+        pthread_mutex_lock(&iobuf_pool->mutex);
+        {
+            for (i = 0; i < count; i++)
+                __iobuf_put(iobufs[i], iobufs[i]->iobuf_arena);
+        }
+        pthread_mutex_unlock(&iobuf_pool->mutex);
+
+        iobuf_pool_notify(iobuf_pool);
+    }
+
+    return _gf_true;
+}
+
 /* This function destroys all the iobufs and the iobuf_pool */
 void
 iobuf_pool_destroy(struct iobuf_pool *iobuf_pool)
 {
     struct iobuf_arena *iobuf_arena = NULL;
     struct iobuf_arena *tmp = NULL;
+    struct iobuf_arena_notifier *notifier = NULL;
+    struct iobuf_arena_notifier *tmp_notifier = NULL;
+    int node = 0;
     int i = 0;
 
     GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
 
+    iobuf_pool_detach_caches(iobuf_pool);
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
-        for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
-            list_for_each_entry_safe(iobuf_arena, tmp, &iobuf_pool->arenas[i],
-                                     list)
-            {
-                list_del_init(&iobuf_arena->list);
-                iobuf_pool->arena_cnt--;
-
-                __iobuf_arena_destroy(iobuf_arena);
-            }
-            list_for_each_entry_safe(iobuf_arena, tmp, &iobuf_pool->purge[i],
-                                     list)
-            {
-                list_del_init(&iobuf_arena->list);
-                iobuf_pool->arena_cnt--;
-                __iobuf_arena_destroy(iobuf_arena);
-            }
-            /* If there are no iobuf leaks, there should be no
-             * arenas in the filled list. If at all there are any
-             * arenas in the filled list, the below function will
-             * assert.
-             */
-            list_for_each_entry_safe(iobuf_arena, tmp, &iobuf_pool->filled[i],
-                                     list)
-            {
-                list_del_init(&iobuf_arena->list);
-                iobuf_pool->arena_cnt--;
-                __iobuf_arena_destroy(iobuf_arena);
+        for (node = 0; node < iobuf_pool->node_count; node++) {
+            for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
+                list_for_each_entry_safe(iobuf_arena, tmp,
+                                         &iobuf_pool->arenas[node][i], list)
+                {
+                    list_del_init(&iobuf_arena->list);
+                    iobuf_pool->arena_cnt--;
+
+                    __iobuf_arena_destroy(iobuf_arena);
+                }
+                list_for_each_entry_safe(iobuf_arena, tmp,
+                                         &iobuf_pool->purge[node][i], list)
+                {
+                    list_del_init(&iobuf_arena->list);
+                    iobuf_pool->arena_cnt--;
+                    __iobuf_arena_destroy(iobuf_arena);
+                }
+                /* If there are no iobuf leaks, there should be no
+                 * arenas in the filled list. If at all there are any
+                 * arenas in the filled list, the below function will
+                 * assert.
+                 */
+                list_for_each_entry_safe(iobuf_arena, tmp,
+                                         &iobuf_pool->filled[node][i], list)
+                {
+                    list_del_init(&iobuf_arena->list);
+                    iobuf_pool->arena_cnt--;
+                    __iobuf_arena_destroy(iobuf_arena);
+                }
+                /* If there are no iobuf leaks, there shoould be
+                 * no standard allocated arenas, iobuf_put will free
+                 * such arenas.
+                 * TODO: Free the stdalloc arenas forcefully if present?
+                 */
             }
-            /* If there are no iobuf leaks, there shoould be
-             * no standard allocated arenas, iobuf_put will free
-             * such arenas.
-             * TODO: Free the stdalloc arenas forcefully if present?
-             */
         }
     }
     pthread_mutex_unlock(&iobuf_pool->mutex);
 
+    /* All consumers should have removed their notifiers by now. */
+    list_for_each_entry_safe(notifier, tmp_notifier, &iobuf_pool->notifiers,
+                             list)
+    {
+        list_del_init(&notifier->list);
+        GF_FREE(notifier);
+    }
+
+    pthread_mutex_destroy(&iobuf_pool->notify_mutex);
     pthread_mutex_destroy(&iobuf_pool->mutex);
 
     GF_FREE(iobuf_pool);
@@ -290,11 +708,12 @@ iobuf_create_stdalloc_arena(struct iobuf_pool *iobuf_pool)
     INIT_LIST_HEAD(&iobuf_arena->active_list);
 
     iobuf_arena->iobuf_pool = iobuf_pool;
+    iobuf_arena->slot = -1;
 
     iobuf_arena->page_size = 0x7fffffff;
 
     list_add_tail(&iobuf_arena->list,
-                  &iobuf_pool->arenas[IOBUF_ARENA_MAX_INDEX]);
+                  &iobuf_pool->arenas[0][IOBUF_ARENA_MAX_INDEX]);
 
 err:
     return;
@@ -308,29 +727,40 @@ iobuf_pool_new(void)
     size_t page_size = 0;
     size_t arena_size = 0;
     int32_t num_pages = 0;
+    int node = 0;
 
     iobuf_pool = GF_CALLOC(sizeof(*iobuf_pool), 1, gf_common_mt_iobuf_pool);
     if (!iobuf_pool)
         goto out;
 
     pthread_mutex_init(&iobuf_pool->mutex, NULL);
-    for (i = 0; i <= IOBUF_ARENA_MAX_INDEX; i++) {
-        INIT_LIST_HEAD(&iobuf_pool->arenas[i]);
-        INIT_LIST_HEAD(&iobuf_pool->filled[i]);
-        INIT_LIST_HEAD(&iobuf_pool->purge[i]);
+    pthread_mutex_init(&iobuf_pool->notify_mutex, NULL);
+    GF_ATOMIC_INIT(iobuf_pool->notify_pending, 0);
+    INIT_LIST_HEAD(&iobuf_pool->notifiers);
+    INIT_LIST_HEAD(&iobuf_pool->caches);
+    for (node = 0; node < GF_NUMA_MAX_NODES; node++) {
+        for (i = 0; i <= IOBUF_ARENA_MAX_INDEX; i++) {
+            INIT_LIST_HEAD(&iobuf_pool->arenas[node][i]);
+            INIT_LIST_HEAD(&iobuf_pool->filled[node][i]);
+            INIT_LIST_HEAD(&iobuf_pool->purge[node][i]);
+        }
     }
 
     iobuf_pool->default_page_size = 128 * GF_UNIT_KB;
+    iobuf_pool->node_count = gf_numa_node_count();
 
     /* No locking required here
      * as no one else can use this pool yet
      */
-    for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
-        page_size = gf_iobuf_init_config[i].pagesize;
-        num_pages = gf_iobuf_init_config[i].num_pages;
+    for (node = 0; node < iobuf_pool->node_count; node++) {
+        for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
+            page_size = gf_iobuf_init_config[i].pagesize;
+            num_pages = gf_iobuf_init_config[i].num_pages;
 
-        if (__iobuf_pool_add_arena(iobuf_pool, page_size, num_pages, i) != NULL)
-            arena_size += page_size * num_pages;
+            if (__iobuf_pool_add_arena(iobuf_pool, page_size, num_pages, node,
+                                       i) != NULL)
+                arena_size += page_size * num_pages;
+        }
     }
 
     /* Need an arena to handle all the bigger iobuf requests */
@@ -351,12 +781,13 @@ __iobuf_arena_prune(struct iobuf_pool *iobuf_pool,
      * (ie, at least few iobufs free in arena), that way, there won't
      * be spurious mmap/unmap of buffers
      */
-    if (list_empty(&iobuf_pool->arenas[index]))
+    if (list_empty(&iobuf_pool->arenas[iobuf_arena->node][index]))
         goto out;
 
     /* All cases matched, destroy */
     list_del_init(&iobuf_arena->list);
     iobuf_pool->arena_cnt--;
+    iobuf_pool->node_stats[iobuf_arena->node].arena_cnt--;
 
     __iobuf_arena_destroy(iobuf_arena);
 
@@ -369,26 +800,31 @@ iobuf_pool_prune(struct iobuf_pool *iobuf_pool)
 {
     struct iobuf_arena *iobuf_arena = NULL;
     struct iobuf_arena *tmp = NULL;
+    int node = 0;
     int i = 0;
 
     GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
 
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
-        for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
-            if (list_empty(&iobuf_pool->arenas[i])) {
-                continue;
-            }
-
-            list_for_each_entry_safe(iobuf_arena, tmp, &iobuf_pool->purge[i],
-                                     list)
-            {
-                __iobuf_arena_prune(iobuf_pool, iobuf_arena, i);
+        for (node = 0; node < iobuf_pool->node_count; node++) {
+            for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
+                if (list_empty(&iobuf_pool->arenas[node][i])) {
+                    continue;
+                }
+
+                list_for_each_entry_safe(iobuf_arena, tmp,
+                                         &iobuf_pool->purge[node][i], list)
+                {
+                    __iobuf_arena_prune(iobuf_pool, iobuf_arena, i);
+                }
             }
         }
     }
     pthread_mutex_unlock(&iobuf_pool->mutex);
 
+    iobuf_pool_notify(iobuf_pool);
+
 out:
     return;
 }
@@ -396,13 +832,13 @@ out:
 /* Always called under the iobuf_pool mutex lock */
 static struct iobuf_arena *
 __iobuf_select_arena(struct iobuf_pool *iobuf_pool, const size_t page_size,
-                     const int index)
+                     const int node, const int index)
 {
     struct iobuf_arena *iobuf_arena = NULL;
     struct iobuf_arena *trav = NULL;
 
     /* look for unused iobuf from the head-most arena */
-    list_for_each_entry(trav, &iobuf_pool->arenas[index], list)
+    list_for_each_entry(trav, &iobuf_pool->arenas[node][index], list)
     {
         if (trav->passive_cnt) {
             iobuf_arena = trav;
@@ -414,7 +850,7 @@ __iobuf_select_arena(struct iobuf_pool *iobuf_pool, const size_t page_size,
         /* all arenas were full, find the right count to add */
         iobuf_arena = __iobuf_pool_add_arena(
             iobuf_pool, page_size, gf_iobuf_init_config[index].num_pages,
-            index);
+            node, index);
     }
 
     return iobuf_arena;
@@ -423,13 +859,13 @@ __iobuf_select_arena(struct iobuf_pool *iobuf_pool, const size_t page_size,
 /* Always called under the iobuf_pool mutex lock */
 static struct iobuf *
 __iobuf_get(struct iobuf_pool *iobuf_pool, const size_t page_size,
-            const int index)
+            const int node, const int index)
 {
     struct iobuf *iobuf = NULL;
     struct iobuf_arena *iobuf_arena = NULL;
 
     /* most eligible arena for picking an iobuf */
-    iobuf_arena = __iobuf_select_arena(iobuf_pool, page_size, index);
+    iobuf_arena = __iobuf_select_arena(iobuf_pool, page_size, node, index);
     if (!iobuf_arena)
         return NULL;
 
@@ -443,13 +879,14 @@ __iobuf_get(struct iobuf_pool *iobuf_pool, const size_t page_size,
 
     /* no resetting requied for this element */
     iobuf_arena->alloc_cnt++;
+    iobuf_pool->node_stats[node].allocs++;
 
     if (iobuf_arena->max_active < iobuf_arena->active_cnt)
         iobuf_arena->max_active = iobuf_arena->active_cnt;
 
     if (iobuf_arena->passive_cnt == 0) {
         list_del(&iobuf_arena->list);
-        list_add(&iobuf_arena->list, &iobuf_pool->filled[index]);
+        list_add(&iobuf_arena->list, &iobuf_pool->filled[node][index]);
     }
 
     iobuf->page_size = page_size;
@@ -473,7 +910,8 @@ iobuf_get_from_stdalloc(struct iobuf_pool *iobuf_pool, const size_t page_size)
     int ret = -1;
 
     /* The first arena in the 'MAX-INDEX' will always be used for misc */
-    list_for_each_entry(trav, &iobuf_pool->arenas[IOBUF_ARENA_MAX_INDEX], list)
+    list_for_each_entry(trav, &iobuf_pool->arenas[0][IOBUF_ARENA_MAX_INDEX],
+                        list)
     {
         iobuf_arena = trav;
         break;
@@ -539,29 +977,13 @@ out:
     return iobuf;
 }
 
-struct iobuf *
-iobuf_get2(struct iobuf_pool *iobuf_pool, size_t page_size)
+static struct iobuf *
+iobuf_get_pooled(struct iobuf_pool *iobuf_pool, size_t page_size)
 {
     struct iobuf *iobuf = NULL;
     size_t rounded_size = 0;
     int index = 0;
-
-    if (page_size == 0) {
-        page_size = iobuf_pool->default_page_size;
-    }
-
-    /* During smallfile testing we have observed the performance
-       is improved significantly while use standard allocation if
-       page size is less than equal to 128KB, the data is available
-       on the link https://github.com/gluster/glusterfs/issues/2771
-    */
-    if (page_size <= USE_IOBUF_POOL_IF_SIZE_GREATER_THAN) {
-        iobuf = iobuf_get_from_small(page_size);
-        if (!iobuf)
-            gf_smsg(THIS->name, GF_LOG_WARNING, 0, LG_MSG_IOBUF_NOT_FOUND,
-                    NULL);
-        return iobuf;
-    }
+    int node = 0;
 
     rounded_size = gf_iobuf_get_pagesize(page_size, &index);
     if (rounded_size == -1) {
@@ -583,9 +1005,17 @@ iobuf_get2(struct iobuf_pool *iobuf_pool, size_t page_size)
         return NULL;
     }
 
+    node = gf_numa_node_current() % iobuf_pool->node_count;
+
+    iobuf = iobuf_cache_alloc(iobuf_pool, rounded_size, node, index);
+    if (iobuf) {
+        iobuf_ref(iobuf);
+        return iobuf;
+    }
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
-        iobuf = __iobuf_get(iobuf_pool, rounded_size, index);
+        iobuf = __iobuf_get(iobuf_pool, rounded_size, node, index);
         if (!iobuf) {
             pthread_mutex_unlock(&iobuf_pool->mutex);
             gf_smsg(THIS->name, GF_LOG_WARNING, 0, LG_MSG_IOBUF_NOT_FOUND,
@@ -595,10 +1025,50 @@ iobuf_get2(struct iobuf_pool *iobuf_pool, size_t page_size)
         iobuf_ref(iobuf);
     }
     pthread_mutex_unlock(&iobuf_pool->mutex);
+
+    iobuf_pool_notify(iobuf_pool);
 post_unlock:
     return iobuf;
 }
 
+struct iobuf *
+iobuf_get2(struct iobuf_pool *iobuf_pool, size_t page_size)
+{
+    struct iobuf *iobuf = NULL;
+
+    if (page_size == 0) {
+        page_size = iobuf_pool->default_page_size;
+    }
+
+    /* During smallfile testing we have observed the performance
+       is improved significantly while use standard allocation if
+       page size is less than equal to 128KB, the data is available
+       on the link https://github.com/gluster/glusterfs/issues/2771
+    */
+    if (page_size <= USE_IOBUF_POOL_IF_SIZE_GREATER_THAN) {
+        iobuf = iobuf_get_from_small(page_size);
+        if (!iobuf)
+            gf_smsg(THIS->name, GF_LOG_WARNING, 0, LG_MSG_IOBUF_NOT_FOUND,
+                    NULL);
+        return iobuf;
+    }
+
+    return iobuf_get_pooled(iobuf_pool, page_size);
+}
+
+/* Same as iobuf_get2(), but small requests are also served from the mmapped
+ * arenas instead of the heap. Useful when the caller needs the memory to be
+ * part of an arena (see iobuf_arena_slot()). */
+struct iobuf *
+iobuf_get_from_arena(struct iobuf_pool *iobuf_pool, size_t page_size)
+{
+    if (page_size == 0) {
+        page_size = iobuf_pool->default_page_size;
+    }
+
+    return iobuf_get_pooled(iobuf_pool, page_size);
+}
+
 struct iobuf *
 iobuf_get_page_aligned(struct iobuf_pool *iobuf_pool, size_t page_size,
                        size_t align_size)
@@ -669,7 +1139,8 @@ __iobuf_put(struct iobuf *iobuf, struct iobuf_arena *iobuf_arena)
 
     if (iobuf_arena->passive_cnt == 0) {
         list_del(&iobuf_arena->list);
-        list_add_tail(&iobuf_arena->list, &iobuf_pool->arenas[index]);
+        list_add_tail(&iobuf_arena->list,
+                      &iobuf_pool->arenas[iobuf_arena->node][index]);
     }
 
     list_del_init(&iobuf->list);
@@ -685,7 +1156,8 @@ __iobuf_put(struct iobuf *iobuf, struct iobuf_arena *iobuf_arena)
 
     if (iobuf_arena->active_cnt == 0) {
         list_del(&iobuf_arena->list);
-        list_add_tail(&iobuf_arena->list, &iobuf_pool->purge[index]);
+        list_add_tail(&iobuf_arena->list,
+                      &iobuf_pool->purge[iobuf_arena->node][index]);
         GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
         __iobuf_arena_prune(iobuf_pool, iobuf_arena, index);
     }
@@ -698,6 +1170,8 @@ iobuf_put(struct iobuf *iobuf)
 {
     struct iobuf_arena *iobuf_arena = NULL;
     struct iobuf_pool *iobuf_pool = NULL;
+    int index = 0;
+    int node = 0;
 
     GF_VALIDATE_OR_GOTO("iobuf", iobuf, out);
 
@@ -714,12 +1188,23 @@ iobuf_put(struct iobuf *iobuf)
         return;
     }
 
+    index = gf_iobuf_get_arena_index(iobuf_arena->page_size);
+    if (index != -1) {
+        node = gf_numa_node_current() % iobuf_pool->node_count;
+        if (iobuf_cache_free(iobuf_pool, iobuf, node, index))
+            return;
+    }
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
+        if ((index != -1) && (iobuf_arena->node != node))
+            iobuf_pool->node_stats[iobuf_arena->node].remote_puts++;
         __iobuf_put(iobuf, iobuf_arena);
     }
     pthread_mutex_unlock(&iobuf_pool->mutex);
 
+    iobuf_pool_notify(iobuf_pool);
+
 out:
     return;
 }
@@ -768,6 +1253,7 @@ iobref_new()
 
     iobref->allocated = 16;
     iobref->used = 0;
+    iobref->pipe.fds[0] = iobref->pipe.fds[1] = -1;
 
     LOCK_INIT(&iobref->lock);
 
@@ -801,6 +1287,8 @@ iobref_destroy(struct iobref *iobref)
             iobuf_unref(iobuf);
     }
 
+    gf_pipe_put(&iobref->pipe);
+
     LOCK_DESTROY(&iobref->lock);
 
     GF_FREE(iobref->iobrefs);
@@ -847,6 +1335,179 @@ out:
     return;
 }
 
+/* Attaches a pipe to @iobref. The data in the pipe is the content of the
+ * only vector with a NULL base that goes along with @iobref. Transports that
+ * support it can send it without copying it to user space. The iobref takes
+ * the ownership of @gpipe, which must come from gf_pipe_get(). */
+int
+iobref_set_pipe(struct iobref *iobref, struct gf_pipe *gpipe)
+{
+    int ret = -EINVAL;
+
+    GF_VALIDATE_OR_GOTO("iobuf", iobref, out);
+
+    LOCK(&iobref->lock);
+    {
+        if (iobref->pipe.fds[0] < 0) {
+            iobref->pipe = *gpipe;
+            ret = 0;
+        }
+    }
+    UNLOCK(&iobref->lock);
+
+out:
+    return ret;
+}
+
+int
+iobref_pipe(struct iobref *iobref)
+{
+    GF_VALIDATE_OR_GOTO("iobuf", iobref, out);
+
+    return iobref->pipe.fds[0];
+
+out:
+    return -1;
+}
+
+/* Idle pipes of the current thread. */
+static __thread struct gf_pipe thread_pipes[GF_PIPE_CACHE_SIZE];
+static __thread int thread_pipe_count = 0;
+
+/* Idle pipes released by threads whose cache was full. */
+static pthread_mutex_t gf_pipe_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct gf_pipe gf_pipe_shared[GF_PIPE_SHARED_SIZE];
+static int gf_pipe_shared_count = 0;
+static int gf_pipe_count = 0; /* pipes open, busy or idle */
+static int gf_pipe_max = -1;
+
+static int
+gf_pipe_limit(void)
+{
+    struct rlimit rlim;
+    int max = GF_PIPE_MAX;
+
+    /* Each pipe takes two file descriptors. Pipes can't use more than one
+     * eighth of them. */
+    if ((getrlimit(RLIMIT_NOFILE, &rlim) == 0) &&
+        (rlim.rlim_cur != RLIM_INFINITY) && (rlim.rlim_cur / 16 < max))
+        max = rlim.rlim_cur / 16;
+
+    return max;
+}
+
+static void
+gf_pipe_close(struct gf_pipe *gpipe)
+{
+    sys_close(gpipe->fds[0]);
+    sys_close(gpipe->fds[1]);
+    gpipe->fds[0] = gpipe->fds[1] = -1;
+
+    pthread_mutex_lock(&gf_pipe_lock);
+    gf_pipe_count--;
+    pthread_mutex_unlock(&gf_pipe_lock);
+}
+
+/* Gets an empty pipe that can hold @capacity bytes. Returns -1 if there's
+ * none and no more pipes can be created. */
+int
+gf_pipe_get(struct gf_pipe *gpipe, size_t capacity)
+{
+#ifdef GF_LINUX_HOST_OS
+    gf_boolean_t create = _gf_false;
+    int ret = 0;
+
+    if (thread_pipe_count > 0) {
+        *gpipe = thread_pipes[--thread_pipe_count];
+    } else {
+        pthread_mutex_lock(&gf_pipe_lock);
+        {
+            if (gf_pipe_max < 0)
+                gf_pipe_max = gf_pipe_limit();
+
+            if (gf_pipe_shared_count > 0) {
+                *gpipe = gf_pipe_shared[--gf_pipe_shared_count];
+            } else if (gf_pipe_count < gf_pipe_max) {
+                gf_pipe_count++;
+                create = _gf_true;
+            } else {
+                ret = -1;
+            }
+        }
+        pthread_mutex_unlock(&gf_pipe_lock);
+
+        if (ret < 0)
+            return -1;
+
+        if (create) {
+            if (pipe2(gpipe->fds, O_CLOEXEC) != 0) {
+                pthread_mutex_lock(&gf_pipe_lock);
+                gf_pipe_count--;
+                pthread_mutex_unlock(&gf_pipe_lock);
+                return -1;
+            }
+            gpipe->size = fcntl(gpipe->fds[1], F_GETPIPE_SZ);
+        }
+    }
+
+    /* F_GETPIPE_SZ may have failed, leaving a negative size. */
+    if ((gpipe->size < 0) || ((size_t)gpipe->size < capacity)) {
+        ret = fcntl(gpipe->fds[1], F_SETPIPE_SZ, capacity);
+        if (ret < 0) {
+            /* It's still empty and usable for smaller requests. */
+            gf_pipe_put(gpipe);
+            return -1;
+        }
+        gpipe->size = ret;
+    }
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/* Gives @gpipe back to the pool. Pipes that still contain data, because the
+ * payload couldn't be completely sent, are closed. */
+void
+gf_pipe_put(struct gf_pipe *gpipe)
+{
+    int pending = 0;
+
+    if (gpipe->fds[0] < 0)
+        return;
+
+    if ((ioctl(gpipe->fds[0], FIONREAD, &pending) != 0) || (pending != 0)) {
+        gf_pipe_close(gpipe);
+        return;
+    }
+
+    if (thread_pipe_count < GF_PIPE_CACHE_SIZE) {
+        if (thread_pipe_count == 0)
+            gf_thread_needs_cleanup();
+        thread_pipes[thread_pipe_count++] = *gpipe;
+        gpipe->fds[0] = gpipe->fds[1] = -1;
+        return;
+    }
+
+    pthread_mutex_lock(&gf_pipe_lock);
+    if (gf_pipe_shared_count < GF_PIPE_SHARED_SIZE) {
+        gf_pipe_shared[gf_pipe_shared_count++] = *gpipe;
+        gpipe->fds[0] = gpipe->fds[1] = -1;
+    }
+    pthread_mutex_unlock(&gf_pipe_lock);
+
+    if (gpipe->fds[0] >= 0)
+        gf_pipe_close(gpipe);
+}
+
+void
+gf_pipe_thread_destructor(void)
+{
+    while (thread_pipe_count > 0)
+        gf_pipe_close(&thread_pipes[--thread_pipe_count]);
+}
+
 static void
 __iobref_grow(struct iobref *iobref)
 {
@@ -1022,6 +1683,10 @@ iobuf_arena_info_dump(struct iobuf_arena *iobuf_arena, const char *key_prefix)
     gf_proc_dump_write(key, "%d", iobuf_arena->max_active);
     gf_proc_dump_build_key(key, key_prefix, "page_size");
     gf_proc_dump_write(key, "%" GF_PRI_SIZET, iobuf_arena->page_size);
+    gf_proc_dump_build_key(key, key_prefix, "slot");
+    gf_proc_dump_write(key, "%d", iobuf_arena->slot);
+    gf_proc_dump_build_key(key, key_prefix, "node");
+    gf_proc_dump_write(key, "%d", iobuf_arena->node);
     list_for_each_entry(trav, &iobuf_arena->active_list, list)
     {
         gf_proc_dump_build_key(key, key_prefix, "active_iobuf.%d", i++);
@@ -1033,11 +1698,50 @@ out:
     return;
 }
 
+/* Always called under the iobuf_pool mutex lock */
+static void
+iobuf_cache_stats_dump(struct iobuf_pool *iobuf_pool, const int index)
+{
+    char key[GF_DUMP_MAX_BUF_LEN];
+    struct iobuf_cache *cache = NULL;
+    uint64_t hits = iobuf_pool->cache_hits[index];
+    uint64_t misses = iobuf_pool->cache_misses[index];
+    struct iobuf_magazine *mag = NULL;
+    uint64_t cached = 0;
+    int threads = 0;
+    int node = 0;
+
+    /* Counters of live caches are only updated by their owner thread, so the
+     * values may be slightly off, which is fine for statistics. */
+    list_for_each_entry(cache, &iobuf_pool->caches, list)
+    {
+        for (node = 0; node < cache->node_count; node++) {
+            mag = iobuf_cache_mag(cache, node, index);
+            hits += mag->hits;
+            misses += mag->misses;
+            cached += mag->count;
+        }
+        threads++;
+    }
+
+    if (!hits && !misses)
+        return;
+
+    snprintf(key, sizeof(key), "iobuf_pool.cache.%" GF_PRI_SIZET,
+             gf_iobuf_init_config[index].pagesize);
+    gf_proc_dump_write(key, "threads=%d,cached=%" PRIu64 ",hits=%" PRIu64
+                       ",misses=%" PRIu64 ",hit_rate=%.2f%%",
+                       threads, cached, hits, misses,
+                       (hits * 100.0) / (hits + misses));
+}
+
 void
 iobuf_stats_dump(struct iobuf_pool *iobuf_pool)
 {
     char msg[1024];
     struct iobuf_arena *trav = NULL;
+    struct iobuf_node_stats *stats = NULL;
+    int node = 0;
     int i = 1;
     int j = 0;
     int ret = -1;
@@ -1059,27 +1763,45 @@ iobuf_stats_dump(struct iobuf_pool *iobuf_pool)
     gf_proc_dump_write("iobuf_pool.request_misses", "%" PRId64,
                        iobuf_pool->request_misses);
 
+    gf_proc_dump_write("iobuf_pool.node_count", "%d", iobuf_pool->node_count);
+
+    for (node = 0; node < iobuf_pool->node_count; node++) {
+        stats = &iobuf_pool->node_stats[node];
+        snprintf(msg, sizeof(msg), "iobuf_pool.node.%d", node);
+        gf_proc_dump_write(msg,
+                           "arena_cnt=%d,allocs=%" PRIu64
+                           ",remote_puts=%" PRIu64,
+                           stats->arena_cnt, stats->allocs,
+                           stats->remote_puts);
+    }
+
     for (j = 0; j < IOBUF_ARENA_MAX_INDEX; j++) {
-        list_for_each_entry(trav, &iobuf_pool->arenas[j], list)
-        {
-            snprintf(msg, sizeof(msg), "arena.%d", i);
-            gf_proc_dump_add_section("%s", msg);
-            iobuf_arena_info_dump(trav, msg);
-            i++;
-        }
-        list_for_each_entry(trav, &iobuf_pool->purge[j], list)
-        {
-            snprintf(msg, sizeof(msg), "purge.%d", i);
-            gf_proc_dump_add_section("%s", msg);
-            iobuf_arena_info_dump(trav, msg);
-            i++;
-        }
-        list_for_each_entry(trav, &iobuf_pool->filled[j], list)
-        {
-            snprintf(msg, sizeof(msg), "filled.%d", i);
-            gf_proc_dump_add_section("%s", msg);
-            iobuf_arena_info_dump(trav, msg);
-            i++;
+        iobuf_cache_stats_dump(iobuf_pool, j);
+    }
+
+    for (node = 0; node < iobuf_pool->node_count; node++) {
+        for (j = 0; j < IOBUF_ARENA_MAX_INDEX; j++) {
+            list_for_each_entry(trav, &iobuf_pool->arenas[node][j], list)
+            {
+                snprintf(msg, sizeof(msg), "arena.%d", i);
+                gf_proc_dump_add_section("%s", msg);
+                iobuf_arena_info_dump(trav, msg);
+                i++;
+            }
+            list_for_each_entry(trav, &iobuf_pool->purge[node][j], list)
+            {
+                snprintf(msg, sizeof(msg), "purge.%d", i);
+                gf_proc_dump_add_section("%s", msg);
+                iobuf_arena_info_dump(trav, msg);
+                i++;
+            }
+            list_for_each_entry(trav, &iobuf_pool->filled[node][j], list)
+            {
+                snprintf(msg, sizeof(msg), "filled.%d", i);
+                gf_proc_dump_add_section("%s", msg);
+                iobuf_arena_info_dump(trav, msg);
+                i++;
+            }
         }
     }
 
@@ -1144,3 +1866,120 @@ iobuf_copy(struct iobuf_pool *iobuf_pool, const struct iovec *iovec_src,
 out:
     return ret;
 }
+
+int
+iobuf_arena_slot(struct iobuf *iobuf)
+{
+    GF_VALIDATE_OR_GOTO("iobuf", iobuf, out);
+
+    if (iobuf->iobuf_arena)
+        return iobuf->iobuf_arena->slot;
+
+out:
+    return -1;
+}
+
+/* Returns the slot of the arena that contains the whole [ptr, ptr + size)
+ * range, looking only at the iobufs referenced by @iobref. */
+int
+iobref_arena_slot(struct iobref *iobref, const void *ptr, size_t size)
+{
+    struct iobuf_arena *iobuf_arena = NULL;
+    struct iobuf *iobuf = NULL;
+    int slot = -1;
+    int i = 0;
+
+    GF_VALIDATE_OR_GOTO("iobuf", iobref, out);
+
+    LOCK(&iobref->lock);
+    {
+        for (i = 0; i < iobref->allocated; i++) {
+            iobuf = iobref->iobrefs[i];
+            if (!iobuf || !iobuf->iobuf_arena)
+                continue;
+
+            iobuf_arena = iobuf->iobuf_arena;
+            if ((iobuf_arena->slot >= 0) &&
+                ((char *)ptr >= (char *)iobuf_arena->mem_base) &&
+                ((char *)ptr + size <=
+                 (char *)iobuf_arena->mem_base + iobuf_arena->arena_size)) {
+                slot = iobuf_arena->slot;
+                break;
+            }
+        }
+    }
+    UNLOCK(&iobref->lock);
+
+out:
+    return slot;
+}
+
+/* Registers @fn to be notified about arena slot changes. The notifier is
+ * immediately called for all the arenas that already own a slot. */
+struct iobuf_arena_notifier *
+iobuf_pool_notifier_add(struct iobuf_pool *iobuf_pool, iobuf_arena_notify_t fn,
+                        void *data)
+{
+    struct iobuf_arena_notifier *notifier = NULL;
+    struct iobuf_arena *iobuf_arena = NULL;
+    void *base[GF_IOBUF_ARENA_SLOTS];
+    size_t size[GF_IOBUF_ARENA_SLOTS];
+    int i = 0;
+
+    GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
+    GF_VALIDATE_OR_GOTO("iobuf", fn, out);
+
+    notifier = GF_MALLOC(sizeof(*notifier), gf_common_mt_iobuf_notifier);
+    if (!notifier)
+        goto out;
+
+    INIT_LIST_HEAD(&notifier->list);
+    notifier->fn = fn;
+    notifier->data = data;
+
+    /* Deliver what's pending to the current notifiers first, so that the
+     * new one only needs the slots already in use. */
+    iobuf_pool_notify(iobuf_pool);
+
+    pthread_mutex_lock(&iobuf_pool->notify_mutex);
+    {
+        pthread_mutex_lock(&iobuf_pool->mutex);
+        {
+            for (i = 0; i < GF_IOBUF_ARENA_SLOTS; i++) {
+                iobuf_arena = iobuf_pool->slots[i];
+                base[i] = iobuf_arena ? iobuf_arena->mem_base : NULL;
+                size[i] = iobuf_arena ? iobuf_arena->arena_size : 0;
+            }
+        }
+        pthread_mutex_unlock(&iobuf_pool->mutex);
+
+        for (i = 0; i < GF_IOBUF_ARENA_SLOTS; i++) {
+            if (base[i])
+                fn(data, i, base[i], size[i]);
+        }
+        list_add_tail(&notifier->list, &iobuf_pool->notifiers);
+    }
+    pthread_mutex_unlock(&iobuf_pool->notify_mutex);
+
+out:
+    return notifier;
+}
+
+void
+iobuf_pool_notifier_del(struct iobuf_pool *iobuf_pool,
+                        struct iobuf_arena_notifier *notifier)
+{
+    GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
+    GF_VALIDATE_OR_GOTO("iobuf", notifier, out);
+
+    pthread_mutex_lock(&iobuf_pool->notify_mutex);
+    {
+        list_del_init(&notifier->list);
+    }
+    pthread_mutex_unlock(&iobuf_pool->notify_mutex);
+
+    GF_FREE(notifier);
+
+out:
+    return;
+}
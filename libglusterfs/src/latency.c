@@ -16,13 +16,18 @@
 #include <glusterfs/logging.h>
 #include "glusterfs/statedump.h"
 
+/* Stripe of the histograms updated by the current thread, plus one. */
+static __thread int gf_latency_stripe = 0;
+
+static unsigned int gf_latency_next_stripe = 0;
+
 gf_latency_t *
 gf_latency_new(size_t n)
 {
     int i = 0;
     gf_latency_t *lat = NULL;
 
-    lat = GF_MALLOC(n * sizeof(*lat), gf_common_mt_latency_t);
+    lat = GF_CALLOC(n, sizeof(*lat), gf_common_mt_latency_t);
     if (!lat)
         return NULL;
 
@@ -32,6 +37,131 @@ gf_latency_new(size_t n)
     return lat;
 }
 
+void
+gf_latency_destroy(gf_latency_t *lat)
+{
+    int i;
+
+    if (!lat)
+        return;
+
+    for (i = 0; i < GF_LATENCY_STRIPES; i++) {
+        free(lat->hist[i]);
+        lat->hist[i] = NULL;
+    }
+}
+
+void
+gf_latency_free(gf_latency_t *lat, size_t n)
+{
+    int i;
+
+    if (!lat)
+        return;
+
+    for (i = 0; i < n; i++) {
+        gf_latency_destroy(lat + i);
+    }
+    GF_FREE(lat);
+}
+
+static int
+gf_latency_bucket(uint64_t value)
+{
+    int shift;
+
+    if (value < GF_LATENCY_SUB_BUCKETS)
+        return value;
+
+    if (value >= (1ULL << GF_LATENCY_MAX_BITS))
+        return GF_LATENCY_BUCKETS - 1;
+
+    shift = 63 - __builtin_clzll(value) - GF_LATENCY_SUB_BITS;
+
+    return ((shift + 1) << GF_LATENCY_SUB_BITS) + (value >> shift) -
+           GF_LATENCY_SUB_BUCKETS;
+}
+
+/* Returns the value in the middle of the range covered by @bucket. */
+static uint64_t
+gf_latency_bucket_value(int bucket)
+{
+    uint64_t low;
+    int shift;
+
+    if (bucket < GF_LATENCY_SUB_BUCKETS)
+        return bucket;
+
+    shift = (bucket >> GF_LATENCY_SUB_BITS) - 1;
+    low = (uint64_t)((bucket & (GF_LATENCY_SUB_BUCKETS - 1)) +
+                     GF_LATENCY_SUB_BUCKETS)
+          << shift;
+
+    return low + ((1ULL << shift) >> 1);
+}
+
+static gf_latency_hist_t *
+gf_latency_hist_get(gf_latency_t *lat)
+{
+    gf_latency_hist_t *hist, *expected = NULL;
+    int stripe;
+
+    if (gf_latency_stripe == 0) {
+        gf_latency_stripe = __atomic_fetch_add(&gf_latency_next_stripe, 1,
+                                               __ATOMIC_RELAXED) %
+                                GF_LATENCY_STRIPES +
+                            1;
+    }
+    stripe = gf_latency_stripe - 1;
+
+    hist = __atomic_load_n(&lat->hist[stripe], __ATOMIC_ACQUIRE);
+    if (hist != NULL)
+        return hist;
+
+    /* The histogram can be allocated from any xlator, and it can outlive
+     * it, so it's not accounted to any of them. */
+    hist = calloc(1, sizeof(*hist));
+    if (hist == NULL)
+        return NULL;
+
+    if (!__atomic_compare_exchange_n(&lat->hist[stripe], &expected, hist,
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) {
+        free(hist);
+        hist = expected;
+    }
+
+    return hist;
+}
+
+void
+gf_latency_add(gf_latency_t *lat, uint64_t elapsed)
+{
+    gf_latency_hist_t *hist;
+    uint64_t old;
+
+    old = __atomic_load_n(&lat->max, __ATOMIC_RELAXED);
+    while ((old < elapsed) &&
+           !__atomic_compare_exchange_n(&lat->max, &old, elapsed, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    old = __atomic_load_n(&lat->min, __ATOMIC_RELAXED);
+    while ((old > elapsed) &&
+           !__atomic_compare_exchange_n(&lat->min, &old, elapsed, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    __atomic_fetch_add(&lat->total, elapsed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&lat->count, 1, __ATOMIC_RELAXED);
+
+    hist = gf_latency_hist_get(lat);
+    if (hist != NULL) {
+        __atomic_fetch_add(&hist->buckets[gf_latency_bucket(elapsed)], 1,
+                           __ATOMIC_RELAXED);
+    }
+}
+
 void
 gf_latency_update(gf_latency_t *lat, struct timespec *begin,
                   struct timespec *end)
@@ -43,25 +173,82 @@ gf_latency_update(gf_latency_t *lat, struct timespec *begin,
 
     int64_t elapsed = gf_tsdiff(begin, end);
 
-    if (lat->max < elapsed)
-        lat->max = elapsed;
+    if (elapsed < 0)
+        return;
 
-    if (lat->min > elapsed)
-        lat->min = elapsed;
+    gf_latency_add(lat, elapsed);
+}
 
-    lat->total += elapsed;
-    lat->count++;
+void
+gf_latency_percentiles(gf_latency_t *lat, const double *pct, uint64_t *values,
+                       int count)
+{
+    gf_latency_hist_t merged;
+    gf_latency_hist_t *hist;
+    uint64_t total = 0, rank, sum;
+    int i, j;
+
+    memset(&merged, 0, sizeof(merged));
+    for (i = 0; i < GF_LATENCY_STRIPES; i++) {
+        hist = __atomic_load_n(&lat->hist[i], __ATOMIC_ACQUIRE);
+        if (hist == NULL)
+            continue;
+        for (j = 0; j < GF_LATENCY_BUCKETS; j++) {
+            merged.buckets[j] += __atomic_load_n(&hist->buckets[j],
+                                                 __ATOMIC_RELAXED);
+        }
+    }
+    for (j = 0; j < GF_LATENCY_BUCKETS; j++) {
+        total += merged.buckets[j];
+    }
+
+    for (i = 0; i < count; i++) {
+        values[i] = 0;
+        if (total == 0)
+            continue;
+
+        rank = (uint64_t)(pct[i] * total + 0.5);
+        if (rank == 0)
+            rank = 1;
+
+        sum = 0;
+        for (j = 0; j < GF_LATENCY_BUCKETS - 1; j++) {
+            sum += merged.buckets[j];
+            if (sum >= rank)
+                break;
+        }
+        values[i] = gf_latency_bucket_value(j);
+
+        /* The extremes are known exactly. */
+        if (values[i] > lat->max)
+            values[i] = lat->max;
+        if (values[i] < lat->min)
+            values[i] = lat->min;
+    }
 }
 
 void
 gf_latency_reset(gf_latency_t *lat)
 {
+    gf_latency_hist_t *hist;
+    int i;
+
     if (!lat)
         return;
-    memset(lat, 0, sizeof(*lat));
+    lat->max = 0;
+    lat->total = 0;
+    lat->count = 0;
     lat->min = ULLONG_MAX;
     /* make sure 'min' is set to high value, so it would be
        properly set later */
+
+    /* Histograms are kept once allocated, since other threads may be
+     * updating them right now. */
+    for (i = 0; i < GF_LATENCY_STRIPES; i++) {
+        hist = __atomic_load_n(&lat->hist[i], __ATOMIC_ACQUIRE);
+        if (hist != NULL)
+            memset(hist, 0, sizeof(*hist));
+    }
 }
 
 void
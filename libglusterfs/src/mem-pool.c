@@ -11,6 +11,7 @@
 #include "glusterfs/mem-pool.h"
 #include "glusterfs/common-utils.h"  // for GF_ASSERT, gf_thread_cr...
 #include "glusterfs/globals.h"       // for xlator_t, THIS
+#include "glusterfs/gf-numa.h"       // for gf_numa_node_current
 #include <stdlib.h>
 #include <stdarg.h>
 
@@ -402,7 +403,7 @@ mem_pool_destroy(struct mem_pool *pool)
 static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
 static struct list_head pool_threads;
 static pthread_mutex_t pool_free_lock = PTHREAD_MUTEX_INITIALIZER;
-static struct list_head pool_free_threads;
+static struct list_head pool_free_threads[GF_NUMA_MAX_NODES];
 static struct mem_pool_shared pools[NPOOLS];
 static size_t pool_list_size;
 
@@ -553,7 +554,7 @@ mem_pool_thread_destructor(per_thread_pool_list_t *pool_list)
         }
 
         pthread_mutex_lock(&pool_free_lock);
-        list_add(&pool_list->thr_list, &pool_free_threads);
+        list_add(&pool_list->thr_list, &pool_free_threads[pool_list->node]);
         pthread_mutex_unlock(&pool_free_lock);
 
         thread_pool_list = NULL;
@@ -566,7 +567,9 @@ mem_pools_preinit(void)
     unsigned int i;
 
     INIT_LIST_HEAD(&pool_threads);
-    INIT_LIST_HEAD(&pool_free_threads);
+    for (i = 0; i < GF_NUMA_MAX_NODES; ++i) {
+        INIT_LIST_HEAD(&pool_free_threads[i]);
+    }
 
     for (i = 0; i < NPOOLS; ++i) {
         pools[i].power_of_two = POOL_SMALLEST + i;
@@ -744,16 +747,21 @@ mem_get_pool_list(void)
 {
     per_thread_pool_list_t *pool_list;
     unsigned int i;
+    int node;
 
     pool_list = thread_pool_list;
     if (pool_list) {
         return pool_list;
     }
 
+    /* Objects cached in a pool_list were first touched by the thread that
+     * created it, so only reuse pool_lists that belong to our own node. */
+    node = gf_numa_node_current();
+
     (void)pthread_mutex_lock(&pool_free_lock);
-    if (!list_empty(&pool_free_threads)) {
-        pool_list = list_entry(pool_free_threads.next, per_thread_pool_list_t,
-                               thr_list);
+    if (!list_empty(&pool_free_threads[node])) {
+        pool_list = list_entry(pool_free_threads[node].next,
+                               per_thread_pool_list_t, thr_list);
         list_del(&pool_list->thr_list);
     }
     (void)pthread_mutex_unlock(&pool_free_lock);
@@ -766,6 +774,9 @@ mem_get_pool_list(void)
 
         INIT_LIST_HEAD(&pool_list->thr_list);
         (void)pthread_spin_init(&pool_list->lock, PTHREAD_PROCESS_PRIVATE);
+        pool_list->node = node;
+        pool_list->allocs = 0;
+        pool_list->remote_puts = 0;
         for (i = 0; i < NPOOLS; ++i) {
             pool_list->pools[i].parent = &pools[i];
             pool_list->pools[i].hot_list = NULL;
@@ -813,11 +824,13 @@ mem_get_from_pool(struct mem_pool *mem_pool)
     retval = pt_pool->hot_list;
     if (retval) {
         pt_pool->hot_list = retval->next;
+        pool_list->allocs++;
         (void)pthread_spin_unlock(&pool_list->lock);
     } else {
         retval = pt_pool->cold_list;
         if (retval) {
             pt_pool->cold_list = retval->next;
+            pool_list->allocs++;
             (void)pthread_spin_unlock(&pool_list->lock);
         } else {
             (void)pthread_spin_unlock(&pool_list->lock);
@@ -880,6 +893,7 @@ mem_put_pool(void *ptr)
     pooled_obj_hdr_t *hdr;
     per_thread_pool_list_t *pool_list;
     per_thread_pool_t *pt_pool;
+    int node;
 
     if (!ptr) {
         gf_msg_callingfn("mem-pool", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
@@ -908,10 +922,15 @@ mem_put_pool(void *ptr)
 
     hdr->magic = GF_MEM_INVALID_MAGIC;
 
+    node = gf_numa_node_current();
+
     (void)pthread_spin_lock(&pool_list->lock);
     if (!pool_list->poison) {
         hdr->next = pt_pool->hot_list;
         pt_pool->hot_list = hdr;
+        if (pool_list->node != node) {
+            pool_list->remote_puts++;
+        }
         (void)pthread_spin_unlock(&pool_list->lock);
     } else {
         /* If the owner thread of this element has terminated, we simply
@@ -921,4 +940,42 @@ mem_put_pool(void *ptr)
     }
 }
 
+static void
+mem_pools_add_node_stats(per_thread_pool_list_t *pool_list,
+                         struct mem_pool_node_stats *stats)
+{
+    (void)pthread_spin_lock(&pool_list->lock);
+    stats->allocs += pool_list->allocs;
+    stats->remote_puts += pool_list->remote_puts;
+    (void)pthread_spin_unlock(&pool_list->lock);
+}
+
+/* Collects the counters of all the pool_lists, alive or not, that belong to
+ * @node. */
+void
+mem_pools_node_stats(int node, struct mem_pool_node_stats *stats)
+{
+    per_thread_pool_list_t *pool_list;
+
+    memset(stats, 0, sizeof(*stats));
+
+    (void)pthread_mutex_lock(&pool_lock);
+    list_for_each_entry(pool_list, &pool_threads, thr_list)
+    {
+        if (pool_list->node == node) {
+            stats->threads++;
+            mem_pools_add_node_stats(pool_list, stats);
+        }
+    }
+    (void)pthread_mutex_unlock(&pool_lock);
+
+    (void)pthread_mutex_lock(&pool_free_lock);
+    list_for_each_entry(pool_list, &pool_free_threads[node], thr_list)
+    {
+        stats->free_lists++;
+        mem_pools_add_node_stats(pool_list, stats);
+    }
+    (void)pthread_mutex_unlock(&pool_free_lock);
+}
+
 #endif /* GF_DISABLE_MEMPOOL */
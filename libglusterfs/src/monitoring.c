@@ -53,6 +53,9 @@ dump_latency_and_count(xlator_t *xl, int fd)
     uint64_t cbk = 0;
     uint64_t total_fop_count = 0;
     uint64_t interval_fop_count = 0;
+    static const double pct[] = {0.5, 0.99, 0.999};
+    uint64_t values[3];
+    gf_latency_t *lat;
 
     if (xl->winds) {
         dprintf(fd, "%s.total.pending-winds.count %" PRIu64 "\n", xl->name,
@@ -81,18 +84,23 @@ dump_latency_and_count(xlator_t *xl, int fd)
             dprintf(fd, "%s.interval.%s.fail_count %" PRIu64 "\n", xl->name,
                     gf_fop_list[index], cbk);
         }
-        if (xl->stats[index].latencies.count != 0) {
+        lat = &xl->stats[index].latencies;
+        if (lat->count != 0) {
             dprintf(fd, "%s.interval.%s.latency %lf\n", xl->name,
-                    gf_fop_list[index],
-                    (((double)xl->stats[index].latencies.total) /
-                     xl->stats[index].latencies.count));
+                    gf_fop_list[index], (((double)lat->total) / lat->count));
             dprintf(fd, "%s.interval.%s.max %" PRIu64 "\n", xl->name,
-                    gf_fop_list[index], xl->stats[index].latencies.max);
+                    gf_fop_list[index], lat->max);
             dprintf(fd, "%s.interval.%s.min %" PRIu64 "\n", xl->name,
-                    gf_fop_list[index], xl->stats[index].latencies.min);
+                    gf_fop_list[index], lat->min);
+            gf_latency_percentiles(lat, pct, values, 3);
+            dprintf(fd, "%s.interval.%s.p50 %" PRIu64 "\n", xl->name,
+                    gf_fop_list[index], values[0]);
+            dprintf(fd, "%s.interval.%s.p99 %" PRIu64 "\n", xl->name,
+                    gf_fop_list[index], values[1]);
+            dprintf(fd, "%s.interval.%s.p99.9 %" PRIu64 "\n", xl->name,
+                    gf_fop_list[index], values[2]);
         }
-        memset(&xl->stats[index].latencies, 0,
-               sizeof(xl->stats[index].latencies));
+        gf_latency_reset(lat);
     }
 
     dprintf(fd, "%s.total.fop-count %" PRIu64 "\n", xl->name, total_fop_count);
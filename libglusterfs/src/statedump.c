@@ -12,6 +12,7 @@
 #include "glusterfs/logging.h"
 #include "glusterfs/statedump.h"
 #include "glusterfs/syscall.h"
+#include "glusterfs/gf-numa.h"
 
 #ifdef HAVE_MALLOC_H
 #include <malloc.h>
@@ -210,15 +211,21 @@ gf_proc_dump_write(char *key, char *value, ...)
 void
 gf_latency_statedump_and_reset(char *key, gf_latency_t *lat)
 {
+    static const double pct[] = {0.5, 0.99, 0.999};
+    uint64_t values[3];
+
     /* Doesn't make sense to continue if there are no fops
        came in the given interval */
     if (!lat || !lat->count)
         return;
+    gf_latency_percentiles(lat, pct, values, 3);
     gf_proc_dump_write(key,
                        "AVG:%lf CNT:%" PRIu64 " TOTAL:%" PRIu64 " MIN:%" PRIu64
-                       " MAX:%" PRIu64,
+                       " MAX:%" PRIu64 " P50:%" PRIu64 " P99:%" PRIu64
+                       " P99.9:%" PRIu64,
                        (((double)lat->total) / lat->count), lat->count,
-                       lat->total, lat->min, lat->max);
+                       lat->total, lat->min, lat->max, values[0], values[1],
+                       values[2]);
     gf_latency_reset(lat);
 }
 
@@ -425,9 +432,22 @@ gf_proc_dump_mempool_info(glusterfs_ctx_t *ctx)
     gf_proc_dump_write("built with --disable-mempool", " so no memory pools");
 #else
     struct mem_pool *pool = NULL;
+    struct mem_pool_node_stats stats;
+    char key[GF_DUMP_MAX_BUF_LEN];
+    int node;
 
     gf_proc_dump_add_section("mempool");
 
+    for (node = 0; node < gf_numa_node_count(); node++) {
+        mem_pools_node_stats(node, &stats);
+        snprintf(key, sizeof(key), "node.%d", node);
+        gf_proc_dump_write(key,
+                           "threads=%" PRIu64 ",free_lists=%" PRIu64
+                           ",allocs=%" PRIu64 ",remote_puts=%" PRIu64,
+                           stats.threads, stats.free_lists, stats.allocs,
+                           stats.remote_puts);
+    }
+
     LOCK(&ctx->lock);
     {
         list_for_each_entry(pool, &ctx->mempool_list, owner)
@@ -253,6 +253,12 @@ sys_rename(const char *oldpath, const char *newpath)
     return FS_RET_CHECK0(rename(oldpath, newpath), errno);
 }
 
+int
+sys_renameat(int olddfd, const char *oldpath, int newdfd, const char *newpath)
+{
+    return FS_RET_CHECK0(renameat(olddfd, oldpath, newdfd, newpath), errno);
+}
+
 int
 sys_link(const char *oldpath, const char *newpath)
 {
@@ -875,6 +881,18 @@ sys_copy_file_range(int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
 #endif /* HAVE_COPY_FILE_RANGE */
 }
 
+int
+sys_statx(int dirfd, const char *path, int flags, unsigned int mask,
+          struct statx *buf)
+{
+#ifdef HAVE_STATX
+    return FS_RET_CHECK0(statx(dirfd, path, flags, mask, buf), errno);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif /* HAVE_STATX */
+}
+
 #ifdef __FreeBSD__
 int
 sys_kill(pid_t pid, int sig)
@@ -0,0 +1,224 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs/dict.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/mem-pool.h"
+#include "glusterfs/xlator.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define ALL_INLINE_PAIRS ((1U << DICT_INLINE_PAIRS) - 1)
+
+/*
+ * Helper functions
+ */
+static void
+helper_set_keys(dict_t *dict, int first, int count)
+{
+    char key[64];
+    int len, i;
+
+    for (i = first; i < first + count; i++) {
+        len = snprintf(key, sizeof(key), "key-%d", i);
+        assert_int_equal(dict_set_int32n(dict, key, len, i), 0);
+    }
+}
+
+static void
+helper_del_keys(dict_t *dict, int first, int count)
+{
+    char key[64];
+    int len, i;
+
+    for (i = first; i < first + count; i++) {
+        len = snprintf(key, sizeof(key), "key-%d", i);
+        assert_true(dict_deln(dict, key, len));
+    }
+}
+
+/* Checks that the keys in [first, first + count) are present with their
+ * values and that the ones in [first + count, end) are not. */
+static void
+helper_check_keys(dict_t *dict, int first, int count, int end)
+{
+    char key[64];
+    int32_t value;
+    int len, i;
+
+    for (i = first; i < end; i++) {
+        len = snprintf(key, sizeof(key), "key-%d", i);
+        if (i < first + count) {
+            assert_int_equal(dict_get_int32n(dict, key, len, &value), 0);
+            assert_int_equal(value, i);
+        } else {
+            assert_null(dict_getn(dict, key, len));
+        }
+    }
+}
+
+static int
+helper_setup(void **state)
+{
+    glusterfs_ctx_t *ctx;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+
+    mem_pools_init();
+
+    ctx->dict_pool = mem_pool_new(dict_t, 16);
+    ctx->dict_pair_pool = mem_pool_new(data_pair_t, 64);
+    ctx->dict_data_pool = mem_pool_new(data_t, 64);
+    assert_non_null(ctx->dict_pool);
+    assert_non_null(ctx->dict_pair_pool);
+    assert_non_null(ctx->dict_data_pool);
+
+    *state = ctx;
+
+    return 0;
+}
+
+/*
+ * Tests
+ */
+static void
+test_dict_inline_pairs_exhausted(void **state)
+{
+    dict_t *dict;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    helper_set_keys(dict, 0, DICT_INLINE_PAIRS);
+    assert_int_equal(dict->inline_used, ALL_INLINE_PAIRS);
+    assert_int_equal(dict->count, DICT_INLINE_PAIRS);
+
+    /* The next pairs come from the pool. */
+    helper_set_keys(dict, DICT_INLINE_PAIRS, 4);
+    assert_int_equal(dict->inline_used, ALL_INLINE_PAIRS);
+    assert_int_equal(dict->count, DICT_INLINE_PAIRS + 4);
+    assert_null(dict->members);
+    helper_check_keys(dict, 0, DICT_INLINE_PAIRS + 4, DICT_INLINE_PAIRS + 8);
+
+    /* Replacing a value doesn't take a new pair. */
+    assert_int_equal(dict_set_int32n(dict, "key-0", 5, 0), 0);
+    assert_int_equal(dict->count, DICT_INLINE_PAIRS + 4);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_inline_pairs_reused(void **state)
+{
+    dict_t *dict;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    helper_set_keys(dict, 0, DICT_INLINE_PAIRS + 4);
+
+    /* Deleting the first keys releases inline pairs, which are used again
+     * before taking pairs from the pool. */
+    helper_del_keys(dict, 0, 2);
+    assert_int_not_equal(dict->inline_used, ALL_INLINE_PAIRS);
+    assert_int_equal(dict->count, DICT_INLINE_PAIRS + 2);
+    helper_check_keys(dict, 2, DICT_INLINE_PAIRS + 2, DICT_INLINE_PAIRS + 4);
+
+    helper_set_keys(dict, 100, 2);
+    assert_int_equal(dict->inline_used, ALL_INLINE_PAIRS);
+    helper_check_keys(dict, 100, 2, 102);
+
+    /* Deleting pairs from the pool doesn't touch the inline ones. */
+    helper_del_keys(dict, DICT_INLINE_PAIRS, 4);
+    assert_int_equal(dict->inline_used, ALL_INLINE_PAIRS);
+    helper_check_keys(dict, 2, DICT_INLINE_PAIRS - 2, DICT_INLINE_PAIRS + 4);
+    helper_check_keys(dict, 100, 2, 102);
+
+    helper_del_keys(dict, 2, DICT_INLINE_PAIRS - 2);
+    helper_del_keys(dict, 100, 2);
+    assert_int_equal(dict->inline_used, 0);
+    assert_int_equal(dict->count, 0);
+    assert_int_equal(dict->totkvlen, 0);
+    assert_null(dict->members_list);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_index(void **state)
+{
+    dict_t *dict;
+    int count = DICT_INDEX_MIN_COUNT * 8;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    helper_set_keys(dict, 0, DICT_INDEX_MIN_COUNT - 1);
+    assert_null(dict->members);
+
+    /* The index is created and grown as keys are added. */
+    helper_set_keys(dict, DICT_INDEX_MIN_COUNT - 1,
+                    count - DICT_INDEX_MIN_COUNT + 1);
+    assert_non_null(dict->members);
+    assert_true(dict->hash_size >= count * 2);
+    helper_check_keys(dict, 0, count, count + 16);
+
+    /* Deletions move back the following entries of the index. Every other
+     * key must still be found after removing the rest. */
+    helper_del_keys(dict, 0, count / 2);
+    assert_int_equal(dict->count, count / 2);
+    helper_check_keys(dict, count / 2, count / 2, count);
+    helper_check_keys(dict, 0, 0, count / 2);
+
+    helper_set_keys(dict, 0, count / 2);
+    helper_check_keys(dict, 0, count, count + 16);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_keylen(void **state)
+{
+    dict_t *dict;
+    char key[] = "key-1-suffix";
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    /* Only the first keylen bytes of the key are used. */
+    assert_int_equal(dict_set_int32n(dict, key, 5, 1), 0);
+    helper_check_keys(dict, 1, 1, 2);
+    assert_null(dict_get(dict, key));
+    assert_int_equal(dict->totkvlen, 6 + sizeof("1"));
+
+    dict_unref(dict);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_dict_inline_pairs_exhausted),
+        cmocka_unit_test(test_dict_inline_pairs_reused),
+        cmocka_unit_test(test_dict_index),
+        cmocka_unit_test(test_dict_keylen),
+    };
+
+    return cmocka_run_group_tests(tests, helper_setup, NULL);
+}
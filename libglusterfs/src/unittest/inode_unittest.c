@@ -0,0 +1,292 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs/inode.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/mem-pool.h"
+#include "glusterfs/xlator.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmocka.h>
+
+#define TEST_THREADS 8
+#define TEST_LOOPS 100000
+#define TEST_LRU_LIMIT 16
+
+static glusterfs_graph_t test_graph = {
+    .xl_count = 1,
+};
+
+static xlator_t test_xl = {
+    .name = "inode-test",
+    .graph = &test_graph,
+};
+
+struct test_state {
+    inode_table_t *table;
+    uuid_t gfid;
+    int thread;
+    int errors;
+};
+
+/*
+ * Helper functions
+ */
+
+/* Links a new file in the root directory. The inode is returned with one
+ * reference and one lookup. */
+static inode_t *
+helper_link(inode_table_t *table, const char *name, uuid_t gfid)
+{
+    struct iatt iatt = {
+        0,
+    };
+    inode_t *inode;
+    inode_t *linked;
+
+    gf_uuid_generate(iatt.ia_gfid);
+    iatt.ia_type = IA_IFREG;
+    if (gfid)
+        gf_uuid_copy(gfid, iatt.ia_gfid);
+
+    inode = inode_new(table);
+    if (!inode)
+        return NULL;
+    linked = inode_link(inode, table->root, name, &iatt);
+    if (linked)
+        inode_lookup(linked);
+    inode_unref(inode);
+
+    return linked;
+}
+
+static void
+helper_run(void *(*fn)(void *), struct test_state *states, int count)
+{
+    pthread_t threads[TEST_THREADS];
+    int i;
+
+    for (i = 0; i < count; i++)
+        assert_int_equal(pthread_create(&threads[i], NULL, fn, &states[i]),
+                         0);
+    for (i = 0; i < count; i++) {
+        assert_int_equal(pthread_join(threads[i], NULL), 0);
+        assert_int_equal(states[i].errors, 0);
+    }
+}
+
+static void *
+helper_ref_unref(void *data)
+{
+    struct test_state *state = data;
+    inode_t *inode;
+    int i;
+
+    inode = inode_find(state->table, state->gfid);
+    if (!inode) {
+        state->errors++;
+        return NULL;
+    }
+
+    for (i = 0; i < TEST_LOOPS; i++) {
+        if (inode_ref(inode) != inode)
+            state->errors++;
+        inode_unref(inode);
+    }
+
+    inode_unref(inode);
+
+    return NULL;
+}
+
+static void *
+helper_find_unref(void *data)
+{
+    struct test_state *state = data;
+    inode_t *inode;
+    int i;
+
+    for (i = 0; i < TEST_LOOPS; i++) {
+        inode = inode_find(state->table, state->gfid);
+        if (!inode) {
+            state->errors++;
+            continue;
+        }
+        if (gf_uuid_compare(inode->gfid, state->gfid) != 0)
+            state->errors++;
+        inode_unref(inode);
+    }
+
+    return NULL;
+}
+
+static void *
+helper_lookup_forget(void *data)
+{
+    struct test_state *state = data;
+    char name[64];
+    inode_t *inode;
+    inode_t *found;
+    int i;
+
+    for (i = 0; i < TEST_LOOPS / 10; i++) {
+        /* Lookups and forgets of an inode shared by all the threads. */
+        inode = inode_find(state->table, state->gfid);
+        if (!inode) {
+            state->errors++;
+            continue;
+        }
+        inode_lookup(inode);
+        inode_forget(inode, 1);
+        inode_unref(inode);
+
+        /* New inodes that are forgotten and pushed out of the lru list by
+         * the others. */
+        snprintf(name, sizeof(name), "file-%d-%d", state->thread, i);
+        inode = helper_link(state->table, name, NULL);
+        if (!inode) {
+            state->errors++;
+            continue;
+        }
+        found = inode_grep(state->table, state->table->root, name);
+        if (found != inode)
+            state->errors++;
+        if (found)
+            inode_unref(found);
+        inode_unlink(inode, state->table->root, name);
+        inode_forget(inode, 1);
+        inode_unref(inode);
+    }
+
+    return NULL;
+}
+
+static int
+helper_setup(void **state)
+{
+    glusterfs_ctx_t *ctx;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+    test_xl.ctx = ctx;
+
+    mem_pools_init();
+
+    *state = ctx;
+
+    return 0;
+}
+
+static void
+helper_states_init(struct test_state *states, inode_table_t *table,
+                   uuid_t gfid)
+{
+    int i;
+
+    for (i = 0; i < TEST_THREADS; i++) {
+        states[i].table = table;
+        gf_uuid_copy(states[i].gfid, gfid);
+        states[i].thread = i;
+        states[i].errors = 0;
+    }
+}
+
+/*
+ * Tests
+ */
+static void
+test_inode_ref_unref_concurrent(void **state)
+{
+    struct test_state states[TEST_THREADS];
+    inode_table_t *table;
+    inode_t *inode;
+    uuid_t gfid;
+
+    table = inode_table_new(0, &test_xl, 0, 0);
+    assert_non_null(table);
+
+    /* The count never goes to 0, so it's only changed without the lock. */
+    inode = helper_link(table, "file", gfid);
+    assert_non_null(inode);
+    assert_int_equal(inode->ref, 1);
+
+    helper_states_init(states, table, gfid);
+    helper_run(helper_ref_unref, states, TEST_THREADS);
+    assert_int_equal(inode->ref, 1);
+    assert_true(!inode->in_lru_list);
+
+    /* Now it keeps moving between the active and the lru lists, while
+     * other threads increment the count without the lock when they can. */
+    inode_unref(inode);
+    assert_int_equal(inode->ref, 0);
+    assert_true(inode->in_lru_list);
+
+    helper_run(helper_find_unref, states, TEST_THREADS / 2);
+    helper_run(helper_ref_unref, states + TEST_THREADS / 2, TEST_THREADS / 2);
+    assert_int_equal(inode->ref, 0);
+    assert_true(inode->in_lru_list);
+    assert_int_equal(table->active_size, 1);
+    assert_int_equal(table->lru_size, 1);
+
+    inode_table_destroy(table);
+}
+
+static void
+test_inode_lookup_forget_concurrent(void **state)
+{
+    struct test_state states[TEST_THREADS];
+    inode_table_t *table;
+    inode_t *inode;
+    uuid_t gfid;
+
+    table = inode_table_new(TEST_LRU_LIMIT, &test_xl, 0, 0);
+    assert_non_null(table);
+
+    inode = helper_link(table, "shared", gfid);
+    assert_non_null(inode);
+
+    helper_states_init(states, table, gfid);
+    helper_run(helper_lookup_forget, states, TEST_THREADS);
+
+    /* The shared inode keeps the lookup of helper_link(). The other ones
+     * have been forgotten and some of them pruned. */
+    assert_ptr_equal(inode_find(table, gfid), inode);
+    assert_int_equal(inode->ref, 2);
+    assert_int_equal(GF_ATOMIC_GET(inode->nlookup), 1);
+    inode_unref(inode);
+
+    assert_int_equal(table->active_size, 2);
+    assert_true(table->lru_size <= TEST_LRU_LIMIT);
+    assert_ptr_equal(inode_grep(table, table->root, "shared"), inode);
+    inode_unref(inode);
+    inode_unref(inode);
+    assert_int_equal(table->active_size, 1);
+
+    inode_table_destroy(table);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_inode_ref_unref_concurrent),
+        cmocka_unit_test(test_inode_lookup_forget_concurrent),
+    };
+
+    return cmocka_run_group_tests(tests, helper_setup, NULL);
+}
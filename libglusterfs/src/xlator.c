@@ -818,6 +818,7 @@ xlator_members_free(xlator_t *xl)
 {
     volume_opt_list_t *vol_opt = NULL;
     volume_opt_list_t *tmp = NULL;
+    int i;
 
     if (!xl)
         return 0;
@@ -839,6 +840,10 @@ xlator_members_free(xlator_t *xl)
         GF_FREE(vol_opt);
     }
 
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        gf_latency_destroy(&xl->stats[i].latencies);
+    }
+
     return 0;
 }
 
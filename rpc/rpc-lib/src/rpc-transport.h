@@ -201,6 +201,9 @@ struct rpc_transport {
      * layer or in client management notification handler functions
      */
     gf_boolean_t connect_failed;
+    /* replies may carry a payload attached to the iobref as a pipe (see
+     * iobref_set_pipe()), which the transport sends without copying it */
+    gf_boolean_t pipe_payload;
     char poller_death_accept;
 };
 
@@ -0,0 +1,581 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifdef HAVE_LIBURING_BUF_RING
+
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <liburing.h>
+
+#include <glusterfs/common-utils.h>
+#include <glusterfs/logging.h>
+#include <glusterfs/mem-pool.h>
+
+#include "socket-uring.h"
+#include "socket-mem-types.h"
+
+/* Only a few requests are in flight at any time (the recv, one send, a wait
+ * for the connection or a wake up, and a cancellation), so a small ring is
+ * enough. */
+#define SOCKET_URING_ENTRIES 16
+
+/* Number of provided buffers. It must be a power of 2. */
+#define SOCKET_URING_BUFS 32
+#define SOCKET_URING_BUF_SIZE (32 * GF_UNIT_KB)
+
+#define SOCKET_URING_BGID 0
+
+/* Maximum time to wait for the cancellation of the pending requests when
+ * the connection is torn down. */
+#define SOCKET_URING_STOP_TIMEOUT 5
+
+enum {
+    SOCKET_URING_OP_RECV = 1,
+    SOCKET_URING_OP_SEND,
+    SOCKET_URING_OP_POLL,
+    SOCKET_URING_OP_NOP,
+    SOCKET_URING_OP_CANCEL
+};
+
+/* Received data waiting to be read, in one of the provided buffers. */
+struct socket_uring_rx {
+    uint32_t offset;
+    uint32_t len;
+    uint16_t bid;
+};
+
+struct socket_uring {
+    struct io_uring ring;
+    /* Serializes the access to the submission queue and the state of the
+     * requests in flight. The received data is only accessed by the event
+     * handler of the connection, which never runs concurrently with
+     * itself. */
+    pthread_mutex_t lock;
+    struct io_uring_buf_ring *br;
+    struct iobuf *bufs[SOCKET_URING_BUFS];
+    struct socket_uring_rx rx[SOCKET_URING_BUFS];
+    struct msghdr msg;
+    const char *name;
+    uint32_t rx_head;
+    uint32_t rx_count;
+    int rx_error;
+    int sock;
+    int inflight;
+    bool rx_eof;
+    bool starved; /* the recv stopped because all buffers were full */
+    bool receiving;
+    bool sending;
+    bool kicked;
+    bool throttled;
+    bool stopped;
+};
+
+static int
+__socket_uring_submit(struct socket_uring *uring, struct io_uring_sqe *sqe,
+                      uint64_t op)
+{
+    int ret;
+
+    io_uring_sqe_set_data64(sqe, op);
+
+    ret = io_uring_submit(&uring->ring);
+    if (ret < 0) {
+        gf_log(uring->name, GF_LOG_ERROR, "io_uring submission failed (%s)",
+               strerror(-ret));
+        return ret;
+    }
+
+    uring->inflight++;
+
+    return 0;
+}
+
+static int
+__socket_uring_recv(struct socket_uring *uring)
+{
+    struct io_uring_sqe *sqe;
+    int ret;
+
+    if (uring->receiving || uring->stopped) {
+        return 0;
+    }
+
+    sqe = io_uring_get_sqe(&uring->ring);
+    if (sqe == NULL) {
+        return -EAGAIN;
+    }
+
+    io_uring_prep_recv_multishot(sqe, uring->sock, NULL, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = SOCKET_URING_BGID;
+
+    ret = __socket_uring_submit(uring, sqe, SOCKET_URING_OP_RECV);
+    if (ret == 0) {
+        uring->receiving = true;
+        uring->starved = false;
+    }
+
+    return ret;
+}
+
+static int
+__socket_uring_kick(struct socket_uring *uring)
+{
+    struct io_uring_sqe *sqe;
+    int ret;
+
+    if (uring->kicked || uring->stopped) {
+        return 0;
+    }
+
+    sqe = io_uring_get_sqe(&uring->ring);
+    if (sqe == NULL) {
+        return -EAGAIN;
+    }
+
+    io_uring_prep_nop(sqe);
+
+    ret = __socket_uring_submit(uring, sqe, SOCKET_URING_OP_NOP);
+    if (ret == 0) {
+        uring->kicked = true;
+    }
+
+    return ret;
+}
+
+struct socket_uring *
+socket_uring_new(const char *name, int sock, struct iobuf_pool *pool)
+{
+    struct socket_uring *uring;
+    int mask, ret, i;
+
+    uring = GF_CALLOC(1, sizeof(*uring), gf_sock_mt_uring);
+    if (uring == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    uring->name = name;
+    uring->sock = sock;
+
+    ret = io_uring_queue_init(SOCKET_URING_ENTRIES, &uring->ring, 0);
+    if (ret < 0) {
+        goto failed;
+    }
+
+    uring->br = io_uring_setup_buf_ring(&uring->ring, SOCKET_URING_BUFS,
+                                        SOCKET_URING_BGID, 0, &ret);
+    if (uring->br == NULL) {
+        goto failed_ring;
+    }
+
+    mask = io_uring_buf_ring_mask(SOCKET_URING_BUFS);
+    for (i = 0; i < SOCKET_URING_BUFS; i++) {
+        uring->bufs[i] = iobuf_get2(pool, SOCKET_URING_BUF_SIZE);
+        if (uring->bufs[i] == NULL) {
+            ret = -ENOMEM;
+            goto failed_bufs;
+        }
+        io_uring_buf_ring_add(uring->br, iobuf_ptr(uring->bufs[i]),
+                              SOCKET_URING_BUF_SIZE, i, mask, i);
+    }
+    io_uring_buf_ring_advance(uring->br, SOCKET_URING_BUFS);
+
+    pthread_mutex_init(&uring->lock, NULL);
+
+    return uring;
+
+failed_bufs:
+    while (i-- > 0) {
+        iobuf_unref(uring->bufs[i]);
+    }
+    io_uring_free_buf_ring(&uring->ring, uring->br, SOCKET_URING_BUFS,
+                           SOCKET_URING_BGID);
+failed_ring:
+    io_uring_queue_exit(&uring->ring);
+failed:
+    GF_FREE(uring);
+
+    errno = -ret;
+
+    return NULL;
+}
+
+/* Cancels all pending requests and waits until the kernel has released the
+ * memory they reference. Vectors of an in-flight send belong to the caller,
+ * so this must be done before they are released. */
+void
+socket_uring_stop(struct socket_uring *uring)
+{
+    struct __kernel_timespec ts = {.tv_sec = 1};
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe *cqe;
+    int tries = SOCKET_URING_STOP_TIMEOUT;
+
+    pthread_mutex_lock(&uring->lock);
+
+    if (uring->stopped) {
+        goto out;
+    }
+    uring->stopped = true;
+
+    if (uring->inflight == 0) {
+        goto out;
+    }
+
+    /* Requests waiting for the socket complete as soon as it's shut down. */
+    shutdown(uring->sock, SHUT_RDWR);
+
+    sqe = io_uring_get_sqe(&uring->ring);
+    if (sqe != NULL) {
+        io_uring_prep_cancel_fd(sqe, uring->sock, IORING_ASYNC_CANCEL_ALL);
+        __socket_uring_submit(uring, sqe, SOCKET_URING_OP_CANCEL);
+    }
+
+    while ((uring->inflight > 0) && (tries > 0)) {
+        if (io_uring_wait_cqe_timeout(&uring->ring, &cqe, &ts) < 0) {
+            tries--;
+            continue;
+        }
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+            uring->inflight--;
+        }
+        io_uring_cqe_seen(&uring->ring, cqe);
+    }
+
+    if (uring->inflight > 0) {
+        gf_log(uring->name, GF_LOG_WARNING,
+               "%d io_uring requests didn't complete after cancellation",
+               uring->inflight);
+    }
+
+    uring->receiving = false;
+    uring->sending = false;
+
+out:
+    pthread_mutex_unlock(&uring->lock);
+}
+
+void
+socket_uring_destroy(struct socket_uring *uring)
+{
+    int i;
+
+    socket_uring_stop(uring);
+
+    /* Closing the ring cancels anything that could still be pending. */
+    io_uring_free_buf_ring(&uring->ring, uring->br, SOCKET_URING_BUFS,
+                           SOCKET_URING_BGID);
+    io_uring_queue_exit(&uring->ring);
+
+    for (i = 0; i < SOCKET_URING_BUFS; i++) {
+        iobuf_unref(uring->bufs[i]);
+    }
+
+    pthread_mutex_destroy(&uring->lock);
+
+    GF_FREE(uring);
+}
+
+int
+socket_uring_fd(struct socket_uring *uring)
+{
+    return uring->ring.ring_fd;
+}
+
+/* Waits until a nonblocking connect() completes. The completion is reported
+ * as poll_out, like the socket would do. */
+int
+socket_uring_connect(struct socket_uring *uring)
+{
+    struct io_uring_sqe *sqe;
+    int ret = -EAGAIN;
+
+    pthread_mutex_lock(&uring->lock);
+
+    sqe = io_uring_get_sqe(&uring->ring);
+    if (sqe != NULL) {
+        io_uring_prep_poll_add(sqe, uring->sock, POLLOUT);
+        ret = __socket_uring_submit(uring, sqe, SOCKET_URING_OP_POLL);
+    }
+
+    pthread_mutex_unlock(&uring->lock);
+
+    return ret;
+}
+
+int
+socket_uring_recv(struct socket_uring *uring)
+{
+    int ret;
+
+    pthread_mutex_lock(&uring->lock);
+    ret = __socket_uring_recv(uring);
+    pthread_mutex_unlock(&uring->lock);
+
+    return ret;
+}
+
+/* Only one send can be in flight, otherwise a partial write could interleave
+ * data of different messages. The vectors must be kept unmodified until the
+ * completion has been reaped. */
+int
+socket_uring_send(struct socket_uring *uring, struct iovec *vector, int count)
+{
+    struct io_uring_sqe *sqe;
+    int ret = -EBUSY;
+
+    pthread_mutex_lock(&uring->lock);
+
+    if (uring->stopped) {
+        ret = -ENOTCONN;
+        goto out;
+    }
+    if (uring->sending) {
+        goto out;
+    }
+
+    sqe = io_uring_get_sqe(&uring->ring);
+    if (sqe == NULL) {
+        ret = -EAGAIN;
+        goto out;
+    }
+
+    uring->msg.msg_iov = vector;
+    uring->msg.msg_iovlen = min(IOV_MAX, count);
+    io_uring_prep_sendmsg(sqe, uring->sock, &uring->msg, MSG_NOSIGNAL);
+
+    ret = __socket_uring_submit(uring, sqe, SOCKET_URING_OP_SEND);
+    if (ret == 0) {
+        uring->sending = true;
+    }
+
+out:
+    pthread_mutex_unlock(&uring->lock);
+
+    return ret;
+}
+
+bool
+socket_uring_sending(struct socket_uring *uring)
+{
+    bool sending;
+
+    pthread_mutex_lock(&uring->lock);
+    sending = uring->sending;
+    pthread_mutex_unlock(&uring->lock);
+
+    return sending;
+}
+
+/* Same semantics as readv() on a nonblocking socket, but the data is taken
+ * from the buffers already filled by the kernel. Buffers that have been
+ * completely read are given back to the kernel. */
+ssize_t
+socket_uring_readv(struct socket_uring *uring, struct iovec *vector,
+                   int count)
+{
+    struct socket_uring_rx *rx;
+    size_t offset = 0;
+    size_t len;
+    ssize_t total = 0;
+    int mask, recycled = 0;
+
+    mask = io_uring_buf_ring_mask(SOCKET_URING_BUFS);
+
+    while ((count > 0) && (uring->rx_count > 0)) {
+        if (offset >= vector->iov_len) {
+            vector++;
+            count--;
+            offset = 0;
+            continue;
+        }
+
+        rx = &uring->rx[uring->rx_head];
+        len = min(vector->iov_len - offset, rx->len);
+        memcpy(vector->iov_base + offset,
+               iobuf_ptr(uring->bufs[rx->bid]) + rx->offset, len);
+        offset += len;
+        total += len;
+        rx->offset += len;
+        rx->len -= len;
+
+        if (rx->len == 0) {
+            io_uring_buf_ring_add(uring->br, iobuf_ptr(uring->bufs[rx->bid]),
+                                  SOCKET_URING_BUF_SIZE, rx->bid, mask,
+                                  recycled++);
+            uring->rx_head = (uring->rx_head + 1) % SOCKET_URING_BUFS;
+            uring->rx_count--;
+        }
+    }
+
+    if (recycled > 0) {
+        io_uring_buf_ring_advance(uring->br, recycled);
+
+        pthread_mutex_lock(&uring->lock);
+        if (uring->starved) {
+            __socket_uring_recv(uring);
+        }
+        pthread_mutex_unlock(&uring->lock);
+    }
+
+    if (total > 0) {
+        return total;
+    }
+
+    if (uring->rx_error != 0) {
+        errno = uring->rx_error;
+        return -1;
+    }
+    if (uring->rx_eof) {
+        return 0;
+    }
+
+    errno = EAGAIN;
+
+    return -1;
+}
+
+static bool
+__socket_uring_pending(struct socket_uring *uring)
+{
+    if (uring->throttled) {
+        return false;
+    }
+
+    return (uring->rx_count > 0) || uring->rx_eof || (uring->rx_error != 0);
+}
+
+/* Tells if there's something to read that won't be notified by a new
+ * completion. */
+bool
+socket_uring_pending(struct socket_uring *uring)
+{
+    bool pending;
+
+    pthread_mutex_lock(&uring->lock);
+    pending = __socket_uring_pending(uring);
+    pthread_mutex_unlock(&uring->lock);
+
+    return pending;
+}
+
+static void
+__socket_uring_received(struct socket_uring *uring, struct io_uring_cqe *cqe)
+{
+    uint32_t tail;
+
+    if (cqe->res > 0) {
+        tail = (uring->rx_head + uring->rx_count) % SOCKET_URING_BUFS;
+        uring->rx[tail].bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        uring->rx[tail].offset = 0;
+        uring->rx[tail].len = cqe->res;
+        uring->rx_count++;
+    } else if (cqe->res == 0) {
+        uring->rx_eof = true;
+    } else if (cqe->res == -ENOBUFS) {
+        /* The recv is restarted as soon as a buffer is released. */
+        uring->starved = true;
+    } else if (cqe->res != -ECANCELED) {
+        uring->rx_error = -cqe->res;
+    }
+
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+        uring->receiving = false;
+        /* The kernel can end a multishot request at any time. */
+        if ((cqe->res > 0) && !uring->starved) {
+            __socket_uring_recv(uring);
+        }
+    }
+}
+
+/* Processes all available completions. It's only called from the event
+ * handler of the connection. */
+void
+socket_uring_reap(struct socket_uring *uring,
+                  struct socket_uring_events *events)
+{
+    struct io_uring_cqe *cqe;
+
+    memset(events, 0, sizeof(*events));
+
+    pthread_mutex_lock(&uring->lock);
+
+    while (io_uring_peek_cqe(&uring->ring, &cqe) == 0) {
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+            uring->inflight--;
+        }
+
+        switch (io_uring_cqe_get_data64(cqe)) {
+            case SOCKET_URING_OP_RECV:
+                __socket_uring_received(uring, cqe);
+                break;
+            case SOCKET_URING_OP_SEND:
+                uring->sending = false;
+                if (events->sent >= 0) {
+                    events->sent = (cqe->res < 0) ? cqe->res
+                                                  : events->sent + cqe->res;
+                }
+                events->poll_out = 1;
+                break;
+            case SOCKET_URING_OP_POLL:
+                if (cqe->res < 0) {
+                    events->poll_err = 1;
+                } else {
+                    events->poll_out |= (cqe->res & POLLOUT) != 0;
+                    events->poll_err |= (cqe->res & (POLLERR | POLLHUP)) != 0;
+                }
+                break;
+            case SOCKET_URING_OP_NOP:
+                uring->kicked = false;
+                break;
+            default:
+                break;
+        }
+
+        io_uring_cqe_seen(&uring->ring, cqe);
+    }
+
+    events->poll_in = __socket_uring_pending(uring);
+
+    pthread_mutex_unlock(&uring->lock);
+}
+
+/* Makes sure that the event handler will be called again if there's pending
+ * data. It must be called before releasing the event. */
+void
+socket_uring_rearm(struct socket_uring *uring)
+{
+    pthread_mutex_lock(&uring->lock);
+    if (__socket_uring_pending(uring)) {
+        __socket_uring_kick(uring);
+    }
+    pthread_mutex_unlock(&uring->lock);
+}
+
+/* While throttled, received data is kept in the buffers. Once they are all
+ * full, the kernel stops receiving and the peer is blocked by TCP flow
+ * control. */
+void
+socket_uring_throttle(struct socket_uring *uring, bool onoff)
+{
+    pthread_mutex_lock(&uring->lock);
+
+    uring->throttled = onoff;
+    if (!onoff) {
+        __socket_uring_kick(uring);
+    }
+
+    pthread_mutex_unlock(&uring->lock);
+}
+
+#endif /* HAVE_LIBURING_BUF_RING */
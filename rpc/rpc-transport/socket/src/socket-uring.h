@@ -0,0 +1,170 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef _SOCKET_URING_H
+#define _SOCKET_URING_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <glusterfs/iobuf.h>
+
+/* io_uring based data path for a socket.
+ *
+ * Each connection gets a small ring. Incoming data is received by a
+ * multishot recv into a ring of provided buffers backed by iobufs, so a
+ * single request keeps receiving for as long as there are free buffers.
+ * Outgoing messages are sent with sendmsg requests submitted to the same
+ * ring. The fd of the ring is the one registered in the event pool: the
+ * connection is driven by completions instead of readiness notifications.
+ *
+ * The framing of the messages is not touched. socket.c parses the received
+ * data with the same state machine it uses for plain sockets. */
+
+struct socket_uring;
+
+/* Summary of the completions collected by socket_uring_reap(). */
+struct socket_uring_events {
+    ssize_t sent; /* bytes written by a send, or -errno if it failed */
+    int poll_in;  /* there's received data, EOF or an error to read */
+    int poll_out; /* a send or a wait for connection has completed */
+    int poll_err;
+};
+
+#ifdef HAVE_LIBURING_BUF_RING
+
+struct socket_uring *
+socket_uring_new(const char *name, int sock, struct iobuf_pool *pool);
+
+void
+socket_uring_stop(struct socket_uring *uring);
+
+void
+socket_uring_destroy(struct socket_uring *uring);
+
+int
+socket_uring_fd(struct socket_uring *uring);
+
+int
+socket_uring_connect(struct socket_uring *uring);
+
+int
+socket_uring_recv(struct socket_uring *uring);
+
+int
+socket_uring_send(struct socket_uring *uring, struct iovec *vector, int count);
+
+bool
+socket_uring_sending(struct socket_uring *uring);
+
+ssize_t
+socket_uring_readv(struct socket_uring *uring, struct iovec *vector,
+                   int count);
+
+bool
+socket_uring_pending(struct socket_uring *uring);
+
+void
+socket_uring_reap(struct socket_uring *uring,
+                  struct socket_uring_events *events);
+
+void
+socket_uring_rearm(struct socket_uring *uring);
+
+void
+socket_uring_throttle(struct socket_uring *uring, bool onoff);
+
+#else /* !HAVE_LIBURING_BUF_RING */
+
+/* socket_uring_new() always fails, so none of the other functions is ever
+ * called with a valid object. */
+
+static inline struct socket_uring *
+socket_uring_new(const char *name, int sock, struct iobuf_pool *pool)
+{
+    errno = ENOTSUP;
+    return NULL;
+}
+
+static inline void
+socket_uring_stop(struct socket_uring *uring)
+{
+}
+
+static inline void
+socket_uring_destroy(struct socket_uring *uring)
+{
+}
+
+static inline int
+socket_uring_fd(struct socket_uring *uring)
+{
+    return -1;
+}
+
+static inline int
+socket_uring_connect(struct socket_uring *uring)
+{
+    return -ENOTSUP;
+}
+
+static inline int
+socket_uring_recv(struct socket_uring *uring)
+{
+    return -ENOTSUP;
+}
+
+static inline int
+socket_uring_send(struct socket_uring *uring, struct iovec *vector, int count)
+{
+    return -ENOTSUP;
+}
+
+static inline bool
+socket_uring_sending(struct socket_uring *uring)
+{
+    return false;
+}
+
+static inline ssize_t
+socket_uring_readv(struct socket_uring *uring, struct iovec *vector,
+                   int count)
+{
+    errno = ENOTSUP;
+    return -1;
+}
+
+static inline bool
+socket_uring_pending(struct socket_uring *uring)
+{
+    return false;
+}
+
+static inline void
+socket_uring_reap(struct socket_uring *uring,
+                  struct socket_uring_events *events)
+{
+}
+
+static inline void
+socket_uring_rearm(struct socket_uring *uring)
+{
+}
+
+static inline void
+socket_uring_throttle(struct socket_uring *uring, bool onoff)
+{
+}
+
+#endif /* HAVE_LIBURING_BUF_RING */
+
+#endif /* _SOCKET_URING_H */
@@ -14,6 +14,7 @@
 #include <glusterfs/syscall.h>
 #include <glusterfs/compat-errno.h>
 #include "socket-mem-types.h"
+#include "socket-uring.h"
 
 /* ugly #includes below */
 #include "protocol-common.h"
@@ -66,6 +67,11 @@
 
 #define IOV_MIN(n) min(IOV_MAX, n)
 
+/* fd registered in the event pool for the connection. With io_uring it's the
+ * fd of the ring, not the socket. */
+#define SOCKET_EVENT_FD(priv)                                                  \
+    (((priv)->uring != NULL) ? socket_uring_fd((priv)->uring) : (priv)->sock)
+
 typedef int
 SSL_unary_func(SSL *);
 typedef int
@@ -550,6 +556,8 @@ __socket_ssl_readv(rpc_transport_t *this, struct iovec *opvector, int opcount)
     if (priv->use_ssl) {
         gf_log(this->name, GF_LOG_TRACE, "***** reading over SSL");
         ret = ssl_read_one(priv, opvector->iov_base, opvector->iov_len);
+    } else if (priv->uring != NULL) {
+        ret = socket_uring_readv(priv->uring, opvector, IOV_MIN(opcount));
     } else {
         gf_log(this->name, GF_LOG_TRACE, "***** reading over non-SSL");
         ret = sys_readv(sock, opvector, IOV_MIN(opcount));
@@ -1155,7 +1163,16 @@ __socket_reset(rpc_transport_t *this)
 
     memset(&priv->incoming, 0, sizeof(priv->incoming));
 
-    gf_event_unregister_close(this->ctx->event_pool, priv->sock, priv->idx);
+    if (priv->uring != NULL) {
+        gf_event_unregister(this->ctx->event_pool,
+                            socket_uring_fd(priv->uring), priv->idx);
+        socket_uring_destroy(priv->uring);
+        priv->uring = NULL;
+        sys_close(priv->sock);
+    } else {
+        gf_event_unregister_close(this->ctx->event_pool, priv->sock,
+                                  priv->idx);
+    }
     if (priv->use_ssl && priv->ssl_ssl) {
         SSL_clear(priv->ssl_ssl);
         SSL_free(priv->ssl_ssl);
@@ -1207,10 +1224,11 @@ socket_set_last_frag_header_size(uint32_t size, char *haddr)
 }
 
 static struct ioq *
-__socket_ioq_new(rpc_transport_msg_t *msg)
+__socket_ioq_new(rpc_transport_t *this, rpc_transport_msg_t *msg)
 {
     struct ioq *entry = NULL;
     int count = 0;
+    int pipe_fd = -1;
     uint32_t size = 0;
 
     count = msg->rpchdrcount + msg->proghdrcount + msg->progpayloadcount;
@@ -1229,6 +1247,15 @@ __socket_ioq_new(rpc_transport_msg_t *msg)
         return NULL;
     }
 
+    if (msg->iobref != NULL)
+        pipe_fd = iobref_pipe(msg->iobref);
+    if ((pipe_fd >= 0) && !this->pipe_payload) {
+        gf_log(this->name, GF_LOG_ERROR,
+               "message with a pipe payload submitted to a transport that "
+               "doesn't support it");
+        return NULL;
+    }
+
     entry = GF_CALLOC(1, sizeof(*entry), gf_common_mt_ioq);
     if (!entry)
         return NULL;
@@ -1264,6 +1291,7 @@ __socket_ioq_new(rpc_transport_msg_t *msg)
 
     if (msg->iobref != NULL)
         entry->iobref = iobref_ref(msg->iobref);
+    entry->pipe_fd = pipe_fd;
 
     return entry;
 }
@@ -1283,6 +1311,10 @@ __socket_ioq_flush(socket_private_t *priv)
 {
     struct ioq *entry = NULL;
 
+    /* the kernel could still be reading the vectors of the first entry */
+    if (priv->uring != NULL)
+        socket_uring_stop(priv->uring);
+
     while (!list_empty(&priv->ioq)) {
         entry = priv->ioq_next;
         if (entry)
@@ -1290,14 +1322,99 @@ __socket_ioq_flush(socket_private_t *priv)
     }
 }
 
+#ifdef GF_LINUX_HOST_OS
+/* Same as __socket_writev() for an ioq entry whose payload is in a pipe. The
+ * vectors in memory are written as usual, and the one with a NULL base is
+ * spliced from the pipe into the socket, so the data never gets copied to
+ * user space. */
+static int
+__socket_splicev(rpc_transport_t *this, struct ioq *entry)
+{
+    socket_private_t *priv = this->private;
+    struct iovec *vector = NULL;
+    unsigned int flags = 0;
+    ssize_t len = 0;
+    int count = 0;
+    int pending = 0;
+    int ret = 0;
+
+    while (entry->pending_count > 0) {
+        vector = entry->pending_vector;
+
+        if (vector->iov_base != NULL) {
+            for (count = 1; count < entry->pending_count; count++) {
+                if (vector[count].iov_base == NULL)
+                    break;
+            }
+            pending = count;
+            ret = __socket_writev(this, vector, count, &entry->pending_vector,
+                                  &pending);
+            if (ret < 0)
+                return ret;
+            entry->pending_count -= count - pending;
+            if (ret > 0)
+                return ret;
+            continue;
+        }
+
+        if (vector->iov_len == 0) {
+            entry->pending_vector++;
+            entry->pending_count--;
+            continue;
+        }
+
+        flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+        if (entry->pending_count > 1)
+            flags |= SPLICE_F_MORE;
+
+        len = splice(entry->pipe_fd, NULL, priv->sock, NULL, vector->iov_len,
+                     flags);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                return entry->pending_count;
+            GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                                "splice on %s failed (%s)",
+                                this->peerinfo.identifier, strerror(errno));
+            return -1;
+        }
+        if (len == 0) {
+            /* The pipe is filled before submitting the reply, so this can
+             * only mean that the payload is shorter than announced. */
+            gf_log(this->name, GF_LOG_ERROR,
+                   "pipe payload for %s ended prematurely",
+                   this->peerinfo.identifier);
+            errno = EIO;
+            return -1;
+        }
+
+        this->total_bytes_write += len;
+        vector->iov_len -= len;
+        if (vector->iov_len == 0) {
+            entry->pending_vector++;
+            entry->pending_count--;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 static int
 __socket_ioq_churn_entry(rpc_transport_t *this, struct ioq *entry,
                          gf_boolean_t free_entry)
 {
     int ret;
 
-    ret = __socket_writev(this, entry->pending_vector, entry->pending_count,
-                          &entry->pending_vector, &entry->pending_count);
+#ifdef GF_LINUX_HOST_OS
+    if (entry->pipe_fd >= 0)
+        ret = __socket_splicev(this, entry);
+    else
+#endif
+        ret = __socket_writev(this, entry->pending_vector,
+                              entry->pending_count, &entry->pending_vector,
+                              &entry->pending_count);
 
     if (ret == 0) {
         /* current entry was completely written */
@@ -1309,6 +1426,71 @@ __socket_ioq_churn_entry(rpc_transport_t *this, struct ioq *entry,
     return ret;
 }
 
+/* Accounts the bytes written by a send submitted to io_uring, which always
+ * belongs to the first entry of the queue. */
+static int
+__socket_uring_sent(rpc_transport_t *this, ssize_t sent)
+{
+    socket_private_t *priv = this->private;
+    struct ioq *entry = NULL;
+
+    if (sent < 0) {
+        GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                            "sendmsg on %s failed (%s)",
+                            this->peerinfo.identifier, strerror(-sent));
+        errno = -sent;
+        return -1;
+    }
+
+    if (list_empty(&priv->ioq))
+        return 0;
+
+    entry = priv->ioq_next;
+    this->total_bytes_write += sent;
+
+    while (entry->pending_count > 0) {
+        if (sent < entry->pending_vector->iov_len) {
+            entry->pending_vector->iov_base += sent;
+            entry->pending_vector->iov_len -= sent;
+            break;
+        }
+        sent -= entry->pending_vector->iov_len;
+        entry->pending_vector++;
+        entry->pending_count--;
+    }
+
+    if (entry->pending_count == 0)
+        __socket_ioq_entry_free(entry);
+
+    return 0;
+}
+
+/* io_uring version of __socket_ioq_churn(). Entries are sent one at a time,
+ * each one when the send of the previous one has completed. */
+static int
+__socket_uring_churn(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct ioq *entry = NULL;
+    int ret;
+
+    if (socket_uring_sending(priv->uring))
+        return 1;
+
+    if (list_empty(&priv->ioq))
+        return 0;
+
+    entry = priv->ioq_next;
+    ret = socket_uring_send(priv->uring, entry->pending_vector,
+                            entry->pending_count);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+
+    return 1;
+}
+
 static int
 __socket_ioq_churn(rpc_transport_t *this)
 {
@@ -1318,6 +1500,9 @@ __socket_ioq_churn(rpc_transport_t *this)
 
     priv = this->private;
 
+    if (priv->uring != NULL)
+        return __socket_uring_churn(this);
+
     while (!list_empty(&priv->ioq)) {
         /* pick next entry */
         entry = priv->ioq_next;
@@ -2397,6 +2582,24 @@ socket_event_poll_in(rpc_transport_t *this, gf_boolean_t notify_handled)
 
     ret = socket_proto_state_machine(this, &pollin);
 
+    /* There won't be a new event for messages that are already in the
+     * io_uring buffers, so all of them are dispatched now except the last
+     * one, which is handled as usual. */
+    while (pollin && (ret >= 0) && (priv->uring != NULL) &&
+           socket_uring_pending(priv->uring)) {
+        pthread_mutex_lock(&priv->notify.lock);
+        {
+            priv->notify.in_progress++;
+        }
+        pthread_mutex_unlock(&priv->notify.lock);
+
+        rpc_transport_ref(this);
+        gf_async(&pollin->async, socket_event_poll_in_async);
+
+        pollin = NULL;
+        ret = socket_proto_state_machine(this, &pollin);
+    }
+
     if (pollin) {
         pthread_mutex_lock(&priv->notify.lock);
         {
@@ -2405,8 +2608,12 @@ socket_event_poll_in(rpc_transport_t *this, gf_boolean_t notify_handled)
         pthread_mutex_unlock(&priv->notify.lock);
     }
 
-    if (notify_handled && (ret >= 0))
-        gf_event_handled(ctx->event_pool, priv->sock, priv->idx, priv->gen);
+    if (notify_handled && (ret >= 0)) {
+        if (priv->uring != NULL)
+            socket_uring_rearm(priv->uring);
+        gf_event_handled(ctx->event_pool, SOCKET_EVENT_FD(priv), priv->idx,
+                         priv->gen);
+    }
 
     if (pollin) {
         rpc_transport_ref(this);
@@ -2438,6 +2645,13 @@ socket_connect_finish(rpc_transport_t *this)
         if ((ret < 0) && (errno == EINPROGRESS))
             ret = 1;
 
+        if ((ret == 1) && (priv->uring != NULL) &&
+            (socket_uring_connect(priv->uring) < 0)) {
+            __socket_disconnect(this);
+            ret = -1;
+            goto unlock;
+        }
+
         if ((ret < 0) && (errno != EINPROGRESS)) {
             if (!priv->connect_finish_log) {
                 gf_log(this->name, GF_LOG_ERROR,
@@ -2467,6 +2681,19 @@ socket_connect_finish(rpc_transport_t *this)
                 goto unlock;
             }
 
+            if (priv->uring != NULL) {
+                ret = socket_uring_recv(priv->uring);
+                if (ret < 0) {
+                    gf_log(this->name, GF_LOG_WARNING,
+                           "failed to start receiving from %s (%s) - "
+                           "disconnecting socket",
+                           this->peerinfo.identifier, strerror(-ret));
+                    __socket_disconnect(this);
+                    event = RPC_TRANSPORT_DISCONNECT;
+                    goto unlock;
+                }
+            }
+
             priv->connected = 1;
             priv->connect_finish_log = 0;
             event = RPC_TRANSPORT_CONNECT;
@@ -2642,7 +2869,7 @@ socket_handle_client_connection_attempt(rpc_transport_t *this)
 
     idx = priv->idx;
     gen = priv->gen;
-    fd = priv->sock;
+    fd = SOCKET_EVENT_FD(priv);
 
     /* non-SSL client */
     if (priv->connect_failed) {
@@ -2695,7 +2922,7 @@ socket_complete_connection(rpc_transport_t *this)
 
     idx = priv->idx;
     gen = priv->gen;
-    fd = priv->sock;
+    fd = SOCKET_EVENT_FD(priv);
 
     if (priv->use_ssl) {
         if (priv->is_server) {
@@ -2710,6 +2937,9 @@ socket_complete_connection(rpc_transport_t *this)
              * socket_server_event_handler()
              */
             priv->accepted = _gf_true;
+            /* data received with io_uring is read on the next event */
+            if (priv->uring != NULL)
+                socket_uring_rearm(priv->uring);
             gf_event_handled(ctx->event_pool, fd, idx, gen);
             ret = 1;
         } else {
@@ -2845,6 +3075,84 @@ out:
     rpc_transport_unref(this);
 }
 
+/* Event handler of the connections that use io_uring. The completions are
+ * translated to the poll events that socket_event_handler() expects. */
+static void
+socket_uring_event_handler(int fd, int idx, int gen, void *data, int poll_in,
+                           int poll_out, int poll_err, int event_thread_died)
+{
+    struct socket_uring_events events = {
+        0,
+    };
+    rpc_transport_t *this = data;
+    socket_private_t *priv = this->private;
+    int ret = 0;
+
+    if (!event_thread_died && (priv->uring != NULL)) {
+        socket_uring_reap(priv->uring, &events);
+
+        if (events.sent != 0) {
+            pthread_mutex_lock(&priv->out_lock);
+            {
+                ret = __socket_uring_sent(this, events.sent);
+            }
+            pthread_mutex_unlock(&priv->out_lock);
+
+            if (ret < 0)
+                events.poll_err = 1;
+        }
+
+        /* a spurious wake up must not be taken as the completion of a
+         * connect() */
+        if (!events.poll_in && !events.poll_out && !events.poll_err &&
+            !poll_err) {
+            gf_event_handled(this->ctx->event_pool, fd, idx, gen);
+            return;
+        }
+    }
+
+    socket_event_handler(fd, idx, gen, data, events.poll_in, events.poll_out,
+                         poll_err || events.poll_err, event_thread_died);
+}
+
+/* Moves the data path of a new connection to io_uring, if enabled. SSL
+ * connections always use the socket directly. On failure the connection
+ * just keeps using the socket. */
+static void
+socket_uring_attach(rpc_transport_t *this, gf_boolean_t connected)
+{
+    socket_private_t *priv = this->private;
+    int ret;
+
+    if (!priv->io_uring || priv->use_ssl)
+        return;
+
+    priv->uring = socket_uring_new(this->name, priv->sock,
+                                   this->ctx->iobuf_pool);
+    if (priv->uring == NULL) {
+        ret = -errno;
+        goto failed;
+    }
+
+    if (connected)
+        ret = socket_uring_recv(priv->uring);
+    else
+        ret = socket_uring_connect(priv->uring);
+    if (ret >= 0) {
+        gf_log(this->name, GF_LOG_DEBUG, "using io_uring for the connection");
+        return;
+    }
+
+    socket_uring_destroy(priv->uring);
+    priv->uring = NULL;
+
+failed:
+    GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                        "io_uring not available for the connection (%s), "
+                        "using the socket",
+                        strerror(-ret));
+}
+
 static void
 socket_server_event_handler(int fd, int idx, int gen, void *data, int poll_in,
                             int poll_out, int poll_err, int event_thread_died)
@@ -3038,6 +3346,16 @@ socket_server_event_handler(int fd, int idx, int gen, void *data, int poll_in,
 
         new_priv->sock = new_sock;
 
+        new_priv->io_uring = priv->io_uring;
+        socket_uring_attach(new_trans, _gf_true);
+
+        /* The payload of the replies can't be spliced into the socket when
+         * it has to be encrypted by SSL, nor when io_uring is used. */
+        new_priv->zero_copy_read = priv->zero_copy_read;
+        new_trans->pipe_payload = priv->zero_copy_read &&
+                                  !new_priv->use_ssl &&
+                                  (new_priv->uring == NULL);
+
         new_priv->ssl_enabled = priv->ssl_enabled;
         new_priv->connected = 1;
         new_priv->is_server = _gf_true;
@@ -3065,10 +3383,17 @@ socket_server_event_handler(int fd, int idx, int gen, void *data, int poll_in,
              */
             ret = rpc_transport_notify(this, RPC_TRANSPORT_ACCEPT, new_trans);
 
-            if (ret >= 0) {
+            if ((ret >= 0) && (new_priv->uring != NULL)) {
+                new_priv->idx = gf_event_register(
+                    ctx->event_pool, socket_uring_fd(new_priv->uring),
+                    socket_uring_event_handler, new_trans, 1, 0,
+                    new_trans->notify_poller_death);
+            } else if (ret >= 0) {
                 new_priv->idx = gf_event_register(
                     ctx->event_pool, new_sock, socket_event_handler, new_trans,
                     1, 0, new_trans->notify_poller_death);
+            }
+            if (ret >= 0) {
                 if (new_priv->idx == -1) {
                     ret = -1;
                     gf_log(this->name, GF_LOG_ERROR,
@@ -3442,9 +3767,22 @@ socket_connect(rpc_transport_t *this, int port)
         refd = _gf_true;
 
         this->listener = this;
-        priv->idx = gf_event_register(ctx->event_pool, priv->sock,
-                                      socket_event_handler, this, 1, 1,
-                                      this->notify_poller_death);
+        socket_uring_attach(this, _gf_false);
+        if (priv->uring != NULL) {
+            /* completion of connect() is notified by the ring */
+            priv->idx = gf_event_register(
+                ctx->event_pool, socket_uring_fd(priv->uring),
+                socket_uring_event_handler, this, 1, 0,
+                this->notify_poller_death);
+            if (priv->idx == -1) {
+                socket_uring_destroy(priv->uring);
+                priv->uring = NULL;
+            }
+        } else {
+            priv->idx = gf_event_register(ctx->event_pool, priv->sock,
+                                          socket_event_handler, this, 1, 1,
+                                          this->notify_poller_death);
+        }
         if (priv->idx == -1) {
             gf_log("", GF_LOG_WARNING,
                    "failed to register the event; "
@@ -3653,7 +3991,7 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
     priv = this->private;
     GF_VALIDATE_OR_GOTO("socket", priv, out);
 
-    entry = __socket_ioq_new(msg);
+    entry = __socket_ioq_new(this, msg);
     if (!entry)
         goto out;
 
@@ -3671,6 +4009,18 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
 
         priv->submit_log = 0;
 
+        if (priv->uring != NULL) {
+            /* sent from the event handler once the previous entries have
+             * completed */
+            list_add_tail(&entry->list, &priv->ioq);
+            ret = __socket_uring_churn(this);
+            if (ret < 0)
+                __socket_disconnect(this);
+            else
+                ret = 0;
+            goto unlock;
+        }
+
         if (list_empty(&priv->ioq)) {
             ret = __socket_ioq_churn_entry(this, entry, _gf_false);
 
@@ -3806,7 +4156,9 @@ socket_throttle(rpc_transport_t *this, gf_boolean_t onoff)
          * on a disconnected transport, which breaks epoll's event to
          * registered fd mapping. */
 
-        if (priv->connected == 1)
+        if ((priv->connected == 1) && (priv->uring != NULL))
+            socket_uring_throttle(priv->uring, onoff);
+        else if (priv->connected == 1)
             priv->idx = gf_event_select_on(this->ctx->event_pool, priv->sock,
                                            priv->idx, (int)!onoff, -1);
     }
@@ -3827,6 +4179,62 @@ struct rpc_transport_ops tops = {
     .throttle = socket_throttle,
 };
 
+static gf_boolean_t
+socket_zero_copy_read(rpc_transport_t *this, dict_t *options)
+{
+    gf_boolean_t tmp_bool = _gf_false;
+    char *optstr = NULL;
+
+    if (dict_get_str_sizen(options, "transport.socket.zero-copy-read",
+                           &optstr) != 0)
+        return _gf_false;
+
+    if (gf_string2boolean(optstr, &tmp_bool) != 0) {
+        gf_log(this->name, GF_LOG_ERROR,
+               "'transport.socket.zero-copy-read' takes only "
+               "boolean options, not taking any action");
+        return _gf_false;
+    }
+
+#ifndef GF_LINUX_HOST_OS
+    if (tmp_bool) {
+        gf_log(this->name, GF_LOG_WARNING,
+               "'transport.socket.zero-copy-read' is not supported on this "
+               "platform");
+        tmp_bool = _gf_false;
+    }
+#endif
+
+    return tmp_bool;
+}
+
+static gf_boolean_t
+socket_io_uring(rpc_transport_t *this, dict_t *options)
+{
+    gf_boolean_t tmp_bool = _gf_false;
+    char *optstr = NULL;
+
+    if (dict_get_str_sizen(options, "transport.socket.io-uring", &optstr) != 0)
+        return _gf_false;
+
+    if (gf_string2boolean(optstr, &tmp_bool) != 0) {
+        gf_log(this->name, GF_LOG_ERROR,
+               "'transport.socket.io-uring' takes only "
+               "boolean options, not taking any action");
+        return _gf_false;
+    }
+
+#ifndef HAVE_LIBURING_BUF_RING
+    if (tmp_bool) {
+        gf_log(this->name, GF_LOG_WARNING,
+               "'transport.socket.io-uring' is not supported by this build");
+        tmp_bool = _gf_false;
+    }
+#endif
+
+    return tmp_bool;
+}
+
 int
 reconfigure(rpc_transport_t *this, dict_t *options)
 {
@@ -3905,6 +4313,10 @@ reconfigure(rpc_transport_t *this, dict_t *options)
 
     priv->windowsize = (int)windowsize;
 
+    priv->zero_copy_read = socket_zero_copy_read(this, options);
+
+    priv->io_uring = socket_io_uring(this, options);
+
     data = dict_get_sizen(options, "non-blocking-io");
     if (data) {
         optstr = data_to_str(data);
@@ -4472,6 +4884,10 @@ socket_init(rpc_transport_t *this)
 
     priv->windowsize = (int)windowsize;
 
+    priv->zero_copy_read = socket_zero_copy_read(this, this->options);
+
+    priv->io_uring = socket_io_uring(this, this->options);
+
     priv->ssl_enabled = _gf_false;
     if (dict_get_str_sizen(this->options, SSL_ENABLED_OPT, &optstr) == 0) {
         if (gf_string2boolean(optstr, &priv->ssl_enabled) != 0) {
@@ -4615,6 +5031,20 @@ struct volume_options options[] = {
      .op_version = {GD_OP_VERSION_3_10_2},
      .default_value = "9"},
     {.key = {"transport.socket.read-fail-log"}, .type = GF_OPTION_TYPE_BOOL},
+    {.key = {"transport.socket.zero-copy-read"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .op_version = {GD_OP_VERSION_10_0},
+     .default_value = "off",
+     .description = "Send the data of read replies directly from the page "
+                    "cache of the brick using splice(), without copying it "
+                    "to user space. Ignored when SSL is enabled."},
+    {.key = {"transport.socket.io-uring"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .op_version = {GD_OP_VERSION_10_0},
+     .default_value = "off",
+     .description = "Receive and send the data of new connections through "
+                    "io_uring instead of using readiness notifications and "
+                    "readv()/writev() calls. Ignored when SSL is enabled."},
     {.key = {SSL_ENABLED_OPT}, .type = GF_OPTION_TYPE_BOOL},
     {.key = {SSL_OWN_CERT_OPT}, .type = GF_OPTION_TYPE_STR},
     {.key = {SSL_PRIVATE_KEY_OPT}, .type = GF_OPTION_TYPE_STR},
@@ -105,7 +105,7 @@ struct ioq {
     int pending_count;
     struct iobref *iobref;
     uint32_t fraghdr;
-    char _pad[4];
+    int pipe_fd; /* data of the vector with a NULL base, owned by iobref */
 };
 
 typedef struct {
@@ -264,7 +264,9 @@ typedef struct {
                             * socket_event_handler() for
                             * newly accepted socket
                             */
-    char _pad[4];
+    gf_boolean_t zero_copy_read; /* send read replies from a pipe */
+    gf_boolean_t io_uring;       /* use io_uring for new connections */
+    struct socket_uring *uring;  /* io_uring data path, if active */
 } socket_private_t;
 
 #endif
@@ -0,0 +1,84 @@
+#!/bin/bash
+
+#A brick that doesn't know GF_IPC_TARGET_XATTROP_BATCH answers EOPNOTSUPP,
+#like posix does when there's no protocol/server in front of it. AFR must then
+#send the xattrops of that brick one by one, without losing any of them.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function mount_pid {
+        ps auxww | grep glusterfs | grep -E "volfile[ =]$B0/test.vol" | \
+                awk '{print $2}' | head -1
+}
+
+function batch_stat {
+        local statedump=$(generate_statedump $(mount_pid))
+        grep -a "^$1=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+function pending_xattr_count {
+        getfattr -d -m "trusted.afr.test-locks" -e hex \
+                 $B0/test{0,1}/file* 2>/dev/null | grep "=0x" | \
+                 grep -v "=0x0*$" | wc -l
+}
+
+function brick_mode_count {
+        stat -c %a $B0/test{0,1}/file* | grep -x "$1" | wc -l
+}
+
+TEST mkdir -p $B0/test{0,1}
+
+cat > $B0/test.vol <<EOF
+volume test-posix-0
+    type storage/posix
+    option directory $B0/test0
+end-volume
+
+volume test-locks-0
+    type features/locks
+    subvolumes test-posix-0
+end-volume
+
+volume test-posix-1
+    type storage/posix
+    option directory $B0/test1
+end-volume
+
+volume test-locks-1
+    type features/locks
+    subvolumes test-posix-1
+end-volume
+
+volume test-replicate-0
+    type cluster/replicate
+    option changelog-batch on
+    subvolumes test-locks-0 test-locks-1
+end-volume
+EOF
+
+logdir=$(gluster --print-logdir)
+TEST glusterfs --volfile=$B0/test.vol --log-file=$logdir/changelog-batch.log \
+               --attribute-timeout=0 --entry-timeout=0 $M0
+TEST touch $M0/file{1..100}
+
+seq 1 100 | xargs -P 16 -I{} chmod 600 $M0/file{}
+EXPECT "200" brick_mode_count 600
+EXPECT "0" pending_xattr_count
+TEST grep -q "doesn't support batched xattrops" $logdir/changelog-batch.log
+
+#Only the first batch of each brick has been tried
+TEST [ $(batch_stat xattrop_batches) -le 2 ]
+batches=$(batch_stat xattrop_batches)
+seq 1 100 | xargs -P 16 -I{} chmod 644 $M0/file{}
+EXPECT "200" brick_mode_count 644
+EXPECT "0" pending_xattr_count
+EXPECT "$batches" batch_stat xattrop_batches
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+rm -f $B0/test.vol $logdir/changelog-batch.log
+rm -rf $B0/test0 $B0/test1
+
+cleanup;
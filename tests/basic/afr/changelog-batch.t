@@ -0,0 +1,113 @@
+#!/bin/bash
+
+#With cluster.changelog-batch, the changelog xattrops of concurrent data and
+#metadata transactions on different files are sent to each brick together, in a
+#GF_IPC_TARGET_XATTROP_BATCH ipc. The result must be the same as with plain
+#xattrops: the changes are on all the bricks and nothing is left pending.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../fileio.rc
+
+cleanup;
+
+function batch_stat {
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+function pending_xattr_count {
+        getfattr -d -m "trusted.afr.$V0-client" -e hex \
+                 $B0/${V0}{0..2}/file* 2>/dev/null | grep "=0x" | \
+                 grep -v "=0x0*$" | wc -l
+}
+
+function brick_mode_count {
+        stat -c %a $B0/${V0}{0..2}/file* | grep -x "$1" | wc -l
+}
+
+function brick_xattr_count {
+        local count=0
+        for i in {1..200}; do
+                for b in {0..2}; do
+                        if [ "$(getfattr --only-values -n user.batch \
+                                $B0/${V0}$b/file$i 2>/dev/null)" == "$1$i" ]
+                        then
+                                count=$((count + 1))
+                        fi
+                done
+        done
+        echo $count
+}
+
+function brick_data_count {
+        md5sum $B0/${V0}{0..2}/file* | grep -c "^$(md5sum $B0/data | \
+                                                   cut -f1 -d' ') "
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 cluster.changelog-batch on
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 2
+EXPECT "1" batch_stat changelog-batch
+TEST touch $M0/file{1..200}
+
+#Concurrent setattr and setxattr transactions on different files
+seq 1 200 | xargs -P 32 -I{} chmod 600 $M0/file{}
+seq 1 200 | xargs -P 32 -I{} setfattr -n user.batch -v a{} $M0/file{}
+EXPECT "600" brick_mode_count 600
+EXPECT "600" brick_xattr_count a
+EXPECT "0" pending_xattr_count
+EXPECT "0" get_pending_heal_count $V0
+TEST [ $(batch_stat xattrop_batches) -gt 0 ]
+TEST [ $(batch_stat xattrop_batched) -ge $(batch_stat xattrop_batches) ]
+
+#Concurrent writes to different files. Their fxattrops are batched too, and
+#the bricks send them on anonymous fds.
+batched=$(batch_stat xattrop_batched)
+TEST dd if=/dev/urandom of=$B0/data bs=64k count=16
+seq 1 200 | xargs -P 32 -I{} dd if=$B0/data of=$M0/file{} bs=4k conv=fsync \
+                                status=none
+EXPECT "600" brick_data_count
+EXPECT "0" pending_xattr_count
+EXPECT "0" get_pending_heal_count $V0
+TEST [ $(batch_stat xattrop_batched) -gt $batched ]
+
+#Writes to a file that is open but unlinked use plain fxattrops
+TEST fd_open 5 'w' $M0/unlinked
+TEST rm -f $M0/unlinked
+TEST fd_write 5 "unlinked data"
+TEST fd_close 5
+EXPECT "0" pending_xattr_count
+EXPECT "0" get_pending_heal_count $V0
+
+#With a tiny inode table on the bricks, some inodes are forgotten between
+#the lock and the xattrop. Their entries of the batch fail with ESTALE and
+#are sent again as plain xattrops.
+TEST $CLI volume set $V0 network.inode-lru-limit 1
+seq 1 200 | xargs -P 32 -I{} chmod 644 $M0/file{}
+seq 1 200 | xargs -P 32 -I{} setfattr -n user.batch -v b{} $M0/file{}
+EXPECT "600" brick_mode_count 644
+EXPECT "600" brick_xattr_count b
+EXPECT "0" pending_xattr_count
+EXPECT "0" get_pending_heal_count $V0
+TEST [ $(batch_stat xattrop_batch_stale) -gt 0 ]
+
+#Plain xattrops once the option is turned off
+TEST $CLI volume set $V0 cluster.changelog-batch off
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" batch_stat changelog-batch
+batches=$(batch_stat xattrop_batches)
+seq 1 200 | xargs -P 32 -I{} chmod 640 $M0/file{}
+EXPECT "600" brick_mode_count 640
+EXPECT "0" pending_xattr_count
+EXPECT "$batches" batch_stat xattrop_batches
+
+TEST force_umount $M0
+rm -f $B0/data
+cleanup;
@@ -0,0 +1,119 @@
+#!/bin/bash
+
+#copy_file_range on a replica is done by every brick from its own copy of the
+#source. The destination replicas must be identical, the count returned must
+#be the one of the data bricks, also when the copy stops at the end of the
+#source or there's an arbiter, and the copy must be refused with EXDEV when
+#some brick doesn't have good data for the source, so that the caller falls
+#back to read and write.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../afr.rc
+
+cleanup;
+
+function copy_range_vol {
+        local vol=$1
+        shift
+        $(dirname $0)/../gfapi/glfs-copy-range $H0 $vol \
+                $logdir/glfs-copy-range.log "$@"
+}
+
+function copy_range {
+        copy_range_vol $V0 "$@"
+}
+
+function brick_md5 {
+        md5sum $B0/${V0}$1/$2 | awk '{print $1}'
+}
+
+function arbiter_brick_md5 {
+        md5sum $B0/${V1}$1/$2 | awk '{print $1}'
+}
+
+logdir=$(gluster --print-logdir)
+TEST build_tester $(dirname $0)/../gfapi/glfs-copy-range.c -lgfapi
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume set $V0 cluster.data-self-heal off
+TEST $CLI volume set $V0 cluster.metadata-self-heal off
+TEST $CLI volume set $V0 cluster.entry-self-heal off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/src bs=1M count=4
+
+#Whole file
+EXPECT "4194304" copy_range /src /dst 0 0 4194304
+md5=$(md5sum $M0/src | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $M0/dst | awk '{print $1}')
+EXPECT "$md5" brick_md5 0 dst
+EXPECT "$md5" brick_md5 1 dst
+EXPECT "$md5" brick_md5 2 dst
+
+#Ranges that are not aligned to anything
+EXPECT "100000" copy_range /src /part 1000 5000 100000
+TEST cmp -n 100000 -i 1000:5000 $M0/src $M0/part
+md5=$(brick_md5 0 part)
+EXPECT "$md5" brick_md5 1 part
+EXPECT "$md5" brick_md5 2 part
+
+#Copies that reach the end of the source are short, or empty, on all the
+#bricks. Nothing must be left pending for heal.
+EXPECT "1000" copy_range /src /tail 4193304 0 100000
+TEST cmp -n 1000 -i 4193304:0 $M0/src $M0/tail
+EXPECT "1000" stat -c %s $M0/tail
+EXPECT "0" copy_range /src /tail 8388608 1000 4096
+EXPECT "1000" stat -c %s $M0/tail
+EXPECT "0" get_pending_heal_count $V0
+
+#The read lock on the source has been released
+TEST timeout 10 dd if=/dev/urandom of=$M0/src bs=4k count=1 conv=notrunc
+
+#Source and destination in the same file
+EXPECT "EXDEV" copy_range /src /src 0 1048576 4096
+
+#Source needing heal
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST dd if=/dev/urandom of=$M0/src bs=4k count=1 conv=notrunc
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT "EXDEV" copy_range /src /dst2 0 0 4096
+
+#After heal the copy is possible again
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+EXPECT "4096" copy_range /src /dst2 0 0 4096
+TEST cmp -n 4096 $M0/src $M0/dst2
+
+TEST force_umount $M0
+
+#With an arbiter, the count only comes from the data bricks
+TEST $CLI volume create $V1 replica 3 arbiter 1 $H0:$B0/${V1}{0,1,2}
+TEST $CLI volume start $V1
+TEST $GFS --volfile-id=/$V1 --volfile-server=$H0 $M1;
+TEST dd if=/dev/urandom of=$M1/src bs=1M count=4
+
+EXPECT "4194304" copy_range_vol $V1 /src /dst 0 0 4194304
+md5=$(md5sum $M1/src | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $M1/dst | awk '{print $1}')
+EXPECT "$md5" arbiter_brick_md5 0 dst
+EXPECT "$md5" arbiter_brick_md5 1 dst
+EXPECT "0" stat -c %s $B0/${V1}2/dst
+
+EXPECT "1000" copy_range_vol $V1 /src /tail 4193304 0 100000
+EXPECT "1000" stat -c %s $M1/tail
+EXPECT "0" copy_range_vol $V1 /src /tail 8388608 1000 4096
+EXPECT "1000" stat -c %s $M1/tail
+TEST cmp -n 1000 -i 4193304:0 $M1/src $M1/tail
+EXPECT "0" get_pending_heal_count $V1
+
+TEST force_umount $M1
+cleanup_tester $(dirname $0)/../gfapi/glfs-copy-range
+cleanup;
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+#Diff self-heal asks the bricks for the fast xxh64x2 strong checksum. Both
+#bricks must answer with it, blocks that differ must be detected and healed,
+#and identical blocks must compare equal on all bricks.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../afr.rc
+
+cleanup;
+
+function xxh64x2_count {
+        local statedump=$(generate_brick_statedump $V0 $H0 $B0/${V0}$1)
+        grep -a "^rchecksum_xxh64x2=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 data-self-heal-algorithm diff
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=4
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+#Change two blocks while the first brick is down
+TEST dd if=/dev/urandom of=$M0/file bs=128k count=1 seek=13 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/file bs=128k count=1 seek=40 conv=notrunc
+md5=$(md5sum $M0/file | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+EXPECT "0" xxh64x2_count 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+
+#The 4MB file has 32 blocks of 128KB, checksummed on both bricks
+TEST [ $(xxh64x2_count 0) -ge 32 ]
+TEST [ $(xxh64x2_count 1) -ge 32 ]
+
+EXPECT "$md5" echo $(md5sum $B0/${V0}0/file | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $B0/${V0}1/file | awk '{print $1}')
+
+TEST force_umount $M0
+cleanup;
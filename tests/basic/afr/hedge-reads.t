@@ -0,0 +1,59 @@
+#!/bin/bash
+
+#With cluster.hedge-reads, a read that is late on its brick is also sent to
+#another brick with a good copy. delay-gen makes a few reads of each brick
+#much slower than the others, which must be hedged, and the hedges must win.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function hedge_stat {
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 cluster.choose-local off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 cluster.hedge-reads on
+#3% of the reads of each brick take 100ms more than the others
+TEST $CLI volume set $V0 delay-gen posix
+TEST $CLI volume set $V0 delay-gen.delay-duration 100000
+TEST $CLI volume set $V0 delay-gen.delay-percentage 3
+TEST $CLI volume set $V0 delay-gen.enable read
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 2
+TEST dd if=/dev/urandom of=$B0/FILE bs=1M count=32
+TEST cp $B0/FILE $M0/FILE
+EXPECT "1" hedge_stat hedge-reads
+
+#Until enough reads have been measured there's no deadline
+for i in {1..12}; do
+        drop_cache $M0
+        TEST cmp $B0/FILE $M0/FILE
+done
+TEST [ $(hedge_stat hedged_reads) -gt 0 ]
+TEST [ $(hedge_stat hedged_reads_won) -gt 0 ]
+TEST [ $(hedge_stat hedged_reads_won) -le $(hedge_stat hedged_reads) ]
+
+#No more hedges once the option is turned off
+TEST $CLI volume set $V0 cluster.hedge-reads off
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" hedge_stat hedge-reads
+sent=$(hedge_stat hedged_reads)
+drop_cache $M0
+TEST cmp $B0/FILE $M0/FILE
+EXPECT "$sent" hedge_stat hedged_reads
+
+TEST force_umount $M0
+cleanup;
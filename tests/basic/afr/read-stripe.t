@@ -0,0 +1,68 @@
+#!/bin/bash
+
+#With cluster.read-stripe-size, big reads are split among the bricks that have
+#a good copy of the file. The data must be the same as with normal reads.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function stripe_stat {
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+function reads_brick_count {
+        $CLI volume profile $V0 info incremental | grep -w READ | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 cluster.choose-local off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 cluster.read-stripe-size 32KB
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$B0/FILE bs=1M count=8
+TEST cp $B0/FILE $M0/FILE
+TEST force_umount $M0
+
+#Reads from a fresh client, so that nothing is cached
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT "32768" stripe_stat read-stripe-size
+TEST $CLI volume profile $V0 start
+TEST cmp $B0/FILE $M0/FILE
+TEST [ $(reads_brick_count) -gt 1 ]
+TEST [ $(stripe_stat striped_reads) -gt 0 ]
+EXPECT "0" stripe_stat striped_read_fallbacks
+
+#Reads at an offset that isn't aligned to the stripe size, and across the end
+#of the file
+TEST cmp <(dd if=$B0/FILE bs=4096 skip=3) \
+         <(dd if=$M0/FILE bs=4096 skip=3)
+TEST cmp <(tail -c 200000 $B0/FILE) <(tail -c 200000 $M0/FILE)
+
+#No striping while a brick is down
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "0" afr_child_up_status $V0 1
+striped=$(stripe_stat striped_reads)
+TEST cmp $B0/FILE $M0/FILE
+EXPECT "$striped" stripe_stat striped_reads
+
+#Nor once the option is turned off
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+TEST $CLI volume set $V0 cluster.read-stripe-size 0
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" stripe_stat read-stripe-size
+TEST cmp $B0/FILE $M0/FILE
+EXPECT "$striped" stripe_stat striped_reads
+
+TEST $CLI volume profile $V0 stop
+TEST force_umount $M0
+cleanup;
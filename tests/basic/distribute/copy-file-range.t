@@ -0,0 +1,56 @@
+#!/bin/bash
+
+#dht winds copy_file_range only when the source and the destination are cached
+#on the same subvolume. Otherwise it must be refused with EXDEV.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function copy_range {
+        $(dirname $0)/../gfapi/glfs-copy-range $H0 $V0 \
+                $logdir/glfs-copy-range.log "$@"
+}
+
+logdir=$(gluster --print-logdir)
+TEST build_tester $(dirname $0)/../gfapi/glfs-copy-range.c -lgfapi
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+
+#Find a file on each brick besides the source
+TEST dd if=/dev/urandom of=$M0/src bs=1M count=2
+if [ -f $B0/${V0}0/src ]; then
+        src_brick=0
+else
+        src_brick=1
+fi
+same=""
+other=""
+for i in {1..100}; do
+        touch $M0/file$i
+        if [ -f $B0/${V0}${src_brick}/file$i ]; then
+                same=${same:-file$i}
+        else
+                other=${other:-file$i}
+        fi
+        [ -n "$same" ] && [ -n "$other" ] && break
+done
+TEST [ -n "$same" ]
+TEST [ -n "$other" ]
+
+EXPECT "2097152" copy_range /src /$same 0 0 2097152
+TEST cmp $M0/src $M0/$same
+
+EXPECT "1000" copy_range /src /$same 1234 567 1000
+TEST cmp -n 1000 -i 1234:567 $M0/src $M0/$same
+
+EXPECT "EXDEV" copy_range /src /$other 0 0 2097152
+
+TEST force_umount $M0
+cleanup_tester $(dirname $0)/../gfapi/glfs-copy-range
+cleanup;
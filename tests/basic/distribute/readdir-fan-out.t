@@ -0,0 +1,57 @@
+#!/bin/bash
+
+#With cluster.readdir-fan-out, dht reads the subvolumes of a directory in
+#parallel. The listing must be the same as with the sequential mode, and the
+#readdirps must be served from the batches requested in advance.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function fan_out_stat {
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1,2,3}
+TEST $CLI volume set $V0 performance.readdir-ahead off
+TEST $CLI volume set $V0 performance.parallel-readdir off
+TEST $CLI volume set $V0 cluster.readdir-fan-out on
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST mkdir $M0/dir
+TEST touch $M0/dir/file{1..2000}
+TEST mkdir $M0/dir/subdir{1..20}
+
+seq -f "file%g" 1 2000 > $B0/expected
+seq -f "subdir%g" 1 20 >> $B0/expected
+sort -o $B0/expected $B0/expected
+
+#Listings from a fresh client, so that nothing is cached
+TEST force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT "2020" echo $(ls $M0/dir | wc -l)
+TEST diff $B0/expected <(ls $M0/dir | sort)
+TEST diff $B0/expected <(ls $M0/dir | sort)
+EXPECT "1" fan_out_stat readdir-fan-out
+TEST [ $(fan_out_stat readdir_fan_out_sent) -gt 0 ]
+TEST [ $(fan_out_stat readdir_fan_out_hits) -gt 0 ]
+
+#Another reader of the same directory
+TEST diff $B0/expected <(find $M0/dir -mindepth 1 -maxdepth 1 \
+                         -printf "%f\n" | sort)
+TEST [ $(fan_out_stat readdir_fan_out_hits) -gt 4 ]
+
+#Same listing in the sequential mode, without new requests in advance
+TEST $CLI volume set $V0 cluster.readdir-fan-out off
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" fan_out_stat readdir-fan-out
+sent=$(fan_out_stat readdir_fan_out_sent)
+TEST diff $B0/expected <(ls $M0/dir | sort)
+EXPECT "$sent" fan_out_stat readdir_fan_out_sent
+
+TEST force_umount $M0
+cleanup;
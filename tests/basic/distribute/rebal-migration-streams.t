@@ -0,0 +1,57 @@
+#!/bin/bash
+
+#Files are migrated with several blocks in flight per stream, and big files
+#with several streams. The data must be intact after the migration, and the
+#rebalance status must report the throughput.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function md5_of {
+        md5sum $1 | awk '{print $1}'
+}
+
+function rebalance_throughput {
+        $CLI volume rebalance $V0 status | grep -c "Rebalance throughput"
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 cluster.rebal-migration-streams 4
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST mkdir $M0/dir
+for i in {1..20}; do
+        TEST dd if=/dev/urandom of=$M0/dir/small$i bs=1k count=$((i * 150))
+done
+TEST dd if=/dev/urandom of=$M0/dir/big bs=1M count=200
+#Sparse file with data segments across several stream ranges
+TEST dd if=/dev/urandom of=$M0/dir/sparse bs=1M count=3 seek=10
+TEST dd if=/dev/urandom of=$M0/dir/sparse bs=1M count=3 seek=100 conv=notrunc
+TEST truncate -s 200M $M0/dir/sparse
+
+declare -A md5
+for f in $M0/dir/*; do
+        md5[$(basename $f)]=$(md5_of $f)
+done
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}{1,2,3}
+TEST $CLI volume rebalance $V0 start force
+EXPECT_WITHIN $REBALANCE_TIMEOUT "completed" rebalance_status_field $V0
+EXPECT "0" rebalance_failed_field $V0
+TEST [ $(rebalanced_files_field $V0) -gt 0 ]
+EXPECT "1" rebalance_throughput
+
+#Read everything back through a fresh mount
+TEST force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+for f in $M0/dir/*; do
+        EXPECT "${md5[$(basename $f)]}" md5_of $f
+done
+EXPECT "209715200" stat -c %s $M0/dir/sparse
+
+TEST force_umount $M0
+cleanup;
@@ -0,0 +1,116 @@
+#!/bin/bash
+
+#With cluster.rebal-resume, a rebalance killed in the middle of the crawl
+#skips the directories finished by the previous run when it is started again.
+#The markers of the subdirectories are removed as soon as their parent is
+#marked, and all the markers must be gone once a run completes.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function marked_dirs {
+        getfattr -m "trusted.glusterfs.dht.rebalance-done" -d $B0/${V0}0/dir* \
+                2>/dev/null | grep -c "rebalance-done"
+}
+
+function marked_at_least {
+        if [ $(marked_dirs) -ge $1 ]; then
+                echo "Y"
+        else
+                echo "N"
+        fi
+}
+
+#Subdirectories of marked directories that still have a marker
+function stale_sub_markers {
+        local count=0
+        for d in $B0/${V0}0/dir*; do
+                if getfattr -m "trusted.glusterfs.dht.rebalance-done" -d $d \
+                        2>/dev/null | grep -q "rebalance-done"; then
+                        count=$((count + $(getfattr -m \
+                                "trusted.glusterfs.dht.rebalance-done" -d \
+                                $d/sub 2>/dev/null | grep -c "rebalance-done")))
+                fi
+        done
+        echo $count
+}
+
+function run_marker {
+        getfattr -m "trusted.glusterfs.dht.rebalance-run" -d $B0/${V0}0 \
+                2>/dev/null | grep -c "rebalance-run"
+}
+
+function md5_of {
+        md5sum $1 | awk '{print $1}'
+}
+
+logdir=$(gluster --print-logdir)
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 delay-gen posix
+TEST $CLI volume set $V0 delay-gen.delay-duration 200000
+TEST $CLI volume set $V0 delay-gen.delay-percentage 0
+TEST $CLI volume set $V0 delay-gen.enable write
+TEST $CLI volume set $V0 cluster.rebal-throttle lazy
+TEST $CLI volume start $V0
+
+#Off by default
+EXPECT "off" volume_get_field $V0 cluster.rebal-resume
+TEST $CLI volume set $V0 cluster.rebal-resume on
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+for i in {1..20}; do
+        TEST mkdir -p $M0/dir$i/sub
+        for j in {1..10}; do
+                dd if=/dev/urandom of=$M0/dir$i/file$j bs=64k count=1 \
+                        2>/dev/null
+        done
+        for j in {1..2}; do
+                dd if=/dev/urandom of=$M0/dir$i/sub/file$j bs=64k count=1 \
+                        2>/dev/null
+        done
+done
+md5_before=$(cat $M0/dir*/file* $M0/dir*/sub/file* | md5sum | \
+             awk '{print $1}')
+
+#Slow down the migration, so that the rebalance can be killed halfway
+TEST $CLI volume set $V0 delay-gen.delay-percentage 100
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}1
+TEST $CLI volume rebalance $V0 start
+EXPECT_WITHIN $REBALANCE_TIMEOUT "1" run_marker
+EXPECT_WITHIN $REBALANCE_TIMEOUT "Y" marked_at_least 3
+TEST pkill -9 -f "rebalance/$V0"
+EXPECT_WITHIN $PROCESS_DOWN_TIMEOUT "0" echo $(pgrep -f "rebalance/$V0" | wc -l)
+marked=$(marked_dirs)
+TEST [ $marked -lt 20 ]
+EXPECT "0" stale_sub_markers
+#Subdirectories of directories not finished yet can be marked too
+marked=$((marked + $(getfattr -m "trusted.glusterfs.dht.rebalance-done" -d \
+                     $B0/${V0}0/dir*/sub 2>/dev/null | grep -c "rebalance-done")))
+
+#The next run skips what was done and clears the markers when it completes
+TEST $CLI volume set $V0 delay-gen.delay-percentage 0
+TEST $CLI volume rebalance $V0 start
+EXPECT_WITHIN $REBALANCE_TIMEOUT "completed" rebalance_status_field $V0
+EXPECT "0" rebalance_failed_field $V0
+skipped=$(grep -o "[0-9]* directories already processed" \
+          $logdir/${V0}-rebalance.log | tail -1 | awk '{print $1}')
+TEST [ "$skipped" -ge 3 ]
+TEST [ "$skipped" -le $((marked + 1)) ]
+EXPECT "0" marked_dirs
+EXPECT "0" echo $(getfattr -m "trusted.glusterfs.dht.rebalance-done" -d \
+                  $B0/${V0}0/dir*/sub 2>/dev/null | grep -c "rebalance-done")
+EXPECT "0" run_marker
+
+TEST force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT "$md5_before" echo $(cat $M0/dir*/file* $M0/dir*/sub/file* | \
+                            md5sum | awk '{print $1}')
+EXPECT "200" echo $(ls $M0/dir* | grep -c file)
+TEST [ $(ls $B0/${V0}1/dir* | grep -c file) -gt 0 ]
+
+TEST force_umount $M0
+cleanup;
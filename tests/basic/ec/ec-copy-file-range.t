@@ -0,0 +1,53 @@
+#!/bin/bash
+
+#copy_file_range on a disperse volume copies the fragments brick by brick. It
+#is only possible on ranges that start on a stripe boundary, the others must
+#be refused with EXDEV.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function copy_range {
+        $(dirname $0)/../gfapi/glfs-copy-range $H0 $V0 \
+                $logdir/glfs-copy-range.log "$@"
+}
+
+logdir=$(gluster --print-logdir)
+TEST build_tester $(dirname $0)/../gfapi/glfs-copy-range.c -lgfapi
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST dd if=/dev/urandom of=$M0/src bs=1M count=4
+
+#Whole file
+EXPECT "4194304" copy_range /src /dst 0 0 4194304
+TEST cmp $M0/src $M0/dst
+
+#Stripe aligned range (the stripe is 1024 bytes)
+EXPECT "8192" copy_range /src /part 1024 4096 8192
+TEST cmp -n 8192 -i 1024:4096 $M0/src $M0/part
+
+#Unaligned length up to the end of the source
+EXPECT "1000" copy_range /src /tail 4193304 0 1000
+TEST cmp -n 1000 -i 4193304:0 $M0/src $M0/tail
+
+#Misaligned ranges
+EXPECT "EXDEV" copy_range /src /dst 100 0 4096
+EXPECT "EXDEV" copy_range /src /dst 0 100 4096
+EXPECT "EXDEV" copy_range /src /dst 0 0 1000
+
+#Source and destination in the same file
+EXPECT "EXDEV" copy_range /src /src 0 1048576 4096
+
+#The bricks still agree on the data
+TEST cmp $M0/src $M0/dst
+
+TEST force_umount $M0
+cleanup_tester $(dirname $0)/../gfapi/glfs-copy-range
+cleanup;
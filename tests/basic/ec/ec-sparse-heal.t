@@ -0,0 +1,57 @@
+#!/bin/bash
+
+#The data heal of a sparse file only rebuilds its data segments. The sink
+#keeps the size of the file while its stale contents are punched out, so the
+#regions that are now holes in the file must read as zeros from the healed
+#brick and must not take space on it.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup
+
+function brick_blocks {
+        stat -c %b $B0/${V0}$1/file
+}
+
+function brick_size {
+        stat -c %s $B0/${V0}$1/file
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume heal $V0 disable
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+#A fully written file, so that brick0 has data everywhere
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=32 conv=fsync
+
+#Most of the file becomes a hole while brick0 is down
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+TEST fallocate -p -o 1M -l 30M $M0/file
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=1 seek=16 conv=notrunc,fsync
+md5=$(md5sum $M0/file | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST $CLI volume heal $V0 enable
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+#The healed fragment has the same size and is as sparse as the others
+EXPECT "$(brick_size 1)" brick_size 0
+TEST [ $(brick_blocks 0) -le $(( $(brick_blocks 1) + 1024 )) ]
+
+#The file read through the healed brick is the same
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup
@@ -0,0 +1,128 @@
+/* Sends many small contiguous writes to a file at the same time, so that ec
+ * can coalesce them, and writes the expected content to a local file. A
+ * statedump of the client is taken once all the writes are answered. When a
+ * lease id is given, it's set for the thread, so that all the writes carry it
+ * in their xdata.
+ *
+ * Usage: ./ec-write-coalesce <host> <volume> <logfile> <file> <expected>
+ *                            <writes> <size> [<lease id>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <glusterfs/api/glfs.h>
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int pending = 0;
+static int failed = 0;
+
+static void
+write_cbk(glfs_fd_t *fd, ssize_t ret, struct glfs_stat *prestat,
+          struct glfs_stat *poststat, void *data)
+{
+    pthread_mutex_lock(&lock);
+    if (ret != (ssize_t)(long)data)
+        failed++;
+    pending--;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+int
+main(int argc, char *argv[])
+{
+    glfs_t *fs = NULL;
+    glfs_fd_t *glfd = NULL;
+    FILE *expected = NULL;
+    glfs_leaseid_t leaseid = {
+        0,
+    };
+    char *buf = NULL;
+    int writes = 0;
+    int size = 0;
+    int i;
+
+    if ((argc != 8) && (argc != 9)) {
+        fprintf(stderr,
+                "Usage: %s <host> <volume> <logfile> <file> <expected> "
+                "<writes> <size> [<lease id>]\n",
+                argv[0]);
+        return 1;
+    }
+
+    writes = atoi(argv[6]);
+    size = atoi(argv[7]);
+
+    buf = malloc((size_t)writes * size);
+    if (!buf)
+        return 1;
+    for (i = 0; i < writes; i++)
+        memset(buf + (size_t)i * size, 'a' + (i % 26), size);
+
+    expected = fopen(argv[5], "w");
+    if (!expected ||
+        (fwrite(buf, size, writes, expected) != (size_t)writes) ||
+        fclose(expected)) {
+        perror("expected");
+        return 1;
+    }
+
+    fs = glfs_new(argv[2]);
+    if (!fs || glfs_set_volfile_server(fs, "tcp", argv[1], 24007) ||
+        glfs_set_logging(fs, argv[3], 7) || glfs_init(fs)) {
+        fprintf(stderr, "glfs_init failed\n");
+        return 1;
+    }
+
+    if (argc == 9) {
+        strncpy(leaseid, argv[8], sizeof(leaseid));
+        if (glfs_setfsleaseid(leaseid)) {
+            perror("glfs_setfsleaseid");
+            return 1;
+        }
+    }
+
+    glfd = glfs_creat(fs, argv[4], O_RDWR | O_TRUNC, 0644);
+    if (!glfd) {
+        perror("glfs_creat");
+        return 1;
+    }
+
+    pthread_mutex_lock(&lock);
+    pending = writes;
+    pthread_mutex_unlock(&lock);
+
+    for (i = 0; i < writes; i++) {
+        if (glfs_pwrite_async(glfd, buf + (size_t)i * size, size,
+                              (off_t)i * size, 0, write_cbk,
+                              (void *)(long)size)) {
+            perror("glfs_pwrite_async");
+            return 1;
+        }
+    }
+
+    pthread_mutex_lock(&lock);
+    while (pending > 0)
+        pthread_cond_wait(&cond, &lock);
+    pthread_mutex_unlock(&lock);
+
+    if (failed) {
+        fprintf(stderr, "%d writes failed\n", failed);
+        return 1;
+    }
+
+    glfs_sysrq(fs, GLFS_SYSRQ_STATEDUMP);
+
+    glfs_close(glfd);
+    glfs_fini(fs);
+    free(buf);
+
+    printf("%d\n", getpid());
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#!/bin/bash
+
+#With disperse.write-coalesce, small writes that arrive while another write
+#owns the inode lock are held and sent together. The content of the file must
+#be the same, and the statedump must show that writes were held and merged,
+#also when all of them carry the same xdata.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function coalesce_stat {
+        grep -a "^$1=" $statedump | cut -f2 -d'=' | tail -1
+}
+
+logdir=$(gluster --print-logdir)
+TEST build_tester $(dirname $0)/ec-write-coalesce.c -lgfapi -lpthread
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 disperse.write-coalesce on
+#Slow writes on the bricks, so that the next ones arrive while the lock is
+#owned
+TEST $CLI volume set $V0 delay-gen posix
+TEST $CLI volume set $V0 delay-gen.delay-duration 20000
+TEST $CLI volume set $V0 delay-gen.delay-percentage 100
+TEST $CLI volume set $V0 delay-gen.enable write
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+#Writes of 100 bytes, never aligned to the 1024 bytes stripe
+pid=$($(dirname $0)/ec-write-coalesce $H0 $V0 $logdir/ec-write-coalesce.log \
+      /file $B0/expected 2000 100)
+TEST [ -n "$pid" ]
+statedump=$(ls $statedumpdir/*.$pid.dump.* | tail -1)
+TEST [ -n "$statedump" ]
+EXPECT "1" coalesce_stat write-coalesce
+TEST [ $(coalesce_stat coalesce-held) -gt 0 ]
+TEST [ $(coalesce_stat coalesce-batches) -gt 0 ]
+TEST [ $(coalesce_stat coalesce-batches) -le $(coalesce_stat coalesce-held) ]
+rm -f $statedump
+
+TEST cmp $B0/expected $M0/file
+
+#Writes that carry the same xdata are merged too
+pid=$($(dirname $0)/ec-write-coalesce $H0 $V0 $logdir/ec-write-coalesce.log \
+      /file3 $B0/expected 2000 100 coalesce-lease-id)
+TEST [ -n "$pid" ]
+statedump=$(ls $statedumpdir/*.$pid.dump.* | tail -1)
+TEST [ -n "$statedump" ]
+TEST [ $(coalesce_stat coalesce-held) -gt 0 ]
+TEST [ $(coalesce_stat coalesce-batches) -gt 0 ]
+rm -f $statedump
+
+TEST cmp $B0/expected $M0/file3
+
+#Same content without the option
+TEST $CLI volume set $V0 disperse.write-coalesce off
+pid=$($(dirname $0)/ec-write-coalesce $H0 $V0 $logdir/ec-write-coalesce.log \
+      /file2 $B0/expected 200 100)
+statedump=$(ls $statedumpdir/*.$pid.dump.* | tail -1)
+EXPECT "0" coalesce_stat coalesce-held
+rm -f $statedump
+TEST cmp -n 20000 $B0/expected $M0/file2
+
+TEST force_umount $M0
+cleanup_tester $(dirname $0)/ec-write-coalesce
+cleanup;
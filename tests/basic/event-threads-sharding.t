@@ -0,0 +1,101 @@
+#!/bin/bash
+
+#With event-threads-sharding and event-threads-balance 'incoming-cpu', each
+#event thread of the brick is bound to the CPUs whose connections it receives.
+#The CPU sets of the threads must not overlap and must be rebuilt when the
+#number of threads changes. This binding takes precedence over
+#event-threads-numa-pin. Connections established before enabling the sharding,
+#which stay in the shared epoll instance, must keep working when the thread
+#that has it nested terminates.
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function epoll_tids {
+        local pid=$(get_brick_pid $V0 $H0 $B0/${V0}0)
+        grep -l "^glfs_epoll" /proc/$pid/task/*/comm 2>/dev/null | \
+                cut -f5 -d'/'
+}
+
+#Prints "<threads> <cpus> <distinct cpus>" of the bound epoll threads of the
+#brick, where <cpus> counts every CPU of every thread
+function epoll_cpus {
+        local all=$(nproc)
+        local threads=0
+        local list=""
+        local cpus
+        for tid in $(epoll_tids); do
+                cpus=$(taskset -cp $tid | cut -f2 -d':' | tr -d ' ')
+                cpus=$(echo $cpus | tr ',' '\n' | \
+                       awk -F'-' '{for (i = $1; i <= ($2 == "" ? $1 : $2); \
+                                   i++) print i}')
+                if [ $(echo "$cpus" | wc -l) -lt $all ]; then
+                        threads=$((threads + 1))
+                        list="$list $cpus"
+                fi
+        done
+        echo "$threads $(echo $list | wc -w) $(echo $list | tr ' ' '\n' | \
+              sort -u | wc -l)"
+}
+
+function bound_threads {
+        epoll_cpus | cut -f1 -d' '
+}
+
+function cpus_disjoint {
+        local cpus=($(epoll_cpus))
+        if [ ${cpus[1]} -eq ${cpus[2]} ]; then
+                echo "Y"
+        else
+                echo "N"
+        fi
+}
+
+function file_count {
+        ls $M0 | wc -l
+}
+
+expected=4
+if [ $(nproc) -lt 4 ]; then
+        expected=$(nproc)
+fi
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.event-threads 4
+TEST $CLI volume start $V0
+
+#This connection stays in the shared epoll instance
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1;
+TEST touch $M1/before
+
+TEST $CLI volume set $V0 server.event-threads-numa-pin on
+TEST $CLI volume set $V0 server.event-threads-balance incoming-cpu
+TEST $CLI volume set $V0 server.event-threads-sharding on
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST touch $M0/file{1..50}
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "$expected" bound_threads
+EXPECT "Y" cpus_disjoint
+EXPECT "51" file_count
+
+#Fewer threads take all the CPUs between them. The shared epoll instance is
+#handed over when the thread that has it terminates.
+TEST $CLI volume set $V0 server.event-threads 2
+if [ $expected -gt 2 ]; then
+        expected=2
+fi
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "$expected" bound_threads
+EXPECT "Y" cpus_disjoint
+TEST [ $(epoll_cpus | cut -f3 -d' ') -eq $(nproc) ]
+
+TEST touch $M1/after{1..50}
+TEST rm -f $M0/file{1..50}
+TEST stat $M1/before
+EXPECT "51" file_count
+
+TEST force_umount $M0
+TEST force_umount $M1
+cleanup;
@@ -0,0 +1,77 @@
+/* Copies a range between two files of a volume with glfs_copy_file_range()
+ * and prints the number of bytes copied, or the error. The destination is
+ * created if it doesn't exist. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <glusterfs/api/glfs.h>
+
+int
+main(int argc, char **argv)
+{
+    glfs_t *fs = NULL;
+    glfs_fd_t *glfd_in = NULL;
+    glfs_fd_t *glfd_out = NULL;
+    off64_t off_in = 0;
+    off64_t off_out = 0;
+    size_t len = 0;
+    ssize_t ret = -1;
+
+    if (argc != 9) {
+        fprintf(stderr,
+                "%s <host> <volume> <log file> <source> <destination> "
+                "<source offset> <destination offset> <length>\n",
+                argv[0]);
+        return 1;
+    }
+
+    off_in = strtoll(argv[6], NULL, 0);
+    off_out = strtoll(argv[7], NULL, 0);
+    len = strtoull(argv[8], NULL, 0);
+
+    fs = glfs_new(argv[2]);
+    if (!fs) {
+        fprintf(stderr, "glfs_new: %s\n", strerror(errno));
+        return 1;
+    }
+
+    if (glfs_set_volfile_server(fs, "tcp", argv[1], 24007) ||
+        glfs_set_logging(fs, argv[3], 7) || glfs_init(fs)) {
+        fprintf(stderr, "glfs_init: %s\n", strerror(errno));
+        return 1;
+    }
+
+    glfd_in = glfs_open(fs, argv[4], O_RDONLY);
+    if (!glfd_in) {
+        fprintf(stderr, "open %s: %s\n", argv[4], strerror(errno));
+        goto out;
+    }
+
+    glfd_out = glfs_creat(fs, argv[5], O_RDWR, 0644);
+    if (!glfd_out) {
+        fprintf(stderr, "open %s: %s\n", argv[5], strerror(errno));
+        goto out;
+    }
+
+    ret = glfs_copy_file_range(glfd_in, &off_in, glfd_out, &off_out, len, 0,
+                               NULL, NULL, NULL);
+    if (ret < 0) {
+        if (errno == EXDEV)
+            printf("EXDEV\n");
+        else
+            printf("ERROR %d\n", errno);
+    } else {
+        printf("%zd\n", ret);
+    }
+
+out:
+    if (glfd_in)
+        glfs_close(glfd_in);
+    if (glfd_out)
+        glfs_close(glfd_out);
+    glfs_fini(fs);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#!/bin/bash
+
+#md-cache serves cached stats without taking locks, and the cached xattrs are
+#replaced by updated copies instead of being changed in place. Concurrent
+#readers must always see complete and current values, and the hit counters,
+#now split in stripes, must add up in the statedump.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function mdc_stat {
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+function xattr_value_count {
+        local count=0
+        for i in {1..50}; do
+                if [ "$(getfattr --only-values -n $1 $M0/file$i 2>/dev/null)" \
+                     == "$2$i" ]; then
+                        count=$((count + 1))
+                fi
+        done
+        echo $count
+}
+
+function mode_count {
+        stat -c %a $M0/file{1..50} | grep -x "$1" | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 group metadata-cache
+TEST $CLI volume set $V0 performance.xattr-cache-list "user.*"
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --attribute-timeout=0 \
+          --entry-timeout=0 $M0;
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --attribute-timeout=0 \
+          --entry-timeout=0 $M1;
+
+TEST touch $M0/file{1..50}
+for i in {1..50}; do
+        TEST setfattr -n user.foo -v foo$i $M0/file$i
+done
+EXPECT "50" xattr_value_count user.foo foo
+
+#Concurrent readers of the cached stats and xattrs
+hits=$(mdc_stat stat_hit_count)
+xhits=$(mdc_stat xattr_hit_count)
+seq 1 50 | xargs -P 16 -I{} sh -c "for j in 1 2 3 4; do \
+        stat $M0/file{} > /dev/null; \
+        getfattr -n user.foo $M0/file{} > /dev/null; done"
+TEST [ $(mdc_stat stat_hit_count) -gt $((hits + 50)) ]
+TEST [ $(mdc_stat xattr_hit_count) -gt $((xhits + 50)) ]
+EXPECT "50" xattr_value_count user.foo foo
+
+#Another client changes the xattrs while this one keeps reading them. Once
+#the invalidations have arrived, only the new values are seen.
+(seq 1 50 | xargs -P 16 -I{} sh -c "for j in 1 2 3 4; do \
+        getfattr -n user.foo $M0/file{} > /dev/null; done") &
+reader=$!
+for i in {1..50}; do
+        TEST setfattr -n user.foo -v bar$i $M1/file$i
+done
+wait $reader
+EXPECT_WITHIN $MDC_TIMEOUT "50" xattr_value_count user.foo bar
+TEST [ $(mdc_stat xattr_invalidations_received) -gt 0 ]
+
+#Adding and removing xattrs installs new copies of the cached dict. The
+#other cached xattrs must still be there.
+for i in {1..50}; do
+        TEST setfattr -n user.baz -v baz$i $M0/file$i
+done
+EXPECT "50" xattr_value_count user.baz baz
+EXPECT "50" xattr_value_count user.foo bar
+for i in {1..50}; do
+        TEST setfattr -x user.baz $M0/file$i
+done
+EXPECT "0" xattr_value_count user.baz baz
+EXPECT "50" xattr_value_count user.foo bar
+
+#Stats stay current after changes from the other client
+TEST chmod 600 $M1/file{1..50}
+EXPECT_WITHIN $MDC_TIMEOUT "50" mode_count 600
+
+TEST force_umount $M0
+TEST force_umount $M1
+cleanup;
@@ -0,0 +1,86 @@
+#!/bin/bash
+
+#With performance.md-cache-prefetch, a directory whose entries are looked up
+#one by one is read ahead with readdirp, and the next lookups are served from
+#the cache. Negative lookups must not start a prefetch, a prefetch stopped by
+#the limit must resume near the walk, and the entries never used must be
+#counted as waste.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function prefetch_stat {
+        local statedump=$(generate_mount_statedump $V0 $1)
+        grep -a "^$2=" $statedump | cut -f2 -d'=' | tail -1
+        rm -f $statedump
+}
+
+function walk {
+        local count=0
+        for f in $(ls -U $B0/$V0/$2 | head -$3); do
+                stat $1/$2/$f > /dev/null && count=$((count + 1))
+        done
+        echo $count
+}
+
+logdir=$(gluster --print-logdir)
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/$V0
+TEST $CLI volume set $V0 group metadata-cache
+TEST $CLI volume set $V0 performance.md-cache-prefetch on
+TEST $CLI volume start $V0
+
+#The files are created by another client, so that nothing is cached here
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1;
+TEST mkdir $M1/dir{1,2,3}
+TEST touch $M1/dir1/file{1..300} $M1/dir2/file{1..300} $M1/dir3/file{1..300}
+TEST force_umount $M1
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --attribute-timeout=0 \
+          --entry-timeout=0 --log-level=DEBUG \
+          --log-file=$logdir/md-cache-prefetch.log $M0;
+
+#Negative lookups don't count
+for i in {1..20}; do
+        TEST ! stat $M0/dir1/missing$i
+done
+EXPECT "0" prefetch_stat $M0 prefetch_count
+
+#Walk in the order of the directory
+EXPECT "300" walk $M0 dir1 300
+TEST [ $(prefetch_stat $M0 prefetch_count) -ge 1 ]
+TEST [ $(prefetch_stat $M0 prefetched_entries) -gt 250 ]
+TEST [ $(prefetch_stat $M0 prefetch_hit_count) -gt 250 ]
+EXPECT "0" prefetch_stat $M0 prefetch_waste_count
+
+#With a small limit, each prefetch stops after 50 entries and the next one
+#starts where the walk is, not at the beginning of the directory
+TEST $CLI volume set $V0 performance.md-cache-prefetch-limit 50
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "50" mount_get_option_value $M0 \
+              $V0-md-cache md-cache-prefetch-limit
+count=$(prefetch_stat $M0 prefetch_count)
+hits=$(prefetch_stat $M0 prefetch_hit_count)
+EXPECT "300" walk $M0 dir2 300
+TEST [ $(prefetch_stat $M0 prefetch_count) -ge $((count + 4)) ]
+TEST [ $(prefetch_stat $M0 prefetch_hit_count) -gt $((hits + 200)) ]
+gfid=$(gf_gfid_xattr_to_str $(gf_get_gfid_xattr $B0/$V0/dir2))
+TEST [ $(grep "prefetching directory $gfid from" \
+         $logdir/md-cache-prefetch.log | grep -v " from 0$" | wc -l) -gt 0 ]
+EXPECT "0" prefetch_stat $M0 prefetch_waste_count
+
+#A client with a small inode table forgets the entries cached ahead before
+#the walk gets to them
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --attribute-timeout=0 \
+          --entry-timeout=0 --lru-limit=32 $M1;
+EXPECT "10" walk $M1 dir3 10
+TEST [ $(prefetch_stat $M1 prefetch_count) -ge 1 ]
+TEST [ $(prefetch_stat $M1 prefetch_waste_count) -gt 0 ]
+EXPECT "300" walk $M1 dir3 300
+
+TEST force_umount $M0
+TEST force_umount $M1
+rm -f $logdir/md-cache-prefetch.log
+cleanup;
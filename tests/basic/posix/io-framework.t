@@ -0,0 +1,96 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../common-utils.rc
+
+cleanup;
+
+USERNAME=iofwuser
+
+function gfid2path_count {
+    getfattr -d -m trusted.gfid2path -e text $1 2>/dev/null | grep -c "/$2\"$"
+}
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.io-framework on
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# open, fstat and fallocate
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=1
+TEST fallocate -l 4M $M0/file
+EXPECT "4194304" stat -c %s $M0/file
+EXPECT "4194304" stat -c %s $B0/${V0}0/file
+
+# fsetxattr and fgetxattr
+TEST setfattr -n user.test -v value $M0/file
+EXPECT "value" getfattr --only-values -n user.test $M0/file
+
+# Requests of other users must keep their credentials
+TEST useradd -M $USERNAME
+push_trapfunc "userdel --force $USERNAME"
+TEST chmod 600 $M0/file
+TEST ! run_cmd_as_user $USERNAME "cat $M0/file"
+TEST ! run_cmd_as_user $USERNAME "setfattr -n user.test -v other $M0/file"
+TEST ! run_cmd_as_user $USERNAME "mv $M0/file $M0/stolen"
+TEST ! run_cmd_as_user $USERNAME "rm -f $M0/file"
+TEST stat $B0/${V0}0/file
+EXPECT "value" getfattr --only-values -n user.test $M0/file
+TEST chmod 644 $M0/file
+
+# Their requests still use the I/O framework where they are allowed
+TEST mkdir $M0/user
+TEST chown $USERNAME $M0/user
+TEST run_cmd_as_user $USERNAME "dd if=/dev/zero of=$M0/user/file bs=1M count=1"
+TEST run_cmd_as_user $USERNAME "fallocate -l 2M $M0/user/file"
+EXPECT "2097152" stat -c %s $B0/${V0}0/user/file
+TEST run_cmd_as_user $USERNAME "setfattr -n user.test -v mine $M0/user/file"
+EXPECT "mine" getfattr --only-values -n user.test $M0/user/file
+TEST run_cmd_as_user $USERNAME "mv $M0/user/file $M0/user/moved"
+EXPECT "1" gfid2path_count $B0/${V0}0/user/moved moved
+TEST run_cmd_as_user $USERNAME "rm -f $M0/user/moved"
+TEST ! stat $B0/${V0}0/user/moved
+
+# rename, also replacing an existing file
+TEST touch $M0/victim
+victim_gfid=$(gf_get_gfid_backend_file_path $B0/${V0}0 victim)
+TEST mv $M0/file $M0/renamed
+TEST ! stat $M0/file
+TEST stat $B0/${V0}0/renamed
+
+# gfid2path must follow the rename
+EXPECT "1" gfid2path_count $B0/${V0}0/renamed renamed
+EXPECT "0" gfid2path_count $B0/${V0}0/renamed file
+TEST mv $M0/renamed $M0/victim
+TEST ! stat $B0/${V0}0/renamed
+TEST ! stat $victim_gfid
+EXPECT "value" getfattr --only-values -n user.test $M0/victim
+
+# Only the last name of a file renamed many times is kept
+TEST touch $M0/hop0
+for i in {1..20}; do
+    TEST mv $M0/hop$((i - 1)) $M0/hop$i
+done
+EXPECT "1" gfid2path_count $B0/${V0}0/hop20 "hop[0-9]*"
+EXPECT "1" gfid2path_count $B0/${V0}0/hop20 hop20
+
+# unlink must remove the gfid handle too
+gfid_path=$(gf_get_gfid_backend_file_path $B0/${V0}0 victim)
+TEST stat $gfid_path
+TEST rm -f $M0/victim
+TEST ! stat $B0/${V0}0/victim
+TEST ! stat $gfid_path
+
+# Disabling it must restore regular behavior
+TEST $CLI volume set $V0 storage.io-framework off
+TEST touch $M0/file2
+TEST rm -f $M0/file2
+TEST ! stat $B0/${V0}0/file2
+
+cleanup;
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+#With server.io-uring and client.io-uring, the connections between the client
+#and the bricks receive and send their data through io_uring. The framing is
+#the same as on plain sockets, so a client without io_uring must still work
+#with the same bricks.
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function uring_count {
+        grep -a "using io_uring for the connection" $1 2>/dev/null | wc -l
+}
+
+logdir=$(gluster --print-logdir)
+brick_log=$logdir/bricks/$(echo $B0/${V0}0 | sed 's|^/||; s|/|-|g').log
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 diagnostics.brick-log-level DEBUG
+TEST $CLI volume set $V0 server.io-uring on
+TEST $CLI volume set $V0 client.io-uring on
+TEST $CLI volume start $V0
+
+if grep -aq "'transport.socket.io-uring' is not supported" $brick_log; then
+        echo "io_uring data path not available in this build" >&2
+        cleanup;
+        SKIP_TESTS
+        exit 0
+fi
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --log-level=DEBUG \
+          --log-file=$logdir/socket-io-uring.log $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+TEST [ $(uring_count $logdir/socket-io-uring.log) -ge 2 ]
+TEST [ $(uring_count $brick_log) -ge 1 ]
+
+#Requests and replies bigger than the provided buffers, and many small ones
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=16
+TEST cp $B0/data $M0/data
+TEST cmp $B0/data $M0/data
+TEST $(dirname $0)/rpc-coverage.sh $M0
+
+#A plain socket client works with the same bricks
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 \
+          --xlator-option=$V0-client-0.transport.socket.io-uring=off \
+          --xlator-option=$V0-client-1.transport.socket.io-uring=off $M1;
+TEST cmp $B0/data $M1/data
+TEST cp $M1/data $M1/data2
+TEST cmp $B0/data $M0/data2
+
+TEST force_umount $M0
+TEST force_umount $M1
+rm -f $B0/data $logdir/socket-io-uring.log
+cleanup;
@@ -0,0 +1,81 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.zero-copy-read on
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# Reads of different sizes and alignments, including a short read at EOF
+TEST dd if=/dev/urandom of=$B0/orig bs=1M count=3
+TEST truncate -s +12345 $B0/orig
+TEST cp $B0/orig $M0/file
+TEST drop_cache $M0
+
+for bs in 4k 128k 1M; do
+        EXPECT "$(md5sum < $B0/orig)" eval "dd if=$M0/file bs=$bs 2>/dev/null | md5sum"
+done
+unaligned="bs=64k skip=1000 count=200000 iflag=count_bytes,skip_bytes"
+EXPECT "$(dd if=$B0/orig $unaligned 2>/dev/null | md5sum)" \
+       eval "dd if=$M0/file $unaligned 2>/dev/null | md5sum"
+
+# Reading past EOF returns nothing
+EXPECT "0" eval "dd if=$M0/file bs=128k skip=100 2>/dev/null | wc -c"
+
+# Each reply holds the data of the file when it was read, even if the file
+# is overwritten right after
+function overwrite_and_read {
+        local i
+        for i in $(seq 1 20); do
+                yes "pattern $i" | head -c 1M > $B0/pattern
+                dd if=$B0/pattern of=$M0/file bs=1M conv=notrunc,fsync \
+                   2>/dev/null
+                if [ "$(dd if=$M0/file bs=1M count=1 iflag=direct \
+                        2>/dev/null | md5sum)" != "$(md5sum < $B0/pattern)" ]
+                then
+                        echo "N"
+                        return
+                fi
+        done
+        echo "Y"
+}
+EXPECT "Y" overwrite_and_read
+TEST dd if=$B0/orig of=$M0/file bs=1M conv=notrunc
+TEST rm -f $B0/pattern
+
+# Pipes are reused, so the descriptors used by the brick don't grow with the
+# number of reads
+function brick_pipe_count {
+        ls -l /proc/$(get_brick_pid $V0 $H0 $B0/${V0}0)/fd 2>/dev/null |
+                grep -c "pipe:"
+}
+
+function parallel_reads {
+        for i in $(seq 1 16); do
+                dd if=$M0/file of=/dev/null bs=128k iflag=direct 2>/dev/null &
+        done
+        wait
+}
+
+parallel_reads
+first=$(brick_pipe_count)
+for round in 1 2 3 4; do
+        parallel_reads
+done
+TEST [ $(brick_pipe_count) -le $((first + 16)) ]
+EXPECT "$(md5sum < $B0/orig)" eval "dd if=$M0/file bs=1M 2>/dev/null | md5sum"
+
+TEST rm -f $B0/orig
+cleanup;
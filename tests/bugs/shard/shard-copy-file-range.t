@@ -0,0 +1,55 @@
+#!/bin/bash
+
+#copy_file_range on sharded files copies each shard from the source shard at
+#the same position. Ranges that don't start at the same offset inside a block
+#and files with different block sizes must be refused with EXDEV.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function copy_range {
+        $(dirname $0)/../../basic/gfapi/glfs-copy-range $H0 $V0 \
+                $logdir/glfs-copy-range.log "$@"
+}
+
+logdir=$(gluster --print-logdir)
+TEST build_tester $(dirname $0)/../../basic/gfapi/glfs-copy-range.c -lgfapi
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 features.shard on
+TEST $CLI volume set $V0 features.shard-block-size 4MB
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/src bs=1M count=10
+
+#Whole file, across three shards
+EXPECT "10485760" copy_range /src /dst 0 0 10485760
+TEST cmp $M0/src $M0/dst
+gfid_dst=$(get_gfid_string $M0/dst)
+TEST stat $B0/${V0}0/.shard/$gfid_dst.1
+TEST stat $B0/${V0}0/.shard/$gfid_dst.2
+
+#Same offset inside a block, different blocks
+EXPECT "1048576" copy_range /src /part 5242880 1048576 1048576
+TEST cmp -n 1048576 -i 5242880:1048576 $M0/src $M0/part
+
+#Different offsets inside a block
+EXPECT "EXDEV" copy_range /src /dst 4096 0 4096
+
+#Different block sizes
+TEST $CLI volume set $V0 features.shard-block-size 8MB
+TEST touch $M0/big
+EXPECT "EXDEV" copy_range /src /big 0 0 4096
+
+#Source and destination in the same file
+EXPECT "EXDEV" copy_range /src /src 0 4194304 4096
+
+TEST cmp $M0/src $M0/dst
+
+TEST force_umount $M0
+cleanup_tester $(dirname $0)/../../basic/gfapi/glfs-copy-range
+cleanup;
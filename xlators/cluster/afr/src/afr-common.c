@@ -2689,6 +2689,10 @@ afr_local_cleanup(afr_local_t *local, xlator_t *this)
             iobref_unref(local->cont.writev.iobref);
     }
 
+    { /* readv */
+        afr_readv_stripes_wipe(local);
+    }
+
     { /* setxattr */
         if (local->cont.setxattr.dict)
             dict_unref(local->cont.setxattr.dict);
@@ -2719,6 +2723,13 @@ afr_local_cleanup(afr_local_t *local, xlator_t *this)
             fd_unref(local->cont.open.fd);
     }
 
+    { /* copy_file_range */
+        if (local->cont.copy_file_range.fd_in)
+            fd_unref(local->cont.copy_file_range.fd_in);
+        loc_wipe(&local->cont.copy_file_range.loc_in);
+        GF_FREE(local->cont.copy_file_range.locked_on);
+    }
+
     { /* readdirp */
         if (local->cont.readdir.dict)
             dict_unref(local->cont.readdir.dict);
@@ -5668,6 +5679,9 @@ afr_priv_dump(xlator_t *this)
         gf_proc_dump_write(key, "%" PRId64, priv->child_latency[i]);
         sprintf(key, "halo_child_up[%d]", i);
         gf_proc_dump_write(key, "%d", priv->halo_child_up[i]);
+        sprintf(key, "read_deadline[%d]", i);
+        gf_proc_dump_write(key, "%" PRIu64,
+                           cluster_read_deadline(&priv->read_latency[i]));
     }
     gf_proc_dump_write("data_self_heal", "%d", priv->data_self_heal);
     gf_proc_dump_write("metadata_self_heal", "%d", priv->metadata_self_heal);
@@ -5681,6 +5695,23 @@ afr_priv_dump(xlator_t *this)
     gf_proc_dump_write("healers", "%d", priv->healers);
     gf_proc_dump_write("read-hash-mode", "%d", priv->hash_mode);
     gf_proc_dump_write("use-anonymous-inode", "%d", priv->use_anon_inode);
+    gf_proc_dump_write("read-stripe-size", "%" PRIu64, priv->read_stripe_size);
+    gf_proc_dump_write("striped_reads", "%" PRId64,
+                       GF_ATOMIC_GET(priv->striped_reads));
+    gf_proc_dump_write("striped_read_fallbacks", "%" PRId64,
+                       GF_ATOMIC_GET(priv->striped_read_fallbacks));
+    gf_proc_dump_write("hedge-reads", "%d", priv->hedge_reads);
+    gf_proc_dump_write("hedged_reads", "%" PRId64,
+                       GF_ATOMIC_GET(priv->hedged_reads));
+    gf_proc_dump_write("hedged_reads_won", "%" PRId64,
+                       GF_ATOMIC_GET(priv->hedged_reads_won));
+    gf_proc_dump_write("changelog-batch", "%d", priv->changelog_batch);
+    gf_proc_dump_write("xattrop_batches", "%" PRId64,
+                       GF_ATOMIC_GET(priv->xattrop_batches));
+    gf_proc_dump_write("xattrop_batched", "%" PRId64,
+                       GF_ATOMIC_GET(priv->xattrop_batched));
+    gf_proc_dump_write("xattrop_batch_stale", "%" PRId64,
+                       GF_ATOMIC_GET(priv->xattrop_batch_stale));
     if (priv->quorum_count == AFR_QUORUM_AUTO) {
         gf_proc_dump_write("quorum-type", "auto");
     } else if (priv->quorum_count == 0) {
@@ -5986,6 +6017,8 @@ __afr_handle_child_up_event(xlator_t *this, xlator_t *child_xlator,
         priv->event_generation++;
     }
     priv->child_up[idx] = 1;
+    /* The brick may have been upgraded. */
+    priv->xattrop_batch[idx].unsupported = _gf_false;
 
     *call_psh = 1;
     *up_child = idx;
@@ -6667,6 +6700,12 @@ afr_priv_destroy(afr_private_t *priv)
     }
 
     GF_FREE(priv->pending_reads);
+    if (priv->read_latency) {
+        for (i = 0; i < priv->child_count; i++)
+            cluster_read_latency_fini(&priv->read_latency[i]);
+        GF_FREE(priv->read_latency);
+    }
+    GF_FREE(priv->xattrop_batch);
     GF_FREE(priv->local);
     GF_FREE(priv->pending_key);
     GF_FREE(priv->children);
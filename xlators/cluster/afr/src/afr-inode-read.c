@@ -1731,6 +1731,500 @@ afr_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     return 0;
 }
 
+/*
+ * Striped reads:
+ *
+ * A single stream of big reads normally uses only one brick: the one that
+ * the read policy has chosen for the inode. When read-stripe-size is set and
+ * the file is readable from all the data bricks, a read of at least twice
+ * that size is split in contiguous pieces, one per child, that are read in
+ * parallel and put back together in order before unwinding.
+ *
+ * If any piece fails, the whole read is sent again to the chosen child as a
+ * normal read, so that the usual retry logic takes care of the error. A short
+ * piece is an end of file: the pieces after it are discarded.
+ */
+
+void
+afr_readv_stripes_wipe(afr_local_t *local)
+{
+    struct afr_read_stripe *stripe = NULL;
+    int i = 0;
+
+    for (i = 0; i < local->cont.readv.stripe_count; i++) {
+        stripe = &local->cont.readv.stripes[i];
+        GF_FREE(stripe->vector);
+        if (stripe->iobref)
+            iobref_unref(stripe->iobref);
+    }
+    GF_FREE(local->cont.readv.stripes);
+    local->cont.readv.stripes = NULL;
+    local->cont.readv.stripe_count = 0;
+}
+
+static void
+afr_readv_stripe_done(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = NULL;
+    afr_private_t *priv = NULL;
+    struct afr_read_stripe *stripe = NULL;
+    struct afr_reply *reply = NULL;
+    struct iovec *vector = NULL;
+    struct iobref *iobref = NULL;
+    struct iatt *buf = NULL;
+    int32_t op_ret = 0;
+    int32_t count = 0;
+    int subvol = -1;
+    int pieces = 0;
+    int i = 0;
+
+    local = frame->local;
+    priv = this->private;
+    subvol = local->read_subvol;
+
+    for (i = 0; i < local->cont.readv.stripe_count; i++) {
+        stripe = &local->cont.readv.stripes[i];
+        reply = &local->replies[stripe->child];
+        if (reply->op_ret < 0) {
+            gf_msg_debug(this->name, reply->op_errno,
+                         "%s: striped read failed on %s, retrying on %s",
+                         uuid_utoa(local->inode->gfid),
+                         priv->children[stripe->child]->name,
+                         priv->children[subvol]->name);
+            goto fallback;
+        }
+        op_ret += reply->op_ret;
+        count += stripe->count;
+        buf = &reply->poststat;
+        pieces++;
+        if (reply->op_ret < stripe->size)
+            break;
+    }
+
+    iobref = iobref_new();
+    if (!iobref)
+        goto fallback;
+    if (count > 0) {
+        vector = GF_CALLOC(count, sizeof(*vector), gf_common_mt_iovec);
+        if (!vector)
+            goto fallback;
+    }
+
+    count = 0;
+    for (i = 0; i < pieces; i++) {
+        stripe = &local->cont.readv.stripes[i];
+        if (stripe->count > 0) {
+            memcpy(vector + count, stripe->vector,
+                   stripe->count * sizeof(*vector));
+            count += stripe->count;
+        }
+        if (stripe->iobref && (iobref_merge(iobref, stripe->iobref) != 0))
+            goto fallback;
+    }
+
+    AFR_STACK_UNWIND(readv, frame, op_ret, 0, vector, count, buf, iobref,
+                     local->replies[local->cont.readv.stripes[0].child].xdata);
+
+    GF_FREE(vector);
+    iobref_unref(iobref);
+
+    return;
+
+fallback:
+    GF_FREE(vector);
+    if (iobref)
+        iobref_unref(iobref);
+
+    GF_ATOMIC_INC(priv->striped_read_fallbacks);
+    STACK_WIND_COOKIE(
+        frame, afr_readv_cbk, (void *)(long)subvol, priv->children[subvol],
+        priv->children[subvol]->fops->readv, local->fd, local->cont.readv.size,
+        local->cont.readv.offset, local->cont.readv.flags, local->xdata_req);
+}
+
+static int
+afr_readv_stripe_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                     int32_t count, struct iatt *buf, struct iobref *iobref,
+                     dict_t *xdata)
+{
+    afr_local_t *local = NULL;
+    struct afr_read_stripe *stripe = NULL;
+    struct afr_reply *reply = NULL;
+
+    local = frame->local;
+    stripe = &local->cont.readv.stripes[(long)cookie];
+    reply = &local->replies[stripe->child];
+
+    reply->valid = 1;
+    reply->op_ret = op_ret;
+    reply->op_errno = op_errno;
+    if (op_ret >= 0) {
+        if (buf)
+            reply->poststat = *buf;
+        if (count > 0) {
+            stripe->vector = iov_dup(vector, count);
+            if (!stripe->vector) {
+                reply->op_ret = -1;
+                reply->op_errno = ENOMEM;
+            }
+            stripe->count = count;
+        }
+        if (iobref)
+            stripe->iobref = iobref_ref(iobref);
+    }
+    if (xdata)
+        reply->xdata = dict_ref(xdata);
+
+    if (stripe->child != local->read_subvol)
+        afr_pending_read_decrement(this->private, stripe->child);
+
+    if (afr_frame_return(frame) == 0)
+        afr_readv_stripe_done(frame, this);
+
+    return 0;
+}
+
+/* Splits the read among the readable children, starting with the one that
+ * has been chosen by the read policy. Returns -1 if the read can't be
+ * striped. */
+static int
+afr_readv_stripe(call_frame_t *frame, xlator_t *this, int subvol)
+{
+    afr_local_t *local = NULL;
+    afr_private_t *priv = NULL;
+    afr_fd_ctx_t *fd_ctx = NULL;
+    struct afr_read_stripe *stripes = NULL;
+    uint64_t stripe_size = 0;
+    uint64_t chunk = 0;
+    size_t size = 0;
+    off_t offset = 0;
+    int *children = NULL;
+    int child = 0;
+    int count = 0;
+    int i = 0;
+
+    local = frame->local;
+    priv = this->private;
+    stripe_size = priv->read_stripe_size;
+    size = local->cont.readv.size;
+
+    /* Only the first attempt is striped. Retries use a single child. */
+    if ((stripe_size == 0) || (size < 2 * stripe_size) ||
+        local->cont.readv.stripes)
+        return -1;
+
+    fd_ctx = afr_fd_ctx_get(local->fd, this);
+    if (!fd_ctx)
+        return -1;
+
+    children = alloca(priv->child_count * sizeof(*children));
+    for (i = 0; i < priv->child_count; i++) {
+        child = (subvol + i) % priv->child_count;
+        if (AFR_IS_ARBITER_BRICK(priv, child))
+            continue;
+        /* All data bricks must have a good copy of the file. */
+        if (!local->readable[child] || !local->child_up[child])
+            return -1;
+        if (!fd_is_anonymous(local->fd) &&
+            (fd_ctx->opened_on[child] != AFR_FD_OPENED))
+            return -1;
+        children[count++] = child;
+    }
+
+    /* Pieces are multiples of the stripe size. */
+    chunk = (size + stripe_size - 1) / stripe_size;
+    chunk = (chunk + count - 1) / count * stripe_size;
+    count = (size + chunk - 1) / chunk;
+    if (count < 2)
+        return -1;
+
+    stripes = GF_CALLOC(count, sizeof(*stripes), gf_afr_mt_read_stripe_t);
+    if (!stripes)
+        return -1;
+
+    offset = local->cont.readv.offset;
+    for (i = 0; i < count; i++) {
+        stripes[i].child = children[i];
+        stripes[i].offset = offset;
+        stripes[i].size = min(chunk, size);
+        offset += stripes[i].size;
+        size -= stripes[i].size;
+    }
+
+    afr_local_replies_wipe(local, priv);
+    local->cont.readv.stripes = stripes;
+    local->cont.readv.stripe_count = count;
+    local->call_count = count;
+
+    GF_ATOMIC_INC(priv->striped_reads);
+    for (i = 0; i < count; i++) {
+        child = stripes[i].child;
+        if (child != subvol)
+            afr_pending_read_increment(priv, child);
+        STACK_WIND_COOKIE(frame, afr_readv_stripe_cbk, (void *)(long)i,
+                          priv->children[child],
+                          priv->children[child]->fops->readv, local->fd,
+                          stripes[i].size, stripes[i].offset,
+                          local->cont.readv.flags, local->xdata_req);
+    }
+
+    return 0;
+}
+
+/*
+ * Hedged reads:
+ *
+ * When hedge-reads is enabled, a read that hasn't been answered after the
+ * deadline of its child (the 95th percentile of its recent read latencies)
+ * is also sent to another child that has a good copy of the file. The first
+ * successful answer is used.
+ *
+ * Each read is sent from its own copy of the frame, and the state they share
+ * is reference counted, so the read that answers last finds everything it
+ * needs even if the readv has already been unwound.
+ */
+
+typedef struct afr_read_hedge {
+    gf_lock_t lock;
+    call_frame_t *frame; /* readv to answer, NULL once answered */
+    gf_timer_t *timer;   /* deadline of the first read, if armed */
+    xlator_t *this;
+    fd_t *fd;
+    dict_t *xdata;
+    size_t size;
+    off_t offset;
+    uint32_t flags;
+    struct timespec start[2];
+    int child[2]; /* child of the first read and of the hedge */
+    int pending;
+    int refs;
+} afr_read_hedge_t;
+
+static void
+afr_read_hedge_unref(afr_read_hedge_t *hedge)
+{
+    int refs = 0;
+
+    LOCK(&hedge->lock);
+    {
+        refs = --hedge->refs;
+    }
+    UNLOCK(&hedge->lock);
+
+    if (refs > 0)
+        return;
+
+    fd_unref(hedge->fd);
+    if (hedge->xdata)
+        dict_unref(hedge->xdata);
+    LOCK_DESTROY(&hedge->lock);
+    GF_FREE(hedge);
+}
+
+/* Child to which the read can be hedged, or -1 if there's none. */
+static int
+afr_read_hedge_child(xlator_t *this, afr_local_t *local, int subvol)
+{
+    afr_private_t *priv = NULL;
+    afr_fd_ctx_t *fd_ctx = NULL;
+    int child = 0;
+    int i = 0;
+
+    priv = this->private;
+    fd_ctx = afr_fd_ctx_get(local->fd, this);
+    if (!fd_ctx)
+        return -1;
+
+    for (i = 1; i < priv->child_count; i++) {
+        child = (subvol + i) % priv->child_count;
+        if (AFR_IS_ARBITER_BRICK(priv, child) || !local->readable[child] ||
+            !local->child_up[child] || local->read_attempted[child])
+            continue;
+        if (!fd_is_anonymous(local->fd) &&
+            (fd_ctx->opened_on[child] != AFR_FD_OPENED))
+            continue;
+        return child;
+    }
+
+    return -1;
+}
+
+static int
+afr_readv_hedge_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                    int32_t count, struct iatt *buf, struct iobref *iobref,
+                    dict_t *xdata)
+{
+    afr_read_hedge_t *hedge = NULL;
+    afr_private_t *priv = NULL;
+    call_frame_t *readv_frame = NULL;
+    int child = (long)cookie;
+    int idx = 0;
+
+    hedge = frame->local;
+    frame->local = NULL;
+    priv = this->private;
+    idx = (child == hedge->child[0]) ? 0 : 1;
+
+    if (op_ret >= 0)
+        cluster_read_latency_add(&priv->read_latency[child],
+                                 &hedge->start[idx]);
+    if (idx == 1)
+        afr_pending_read_decrement(priv, child);
+
+    LOCK(&hedge->lock);
+    {
+        hedge->pending--;
+        /* A failed read waits for the other one, if any. */
+        if (hedge->frame && ((op_ret >= 0) || (hedge->pending == 0))) {
+            readv_frame = hedge->frame;
+            hedge->frame = NULL;
+        }
+        /* The timer callback takes hedge->lock, so the timer can't be
+         * released while it's cancelled here. */
+        if (readv_frame && hedge->timer) {
+            if (gf_timer_call_cancel(this->ctx, hedge->timer) == 0)
+                hedge->refs--;
+            hedge->timer = NULL;
+        }
+    }
+    UNLOCK(&hedge->lock);
+
+    if (readv_frame) {
+        if ((idx == 1) && (op_ret >= 0))
+            GF_ATOMIC_INC(priv->hedged_reads_won);
+        afr_readv_cbk(readv_frame, cookie, this, op_ret, op_errno, vector,
+                      count, buf, iobref, xdata);
+    }
+
+    STACK_DESTROY(frame->root);
+    afr_read_hedge_unref(hedge);
+
+    return 0;
+}
+
+static void
+afr_readv_hedge_timeout(void *data)
+{
+    afr_read_hedge_t *hedge = data;
+    afr_private_t *priv = NULL;
+    afr_local_t *local = NULL;
+    call_frame_t *frame = NULL;
+    xlator_t *this = NULL;
+    int child = -1;
+
+    this = hedge->this;
+    priv = this->private;
+
+    LOCK(&hedge->lock);
+    {
+        hedge->timer = NULL;
+        if (hedge->frame && (hedge->pending == 1) &&
+            (hedge->child[1] == -1)) {
+            local = hedge->frame->local;
+            child = afr_read_hedge_child(this, local, hedge->child[0]);
+            if (child != -1)
+                frame = copy_frame(hedge->frame);
+            if (frame) {
+                local->read_attempted[child] = 1;
+                hedge->child[1] = child;
+                timespec_now(&hedge->start[1]);
+                hedge->pending++;
+                hedge->refs++;
+            }
+        }
+    }
+    UNLOCK(&hedge->lock);
+
+    if (frame) {
+        gf_msg_debug(this->name, 0, "%s: read is late, hedging it to %s",
+                     uuid_utoa(hedge->fd->inode->gfid),
+                     priv->children[child]->name);
+        GF_ATOMIC_INC(priv->hedged_reads);
+        afr_pending_read_increment(priv, child);
+        frame->local = hedge;
+        STACK_WIND_COOKIE(frame, afr_readv_hedge_cbk, (void *)(long)child,
+                          priv->children[child],
+                          priv->children[child]->fops->readv, hedge->fd,
+                          hedge->size, hedge->offset, hedge->flags,
+                          hedge->xdata);
+    }
+
+    afr_read_hedge_unref(hedge);
+}
+
+/* Sends the read to @subvol and prepares a hedge for it. Returns -1 if the
+ * read can't be hedged. */
+static int
+afr_readv_hedge(call_frame_t *frame, xlator_t *this, int subvol)
+{
+    afr_local_t *local = NULL;
+    afr_private_t *priv = NULL;
+    afr_read_hedge_t *hedge = NULL;
+    call_frame_t *read_frame = NULL;
+    struct timespec delta = {
+        0,
+    };
+    uint64_t deadline = 0;
+
+    local = frame->local;
+    priv = this->private;
+
+    if (!priv->hedge_reads ||
+        (afr_read_hedge_child(this, local, subvol) == -1))
+        return -1;
+
+    hedge = GF_CALLOC(1, sizeof(*hedge), gf_afr_mt_read_hedge_t);
+    if (!hedge)
+        return -1;
+    read_frame = copy_frame(frame);
+    if (!read_frame) {
+        GF_FREE(hedge);
+        return -1;
+    }
+
+    LOCK_INIT(&hedge->lock);
+    hedge->frame = frame;
+    hedge->this = this;
+    hedge->fd = fd_ref(local->fd);
+    if (local->xdata_req)
+        hedge->xdata = dict_ref(local->xdata_req);
+    hedge->size = local->cont.readv.size;
+    hedge->offset = local->cont.readv.offset;
+    hedge->flags = local->cont.readv.flags;
+    hedge->child[0] = subvol;
+    hedge->child[1] = -1;
+    hedge->pending = 1;
+    hedge->refs = 1;
+    timespec_now(&hedge->start[0]);
+
+    /* Until enough reads have been measured there's no deadline. The
+     * timer is armed with the lock held, so that its callback always finds
+     * it in hedge->timer. */
+    deadline = cluster_read_deadline(&priv->read_latency[subvol]);
+    if (deadline) {
+        delta.tv_sec = deadline / GF_SEC_IN_NS;
+        delta.tv_nsec = deadline % GF_SEC_IN_NS;
+        LOCK(&hedge->lock);
+        {
+            hedge->timer = gf_timer_call_after(this->ctx, delta,
+                                               afr_readv_hedge_timeout, hedge);
+            if (hedge->timer)
+                hedge->refs++;
+        }
+        UNLOCK(&hedge->lock);
+    }
+
+    read_frame->local = hedge;
+    STACK_WIND_COOKIE(read_frame, afr_readv_hedge_cbk, (void *)(long)subvol,
+                      priv->children[subvol],
+                      priv->children[subvol]->fops->readv, hedge->fd,
+                      hedge->size, hedge->offset, hedge->flags, hedge->xdata);
+
+    return 0;
+}
+
 int
 afr_readv_wind(call_frame_t *frame, xlator_t *this, int subvol)
 {
@@ -1746,6 +2240,12 @@ afr_readv_wind(call_frame_t *frame, xlator_t *this, int subvol)
         return 0;
     }
 
+    if (afr_readv_stripe(frame, this, subvol) == 0)
+        return 0;
+
+    if (afr_readv_hedge(frame, this, subvol) == 0)
+        return 0;
+
     STACK_WIND_COOKIE(
         frame, afr_readv_cbk, (void *)(long)subvol, priv->children[subvol],
         priv->children[subvol]->fops->readv, local->fd, local->cont.readv.size,
@@ -29,6 +29,9 @@ int32_t
 afr_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
           off_t offset, uint32_t flags, dict_t *xdata);
 
+void
+afr_readv_stripes_wipe(afr_local_t *local);
+
 int32_t
 afr_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, const char *name,
              dict_t *xdata);
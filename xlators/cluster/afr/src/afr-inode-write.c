@@ -88,6 +88,11 @@ __afr_inode_write_finalize(call_frame_t *frame, xlator_t *this)
             continue;
         if (local->replies[i].op_ret < 0)
             continue;
+        /* The arbiter doesn't copy any data, so its answer doesn't say how
+         * much has been copied. */
+        if ((local->op == GF_FOP_COPY_FILE_RANGE) &&
+            AFR_IS_ARBITER_BRICK(priv, i))
+            continue;
 
         /* Order of checks in the compound conditional
            below is important.
@@ -118,6 +123,18 @@ __afr_inode_write_finalize(call_frame_t *frame, xlator_t *this)
         }
     }
 
+    /* Like a short write, a data brick that copied less than the others
+     * is now out of sync. */
+    if (local->op == GF_FOP_COPY_FILE_RANGE) {
+        for (i = 0; i < priv->child_count; i++) {
+            if (!local->replies[i].valid || (local->replies[i].op_ret < 0) ||
+                AFR_IS_ARBITER_BRICK(priv, i))
+                continue;
+            if (local->replies[i].op_ret < local->op_ret)
+                afr_transaction_fop_failed(frame, this, i);
+        }
+    }
+
     afr_set_in_flight_sb_status(this, frame, local->inode);
 out:
     return;
@@ -137,7 +154,8 @@ __afr_inode_write_fill(call_frame_t *frame, xlator_t *this, int child_index,
 
     local->replies[child_index].valid = 1;
 
-    if (AFR_IS_ARBITER_BRICK(priv, child_index) && op_ret == 1)
+    if (AFR_IS_ARBITER_BRICK(priv, child_index) &&
+        (local->op == GF_FOP_WRITE) && (op_ret == 1))
         op_ret = iov_length(local->cont.writev.vector,
                             local->cont.writev.count);
 
@@ -2262,6 +2280,391 @@ out:
 
 /* }}} */
 
+/* {{{ copy_file_range */
+
+/* Each brick copies the data from its own copy of the source file. A write
+ * to the source racing with the copy could reach one brick before it and
+ * another one after it, leaving destination replicas that differ without
+ * any pending changelog. So a read lock on the source range is held from
+ * before the transaction starts until the copy has completed on all the
+ * bricks.
+ *
+ * The lock is not blocking: two copies going in opposite directions between
+ * the same files would deadlock otherwise. When it can't be taken, EXDEV
+ * makes the caller fall back to a regular read and write. */
+
+static int32_t
+afr_copy_file_range_unlock_cbk(call_frame_t *frame, void *cookie,
+                               xlator_t *this, int32_t op_ret,
+                               int32_t op_errno, dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = this->private;
+    int child_index = (long)cookie;
+
+    if (op_ret < 0)
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, AFR_MSG_UNLOCK_FAIL,
+               "%s: failed to unlock the source of copy_file_range on %s",
+               uuid_utoa(local->loc.gfid), priv->children[child_index]->name);
+
+    if (afr_frame_return(frame) == 0)
+        AFR_STACK_DESTROY(frame);
+
+    return 0;
+}
+
+static void
+afr_copy_file_range_unlock(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = this->private;
+    afr_local_t *unlock_local = NULL;
+    call_frame_t *unlock_frame = NULL;
+    unsigned char *locked_on = alloca0(priv->child_count);
+    struct gf_flock flock = {
+        0,
+    };
+    int op_errno = 0;
+    int count = 0;
+    int i;
+
+    if (!local->cont.copy_file_range.locked_on)
+        return;
+
+    /* The transaction can unwind twice, see
+     * afr_transaction_detach_fop_frame(). */
+    LOCK(&frame->lock);
+    {
+        memcpy(locked_on, local->cont.copy_file_range.locked_on,
+               priv->child_count);
+        memset(local->cont.copy_file_range.locked_on, 0, priv->child_count);
+    }
+    UNLOCK(&frame->lock);
+
+    count = AFR_COUNT(locked_on, priv->child_count);
+    if (count == 0)
+        return;
+
+    unlock_frame = copy_frame(frame);
+    if (!unlock_frame)
+        goto err;
+
+    unlock_local = AFR_FRAME_INIT(unlock_frame, op_errno);
+    if (!unlock_local)
+        goto err;
+
+    if (loc_copy(&unlock_local->loc, &local->cont.copy_file_range.loc_in))
+        goto err;
+
+    lk_owner_copy(&unlock_frame->root->lk_owner,
+                  &local->cont.copy_file_range.lk_owner);
+
+    flock.l_type = F_UNLCK;
+    flock.l_whence = SEEK_SET;
+    flock.l_start = local->cont.copy_file_range.off_in;
+    flock.l_len = local->cont.copy_file_range.len;
+
+    unlock_local->call_count = count;
+    for (i = 0; i < priv->child_count; i++) {
+        if (!locked_on[i])
+            continue;
+        STACK_WIND_COOKIE(unlock_frame, afr_copy_file_range_unlock_cbk,
+                          (void *)(long)i, priv->children[i],
+                          priv->children[i]->fops->inodelk, this->name,
+                          &unlock_local->loc, F_SETLK, &flock, NULL);
+        if (!--count)
+            break;
+    }
+
+    return;
+
+err:
+    gf_msg(this->name, GF_LOG_WARNING, ENOMEM, AFR_MSG_UNLOCK_FAIL,
+           "%s: failed to unlock the source of copy_file_range",
+           uuid_utoa(local->cont.copy_file_range.loc_in.gfid));
+    if (unlock_frame)
+        AFR_STACK_DESTROY(unlock_frame);
+}
+
+int
+afr_copy_file_range_unwind(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = NULL;
+    call_frame_t *main_frame = NULL;
+
+    local = frame->local;
+
+    afr_copy_file_range_unlock(frame, this);
+
+    main_frame = afr_transaction_detach_fop_frame(frame);
+    if (!main_frame)
+        return 0;
+
+    AFR_STACK_UNWIND(copy_file_range, main_frame, local->op_ret,
+                     local->op_errno, &local->cont.copy_file_range.stbuf,
+                     &local->cont.inode_wfop.prebuf,
+                     &local->cont.inode_wfop.postbuf, local->xdata_rsp);
+    return 0;
+}
+
+int
+afr_copy_file_range_wind_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *stbuf, struct iatt *prebuf_dst,
+                             struct iatt *postbuf_dst, dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = this->private;
+
+    /* The arbiter doesn't have the real size of the source. */
+    if ((op_ret >= 0) && stbuf &&
+        !AFR_IS_ARBITER_BRICK(priv, (long)cookie)) {
+        LOCK(&frame->lock);
+        {
+            local->cont.copy_file_range.stbuf = *stbuf;
+        }
+        UNLOCK(&frame->lock);
+    }
+
+    return __afr_inode_write_cbk(frame, cookie, this, op_ret, op_errno,
+                                 prebuf_dst, postbuf_dst, NULL, xdata);
+}
+
+int
+afr_copy_file_range_wind(call_frame_t *frame, xlator_t *this, int subvol)
+{
+    afr_local_t *local = NULL;
+    afr_private_t *priv = NULL;
+
+    local = frame->local;
+    priv = this->private;
+
+    STACK_WIND_COOKIE(frame, afr_copy_file_range_wind_cbk,
+                      (void *)(long)subvol, priv->children[subvol],
+                      priv->children[subvol]->fops->copy_file_range,
+                      local->cont.copy_file_range.fd_in,
+                      local->cont.copy_file_range.off_in, local->fd,
+                      local->cont.copy_file_range.off_out,
+                      local->cont.copy_file_range.len,
+                      local->cont.copy_file_range.flags, local->xdata_req);
+    return 0;
+}
+
+/* Each brick copies the data from its own copy of the source file, so all
+ * the bricks that will receive the copy need to have good data for it. */
+static gf_boolean_t
+afr_copy_file_range_source_is_good(xlator_t *this, inode_t *inode)
+{
+    afr_private_t *priv = this->private;
+    unsigned char *data = alloca0(priv->child_count);
+    unsigned char *metadata = alloca0(priv->child_count);
+    int event = 0;
+    int i;
+
+    if (afr_inode_read_subvol_get(inode, this, data, metadata, &event) < 0)
+        return _gf_false;
+
+    if (event != priv->event_generation)
+        return _gf_false;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (priv->child_up[i] && !data[i] && !AFR_IS_ARBITER_BRICK(priv, i))
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+static void
+afr_copy_file_range_fail(call_frame_t *frame, xlator_t *this, int op_errno)
+{
+    afr_local_t *local = frame->local;
+    call_frame_t *main_frame = local->transaction.main_frame;
+
+    afr_copy_file_range_unlock(frame, this);
+
+    AFR_STACK_DESTROY(frame);
+
+    AFR_STACK_UNWIND(copy_file_range, main_frame, -1, op_errno, NULL, NULL,
+                     NULL, NULL);
+}
+
+static int32_t
+afr_copy_file_range_lock_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    int child_index = (long)cookie;
+    int ret = 0;
+
+    LOCK(&frame->lock);
+    {
+        if (op_ret == 0)
+            local->cont.copy_file_range.locked_on[child_index] = 1;
+        else
+            local->cont.copy_file_range.lock_errno = op_errno;
+    }
+    UNLOCK(&frame->lock);
+
+    if (afr_frame_return(frame) > 0)
+        return 0;
+
+    /* The source could have been marked bad by a write completed before
+     * the lock was granted. */
+    if (local->cont.copy_file_range.lock_errno ||
+        !afr_copy_file_range_source_is_good(
+                this, local->cont.copy_file_range.fd_in->inode)) {
+        gf_msg_debug(this->name, local->cont.copy_file_range.lock_errno,
+                     "%s: source can't be locked, copy_file_range not "
+                     "possible",
+                     uuid_utoa(local->cont.copy_file_range.loc_in.gfid));
+        afr_copy_file_range_fail(frame, this, EXDEV);
+        return 0;
+    }
+
+    ret = afr_transaction(frame, this, AFR_DATA_TRANSACTION);
+    if (ret < 0)
+        afr_copy_file_range_fail(frame, this, -ret);
+
+    return 0;
+}
+
+static int
+afr_copy_file_range_lock(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = this->private;
+    struct gf_flock flock = {
+        0,
+    };
+    int count = 0;
+    int i;
+
+    count = AFR_COUNT(priv->child_up, priv->child_count);
+    if (count == 0)
+        return -ENOTCONN;
+
+    set_lk_owner_from_ptr(&frame->root->lk_owner, local);
+    lk_owner_copy(&local->cont.copy_file_range.lk_owner,
+                  &frame->root->lk_owner);
+
+    flock.l_type = F_RDLCK;
+    flock.l_whence = SEEK_SET;
+    flock.l_start = local->cont.copy_file_range.off_in;
+    flock.l_len = local->cont.copy_file_range.len;
+
+    local->call_count = count;
+    for (i = 0; i < priv->child_count; i++) {
+        if (!priv->child_up[i])
+            continue;
+        STACK_WIND_COOKIE(frame, afr_copy_file_range_lock_cbk,
+                          (void *)(long)i, priv->children[i],
+                          priv->children[i]->fops->inodelk, this->name,
+                          &local->cont.copy_file_range.loc_in, F_SETLK, &flock,
+                          NULL);
+        if (!--count)
+            break;
+    }
+
+    return 0;
+}
+
+int
+afr_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = NULL;
+    call_frame_t *transaction_frame = NULL;
+    int ret = -1;
+    int op_errno = ENOMEM;
+
+    AFR_ERROR_OUT_IF_FDCTX_INVALID(fd_in, this, op_errno, out);
+    AFR_ERROR_OUT_IF_FDCTX_INVALID(fd_out, this, op_errno, out);
+
+    /* The caller will fall back to a regular read and write. */
+    if (!afr_copy_file_range_source_is_good(this, fd_in->inode)) {
+        gf_msg_debug(this->name, 0,
+                     "%s: source needs heal, copy_file_range not possible",
+                     uuid_utoa(fd_in->inode->gfid));
+        op_errno = EXDEV;
+        goto out;
+    }
+
+    /* The lock on the source would conflict with the one of the
+     * transaction. */
+    if (fd_in->inode == fd_out->inode) {
+        op_errno = EXDEV;
+        goto out;
+    }
+
+    transaction_frame = copy_frame(frame);
+    if (!transaction_frame)
+        goto out;
+
+    local = AFR_FRAME_INIT(transaction_frame, op_errno);
+    if (!local)
+        goto out;
+
+    local->cont.copy_file_range.fd_in = fd_ref(fd_in);
+    local->cont.copy_file_range.off_in = off_in;
+    local->cont.copy_file_range.off_out = off_out;
+    local->cont.copy_file_range.len = len;
+    local->cont.copy_file_range.flags = flags;
+
+    local->cont.copy_file_range.loc_in.inode = inode_ref(fd_in->inode);
+    gf_uuid_copy(local->cont.copy_file_range.loc_in.gfid, fd_in->inode->gfid);
+
+    local->cont.copy_file_range.locked_on = GF_CALLOC(priv->child_count, 1,
+                                                      gf_afr_mt_char);
+    if (!local->cont.copy_file_range.locked_on)
+        goto out;
+
+    local->fd = fd_ref(fd_out);
+    ret = afr_set_inode_local(this, local, fd_out->inode);
+    if (ret)
+        goto out;
+
+    if (xdata)
+        local->xdata_req = dict_copy_with_ref(xdata, NULL);
+    else
+        local->xdata_req = dict_new();
+
+    if (!local->xdata_req)
+        goto out;
+
+    local->op = GF_FOP_COPY_FILE_RANGE;
+
+    local->transaction.wind = afr_copy_file_range_wind;
+    local->transaction.unwind = afr_copy_file_range_unwind;
+
+    local->transaction.main_frame = frame;
+
+    local->transaction.start = off_out;
+    local->transaction.len = len;
+
+    afr_fix_open(fd_in, this);
+    afr_fix_open(fd_out, this);
+
+    ret = afr_copy_file_range_lock(transaction_frame, this);
+    if (ret < 0) {
+        op_errno = -ret;
+        goto out;
+    }
+
+    return 0;
+out:
+    if (transaction_frame)
+        AFR_STACK_DESTROY(transaction_frame);
+
+    AFR_STACK_UNWIND(copy_file_range, frame, -1, op_errno, NULL, NULL, NULL,
+                     NULL);
+    return 0;
+}
+
+/* }}} */
+
 int32_t
 afr_xattrop_wind_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                      int32_t op_ret, int32_t op_errno, dict_t *xattr,
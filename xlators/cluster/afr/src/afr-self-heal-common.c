@@ -713,6 +713,7 @@ afr_reply_copy(struct afr_reply *dst, struct afr_reply *src)
         memcpy(dst->checksum, src->checksum, MD5_DIGEST_LENGTH);
     }
     dst->fips_mode_rchecksum = src->fips_mode_rchecksum;
+    dst->xxh64x2_rchecksum = src->xxh64x2_rchecksum;
 }
 
 void
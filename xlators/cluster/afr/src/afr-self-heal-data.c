@@ -13,6 +13,8 @@
 #include "protocol-common.h"
 #include "afr-messages.h"
 #include <glusterfs/events.h>
+#include <glusterfs/syncop-utils.h>
+#include <glusterfs/checksum.h>
 #include <openssl/md5.h>
 
 #define HAS_HOLES(i) ((i->ia_blocks * 512) < (i->ia_size))
@@ -22,6 +24,7 @@ __checksum_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
 {
     afr_local_t *local = NULL;
     struct afr_reply *replies = NULL;
+    char *type = NULL;
     int i = (long)cookie;
 
     local = frame->local;
@@ -30,11 +33,16 @@ __checksum_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     replies[i].valid = 1;
     replies[i].op_ret = op_ret;
     replies[i].op_errno = op_errno;
+    replies[i].xxh64x2_rchecksum = _gf_false;
     if (xdata) {
         replies[i].buf_has_zeroes = dict_get_str_boolean(
             xdata, "buf-has-zeroes", _gf_false);
         replies[i].fips_mode_rchecksum = dict_get_str_boolean(
             xdata, "fips-mode-rchecksum", _gf_false);
+        if ((dict_get_str_sizen(xdata, GF_RCHECKSUM_TYPE, &type) == 0) &&
+            (strcmp(type, GF_RCHECKSUM_XXH64X2) == 0)) {
+            replies[i].xxh64x2_rchecksum = _gf_true;
+        }
     }
     if (strong) {
         if (replies[i].fips_mode_rchecksum) {
@@ -72,6 +80,13 @@ __afr_can_skip_data_block_heal(call_frame_t *frame, xlator_t *this, fd_t *fd,
         dict_unref(xdata);
         goto out;
     }
+    /* Bricks not in FIPS mode that support it will use xxh64x2 (two XXH64
+     * hashes of the block) instead of MD5, which is much cheaper. */
+    if (dict_set_sizen_str_sizen(xdata, GF_RCHECKSUM_TYPE,
+                                 GF_RCHECKSUM_XXH64X2)) {
+        dict_unref(xdata);
+        goto out;
+    }
 
     wind_subvols = alloca0(priv->child_count);
     for (i = 0; i < priv->child_count; i++) {
@@ -91,6 +106,14 @@ __afr_can_skip_data_block_heal(call_frame_t *frame, xlator_t *this, fd_t *fd,
         if (i == source)
             continue;
         if (replies[i].valid) {
+            /* Checksums of different types can't be compared. */
+            if ((replies[source].fips_mode_rchecksum !=
+                 replies[i].fips_mode_rchecksum) ||
+                (replies[source].xxh64x2_rchecksum !=
+                 replies[i].xxh64x2_rchecksum)) {
+                checksum_match = _gf_false;
+                break;
+            }
             if (memcmp(replies[source].checksum, replies[i].checksum,
                        replies[source].fips_mode_rchecksum
                            ? SHA256_DIGEST_LENGTH
@@ -283,6 +306,107 @@ unlock:
     return ret;
 }
 
+/* Makes sure that the hole of the source at [offset, offset + size) is also
+ * a hole in the sinks. Returns 1 if the range has to be healed as data. */
+static int
+afr_selfheal_data_hole(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       int source, unsigned char *healed_sinks, off_t offset,
+                       size_t size, struct afr_reply *replies)
+{
+    int ret = -1;
+    int i = 0;
+    off_t data = 0;
+    uint64_t sink_size = 0;
+    gf_boolean_t punch = _gf_false;
+    afr_private_t *priv = NULL;
+    unsigned char *data_lock = NULL;
+
+    priv = this->private;
+
+    /* Sinks have been truncated to the size of the source, so there's
+     * already a hole in the ones that didn't reach this offset. */
+    for (i = 0; i < priv->child_count; i++) {
+        if (healed_sinks[i] && (replies[i].poststat.ia_size > offset))
+            punch = _gf_true;
+    }
+    if (!punch)
+        return 0;
+
+    data_lock = alloca0(priv->child_count);
+
+    gf_msg_debug(this->name, 0, "gfid:%s, hole offset=%jd, size=%zu",
+                 uuid_utoa(fd->inode->gfid), offset, size);
+
+    ret = afr_selfheal_inodelk(frame, this, fd->inode, this->name, offset, size,
+                               data_lock);
+    {
+        if (!afr_source_sinks_locked(this, data_lock, source, healed_sinks)) {
+            ret = -ENOTCONN;
+            goto unlock;
+        }
+
+        /* The hole was found without holding the lock. Writes also go to
+         * the sinks, so punching data written since then would lose it. */
+        ret = syncop_seek(priv->children[source], fd, offset, GF_SEEK_DATA,
+                          NULL, &data);
+        if ((ret < 0) ? (ret != -ENXIO) : (data < offset + size)) {
+            ret = 1;
+            goto unlock;
+        }
+
+        for (i = 0; i < priv->child_count; i++) {
+            if (!healed_sinks[i])
+                continue;
+            sink_size = replies[i].poststat.ia_size;
+            if (sink_size <= offset)
+                continue;
+
+            ret = syncop_discard(priv->children[i], fd, offset,
+                                 min(size, sink_size - offset), NULL, NULL);
+            if (ret < 0) {
+                /* Writing zeros is the only option left. */
+                ret = 1;
+                goto unlock;
+            }
+        }
+        ret = 0;
+    }
+unlock:
+    afr_selfheal_uninodelk(frame, this, fd->inode, this->name, offset, size,
+                           data_lock);
+    return ret;
+}
+
+/* Finds the next data segment of the source at or after @offset. The whole
+ * range up to @size is considered data if the source can't tell. */
+static void
+afr_selfheal_data_segment(xlator_t *this, fd_t *fd, int source, off_t offset,
+                          off_t size, off_t *start, off_t *end)
+{
+    afr_private_t *priv = this->private;
+    size_t len = 0;
+    int ret = 0;
+
+    *start = offset;
+    ret = syncop_seek_data_segment(priv->children[source], fd, start, &len);
+    if (ret < 0) {
+        gf_msg_debug(this->name, -ret, "%s: unable to find data segments",
+                     uuid_utoa(fd->inode->gfid));
+        *start = offset;
+        *end = size;
+    } else if (ret == 0) {
+        *start = size;
+        *end = size;
+    } else {
+        *end = *start + len;
+    }
+
+    if (*start > size)
+        *start = size;
+    if (*end > size)
+        *end = size;
+}
+
 static int
 afr_selfheal_data_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd,
                         unsigned char *healed_sinks)
@@ -337,6 +461,9 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
 {
     afr_private_t *priv = NULL;
     off_t off = 0;
+    off_t start = 0;
+    off_t end = 0;
+    off_t size = 0;
     size_t block = 0;
     int type = AFR_SELFHEAL_DATA_FULL;
     int ret = -1;
@@ -353,12 +480,11 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
     }
 
     block = 128 * 1024 * priv->data_self_heal_window_size;
-    if (HAS_HOLES((&replies[source].poststat))) {
-        /*Reduce the possibility of data-block allocations in case of files
-         * with holes. Correct way to fix it would be to use seek fop while
-         * healing data*/
-        block = 128 * 1024;
-    }
+    size = replies[source].poststat.ia_size;
+
+    /* Only the data segments of sparse files are read and written. The
+     * rest is kept as holes in the sinks. */
+    end = HAS_HOLES((&replies[source].poststat)) ? 0 : size;
 
     type = afr_data_self_heal_type_get(priv, healed_sinks, source, replies);
 
@@ -368,16 +494,38 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
         goto out;
     }
 
-    for (off = 0; off < replies[source].poststat.ia_size; off += block) {
+    while (off < size) {
         if (AFR_COUNT(healed_sinks, priv->child_count) == 0) {
             ret = -ENOTCONN;
             goto out;
         }
 
-        ret = afr_selfheal_data_block(iter_frame, this, fd, source,
-                                      healed_sinks, off, block, type, replies);
-        if (ret < 0)
-            goto out;
+        if (off >= end) {
+            afr_selfheal_data_segment(this, fd, source, off, size, &start,
+                                      &end);
+            if (start > off) {
+                ret = afr_selfheal_data_hole(iter_frame, this, fd, source,
+                                             healed_sinks, off, start - off,
+                                             replies);
+                if (ret < 0)
+                    goto out;
+                if (ret == 0) {
+                    off = start;
+                } else {
+                    end = start;
+                }
+            }
+        }
+
+        if (off < end) {
+            ret = afr_selfheal_data_block(iter_frame, this, fd, source,
+                                          healed_sinks, off,
+                                          min(block, end - off), type,
+                                          replies);
+            if (ret < 0)
+                goto out;
+            off += min(block, end - off);
+        }
 
         AFR_STACK_RESET(iter_frame);
         if (iter_frame->local == NULL) {
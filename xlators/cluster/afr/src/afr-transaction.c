@@ -1680,6 +1680,360 @@ afr_changelog_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     return 0;
 }
 
+/* Batching of the changelog xattrops (cluster.changelog-batch).
+ *
+ * The xattrops of data and metadata transactions are queued per child. If no
+ * batch is in flight to that child the queue is sent right away. Otherwise it
+ * is sent when the answer of the current batch arrives, so the xattrops of
+ * concurrent transactions on different inodes share one round trip and no
+ * delay is added when there's nothing to batch.
+ *
+ * The batch is an ipc fop to GF_IPC_TARGET_XATTROP_BATCH. The server winds
+ * each xattrop to the brick graph and returns all the answers at once. Old
+ * bricks answer EOPNOTSUPP, and then the child gets plain xattrops again
+ * until it reconnects. The batch doesn't belong to any of the transactions,
+ * so it's sent on an internal frame without their pid or lk-owner.
+ *
+ * The fxattrops of transactions on an fd are sent by gfid too, and the server
+ * winds them as fxattrops on an anonymous fd. An inode that is open but
+ * unlinked can't be opened again by gfid on the brick, so its fxattrops are
+ * sent on the fd of the transaction. So are the ones the server answers with
+ * ESTALE. */
+
+typedef struct _afr_xattrop_batch_entry {
+    struct list_head list;
+    call_frame_t *frame; /* transaction waiting for the answer */
+    dict_t *xattr;
+    uuid_t gfid;
+    gf_boolean_t fd; /* fxattrop of a transaction on an fd */
+} afr_xattrop_batch_entry_t;
+
+typedef struct _afr_xattrop_batch_req {
+    struct list_head entries;
+    int32_t count;
+    int child;
+} afr_xattrop_batch_req_t;
+
+static void
+afr_xattrop_batch_entry_free(afr_xattrop_batch_entry_t *entry)
+{
+    dict_unref(entry->xattr);
+    GF_FREE(entry);
+}
+
+static void
+afr_xattrop_batch_wind(xlator_t *this, int child,
+                       afr_xattrop_batch_entry_t *entry)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = entry->frame->local;
+
+    if (entry->fd)
+        STACK_WIND_COOKIE(entry->frame, afr_changelog_cbk, (void *)(long)child,
+                          priv->children[child],
+                          priv->children[child]->fops->fxattrop, local->fd,
+                          GF_XATTROP_ADD_ARRAY, entry->xattr, NULL);
+    else
+        STACK_WIND_COOKIE(entry->frame, afr_changelog_cbk, (void *)(long)child,
+                          priv->children[child],
+                          priv->children[child]->fops->xattrop, &local->loc,
+                          GF_XATTROP_ADD_ARRAY, entry->xattr, NULL);
+}
+
+static void
+afr_xattrop_batch_fallback(xlator_t *this, afr_xattrop_batch_req_t *req)
+{
+    afr_xattrop_batch_entry_t *entry = NULL;
+    afr_xattrop_batch_entry_t *tmp = NULL;
+
+    list_for_each_entry_safe(entry, tmp, &req->entries, list)
+    {
+        list_del_init(&entry->list);
+        afr_xattrop_batch_wind(this, req->child, entry);
+        afr_xattrop_batch_entry_free(entry);
+    }
+
+    GF_FREE(req);
+}
+
+static void
+afr_xattrop_batch_answer(xlator_t *this, int child,
+                         afr_xattrop_batch_entry_t *entry, int32_t idx,
+                         int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    dict_t *xattr = NULL;
+    char key[64];
+    void *buf = NULL;
+    int len = 0;
+
+    if (op_ret >= 0) {
+        op_ret = -1;
+        op_errno = EIO;
+
+        snprintf(key, sizeof(key), GF_XATTROP_BATCH_RET, idx);
+        if (xdata && (dict_get_int32(xdata, key, &op_ret) == 0)) {
+            snprintf(key, sizeof(key), GF_XATTROP_BATCH_ERRNO, idx);
+            if (dict_get_int32(xdata, key, &op_errno) == 0)
+                op_errno = gf_error_to_errno(op_errno);
+        }
+
+        /* The server didn't find the inode in its table, or couldn't open
+         * it by gfid. A plain xattrop resolves it, and a plain fxattrop uses
+         * the fd that is already open. */
+        if ((op_ret < 0) && (op_errno == ESTALE)) {
+            afr_private_t *priv = this->private;
+
+            GF_ATOMIC_INC(priv->xattrop_batch_stale);
+            afr_xattrop_batch_wind(this, child, entry);
+            afr_xattrop_batch_entry_free(entry);
+            return;
+        }
+
+        snprintf(key, sizeof(key), GF_XATTROP_BATCH_XATTR, idx);
+        if ((op_ret >= 0) &&
+            (dict_get_ptr_and_len(xdata, key, &buf, &len) == 0)) {
+            xattr = dict_new();
+            if (xattr && (dict_unserialize(buf, len, &xattr) != 0)) {
+                dict_unref(xattr);
+                xattr = NULL;
+            }
+        }
+    }
+
+    afr_changelog_cbk(entry->frame, (void *)(long)child, this, op_ret,
+                      op_errno, xattr, NULL);
+
+    if (xattr)
+        dict_unref(xattr);
+    afr_xattrop_batch_entry_free(entry);
+}
+
+/* Takes the next batch from the queue of the child, or marks the child idle
+ * if there's nothing left. If there's no memory for the batch, the queue is
+ * moved to @plain instead. */
+static afr_xattrop_batch_req_t *
+afr_xattrop_batch_next(xlator_t *this, int child, gf_boolean_t *unsupported,
+                       struct list_head *plain)
+{
+    afr_private_t *priv = this->private;
+    afr_xattrop_batch_t *batch = &priv->xattrop_batch[child];
+    afr_xattrop_batch_req_t *req = NULL;
+    afr_xattrop_batch_entry_t *entry = NULL;
+    afr_xattrop_batch_entry_t *tmp = NULL;
+
+    req = GF_CALLOC(1, sizeof(*req), gf_afr_mt_xattrop_batch_t);
+
+    LOCK(&priv->lock);
+    {
+        if (list_empty(&batch->queue)) {
+            batch->busy = _gf_false;
+        } else if (!req) {
+            list_splice_init(&batch->queue, plain);
+        } else {
+            INIT_LIST_HEAD(&req->entries);
+            req->child = child;
+            list_for_each_entry_safe(entry, tmp, &batch->queue, list)
+            {
+                list_move_tail(&entry->list, &req->entries);
+                if (++req->count == GF_XATTROP_BATCH_MAX)
+                    break;
+            }
+            *unsupported = batch->unsupported;
+        }
+    }
+    UNLOCK(&priv->lock);
+
+    if (req && !req->count) {
+        GF_FREE(req);
+        req = NULL;
+    }
+
+    return req;
+}
+
+static int
+afr_xattrop_batch_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, dict_t *xdata);
+
+static int
+afr_xattrop_batch_send(xlator_t *this, afr_xattrop_batch_req_t *req)
+{
+    afr_private_t *priv = this->private;
+    afr_xattrop_batch_entry_t *entry = NULL;
+    call_frame_t *frame = NULL;
+    dict_t *xdata = NULL;
+    char key[64];
+    char *buf = NULL;
+    u_int len = 0;
+    int32_t idx = 0;
+
+    xdata = dict_new();
+    if (!xdata)
+        goto err;
+
+    list_for_each_entry(entry, &req->entries, list)
+    {
+        snprintf(key, sizeof(key), GF_XATTROP_BATCH_GFID, idx);
+        if (dict_set_gfuuid(xdata, key, entry->gfid, true) != 0)
+            goto err;
+        snprintf(key, sizeof(key), GF_XATTROP_BATCH_OPTYPE, idx);
+        if (dict_set_int32(xdata, key, GF_XATTROP_ADD_ARRAY) != 0)
+            goto err;
+        snprintf(key, sizeof(key), GF_XATTROP_BATCH_FD, idx);
+        if (entry->fd && (dict_set_int32(xdata, key, 1) != 0))
+            goto err;
+        if (dict_allocate_and_serialize(entry->xattr, &buf, &len) != 0)
+            goto err;
+        snprintf(key, sizeof(key), GF_XATTROP_BATCH_XATTR, idx);
+        if (dict_set_dynptr(xdata, key, buf, len) != 0) {
+            GF_FREE(buf);
+            goto err;
+        }
+        idx++;
+    }
+    if (dict_set_int32(xdata, GF_XATTROP_BATCH_COUNT, idx) != 0)
+        goto err;
+
+    frame = create_frame(this, this->ctx->pool);
+    if (!frame)
+        goto err;
+
+    GF_ATOMIC_INC(priv->xattrop_batches);
+    GF_ATOMIC_ADD(priv->xattrop_batched, idx);
+
+    STACK_WIND_COOKIE(frame, afr_xattrop_batch_cbk, req,
+                      priv->children[req->child],
+                      priv->children[req->child]->fops->ipc,
+                      GF_IPC_TARGET_XATTROP_BATCH, xdata);
+
+    dict_unref(xdata);
+
+    return 0;
+
+err:
+    if (xdata)
+        dict_unref(xdata);
+
+    return -1;
+}
+
+/* Sends the queue of the child. Only called by whoever set the child busy. */
+static void
+afr_xattrop_batch_flush(xlator_t *this, int child)
+{
+    afr_xattrop_batch_req_t *req = NULL;
+    afr_xattrop_batch_entry_t *entry = NULL;
+    afr_xattrop_batch_entry_t *tmp = NULL;
+    gf_boolean_t unsupported = _gf_false;
+    struct list_head plain;
+
+    for (;;) {
+        INIT_LIST_HEAD(&plain);
+        req = afr_xattrop_batch_next(this, child, &unsupported, &plain);
+        if (req) {
+            if (!unsupported && (afr_xattrop_batch_send(this, req) == 0))
+                break;
+            afr_xattrop_batch_fallback(this, req);
+            continue;
+        }
+        if (list_empty(&plain))
+            break;
+        list_for_each_entry_safe(entry, tmp, &plain, list)
+        {
+            list_del_init(&entry->list);
+            afr_xattrop_batch_wind(this, child, entry);
+            afr_xattrop_batch_entry_free(entry);
+        }
+    }
+}
+
+static int
+afr_xattrop_batch_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    afr_private_t *priv = this->private;
+    afr_xattrop_batch_req_t *req = cookie;
+    afr_xattrop_batch_entry_t *entry = NULL;
+    afr_xattrop_batch_entry_t *tmp = NULL;
+    int child = req->child;
+    int32_t idx = 0;
+
+    STACK_DESTROY(frame->root);
+
+    if ((op_ret < 0) && ((op_errno == EOPNOTSUPP) || (op_errno == ENOTSUP))) {
+        gf_msg(this->name, GF_LOG_INFO, op_errno, AFR_MSG_INFO_COMMON,
+               "%s doesn't support batched xattrops, sending them one by "
+               "one",
+               priv->children[child]->name);
+        LOCK(&priv->lock);
+        {
+            priv->xattrop_batch[child].unsupported = _gf_true;
+        }
+        UNLOCK(&priv->lock);
+        afr_xattrop_batch_fallback(this, req);
+    } else {
+        list_for_each_entry_safe(entry, tmp, &req->entries, list)
+        {
+            list_del_init(&entry->list);
+            afr_xattrop_batch_answer(this, child, entry, idx++, op_ret,
+                                     op_errno, xdata);
+        }
+        GF_FREE(req);
+    }
+
+    afr_xattrop_batch_flush(this, child);
+
+    return 0;
+}
+
+/* Queues the xattrop of a data or metadata transaction for the child. Returns
+ * false if it needs to be sent on its own. */
+static gf_boolean_t
+afr_xattrop_batch_queue(call_frame_t *frame, xlator_t *this, int child,
+                        dict_t *xattr)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    afr_xattrop_batch_t *batch = &priv->xattrop_batch[child];
+    afr_xattrop_batch_entry_t *entry = NULL;
+    inode_t *inode = NULL;
+    gf_boolean_t send = _gf_false;
+
+    if (!priv->changelog_batch || batch->unsupported)
+        return _gf_false;
+
+    inode = local->fd ? local->fd->inode : local->loc.inode;
+    if (!inode || gf_uuid_is_null(inode->gfid))
+        return _gf_false;
+
+    /* Without any name the inode may be open but unlinked, and then the
+     * brick can't open it by gfid. */
+    if (local->fd && !inode_has_dentry(inode))
+        return _gf_false;
+
+    entry = GF_CALLOC(1, sizeof(*entry), gf_afr_mt_xattrop_batch_t);
+    if (!entry)
+        return _gf_false;
+    INIT_LIST_HEAD(&entry->list);
+    entry->frame = frame;
+    entry->xattr = dict_ref(xattr);
+    gf_uuid_copy(entry->gfid, inode->gfid);
+    entry->fd = (local->fd != NULL);
+
+    LOCK(&priv->lock);
+    {
+        list_add_tail(&entry->list, &batch->queue);
+        send = !batch->busy;
+        batch->busy = _gf_true;
+    }
+    UNLOCK(&priv->lock);
+
+    if (send)
+        afr_xattrop_batch_flush(this, child);
+
+    return _gf_true;
+}
+
 void
 afr_changelog_populate_xdata(call_frame_t *frame, afr_xattrop_type_t op,
                              dict_t **xdata, dict_t **newloc_xdata)
@@ -1840,7 +2194,9 @@ afr_changelog_do(call_frame_t *frame, xlator_t *this, dict_t *xattr,
         switch (local->transaction.type) {
             case AFR_DATA_TRANSACTION:
             case AFR_METADATA_TRANSACTION:
-                if (!local->fd) {
+                if (afr_xattrop_batch_queue(frame, this, i, xattr)) {
+                    break;
+                } else if (!local->fd) {
                     STACK_WIND_COOKIE(
                         frame, afr_changelog_cbk, (void *)(long)i,
                         priv->children[i], priv->children[i]->fops->xattrop,
@@ -315,6 +315,11 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("use-anonymous-inode", priv->use_anon_inode, options, bool,
                      out);
+    GF_OPTION_RECONF("read-stripe-size", priv->read_stripe_size, options,
+                     size_uint64, out);
+    GF_OPTION_RECONF("hedge-reads", priv->hedge_reads, options, bool, out);
+    GF_OPTION_RECONF("changelog-batch", priv->changelog_batch, options, bool,
+                     out);
     if (priv->shd.enabled) {
         if ((priv->shd.enabled != enabled_old) ||
             (timeout_old != priv->shd.timeout))
@@ -567,6 +572,10 @@ init(xlator_t *this)
     afr_handle_anon_inode_options(priv, this->options);
 
     GF_OPTION_INIT("use-anonymous-inode", priv->use_anon_inode, bool, out);
+    GF_OPTION_INIT("read-stripe-size", priv->read_stripe_size, size_uint64,
+                   out);
+    GF_OPTION_INIT("hedge-reads", priv->hedge_reads, bool, out);
+    GF_OPTION_INIT("changelog-batch", priv->changelog_batch, bool, out);
     if (priv->quorum_count != 0)
         priv->consistent_io = _gf_false;
 
@@ -599,6 +608,33 @@ init(xlator_t *this)
     for (i = 0; i < child_count; i++)
         priv->child_latency[i] = -1;
 
+    priv->read_latency = GF_CALLOC(priv->child_count,
+                                   sizeof(*priv->read_latency),
+                                   gf_afr_mt_read_latency_t);
+    if (!priv->read_latency) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    for (i = 0; i < priv->child_count; i++)
+        cluster_read_latency_init(&priv->read_latency[i]);
+    GF_ATOMIC_INIT(priv->striped_reads, 0);
+    GF_ATOMIC_INIT(priv->striped_read_fallbacks, 0);
+    GF_ATOMIC_INIT(priv->hedged_reads, 0);
+    GF_ATOMIC_INIT(priv->hedged_reads_won, 0);
+
+    priv->xattrop_batch = GF_CALLOC(priv->child_count,
+                                    sizeof(*priv->xattrop_batch),
+                                    gf_afr_mt_xattrop_batch_t);
+    if (!priv->xattrop_batch) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    for (i = 0; i < priv->child_count; i++)
+        INIT_LIST_HEAD(&priv->xattrop_batch[i].queue);
+    GF_ATOMIC_INIT(priv->xattrop_batches, 0);
+    GF_ATOMIC_INIT(priv->xattrop_batched, 0);
+    GF_ATOMIC_INIT(priv->xattrop_batch_stale, 0);
+
     priv->children = GF_CALLOC(sizeof(xlator_t *), child_count,
                                gf_afr_mt_xlator_t);
     if (!priv->children) {
@@ -787,6 +823,7 @@ struct xlator_fops fops = {
     .fallocate = afr_fallocate,
     .discard = afr_discard,
     .zerofill = afr_zerofill,
+    .copy_file_range = afr_copy_file_range,
     .xattrop = afr_xattrop,
     .fxattrop = afr_fxattrop,
     .fsync = afr_fsync,
@@ -1333,6 +1370,41 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE,
      .tags = {"replicate"},
      .description = "Setting this option heals directory renames efficiently"},
+    {.key = {"read-stripe-size"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .max = 64 * GF_UNIT_MB,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Reads of at least twice this size are split in pieces "
+                    "that are multiples of it and read in parallel from all "
+                    "the bricks that have a good copy of the file. Reads are "
+                    "only split when no brick needs heal for the file. 0 "
+                    "disables it."},
+    {.key = {"hedge-reads"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "If a read takes longer than 95% of the recent reads "
+                    "of the same brick, send it also to another brick that "
+                    "has a good copy of the file and use the first answer. "
+                    "This reduces the tail latency caused by a slow brick "
+                    "at the cost of some extra reads."},
+    {.key = {"changelog-batch"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Send the pre-op and post-op xattrops of writes on "
+                    "different files to a brick together. While one batch "
+                    "is in flight, the xattrops of other transactions wait "
+                    "for it and are sent in the next one. Bricks that don't "
+                    "support it get the xattrops one by one."},
 
     {.key = {NULL}},
 };
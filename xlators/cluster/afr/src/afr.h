@@ -19,6 +19,7 @@
 
 #include "afr-self-heald.h"
 #include "afr-messages.h"
+#include "libxlator.h"
 
 #define SHD_INODE_LRU_LIMIT 1
 #define AFR_PATHINFO_HEADER "REPLICATE:"
@@ -165,6 +166,14 @@ typedef struct _afr_lk_heal_info {
     int32_t *child_down_event_gen;
 } afr_lk_heal_info_t;
 
+/* Changelog xattrops of a child waiting to be sent in a batch. Protected by
+ * priv->lock. */
+typedef struct _afr_xattrop_batch {
+    struct list_head queue;
+    gf_boolean_t busy;        /* a batch is being sent */
+    gf_boolean_t unsupported; /* the brick doesn't understand batches */
+} afr_xattrop_batch_t;
+
 typedef struct _afr_private {
     gf_lock_t lock;             /* to guard access to child_count, etc */
     unsigned int child_count;   /* total number of children   */
@@ -272,6 +281,27 @@ typedef struct _afr_private {
     gf_boolean_t data_self_heal; /* on/off */
     gf_boolean_t use_anon_inode;
 
+    /* Reads of at least twice this size are split among the readable
+     * children. 0 disables it. */
+    uint64_t read_stripe_size;
+    gf_atomic_t striped_reads;
+    gf_atomic_t striped_read_fallbacks;
+
+    /* Send a read to a second child when the first one is late compared to
+     * its recent reads (see cluster_read_latency_t). */
+    gf_boolean_t hedge_reads;
+    cluster_read_latency_t *read_latency;
+    gf_atomic_t hedged_reads;
+    gf_atomic_t hedged_reads_won;
+
+    /* Send the changelog xattrops of data and metadata transactions in
+     * batches, with at most one batch in flight per child. */
+    gf_boolean_t changelog_batch;
+    afr_xattrop_batch_t *xattrop_batch;
+    gf_atomic_t xattrop_batches;
+    gf_atomic_t xattrop_batched;
+    gf_atomic_t xattrop_batch_stale; /* resent on their own after ESTALE */
+
     /*For lock healing.*/
     struct list_head saved_locks;
     struct list_head lk_healq;
@@ -371,10 +401,22 @@ struct afr_reply {
     uint8_t checksum[SHA256_DIGEST_LENGTH];
     gf_boolean_t buf_has_zeroes;
     gf_boolean_t fips_mode_rchecksum;
+    gf_boolean_t xxh64x2_rchecksum;
     /* For lookup */
     int8_t need_heal;
 };
 
+/* Part of a striped readv that is sent to a single child. The answer of the
+ * child is stored in local->replies[child]. */
+struct afr_read_stripe {
+    struct iovec *vector;
+    struct iobref *iobref;
+    off_t offset;
+    size_t size;
+    int32_t count;
+    int child;
+};
+
 typedef enum {
     AFR_FD_NOT_OPENED,
     AFR_FD_OPENED,
@@ -633,6 +675,8 @@ typedef struct _afr_local {
             off_t offset;
             int last_index;
             uint32_t flags;
+            struct afr_read_stripe *stripes;
+            int stripe_count;
         } readv;
 
         /* dir read */
@@ -758,6 +802,20 @@ typedef struct _afr_local {
             struct iatt postbuf;
         } zerofill;
 
+        struct {
+            fd_t *fd_in;
+            off64_t off_in;
+            off64_t off_out;
+            size_t len;
+            uint32_t flags;
+            struct iatt stbuf;
+            /* read lock on the source range, held during the transaction */
+            loc_t loc_in;
+            gf_lkowner_t lk_owner;
+            unsigned char *locked_on;
+            int32_t lock_errno;
+        } copy_file_range;
+
         struct {
             char *volume;
             int32_t cmd;
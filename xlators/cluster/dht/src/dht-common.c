@@ -31,6 +31,9 @@ dht_rmdir_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 static int
 dht_link2(xlator_t *this, xlator_t *subvol, call_frame_t *frame, int ret);
 
+static gf_boolean_t
+dht_readdirp_fan_out(call_frame_t *frame, xlator_t *subvol, off_t offset);
+
 static int
 dht_set_dir_xattr_req(xlator_t *this, loc_t *loc, dict_t *xattr_req);
 
@@ -6700,6 +6703,13 @@ dht_queue_readdirp(call_frame_t *frame, xlator_t *xl, off_t offset,
     /* Check dht_queue_readdir() comments for an explanation of this. */
     if (uatomic_add_return(&local->queue, 1) == 1) {
         do {
+            /* In readdir-fan-out mode the answer may have already been
+             * requested, or even received, in advance. */
+            if ((local->readdir_ctx != NULL) &&
+                dht_readdirp_fan_out(frame, local->queue_xl,
+                                     local->queue_offset)) {
+                continue;
+            }
             STACK_WIND_COOKIE(frame, cbk, local->queue_xl, local->queue_xl,
                               local->queue_xl->fops->readdirp, local->fd,
                               local->size, local->queue_offset, local->xattr);
@@ -7017,6 +7027,352 @@ unwind:
     return 0;
 }
 
+/* readdir-fan-out mode
+ *
+ * Entries are still returned subvolume after subvolume, so the offsets seen
+ * by the application are the same as in the sequential mode. The difference
+ * is that the readdirp requests to the subvolumes are sent in advance: once
+ * a directory starts being read, the first batch of all the following
+ * subvolumes is requested, and each time a batch is consumed the next one of
+ * the same subvolume is requested. Each subvolume has a single slot, so at
+ * most one batch per subvolume is kept in memory for each open directory.
+ *
+ * If a request doesn't match the batch stored in the slot (because of a
+ * seekdir, or because the last entries of the previous batch were filtered
+ * out), it's sent to the subvolume as usual. */
+
+static void
+dht_readdirp_fan_out_done(xlator_t *this, fd_t *fd, int idx, int op_ret,
+                          int op_errno, gf_dirent_t *entries);
+
+static int
+dht_readdirp_fan_out_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                         int op_ret, int op_errno, gf_dirent_t *entries,
+                         dict_t *xdata)
+{
+    fd_t *fd = frame->local;
+
+    frame->local = NULL;
+
+    dht_readdirp_fan_out_done(this, fd, (int)(uintptr_t)cookie, op_ret,
+                              op_errno, entries);
+
+    fd_unref(fd);
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+/* Sends the readdirp request for the slot 'idx', which must have already
+ * been marked as pending. */
+static void
+dht_readdirp_fan_out_wind(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          dht_readdir_ctx_t *ctx, int idx, off_t offset)
+{
+    dht_conf_t *conf = this->private;
+    xlator_t *subvol = conf->subvolumes[idx];
+    call_frame_t *fetch_frame = NULL;
+    dict_t *xattr = NULL, *copy;
+    size_t size;
+
+    fetch_frame = copy_frame(frame);
+    if (fetch_frame == NULL) {
+        dht_readdirp_fan_out_done(this, fd, idx, -1, ENOMEM, NULL);
+        return;
+    }
+
+    LOCK(&ctx->lock);
+    {
+        size = ctx->size;
+        if (ctx->xattr != NULL) {
+            xattr = dict_ref(ctx->xattr);
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (conf->readdir_optimize && (xattr != NULL) &&
+        (subvol != dht_first_up_subvol(this))) {
+        copy = dict_copy_with_ref(xattr, NULL);
+        dict_unref(xattr);
+        xattr = copy;
+        if ((xattr != NULL) &&
+            (dict_set_int32(xattr, GF_READDIR_SKIP_DIRS, 1) != 0)) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_DICT_SET_FAILED,
+                   "Failed to set dictionary value: key = %s",
+                   GF_READDIR_SKIP_DIRS);
+        }
+    }
+
+    fetch_frame->local = fd_ref(fd);
+
+    STACK_WIND_COOKIE(fetch_frame, dht_readdirp_fan_out_cbk,
+                      (void *)(uintptr_t)idx, subvol, subvol->fops->readdirp,
+                      fd, size, offset, xattr);
+
+    if (xattr != NULL) {
+        dict_unref(xattr);
+    }
+}
+
+/* Requests the first batch of the subvolumes after 'idx' that haven't been
+ * read yet. */
+static void
+dht_readdirp_fan_out_start(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                           dht_readdir_ctx_t *ctx, int idx)
+{
+    dht_conf_t *conf = this->private;
+    dht_readdir_slot_t *slot;
+    gf_boolean_t start;
+
+    for (idx++; idx < ctx->count; idx++) {
+        if (!conf->subvolume_status[idx]) {
+            continue;
+        }
+
+        slot = &ctx->slots[idx];
+        start = _gf_false;
+
+        LOCK(&ctx->lock);
+        {
+            if (!slot->started && (slot->state == DHT_READDIR_SLOT_IDLE)) {
+                slot->started = _gf_true;
+                slot->state = DHT_READDIR_SLOT_PENDING;
+                slot->offset = 0;
+                slot->size = ctx->size;
+                start = _gf_true;
+            }
+        }
+        UNLOCK(&ctx->lock);
+
+        if (start) {
+            GF_ATOMIC_INC(conf->readdir_fan_out_sent);
+            dht_readdirp_fan_out_wind(frame, this, fd, ctx, idx, 0);
+        }
+    }
+}
+
+/* Passes the answer of the subvolume 'idx' to the readdirp that was waiting
+ * for it, after requesting the next batch of the same subvolume. */
+static void
+dht_readdirp_fan_out_deliver(call_frame_t *frame, xlator_t *this,
+                             dht_readdir_ctx_t *ctx, int idx, int op_ret,
+                             int op_errno, gf_dirent_t *entries)
+{
+    dht_conf_t *conf = this->private;
+    dht_local_t *local = frame->local;
+    dht_readdir_slot_t *slot = &ctx->slots[idx];
+    gf_dirent_t *last;
+    gf_boolean_t fetch = _gf_false;
+    off_t offset = 0;
+
+    if ((op_ret > 0) && (op_errno != ENOENT)) {
+        last = list_last_entry(&entries->list, gf_dirent_t, list);
+        offset = last->d_off;
+
+        LOCK(&ctx->lock);
+        {
+            if (slot->state == DHT_READDIR_SLOT_IDLE) {
+                slot->state = DHT_READDIR_SLOT_PENDING;
+                slot->offset = offset;
+                slot->size = ctx->size;
+                fetch = _gf_true;
+            }
+        }
+        UNLOCK(&ctx->lock);
+
+        if (fetch) {
+            GF_ATOMIC_INC(conf->readdir_fan_out_sent);
+            dht_readdirp_fan_out_wind(frame, this, local->fd, ctx, idx,
+                                      offset);
+        }
+    }
+
+    dht_readdirp_cbk(frame, conf->subvolumes[idx], this, op_ret, op_errno,
+                     entries, NULL);
+}
+
+static void
+dht_readdirp_fan_out_done(xlator_t *this, fd_t *fd, int idx, int op_ret,
+                          int op_errno, gf_dirent_t *entries)
+{
+    dht_fd_ctx_t *fd_ctx;
+    dht_readdir_ctx_t *ctx;
+    dht_readdir_slot_t *slot;
+    call_frame_t *waiter;
+    gf_dirent_t answer;
+
+    INIT_LIST_HEAD(&answer.list);
+
+    fd_ctx = dht_fd_ctx_readdir_get(this, fd);
+    if (fd_ctx == NULL) {
+        return;
+    }
+    ctx = fd_ctx->readdir;
+    slot = &ctx->slots[idx];
+
+    LOCK(&ctx->lock);
+    {
+        if (entries != NULL) {
+            list_splice_init(&entries->list, &answer.list);
+        }
+        waiter = slot->waiter;
+        slot->waiter = NULL;
+        if (waiter != NULL) {
+            slot->state = DHT_READDIR_SLOT_IDLE;
+        } else {
+            list_splice_init(&answer.list, &slot->entries.list);
+            slot->op_ret = op_ret;
+            slot->op_errno = op_errno;
+            slot->state = DHT_READDIR_SLOT_READY;
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (waiter != NULL) {
+        dht_readdirp_fan_out_deliver(waiter, this, ctx, idx, op_ret, op_errno,
+                                     &answer);
+        gf_dirent_free(&answer);
+    }
+
+    GF_REF_PUT(fd_ctx);
+}
+
+/* Serves a readdirp from the slot of the subvolume. Returns _gf_false if the
+ * request needs to be sent as usual. */
+static gf_boolean_t
+dht_readdirp_fan_out(call_frame_t *frame, xlator_t *subvol, off_t offset)
+{
+    xlator_t *this = frame->this;
+    dht_conf_t *conf = this->private;
+    dht_local_t *local = frame->local;
+    dht_readdir_ctx_t *ctx = local->readdir_ctx;
+    dht_readdir_slot_t *slot;
+    gf_dirent_t entries;
+    gf_boolean_t match;
+    int op_ret = 0;
+    int op_errno = 0;
+    int idx;
+    enum { WIND, WAIT, DELIVER, FETCH } action = WIND;
+
+    idx = dht_subvol_cnt(this, subvol);
+    if ((idx < 0) || (idx >= ctx->count)) {
+        return _gf_false;
+    }
+    slot = &ctx->slots[idx];
+
+    INIT_LIST_HEAD(&entries.list);
+
+    LOCK(&ctx->lock);
+    {
+        match = (slot->offset == offset) && (slot->size == local->size);
+        if (slot->state == DHT_READDIR_SLOT_PENDING) {
+            if (match && (slot->waiter == NULL)) {
+                slot->waiter = frame;
+                action = WAIT;
+            }
+        } else if (match && (slot->state == DHT_READDIR_SLOT_READY)) {
+            list_splice_init(&slot->entries.list, &entries.list);
+            op_ret = slot->op_ret;
+            op_errno = slot->op_errno;
+            slot->state = DHT_READDIR_SLOT_IDLE;
+            action = DELIVER;
+        } else {
+            /* A batch that doesn't match is useless. Discard it. */
+            list_splice_init(&slot->entries.list, &entries.list);
+            slot->state = DHT_READDIR_SLOT_PENDING;
+            slot->waiter = frame;
+            slot->offset = offset;
+            slot->size = local->size;
+            slot->started = _gf_true;
+            action = FETCH;
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    switch (action) {
+        case WIND:
+            return _gf_false;
+        case WAIT:
+            GF_ATOMIC_INC(conf->readdir_fan_out_hits);
+            break;
+        case DELIVER:
+            GF_ATOMIC_INC(conf->readdir_fan_out_hits);
+            dht_readdirp_fan_out_deliver(frame, this, ctx, idx, op_ret,
+                                         op_errno, &entries);
+            break;
+        case FETCH:
+            GF_ATOMIC_INC(conf->readdir_fan_out_misses);
+            gf_dirent_free(&entries);
+            INIT_LIST_HEAD(&entries.list);
+            dht_readdirp_fan_out_wind(frame, this, local->fd, ctx, idx,
+                                      offset);
+            dht_readdirp_fan_out_start(frame, this, local->fd, ctx, idx);
+            break;
+    }
+
+    gf_dirent_free(&entries);
+
+    return _gf_true;
+}
+
+/* Prepares the readdir-fan-out state of the directory for a new readdirp. */
+static void
+dht_readdirp_fan_out_init(xlator_t *this, dht_local_t *local, off_t offset)
+{
+    dht_fd_ctx_t *fd_ctx;
+    dht_readdir_ctx_t *ctx;
+    dict_t *xattr, *old;
+    gf_dirent_t discard;
+    int i;
+
+    fd_ctx = dht_fd_ctx_readdir_get(this, local->fd);
+    if (fd_ctx == NULL) {
+        return;
+    }
+    ctx = fd_ctx->readdir;
+
+    /* dht_readdirp_cbk() modifies local->xattr, so keep a private copy. */
+    xattr = dict_copy_with_ref(local->xattr, NULL);
+    if (xattr == NULL) {
+        GF_REF_PUT(fd_ctx);
+        return;
+    }
+    dict_del(xattr, GF_READDIR_SKIP_DIRS);
+
+    INIT_LIST_HEAD(&discard.list);
+
+    LOCK(&ctx->lock);
+    {
+        old = ctx->xattr;
+        ctx->xattr = xattr;
+        ctx->size = local->size;
+
+        /* The directory is being read again from the beginning. Anything
+         * that was read before is stale. */
+        if (offset == 0) {
+            for (i = 0; i < ctx->count; i++) {
+                ctx->slots[i].started = _gf_false;
+                if (ctx->slots[i].state == DHT_READDIR_SLOT_READY) {
+                    list_splice_init(&ctx->slots[i].entries.list,
+                                     &discard.list);
+                    ctx->slots[i].state = DHT_READDIR_SLOT_IDLE;
+                }
+            }
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (old != NULL) {
+        dict_unref(old);
+    }
+    gf_dirent_free(&discard);
+
+    /* The context lives as long as the fd, which is referenced by local. */
+    local->readdir_ctx = ctx;
+
+    GF_REF_PUT(fd_ctx);
+}
+
 static int
 dht_readdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                 int op_errno, gf_dirent_t *orig_entries, dict_t *xdata)
@@ -7237,6 +7593,8 @@ dht_do_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                            "value:key = %s ",
                            conf->xattr_name);
                 }
+            } else if (conf->readdir_fan_out) {
+                dht_readdirp_fan_out_init(this, local, yoff);
             }
         }
 
@@ -11377,6 +11735,12 @@ dht_release(xlator_t *this, fd_t *fd)
     return dht_fd_ctx_destroy(this, fd);
 }
 
+int32_t
+dht_releasedir(xlator_t *this, fd_t *fd)
+{
+    return dht_fd_ctx_destroy(this, fd);
+}
+
 static int
 dht_pt_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                  int op_errno, inode_t *inode, struct iatt *stbuf,
@@ -339,6 +339,9 @@ struct dht_local {
     off_t queue_offset;
     int32_t queue;
 
+    /* readdir-fan-out state of the directory, owned by the fd */
+    struct dht_readdir_ctx *readdir_ctx;
+
     /* inodelks during filerename for backward compatibility */
     dht_lock_t **rename_inodelk_backward_compatible;
 
@@ -444,6 +447,7 @@ struct dht_container {
     loc_t *parent_loc;
     dict_t *migrate_data;
     int local_subvol_index;
+    struct gf_defrag_dir *dir;
 };
 
 typedef struct nodeuuid_info {
@@ -505,6 +509,21 @@ struct gf_defrag_info_ {
     gf_boolean_t stats;
     /* lock migration flag */
     gf_boolean_t lock_migration_enabled;
+
+    /* data written by file migrations, including the ones in progress */
+    gf_atomic_t bytes_copied;
+
+    /* Resuming an interrupted rebalance: identifier of the run (0 if not
+     * resumable) and keys of the markers stored on the bricks of this node */
+    gf_boolean_t resume;
+    uint64_t resume_run;
+    uint64_t resume_skipped; /* directories skipped by this run */
+    char *resume_run_key;
+    char *resume_done_key;
+    /* markers of the completed subdirectories of the root */
+    struct list_head resume_done;
+    /* an earlier run left markers and this one doesn't resume it */
+    gf_boolean_t resume_stale;
 };
 
 typedef struct gf_defrag_info_ gf_defrag_info_t;
@@ -607,6 +626,15 @@ struct dht_conf {
     /* Request to filter directory entries in readdir request */
     gf_boolean_t readdir_optimize;
 
+    /* Read directories from all subvolumes at the same time */
+    gf_boolean_t readdir_fan_out;
+    gf_atomic_t readdir_fan_out_sent;   /* batches requested in advance */
+    gf_atomic_t readdir_fan_out_hits;   /* readdirps served by them */
+    gf_atomic_t readdir_fan_out_misses; /* readdirps that didn't match */
+
+    /* Number of threads copying the data of a big file during rebalance */
+    uint32_t migration_streams;
+
     gf_boolean_t rsync_regex_valid;
 
     gf_boolean_t extra_regex_valid;
@@ -657,6 +685,7 @@ struct dir_dfmeta {
     int *fetch_entries;
     /* fds corresponding to local subvols only */
     fd_t **lfd;
+    struct gf_defrag_dir *dir;
 };
 
 typedef struct dht_migrate_info {
@@ -665,8 +694,36 @@ typedef struct dht_migrate_info {
     GF_REF_DECL;
 } dht_migrate_info_t;
 
+enum dht_readdir_slot_state {
+    DHT_READDIR_SLOT_IDLE = 0,
+    DHT_READDIR_SLOT_PENDING, /* readdirp sent to the subvolume */
+    DHT_READDIR_SLOT_READY,   /* answer received and not consumed yet */
+};
+
+/* Answer of a subvolume to the readdirp sent ahead of time by readdir-fan-out
+ * mode. There's at most one of them per subvolume. */
+typedef struct dht_readdir_slot {
+    gf_dirent_t entries;
+    call_frame_t *waiter; /* readdirp waiting for the answer */
+    off_t offset;
+    size_t size;
+    int op_ret;
+    int op_errno;
+    enum dht_readdir_slot_state state;
+    gf_boolean_t started; /* the subvolume has been read since offset 0 */
+} dht_readdir_slot_t;
+
+typedef struct dht_readdir_ctx {
+    gf_lock_t lock;
+    size_t size;
+    dict_t *xattr;
+    int count;
+    dht_readdir_slot_t slots[];
+} dht_readdir_ctx_t;
+
 typedef struct dht_fd_ctx {
     uint64_t opened_on_dst;
+    dht_readdir_ctx_t *readdir; /* only for directories */
     GF_REF_DECL;
 } dht_fd_ctx_t;
 
@@ -1081,6 +1138,10 @@ int32_t
 dht_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
              off_t len, dict_t *xdata);
 int32_t
+dht_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata);
+int32_t
 dht_ipc(call_frame_t *frame, xlator_t *this, int32_t op, dict_t *xdata);
 
 int
@@ -1231,9 +1292,15 @@ dht_fd_open_on_dst(xlator_t *this, fd_t *fd, xlator_t *dst);
 int32_t
 dht_fd_ctx_destroy(xlator_t *this, fd_t *fd);
 
+dht_fd_ctx_t *
+dht_fd_ctx_readdir_get(xlator_t *this, fd_t *fd);
+
 int32_t
 dht_release(xlator_t *this, fd_t *fd);
 
+int32_t
+dht_releasedir(xlator_t *this, fd_t *fd);
+
 int32_t
 dht_set_fixed_dir_stat(struct iatt *stat);
 
@@ -12,9 +12,28 @@
 #include "dht-lock.h"
 #include "glusterfs/compat-errno.h"  // for ENODATA on BSD
 
+static void
+dht_free_readdir_ctx(dht_readdir_ctx_t *ctx)
+{
+    int i;
+
+    for (i = 0; i < ctx->count; i++) {
+        gf_dirent_free(&ctx->slots[i].entries);
+    }
+    if (ctx->xattr != NULL) {
+        dict_unref(ctx->xattr);
+    }
+    LOCK_DESTROY(&ctx->lock);
+
+    GF_FREE(ctx);
+}
+
 static void
 dht_free_fd_ctx(dht_fd_ctx_t *fd_ctx)
 {
+    if (fd_ctx->readdir != NULL) {
+        dht_free_readdir_ctx(fd_ctx->readdir);
+    }
     GF_FREE(fd_ctx);
 }
 
@@ -137,6 +156,52 @@ out:
     return fd_ctx;
 }
 
+/* Returns the context of a directory fd with the state of the readdir-fan-out
+ * mode, creating it if needed. The caller must release the reference. */
+dht_fd_ctx_t *
+dht_fd_ctx_readdir_get(xlator_t *this, fd_t *fd)
+{
+    dht_conf_t *conf = this->private;
+    dht_fd_ctx_t *fd_ctx = NULL;
+    dht_readdir_ctx_t *ctx = NULL;
+    uint64_t value = 0;
+    int i;
+
+    LOCK(&fd->lock);
+    {
+        if ((__fd_ctx_get(fd, this, &value) < 0) || (value == 0)) {
+            if (__dht_fd_ctx_set(this, fd, NULL) < 0) {
+                goto unlock;
+            }
+            __fd_ctx_get(fd, this, &value);
+        }
+        fd_ctx = (dht_fd_ctx_t *)(uintptr_t)value;
+
+        if (fd_ctx->readdir == NULL) {
+            ctx = GF_CALLOC(1,
+                            sizeof(*ctx) + conf->subvolume_cnt *
+                                               sizeof(dht_readdir_slot_t),
+                            gf_dht_mt_readdir_ctx_t);
+            if (ctx == NULL) {
+                fd_ctx = NULL;
+                goto unlock;
+            }
+            LOCK_INIT(&ctx->lock);
+            ctx->count = conf->subvolume_cnt;
+            for (i = 0; i < ctx->count; i++) {
+                INIT_LIST_HEAD(&ctx->slots[i].entries.list);
+            }
+            fd_ctx->readdir = ctx;
+        }
+
+        GF_REF_GET(fd_ctx);
+    }
+unlock:
+    UNLOCK(&fd->lock);
+
+    return fd_ctx;
+}
+
 gf_boolean_t
 dht_fd_open_on_dst(xlator_t *this, fd_t *fd, xlator_t *dst)
 {
@@ -10,6 +10,8 @@
 
 #include "dht-common.h"
 #include <glusterfs/syscall.h>
+#include <glusterfs/syncop-utils.h>
+#include <glusterfs/hashfn.h>
 #include <fnmatch.h>
 #include <signal.h>
 #include <glusterfs/events.h>
@@ -18,6 +20,8 @@
 #define GF_DISK_SECTOR_SIZE 512
 #define DHT_REBALANCE_PID 4242        /* Change it if required */
 #define DHT_REBALANCE_BLKSIZE 1048576 /* 1 MB */
+#define DHT_REBALANCE_STREAM_MIN (64 * DHT_REBALANCE_BLKSIZE)
+#define DHT_REBALANCE_STREAM_DEPTH 4 /* blocks in flight per stream */
 #define MAX_MIGRATE_QUEUE_COUNT 500
 #define MIN_MIGRATE_QUEUE_COUNT 200
 #define MAX_REBAL_TYPE_SIZE 16
@@ -42,6 +46,372 @@ dht_migrate_file(xlator_t *this, loc_t *loc, xlator_t *cached_subvol,
 uint64_t g_totalfiles = 0;
 uint64_t g_totalsize = 0;
 
+/* Resuming an interrupted rebalance
+ *
+ * When the migration of the files of a directory and all its subdirectories
+ * completes without errors, a marker with the identifier of the run is
+ * stored on the directory in the local subvolumes. The identifier itself is
+ * stored on the root directory while the rebalance is in progress. If the
+ * rebalance is stopped or the node is restarted, the next run finds it and
+ * skips the directories already marked with it. Once a run completes
+ * without failures, the markers of all the directories and the identifier
+ * are removed, so the next one crawls everything.
+ *
+ * Markers are per node, since each node only migrates its share of the files
+ * of the local subvolumes. The identifier includes a signature of the
+ * command and of the set of subvolumes, so that a rebalance started after
+ * adding or removing bricks doesn't reuse the progress of a previous one. */
+
+#define GF_DEFRAG_RUN_LEN 16
+
+/* Progress of a directory. It's referenced by the crawler while the
+ * directory is being processed, by the files queued for migration and by
+ * its subdirectories.
+ *
+ * Once a directory is marked as processed, the markers of its
+ * subdirectories are not needed anymore, because a resumed run skips the
+ * whole subtree. So each directory keeps the list of its marked
+ * subdirectories, and removes their markers when it's marked itself. The
+ * list of the root is removed at the end of the rebalance. This way no
+ * additional crawl is needed to remove the markers. */
+typedef struct gf_defrag_dir {
+    struct gf_defrag_dir *parent;
+    struct list_head list; /* in the 'done' list of the parent */
+    struct list_head done; /* marked subdirectories, under defrag->lock */
+    loc_t loc;
+    gf_atomic_t ref;
+    uint64_t failures; /* defrag->total_failures when created */
+    gf_boolean_t failed;
+} gf_defrag_dir_t;
+
+static uint32_t
+gf_defrag_resume_signature(dht_conf_t *conf, gf_defrag_info_t *defrag)
+{
+    uint32_t sig = defrag->cmd;
+    char *name;
+    int i;
+
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        name = conf->subvolumes[i]->name;
+        sig = sig * 31 + gf_dm_hashfn(name, strlen(name));
+        if (conf->decommissioned_bricks &&
+            conf->decommissioned_bricks[i]) {
+            sig++;
+        }
+    }
+
+    return sig;
+}
+
+/* Sets the marker 'key' on the directory in all local subvolumes. */
+static int
+gf_defrag_resume_set(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                     char *key)
+{
+    dht_conf_t *conf = this->private;
+    char value[GF_DEFRAG_RUN_LEN + 1];
+    dict_t *xattr;
+    int ret = 0;
+    int i;
+
+    xattr = dict_new();
+    if (xattr == NULL) {
+        return -ENOMEM;
+    }
+
+    snprintf(value, sizeof(value), "%016" PRIx64, defrag->resume_run);
+    ret = dict_set_str(xattr, key, value);
+    for (i = 0; (ret == 0) && (i < conf->local_subvols_cnt); i++) {
+        ret = syncop_setxattr(conf->local_subvols[i], loc, xattr, 0, NULL,
+                              NULL);
+    }
+
+    dict_unref(xattr);
+
+    return ret;
+}
+
+/* Reads the marker 'key' of the directory. Returns 0 if it's not present. */
+static uint64_t
+gf_defrag_resume_get(xlator_t *this, loc_t *loc, char *key)
+{
+    dht_conf_t *conf = this->private;
+    char value[GF_DEFRAG_RUN_LEN + 1];
+    dict_t *xattr = NULL;
+    data_t *data;
+    uint64_t run = 0;
+
+    if (syncop_getxattr(conf->local_subvols[0], loc, &xattr, key, NULL,
+                        NULL) < 0) {
+        return 0;
+    }
+
+    data = dict_get(xattr, key);
+    if ((data != NULL) && (data->len >= GF_DEFRAG_RUN_LEN)) {
+        memcpy(value, data->data, GF_DEFRAG_RUN_LEN);
+        value[GF_DEFRAG_RUN_LEN] = 0;
+        run = strtoull(value, NULL, 16);
+    }
+
+    dict_unref(xattr);
+
+    return run;
+}
+
+/* Finds the run to resume, or starts a new one. Resuming is disabled while
+ * defrag->resume_run is 0. */
+static void
+gf_defrag_resume_init(xlator_t *this, gf_defrag_info_t *defrag, loc_t *root)
+{
+    dht_conf_t *conf = this->private;
+    uint32_t sig;
+    uint64_t run;
+
+    if (conf->local_subvols_cnt == 0) {
+        return;
+    }
+
+    INIT_LIST_HEAD(&defrag->resume_done);
+
+    /* The keys are needed even if resuming is disabled, to remove the
+     * markers left by an earlier run. */
+    if ((gf_asprintf(&defrag->resume_run_key, "%s.rebalance-run.%s",
+                     conf->xattr_name, uuid_utoa(defrag->node_uuid)) < 0) ||
+        (gf_asprintf(&defrag->resume_done_key, "%s.rebalance-done.%s",
+                     conf->xattr_name, uuid_utoa(defrag->node_uuid)) < 0)) {
+        GF_FREE(defrag->resume_run_key);
+        defrag->resume_run_key = NULL;
+        return;
+    }
+
+    run = gf_defrag_resume_get(this, root, defrag->resume_run_key);
+
+    /* The markers are removed from each directory as the crawl goes
+     * through it. */
+    if (!defrag->resume) {
+        defrag->resume_stale = (run != 0);
+        return;
+    }
+
+    sig = gf_defrag_resume_signature(conf, defrag);
+
+    if ((run >> 32) == sig) {
+        gf_log(this->name, GF_LOG_INFO,
+               "Resuming rebalance %016" PRIx64
+               ". Directories already processed will be skipped",
+               run);
+        defrag->resume_run = run;
+        return;
+    }
+
+    defrag->resume_run = ((uint64_t)sig << 32) |
+                         (uint32_t)(gf_time() ^ random());
+    if (gf_defrag_resume_set(this, defrag, root, defrag->resume_run_key) !=
+        0) {
+        gf_log(this->name, GF_LOG_WARNING,
+               "Failed to store the rebalance identifier. The rebalance "
+               "won't be resumable");
+        defrag->resume_run = 0;
+    }
+}
+
+/* Removes the marker of a directory. */
+static void
+gf_defrag_resume_clear(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc)
+{
+    dht_conf_t *conf = this->private;
+    int i;
+
+    for (i = 0; i < conf->local_subvols_cnt; i++) {
+        syncop_removexattr(conf->local_subvols[i], loc,
+                           defrag->resume_done_key, NULL, NULL);
+    }
+}
+
+/* Releases the list of marked subdirectories, removing their markers if
+ * 'clear' is set. */
+static void
+gf_defrag_resume_clear_list(xlator_t *this, gf_defrag_info_t *defrag,
+                            struct list_head *done, gf_boolean_t clear)
+{
+    gf_defrag_dir_t *dir;
+    gf_defrag_dir_t *tmp;
+
+    list_for_each_entry_safe(dir, tmp, done, list)
+    {
+        list_del_init(&dir->list);
+        if (clear) {
+            gf_defrag_resume_clear(this, defrag, &dir->loc);
+        }
+        loc_wipe(&dir->loc);
+        GF_FREE(dir);
+    }
+}
+
+/* Called at the end of the crawl, after all migrations have finished. */
+static void
+gf_defrag_resume_fini(xlator_t *this, gf_defrag_info_t *defrag, loc_t *root)
+{
+    dht_conf_t *conf = this->private;
+    int i;
+
+    if (defrag->resume_run_key == NULL) {
+        return;
+    }
+
+    if (defrag->resume_skipped != 0) {
+        gf_log(this->name, GF_LOG_INFO,
+               "%" PRIu64 " directories already processed by an interrupted "
+               "run were skipped",
+               defrag->resume_skipped);
+    }
+
+    /* With resuming disabled, the markers left by an earlier run have
+     * been removed during the crawl. */
+    if ((defrag->defrag_status == GF_DEFRAG_STATUS_COMPLETE) &&
+        (defrag->total_failures == 0) &&
+        ((defrag->resume_run != 0) || defrag->resume_stale)) {
+        gf_defrag_resume_clear_list(this, defrag, &defrag->resume_done,
+                                    _gf_true);
+
+        /* Last, so that an interruption above doesn't lose the progress */
+        for (i = 0; i < conf->local_subvols_cnt; i++) {
+            syncop_removexattr(conf->local_subvols[i], root,
+                               defrag->resume_run_key, NULL, NULL);
+        }
+    } else {
+        gf_defrag_resume_clear_list(this, defrag, &defrag->resume_done,
+                                    _gf_false);
+    }
+
+    GF_FREE(defrag->resume_run_key);
+    GF_FREE(defrag->resume_done_key);
+    defrag->resume_run_key = NULL;
+    defrag->resume_done_key = NULL;
+}
+
+static gf_defrag_dir_t *
+gf_defrag_dir_new(gf_defrag_info_t *defrag, loc_t *loc,
+                  gf_defrag_dir_t *parent)
+{
+    gf_defrag_dir_t *dir;
+
+    if (defrag->resume_run == 0) {
+        return NULL;
+    }
+
+    dir = GF_CALLOC(1, sizeof(*dir), gf_dht_mt_defrag_dir_t);
+    if (dir == NULL) {
+        return NULL;
+    }
+    if (loc_copy(&dir->loc, loc) != 0) {
+        GF_FREE(dir);
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&dir->list);
+    INIT_LIST_HEAD(&dir->done);
+    GF_ATOMIC_INIT(dir->ref, 1);
+    dir->failures = defrag->total_failures;
+    dir->parent = parent;
+    if (parent != NULL) {
+        GF_ATOMIC_INC(parent->ref);
+    }
+
+    return dir;
+}
+
+static gf_defrag_dir_t *
+gf_defrag_dir_ref(gf_defrag_dir_t *dir)
+{
+    if (dir != NULL) {
+        GF_ATOMIC_INC(dir->ref);
+    }
+
+    return dir;
+}
+
+/* Adds a marked directory to the list of its parent. */
+static void
+gf_defrag_dir_done(gf_defrag_info_t *defrag, gf_defrag_dir_t *parent,
+                   gf_defrag_dir_t *dir)
+{
+    LOCK(&defrag->lock);
+    {
+        list_add_tail(&dir->list, (parent != NULL) ? &parent->done
+                                                   : &defrag->resume_done);
+    }
+    UNLOCK(&defrag->lock);
+}
+
+/* Records a subdirectory skipped because an earlier run already marked it,
+ * so that its marker is removed like the ones set by this run. */
+static void
+gf_defrag_dir_skipped(gf_defrag_info_t *defrag, gf_defrag_dir_t *parent,
+                      loc_t *loc)
+{
+    gf_defrag_dir_t *dir;
+
+    dir = gf_defrag_dir_new(defrag, loc, NULL);
+    if (dir != NULL) {
+        gf_defrag_dir_done(defrag, parent, dir);
+    }
+}
+
+/* Releases a reference. When the last one is released, the directory is
+ * complete and it's marked as such unless something failed. Then the
+ * markers of its subdirectories are removed. The root is not marked:
+ * gf_defrag_resume_fini() takes care of it and of its subdirectories. */
+static void
+gf_defrag_dir_unref(xlator_t *this, gf_defrag_info_t *defrag,
+                    gf_defrag_dir_t *dir)
+{
+    gf_defrag_dir_t *parent;
+    gf_boolean_t done = _gf_false;
+
+    while ((dir != NULL) && (GF_ATOMIC_DEC(dir->ref) == 0)) {
+        parent = dir->parent;
+        done = _gf_false;
+
+        /* No other reference exists, so the list can be used without the
+         * lock. Markers of the subdirectories of a directory that failed
+         * are kept, so that a resumed run skips them. */
+        if (dir->failed ||
+            (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) ||
+            (defrag->total_failures != dir->failures)) {
+            if (parent != NULL) {
+                parent->failed = _gf_true;
+            }
+            gf_defrag_resume_clear_list(this, defrag, &dir->done, _gf_false);
+        } else if (parent == NULL) {
+            LOCK(&defrag->lock);
+            {
+                list_splice_init(&dir->done, &defrag->resume_done);
+            }
+            UNLOCK(&defrag->lock);
+        } else if (gf_defrag_resume_set(this, defrag, &dir->loc,
+                                        defrag->resume_done_key) != 0) {
+            gf_msg_debug(this->name, 0, "Failed to mark %s as processed",
+                         dir->loc.path);
+            parent->failed = _gf_true;
+            gf_defrag_resume_clear_list(this, defrag, &dir->done, _gf_false);
+        } else {
+            gf_defrag_resume_clear_list(this, defrag, &dir->done, _gf_true);
+            done = _gf_true;
+        }
+
+        if (done) {
+            dir->parent = NULL;
+            gf_defrag_dir_done(defrag, parent, dir);
+        } else {
+            loc_wipe(&dir->loc);
+            GF_FREE(dir);
+        }
+
+        dir = parent;
+    }
+}
+
 void
 gf_defrag_free_dir_dfmeta(struct dir_dfmeta *meta, int local_subvols_cnt)
 {
@@ -68,7 +438,15 @@ gf_defrag_free_dir_dfmeta(struct dir_dfmeta *meta, int local_subvols_cnt)
 void
 gf_defrag_free_container(struct dht_container *container)
 {
+    dht_conf_t *conf = NULL;
+
     if (container) {
+        if (container->dir) {
+            conf = container->this->private;
+            gf_defrag_dir_unref(container->this, conf->defrag,
+                                container->dir);
+        }
+
         gf_dirent_entry_free(container->df_entry);
 
         if (container->parent_loc) {
@@ -994,57 +1372,297 @@ out:
     return ret;
 }
 
-static int32_t
-dht_rebalance_sparse_segment(xlator_t *subvol, fd_t *fd, off_t *offset,
-                             size_t *size)
+/* Pipelined copy of a range, used by the rebalance process.
+ *
+ * Each stream keeps up to DHT_REBALANCE_STREAM_DEPTH blocks in flight. A
+ * block is read into its slot of the ring and written from the callback of
+ * the read, so the reads of the next blocks overlap the writes of the
+ * previous ones. The thread of the stream only plans the blocks (seeking the
+ * data segments of sparse files) and waits for a free slot. */
+
+struct dht_migrate_ring;
+
+struct dht_migrate_slot {
+    struct dht_migrate_ring *ring;
+    call_frame_t *frame;
+    struct iovec *vector;
+    struct iobref *iobref;
+    off_t offset; /* next byte to copy */
+    size_t size;  /* bytes left to copy */
+    int count;
+    gf_boolean_t busy;
+};
+
+struct dht_migrate_ring {
+    xlator_t *from;
+    xlator_t *to;
+    fd_t *src;
+    fd_t *dst;
+    dict_t *xdata;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int inflight;
+    int fop_errno; /* first error */
+    struct dht_migrate_slot slots[DHT_REBALANCE_STREAM_DEPTH];
+};
+
+static void
+dht_migrate_slot_done(struct dht_migrate_slot *slot, int op_errno)
 {
-    off_t hole;
-    int32_t ret;
-
-    do {
-        ret = syncop_seek(subvol, fd, *offset, GF_SEEK_DATA, NULL, offset);
-        if (ret >= 0) {
-            /* Starting at the offset of the last data segment, find the
-             * next hole. After a data segment there should always be a
-             * hole, since EOF is considered a hole. */
-            ret = syncop_seek(subvol, fd, *offset, GF_SEEK_HOLE, NULL, &hole);
+    struct dht_migrate_ring *ring = slot->ring;
+
+    GF_FREE(slot->vector);
+    slot->vector = NULL;
+    if (slot->iobref) {
+        iobref_unref(slot->iobref);
+        slot->iobref = NULL;
+    }
+    if (slot->frame) {
+        STACK_DESTROY(slot->frame->root);
+        slot->frame = NULL;
+    }
+
+    pthread_mutex_lock(&ring->mutex);
+    {
+        if (op_errno && !ring->fop_errno) {
+            ring->fop_errno = op_errno;
         }
+        slot->busy = _gf_false;
+        ring->inflight--;
+        pthread_cond_signal(&ring->cond);
+    }
+    pthread_mutex_unlock(&ring->mutex);
+}
 
-        if (ret < 0) {
-            if (ret == -ENXIO) {
-                /* This can happen if there are no more data segments (i.e.
-                 * the offset is at EOF), or there was a data segment but the
-                 * file has been truncated to a smaller size between both
-                 * seek requests. In both cases we are done. The file doesn't
-                 * contain more data. */
-                ret = 0;
+static void
+dht_migrate_slot_read(struct dht_migrate_slot *slot);
+
+static int
+dht_migrate_slot_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iatt *prebuf, struct iatt *postbuf,
+                            dict_t *xdata)
+{
+    struct dht_migrate_slot *slot = cookie;
+    dht_conf_t *conf = this->private;
+    gf_boolean_t failed = _gf_false;
+
+    GF_FREE(slot->vector);
+    slot->vector = NULL;
+    iobref_unref(slot->iobref);
+    slot->iobref = NULL;
+
+    if (op_ret <= 0) {
+        dht_migrate_slot_done(slot, op_ret ? op_errno : ENOSPC);
+        return 0;
+    }
+
+    GF_ATOMIC_ADD(conf->defrag->bytes_copied, op_ret);
+
+    slot->offset += op_ret;
+    slot->size -= op_ret;
+
+    pthread_mutex_lock(&slot->ring->mutex);
+    {
+        failed = (slot->ring->fop_errno != 0);
+    }
+    pthread_mutex_unlock(&slot->ring->mutex);
+
+    /* A short read or write leaves the end of the block to copy. */
+    if ((slot->size > 0) && !failed) {
+        dht_migrate_slot_read(slot);
+    } else {
+        dht_migrate_slot_done(slot, 0);
+    }
+
+    return 0;
+}
+
+static int
+dht_migrate_slot_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno,
+                           struct iovec *vector, int32_t count,
+                           struct iatt *stbuf, struct iobref *iobref,
+                           dict_t *xdata)
+{
+    struct dht_migrate_slot *slot = cookie;
+    struct dht_migrate_ring *ring = slot->ring;
+
+    if (op_ret <= 0) {
+        /* A read of 0 bytes means the file was probably truncated. */
+        dht_migrate_slot_done(slot, op_ret ? op_errno : ENOSPC);
+        return 0;
+    }
+
+    slot->vector = iov_dup(vector, count);
+    if (!slot->vector) {
+        dht_migrate_slot_done(slot, ENOMEM);
+        return 0;
+    }
+    slot->count = count;
+    slot->iobref = iobref_ref(iobref);
+
+    STACK_WIND_COOKIE(frame, dht_migrate_slot_writev_cbk, slot, ring->to,
+                      ring->to->fops->writev, ring->dst, slot->vector,
+                      slot->count, slot->offset, 0, slot->iobref,
+                      ring->xdata);
+
+    return 0;
+}
+
+static void
+dht_migrate_slot_read(struct dht_migrate_slot *slot)
+{
+    struct dht_migrate_ring *ring = slot->ring;
+
+    STACK_WIND_COOKIE(slot->frame, dht_migrate_slot_readv_cbk, slot,
+                      ring->from, ring->from->fops->readv, ring->src,
+                      slot->size, slot->offset, 0, NULL);
+}
+
+static int
+dht_rebalance_migrate_range_pipelined(xlator_t *this, xlator_t *from,
+                                      xlator_t *to, fd_t *src, fd_t *dst,
+                                      off_t start, off_t end, int hole_exists,
+                                      int *fop_errno)
+{
+    struct dht_migrate_ring ring = {
+        0,
+    };
+    struct dht_migrate_slot *slot = NULL;
+    dht_conf_t *conf = NULL;
+    off_t offset = start;
+    size_t read_size = 0;
+    size_t data_block_size = 0;
+    int ret = 0;
+    int i = 0;
+
+    conf = this->private;
+
+    ring.from = from;
+    ring.to = to;
+    ring.src = src;
+    ring.dst = dst;
+    pthread_mutex_init(&ring.mutex, NULL);
+    pthread_cond_init(&ring.cond, NULL);
+    for (i = 0; i < DHT_REBALANCE_STREAM_DEPTH; i++) {
+        ring.slots[i].ring = &ring;
+    }
+
+    /* See dht_rebalance_migrate_range() */
+    if (!conf->force_migration) {
+        ring.xdata = dict_new();
+        if (!ring.xdata ||
+            dict_set_int32_sizen(ring.xdata, GF_AVOID_OVERWRITE, 1)) {
+            gf_msg("dht", GF_LOG_ERROR, 0, DHT_MSG_MIGRATE_FILE_FAILED,
+                   "insufficient memory");
+            ring.fop_errno = ENOMEM;
+            goto out;
+        }
+    }
+
+    while (offset < end) {
+        if (!hole_exists) {
+            data_block_size = end - offset;
+        } else if (data_block_size <= 0) {
+            ret = syncop_seek_data_segment(from, src, &offset,
+                                           &data_block_size);
+            if (ret <= 0) {
+                pthread_mutex_lock(&ring.mutex);
+                {
+                    if (ret < 0 && !ring.fop_errno) {
+                        ring.fop_errno = -ret;
+                    }
+                }
+                pthread_mutex_unlock(&ring.mutex);
+                break;
+            }
+            if (offset >= end) {
+                break;
+            }
+            if (data_block_size > end - offset) {
+                data_block_size = end - offset;
+            }
+        }
+
+        read_size = ((data_block_size > DHT_REBALANCE_BLKSIZE)
+                         ? DHT_REBALANCE_BLKSIZE
+                         : data_block_size);
+        data_block_size -= read_size;
+
+        slot = NULL;
+        pthread_mutex_lock(&ring.mutex);
+        {
+            while (!ring.fop_errno &&
+                   (ring.inflight == DHT_REBALANCE_STREAM_DEPTH)) {
+                pthread_cond_wait(&ring.cond, &ring.mutex);
+            }
+            if (!ring.fop_errno) {
+                for (i = 0; i < DHT_REBALANCE_STREAM_DEPTH; i++) {
+                    if (!ring.slots[i].busy) {
+                        slot = &ring.slots[i];
+                        slot->busy = _gf_true;
+                        ring.inflight++;
+                        break;
+                    }
+                }
             }
-            return ret;
         }
+        pthread_mutex_unlock(&ring.mutex);
 
-        /* It could happen that at the same offset we detected data in the
-         * first seek, there could be a hole in the second seek if user is
-         * modifying the file concurrently. In this case we need to find a
-         * new data segment to migrate. */
-    } while (hole <= *offset);
+        if (!slot) {
+            break;
+        }
 
-    /* Calculate the total size of the current data block */
-    *size = hole - *offset;
+        slot->offset = offset;
+        slot->size = read_size;
+        offset += read_size;
 
-    return 1;
+        /* Carries the pid and lock owner of the thread. */
+        slot->frame = syncop_create_frame(this);
+        if (!slot->frame) {
+            dht_migrate_slot_done(slot, ENOMEM);
+            break;
+        }
+
+        dht_migrate_slot_read(slot);
+    }
+
+out:
+    pthread_mutex_lock(&ring.mutex);
+    {
+        while (ring.inflight > 0) {
+            pthread_cond_wait(&ring.cond, &ring.mutex);
+        }
+    }
+    pthread_mutex_unlock(&ring.mutex);
+
+    pthread_cond_destroy(&ring.cond);
+    pthread_mutex_destroy(&ring.mutex);
+
+    if (ring.xdata) {
+        dict_unref(ring.xdata);
+    }
+
+    if (ring.fop_errno) {
+        *fop_errno = ring.fop_errno;
+        return -1;
+    }
+
+    return 0;
 }
 
+/* Copies the data between 'start' and 'end'. */
 static int
-__dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
-                             fd_t *src, fd_t *dst, uint64_t ia_size,
-                             int hole_exists, int *fop_errno)
+dht_rebalance_migrate_range(xlator_t *this, xlator_t *from, xlator_t *to,
+                            fd_t *src, fd_t *dst, off_t start, off_t end,
+                            int hole_exists, int *fop_errno)
 {
     int ret = 0;
     int count = 0;
-    off_t offset = 0;
+    off_t offset = start;
     struct iovec *vector = NULL;
     struct iobref *iobref = NULL;
-    uint64_t total = 0;
     size_t read_size = 0;
     size_t data_block_size = 0;
     dict_t *xdata = NULL;
@@ -1052,11 +1670,18 @@ __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
 
     conf = this->private;
 
+    /* The pipelined copy waits for its requests on a condition variable,
+     * which would block a synctask. */
+    if (conf->defrag && !synctask_get()) {
+        return dht_rebalance_migrate_range_pipelined(
+            this, from, to, src, dst, start, end, hole_exists, fop_errno);
+    }
+
     /* if file size is '0', no need to enter this loop */
-    while (total < ia_size) {
+    while (offset < end) {
         /* This is a regular file - read it sequentially */
         if (!hole_exists) {
-            data_block_size = ia_size - total;
+            data_block_size = end - offset;
         } else {
             /* This is a sparse file - read only the data segments in the file
              */
@@ -1065,12 +1690,20 @@ __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
              * segment starting at the offset of the last read and written
              * byte. */
             if (data_block_size <= 0) {
-                ret = dht_rebalance_sparse_segment(from, src, &offset,
-                                                   &data_block_size);
+                ret = syncop_seek_data_segment(from, src, &offset,
+                                               &data_block_size);
                 if (ret <= 0) {
                     *fop_errno = -ret;
                     break;
                 }
+                /* The segment may extend beyond the range handled by this
+                 * call. */
+                if (offset >= end) {
+                    break;
+                }
+                if (data_block_size > end - offset) {
+                    data_block_size = end - offset;
+                }
             }
         }
 
@@ -1140,7 +1773,9 @@ __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
         }
 
         offset += ret;
-        total += ret;
+        if (conf->defrag) {
+            GF_ATOMIC_ADD(conf->defrag->bytes_copied, ret);
+        }
 
         GF_FREE(vector);
         if (iobref)
@@ -1165,6 +1800,155 @@ __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
     return ret;
 }
 
+struct dht_migrate_stream {
+    xlator_t *this;
+    xlator_t *from;
+    xlator_t *to;
+    fd_t *src;
+    fd_t *dst;
+    off_t start;
+    off_t end;
+    int hole_exists;
+    int ret;
+    int fop_errno;
+    pthread_t thread;
+    gf_boolean_t running;
+    struct syncopctx opctx;
+};
+
+static void *
+dht_rebalance_migrate_stream(void *data)
+{
+    struct dht_migrate_stream *stream = data;
+
+    THIS = stream->this;
+
+    /* Writes must be identified in the same way as the ones sent by the
+     * migrator thread that owns the file. */
+    if (stream->opctx.valid & SYNCOPCTX_PID) {
+        syncopctx_setfspid(&stream->opctx.pid);
+    }
+    if (stream->opctx.valid & SYNCOPCTX_LKOWNER) {
+        syncopctx_setfslkowner(&stream->opctx.lk_owner);
+    }
+
+    stream->ret = dht_rebalance_migrate_range(
+        stream->this, stream->from, stream->to, stream->src, stream->dst,
+        stream->start, stream->end, stream->hole_exists, &stream->fop_errno);
+
+    return NULL;
+}
+
+/* Returns the number of streams used to migrate a file of 'size' bytes.
+ * Each stream copies at least DHT_REBALANCE_STREAM_MIN bytes. Only the
+ * rebalance process splits files, since other callers may be running inside
+ * a synctask. */
+static int
+dht_rebalance_stream_count(dht_conf_t *conf, uint64_t size)
+{
+    uint64_t count;
+
+    if ((conf->defrag == NULL) || (conf->migration_streams <= 1)) {
+        return 1;
+    }
+
+    count = size / DHT_REBALANCE_STREAM_MIN;
+    if (count > conf->migration_streams) {
+        count = conf->migration_streams;
+    }
+
+    return (count > 1) ? count : 1;
+}
+
+static int
+__dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
+                             fd_t *src, fd_t *dst, uint64_t ia_size,
+                             int hole_exists, int *fop_errno)
+{
+    struct dht_migrate_stream *streams = NULL;
+    struct syncopctx *opctx = NULL;
+    dht_conf_t *conf = NULL;
+    uint64_t range = 0;
+    int count = 0;
+    int ret = 0;
+    int i = 0;
+
+    conf = this->private;
+
+    count = dht_rebalance_stream_count(conf, ia_size);
+    if (count > 1) {
+        streams = GF_CALLOC(count, sizeof(*streams),
+                            gf_dht_mt_migrate_stream_t);
+    }
+    if (streams == NULL) {
+        return dht_rebalance_migrate_range(this, from, to, src, dst, 0,
+                                           ia_size, hole_exists, fop_errno);
+    }
+
+    /* Split the file into ranges of the same size, aligned to the block size
+     * so that each read and write is still a full block. The first range is
+     * copied by this thread. */
+    range = ia_size / count;
+    range -= range % DHT_REBALANCE_BLKSIZE;
+
+    opctx = syncopctx_getctx();
+
+    for (i = 0; i < count; i++) {
+        streams[i].this = this;
+        streams[i].from = from;
+        streams[i].to = to;
+        streams[i].src = src;
+        streams[i].dst = dst;
+        streams[i].start = i * range;
+        streams[i].end = (i == count - 1) ? ia_size : (i + 1) * range;
+        streams[i].hole_exists = hole_exists;
+        if (opctx != NULL) {
+            streams[i].opctx.valid = opctx->valid &
+                                     (SYNCOPCTX_PID | SYNCOPCTX_LKOWNER);
+            streams[i].opctx.pid = opctx->pid;
+            streams[i].opctx.lk_owner = opctx->lk_owner;
+        }
+
+        if (i == 0) {
+            continue;
+        }
+
+        ret = gf_thread_create(&streams[i].thread, NULL,
+                               dht_rebalance_migrate_stream, &streams[i],
+                               "dhtmigs%d", i);
+        if (ret == 0) {
+            streams[i].running = _gf_true;
+        } else {
+            /* Copy the range from this thread later. */
+            gf_msg(this->name, GF_LOG_WARNING, ret,
+                   DHT_MSG_MIGRATE_FILE_FAILED,
+                   "Failed to create migration stream %d", i);
+        }
+    }
+
+    ret = dht_rebalance_migrate_range(this, from, to, src, dst,
+                                      streams[0].start, streams[0].end,
+                                      hole_exists, fop_errno);
+
+    for (i = 1; i < count; i++) {
+        if (streams[i].running) {
+            pthread_join(streams[i].thread, NULL);
+        } else if (ret == 0) {
+            dht_rebalance_migrate_stream(&streams[i]);
+        } else {
+            continue;
+        }
+        if ((streams[i].ret < 0) && (ret == 0)) {
+            ret = streams[i].ret;
+            *fop_errno = streams[i].fop_errno;
+        }
+    }
+
+    GF_FREE(streams);
+
+    return ret;
+}
+
 static int
 __dht_rebalance_open_src_file(xlator_t *this, xlator_t *from, xlator_t *to,
                               loc_t *loc, struct iatt *stbuf, fd_t **src_fd,
@@ -3239,6 +4023,8 @@ gf_defrag_get_entry(xlator_t *this, int i, struct dht_container **container,
             goto out;
         }
 
+        tmp_container->dir = gf_defrag_dir_ref(dir_dfmeta->dir);
+
         tmp_container->migrate_data = migrate_data;
 
         tmp_container->this = this;
@@ -3268,7 +4054,7 @@ out:
 
 int
 gf_defrag_process_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                      dict_t *migrate_data, int *perrno)
+                      dict_t *migrate_data, gf_defrag_dir_t *dir, int *perrno)
 {
     int ret = -1;
     dht_conf_t *conf = NULL;
@@ -3314,6 +4100,8 @@ gf_defrag_process_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         goto out;
     }
 
+    dir_dfmeta->dir = dir;
+
     dir_dfmeta->lfd = GF_CALLOC(local_subvols_cnt, sizeof(fd_t *),
                                 gf_common_mt_pointer);
     if (!dir_dfmeta->lfd) {
@@ -3597,7 +4385,8 @@ gf_defrag_settle_hash(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
 
 int
 gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                     dict_t *fix_layout, dict_t *migrate_data)
+                     dict_t *fix_layout, dict_t *migrate_data,
+                     gf_defrag_dir_t *parent)
 {
     int ret = -1;
     loc_t entry_loc = {
@@ -3617,6 +4406,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     };
     inode_t *linked_inode = NULL, *inode = NULL;
     dht_conf_t *conf = NULL;
+    gf_defrag_dir_t *dir = NULL;
     int perrno = 0;
 
     conf = this->private;
@@ -3656,6 +4446,22 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     loc->inode = linked_inode;
     inode_unref(inode);
 
+    if ((defrag->resume_run != 0) && (parent != NULL)) {
+        if (gf_defrag_resume_get(this, loc, defrag->resume_done_key) ==
+            defrag->resume_run) {
+            gf_msg_debug(this->name, 0, "%s already processed. Skipping",
+                         loc->path);
+            defrag->resume_skipped++;
+            gf_defrag_dir_skipped(defrag, parent, loc);
+            ret = 0;
+            goto out;
+        }
+    }
+    if (defrag->resume_stale) {
+        gf_defrag_resume_clear(this, defrag, loc);
+    }
+    dir = gf_defrag_dir_new(defrag, loc, parent);
+
     fd = fd_create(loc->inode, defrag->pid);
     if (!fd) {
         gf_log(this->name, GF_LOG_ERROR, "Failed to create fd");
@@ -3766,7 +4572,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
              * for the current directory*/
 
             ret = gf_defrag_fix_layout(this, defrag, &entry_loc, fix_layout,
-                                       migrate_data);
+                                       migrate_data, dir);
 
             if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
                 goto out;
@@ -3838,7 +4644,8 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     }
 
     if (defrag->cmd != GF_DEFRAG_CMD_START_LAYOUT_FIX) {
-        ret = gf_defrag_process_dir(this, defrag, loc, migrate_data, &perrno);
+        ret = gf_defrag_process_dir(this, defrag, loc, migrate_data, dir,
+                                    &perrno);
 
         if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
             goto out;
@@ -3890,6 +4697,13 @@ out:
     if (fd)
         fd_unref(fd);
 
+    if (dir) {
+        if (ret) {
+            dir->failed = _gf_true;
+        }
+        gf_defrag_dir_unref(this, defrag, dir);
+    }
+
     return ret;
 }
 
@@ -4373,6 +5187,8 @@ gf_defrag_start_crawl(void *data)
             goto out;
         }
 
+        gf_defrag_resume_init(this, defrag, &loc);
+
         /* Initialise the structures required for parallel migration */
         ret = gf_defrag_parallel_migration_init(this, defrag, &tid,
                                                 &thread_index);
@@ -4390,7 +5206,8 @@ gf_defrag_start_crawl(void *data)
         }
     }
 
-    ret = gf_defrag_fix_layout(this, defrag, &loc, fix_layout, migrate_data);
+    ret = gf_defrag_fix_layout(this, defrag, &loc, fix_layout, migrate_data,
+                               NULL);
     if (ret) {
         ret = -1;
         goto out;
@@ -4420,6 +5237,8 @@ out:
         defrag->defrag_status = GF_DEFRAG_STATUS_COMPLETE;
     }
 
+    gf_defrag_resume_fini(this, defrag, &loc);
+
     if (fc_thread_started) {
         gf_defrag_estimates_cleanup(this, defrag, filecnt_thread);
     }
@@ -4571,6 +5390,7 @@ gf_defrag_status_get(dht_conf_t *conf, dict_t *dict, gf_boolean_t log_status)
     uint64_t lookup = 0;
     uint64_t failures = 0;
     uint64_t skipped = 0;
+    uint64_t throughput = 0;
     char *status = "";
     time_t elapsed = 0;
     time_t time_to_complete = 0;
@@ -4591,6 +5411,9 @@ gf_defrag_status_get(dht_conf_t *conf, dict_t *dict, gf_boolean_t log_status)
     skipped = defrag->skipped;
 
     elapsed = gf_time() - defrag->start_time;
+    if (elapsed > 0) {
+        throughput = GF_ATOMIC_GET(defrag->bytes_copied) / elapsed;
+    }
 
     /* The rebalance is still in progress */
 
@@ -4641,6 +5464,10 @@ gf_defrag_status_get(dht_conf_t *conf, dict_t *dict, gf_boolean_t log_status)
     if (ret)
         gf_log(THIS->name, GF_LOG_WARNING, "failed to set time-left");
 
+    ret = dict_set_uint64(dict, "throughput", throughput);
+    if (ret)
+        gf_log(THIS->name, GF_LOG_WARNING, "failed to set throughput");
+
 log:
     if (log_status) {
         switch (defrag->defrag_status) {
@@ -4668,8 +5495,9 @@ log:
                "Files migrated: %" PRIu64 ", size: %" PRIu64
                ", lookups: %" PRIu64 ", failures: %" PRIu64
                ", skipped: "
-               "%" PRIu64,
-               status, elapsed, files, size, lookup, failures, skipped);
+               "%" PRIu64 ", throughput: %" PRIu64 " bytes/sec",
+               status, elapsed, files, size, lookup, failures, skipped,
+               throughput);
     }
 out:
     return 0;
@@ -117,6 +117,13 @@ dht_priv_dump(xlator_t *this)
     gf_proc_dump_write("refresh_interval", "%d", conf->refresh_interval);
     gf_proc_dump_write("unhashed_sticky_bit", "%d", conf->unhashed_sticky_bit);
     gf_proc_dump_write("use-readdirp", "%d", conf->use_readdirp);
+    gf_proc_dump_write("readdir-fan-out", "%d", conf->readdir_fan_out);
+    gf_proc_dump_write("readdir_fan_out_sent", "%" PRId64,
+                       GF_ATOMIC_GET(conf->readdir_fan_out_sent));
+    gf_proc_dump_write("readdir_fan_out_hits", "%" PRId64,
+                       GF_ATOMIC_GET(conf->readdir_fan_out_hits));
+    gf_proc_dump_write("readdir_fan_out_misses", "%" PRId64,
+                       GF_ATOMIC_GET(conf->readdir_fan_out_misses));
 
     if (conf->du_stats && conf->subvolume_status) {
         for (i = 0; i < conf->subvolume_cnt; i++) {
@@ -469,6 +476,8 @@ dht_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("readdir-optimize", conf->readdir_optimize, options, bool,
                      out);
+    GF_OPTION_RECONF("readdir-fan-out", conf->readdir_fan_out, options, bool,
+                     out);
     GF_OPTION_RECONF("randomize-hash-range-by-gfid", conf->randomize_by_gfid,
                      options, bool, out);
 
@@ -498,6 +507,9 @@ dht_reconfigure(xlator_t *this, dict_t *options)
                          out);
     }
 
+    GF_OPTION_RECONF("rebal-migration-streams", conf->migration_streams,
+                     options, uint32, out);
+
     if (dict_get_str(options, "decommissioned-bricks", &temp_str) == 0) {
         if (!(conf->decommission_in_progress)) {
             ret = dht_parse_decommissioned_bricks(this, conf, temp_str);
@@ -689,6 +701,8 @@ dht_init(xlator_t *this)
 
         defrag->stats = _gf_false;
 
+        GF_ATOMIC_INIT(defrag->bytes_copied, 0);
+
         defrag->queue = NULL;
 
         defrag->crawl_done = 0;
@@ -748,6 +762,11 @@ dht_init(xlator_t *this)
 
     GF_OPTION_INIT("readdir-optimize", conf->readdir_optimize, bool, err);
 
+    GF_OPTION_INIT("readdir-fan-out", conf->readdir_fan_out, bool, err);
+    GF_ATOMIC_INIT(conf->readdir_fan_out_sent, 0);
+    GF_ATOMIC_INIT(conf->readdir_fan_out_hits, 0);
+    GF_ATOMIC_INIT(conf->readdir_fan_out_misses, 0);
+
     GF_OPTION_INIT("lock-migration", conf->lock_migration_enabled, bool, err);
 
     GF_OPTION_INIT("force-migration", conf->force_migration, bool, err);
@@ -758,6 +777,8 @@ dht_init(xlator_t *this)
         defrag->lock_migration_enabled = conf->lock_migration_enabled;
 
         GF_OPTION_INIT("rebalance-stats", defrag->stats, bool, err);
+
+        GF_OPTION_INIT("rebal-resume", defrag->resume, bool, err);
         if (dict_get_str(this->options, "rebalance-filter", &temp_str) == 0) {
             if (gf_defrag_pattern_list_fill(this, defrag, temp_str) == -1) {
                 gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_INVALID_OPTION,
@@ -819,6 +840,9 @@ dht_init(xlator_t *this)
     GF_OPTION_INIT("randomize-hash-range-by-gfid", conf->randomize_by_gfid,
                    bool, err);
 
+    GF_OPTION_INIT("rebal-migration-streams", conf->migration_streams, uint32,
+                   err);
+
     if (defrag) {
         GF_OPTION_INIT("rebal-throttle", temp_str, str, err);
         if (temp_str) {
@@ -1005,6 +1029,17 @@ struct volume_options dht_options[] = {
      .op_version = {1},
      .level = OPT_STATUS_ADVANCED,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"readdir-fan-out"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description =
+         "If enabled, DHT sends readdirp requests to all subvolumes at the "
+         "same time and keeps the answers until the application reaches "
+         "them, instead of reading the subvolumes one after another. At most "
+         "one answer per subvolume is kept for each open directory.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"rsync-hash-regex"},
      .type = GF_OPTION_TYPE_STR,
      /* Setting a default here doesn't work.  See dht_init_regex. */
@@ -1085,6 +1120,29 @@ struct volume_options dht_options[] = {
 
     },
 
+    {.key = {"rebal-resume"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "If enabled, a rebalance that is stopped or interrupted "
+                    "by a restart skips the directories that were completely "
+                    "processed by the previous run when it is started again.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"rebal-migration-streams"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "1",
+     .description = "Maximum number of threads that copy the data of a single "
+                    "file during the rebalance operation. Files of at least "
+                    "128MB are split in ranges of the same size which are "
+                    "copied in parallel, each range being at least 64MB.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
     {.key = {"lock-migration"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
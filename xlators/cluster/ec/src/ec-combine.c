@@ -59,6 +59,7 @@ ec_combine_write(ec_fop_data_t *fop, ec_cbk_data_t *dst, ec_cbk_data_t *src)
         case GF_FOP_CREATE:
         case GF_FOP_MKNOD:
         case GF_FOP_MKDIR:
+        case GF_FOP_COPY_FILE_RANGE:
             valid = 3;
             break;
         case GF_FOP_UNLINK:
@@ -954,6 +955,14 @@ ec_combine(ec_cbk_data_t *newcbk, ec_combine_f combine)
 
     fop->received |= newcbk->mask;
 
+    /* A hedged read can be answered before all its requests have completed.
+     * The late answers are kept in fop->answer_list only. */
+    if (fop->hedging && (fop->answer != NULL)) {
+        UNLOCK(&fop->lock);
+
+        return;
+    }
+
     item = fop->cbk_list.prev;
     list_for_each_entry(cbk, &fop->cbk_list, list)
     {
@@ -540,7 +540,8 @@ void
 ec_complete(ec_fop_data_t *fop)
 {
     ec_cbk_data_t *cbk = NULL;
-    int32_t resume = 0, update = 0;
+    uintptr_t good = 0;
+    int32_t resume = 0, update = 0, won = 0, cancelled = 0;
     int healing_count = 0;
 
     LOCK(&fop->lock);
@@ -556,6 +557,7 @@ ec_complete(ec_fop_data_t *fop)
                  * successful on at least fop->minimum good copies*/
                 if ((cbk->count - healing_count) >= fop->minimum) {
                     fop->answer = cbk;
+                    good = cbk->mask;
 
                     update = 1;
                 }
@@ -563,6 +565,34 @@ ec_complete(ec_fop_data_t *fop)
 
             resume = 1;
         }
+    } else if (fop->hedging && (fop->hedge_idx != EC_INVALID_INDEX) &&
+               (fop->answer == NULL) && !list_empty(&fop->cbk_list)) {
+        /* A hedged read doesn't wait for the late bricks once it has enough
+         * good answers. The answers that arrive later are ignored. */
+        cbk = list_entry(fop->cbk_list.next, ec_cbk_data_t, list);
+        healing_count = gf_bits_count(cbk->mask & fop->healing);
+        if ((cbk->op_ret >= 0) &&
+            ((cbk->count - healing_count) >= fop->minimum)) {
+            fop->answer = cbk;
+            if ((cbk->mask & (1ULL << fop->hedge_idx)) != 0) {
+                won = 1;
+            }
+            /* Bricks that haven't answered yet are not known to be bad. */
+            good = cbk->mask | (fop->mask & ~fop->remaining & ~fop->received);
+
+            update = 1;
+            resume = 1;
+        }
+    }
+
+    /* The deadline of a hedged read is useless once it has been answered.
+     * The timer callback takes fop->lock, so the timer can't be released
+     * while it's cancelled here. */
+    if ((fop->hedge_timer != NULL) && (resume || (fop->winds == 0))) {
+        if (gf_timer_call_cancel(fop->xl->ctx, fop->hedge_timer) == 0) {
+            cancelled = 1;
+        }
+        fop->hedge_timer = NULL;
     }
 
     UNLOCK(&fop->lock);
@@ -572,7 +602,18 @@ ec_complete(ec_fop_data_t *fop)
        be called more than once for each fop, it can be called from outside
        the fop->lock locked region. */
     if (update) {
-        ec_update_good(fop, cbk->mask);
+        ec_update_good(fop, good);
+    }
+
+    if (won) {
+        ec_t *ec = fop->xl->private;
+
+        GF_ATOMIC_INC(ec->stats.hedge.won);
+    }
+
+    if (cancelled) {
+        /* Reference of the timer. */
+        ec_fop_data_release(fop);
     }
 
     if (resume) {
@@ -905,6 +946,121 @@ ec_dispatch_min(ec_fop_data_t *fop)
     }
 }
 
+static void
+ec_hedge_timeout(void *data)
+{
+    ec_fop_data_t *fop = data;
+    ec_t *ec = fop->xl->private;
+    uintptr_t mask;
+    uint32_t idx = EC_INVALID_INDEX;
+
+    LOCK(&fop->lock);
+
+    fop->hedge_timer = NULL;
+
+    mask = fop->remaining & ~fop->healing & ec->xl_up;
+    if ((fop->winds > 0) && (fop->answer == NULL) && (mask != 0)) {
+        idx = gf_bits_index(mask);
+
+        fop->remaining ^= 1ULL << idx;
+        fop->hedge_idx = idx;
+        timespec_now(&fop->hedge_start[1]);
+
+        ec_trace("HEDGE", fop, "idx=%d", idx);
+
+        fop->winds++;
+        fop->refs++;
+    }
+
+    UNLOCK(&fop->lock);
+
+    if (idx != EC_INVALID_INDEX) {
+        GF_ATOMIC_INC(ec->stats.hedge.sent);
+        fop->wind(ec, fop, idx);
+    }
+
+    ec_fop_data_release(fop);
+}
+
+/* Same as ec_dispatch_min(), but if the answers haven't arrived when the
+ * read deadline of the slowest of the bricks expires, the request is also
+ * sent to one of the remaining bricks. ec_complete() then doesn't wait for
+ * the answers that are missing once there are enough to decode the data. */
+void
+ec_dispatch_hedged(ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+    struct timespec delta = {
+        0,
+    };
+    uint64_t deadline = 0, tmp;
+    uintptr_t mask = 0;
+    uint32_t idx;
+
+    if (!ec->hedge_reads || (fop->parent != NULL)) {
+        ec_dispatch_min(fop);
+
+        return;
+    }
+
+    fop->hedging = _gf_true;
+    fop->hedge_idx = EC_INVALID_INDEX;
+    timespec_now(&fop->hedge_start[0]);
+
+    ec_dispatch_min(fop);
+
+    LOCK(&fop->lock);
+
+    if ((fop->winds > 0) && (fop->answer == NULL)) {
+        mask = fop->mask & ~fop->remaining;
+    }
+    for (idx = 0; mask != 0; idx++, mask >>= 1) {
+        if ((mask & 1) == 0) {
+            continue;
+        }
+        /* There's no deadline until enough reads have been measured. */
+        tmp = cluster_read_deadline(&ec->read_latency[idx]);
+        if (tmp == 0) {
+            deadline = 0;
+            break;
+        }
+        if (tmp > deadline) {
+            deadline = tmp;
+        }
+    }
+    /* The timer is armed with fop->lock held, so that ec_complete() and
+     * ec_hedge_timeout() always see it. */
+    if (deadline != 0) {
+        delta.tv_sec = deadline / GF_SEC_IN_NS;
+        delta.tv_nsec = deadline % GF_SEC_IN_NS;
+        fop->hedge_timer = gf_timer_call_after(fop->xl->ctx, delta,
+                                               ec_hedge_timeout, fop);
+        if (fop->hedge_timer != NULL) {
+            fop->refs++;
+        }
+    }
+
+    UNLOCK(&fop->lock);
+}
+
+/* Accounts the latency of a successful answer of a hedged read. */
+void
+ec_hedge_answer(ec_fop_data_t *fop, uint32_t idx)
+{
+    ec_t *ec = fop->xl->private;
+    struct timespec *start = &fop->hedge_start[0];
+
+    LOCK(&fop->lock);
+
+    if (idx == fop->hedge_idx) {
+        start = &fop->hedge_start[1];
+    }
+
+    UNLOCK(&fop->lock);
+
+    cluster_read_latency_add(&ec->read_latency[idx], start);
+}
+
 void
 ec_succeed_all(ec_fop_data_t *fop)
 {
@@ -1767,8 +1923,11 @@ static void
 ec_lock_update_fd(ec_lock_t *lock, ec_fop_data_t *fop)
 {
     /* If the fop has an fd available, attach it to the lock structure to be
-     * able to do fxattrop calls instead of xattrop. */
-    if (fop->use_fd && (lock->fd == NULL)) {
+     * able to do fxattrop calls instead of xattrop. A fop can lock an inode
+     * other than the one of its fd (copy_file_range locks the source too),
+     * so the fd must belong to the locked inode. */
+    if (fop->use_fd && (lock->fd == NULL) &&
+        (fop->fd->inode == lock->loc.inode)) {
         lock->fd = __fd_ref(fop->fd);
     }
 }
@@ -2124,11 +2283,13 @@ ec_lock_next_owner(ec_lock_link_t *link, ec_cbk_data_t *cbk,
                    gf_boolean_t release)
 {
     struct list_head list;
+    struct list_head held;
     ec_lock_t *lock = link->lock;
     ec_fop_data_t *fop = link->fop;
     ec_inode_t *ctx = lock->ctx;
 
     INIT_LIST_HEAD(&list);
+    INIT_LIST_HEAD(&held);
 
     LOCK(&lock->loc.inode->lock);
 
@@ -2142,6 +2303,10 @@ ec_lock_next_owner(ec_lock_link_t *link, ec_cbk_data_t *cbk,
     GF_ASSERT((lock->refs_owners > 0) && !list_empty(&link->owner_list));
     list_del_init(&link->owner_list);
 
+    /* Writes are only held by ec_writev_coalesce() while there's an owner,
+     * and they are sent as soon as any of the owners finishes. */
+    list_splice_init(&ctx->coalesce, &held);
+
     lock->release |= release;
 
     if ((fop->error == 0) && (cbk != NULL) && (cbk->op_ret >= 0)) {
@@ -2170,6 +2335,8 @@ ec_lock_next_owner(ec_lock_link_t *link, ec_cbk_data_t *cbk,
     UNLOCK(&lock->loc.inode->lock);
 
     ec_lock_resume_shared(&list);
+
+    ec_writev_coalesce_send(fop->xl, &held);
 }
 
 void
@@ -2875,8 +3042,8 @@ ec_update_stripe(ec_t *ec, ec_stripe_list_t *stripe_cache, ec_stripe_t *stripe,
          * modified at least one byte (meaning ec has written the full
          * stripe). */
         if (base < fop->answer->op_ret + fop->head) {
-            memcpy(stripe->data, fop->vector[0].iov_base + base,
-                   ec->stripe_size);
+            ec_iov_copy_to(stripe->data, fop->vector, fop->int32 - 1, base,
+                           ec->stripe_size);
             list_move_tail(&stripe->lru, &stripe_cache->lru);
 
             GF_ATOMIC_INC(ec->stats.stripe_cache.updates);
@@ -187,6 +187,11 @@ void
 ec_dispatch_min(ec_fop_data_t *fop);
 void
 ec_dispatch_one(ec_fop_data_t *fop);
+void
+ec_dispatch_hedged(ec_fop_data_t *fop);
+
+void
+ec_hedge_answer(ec_fop_data_t *fop, uint32_t idx);
 
 void
 ec_succeed_all(ec_fop_data_t *fop);
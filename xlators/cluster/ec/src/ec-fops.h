@@ -203,6 +203,12 @@ ec_fallocate(call_frame_t *frame, xlator_t *this, uintptr_t target,
              uint32_t fop_flags, fop_fallocate_cbk_t func, void *data, fd_t *fd,
              int32_t mode, off_t offset, size_t len, dict_t *xdata);
 
+void
+ec_copy_file_range(call_frame_t *frame, xlator_t *this, uintptr_t target,
+                   uint32_t fop_flags, fop_copy_file_range_cbk_t func,
+                   void *data, fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                   off_t off_out, size_t len, uint32_t flags, dict_t *xdata);
+
 void
 ec_discard(call_frame_t *frame, xlator_t *this, uintptr_t target,
            uint32_t fop_flags, fop_discard_cbk_t func, void *data, fd_t *fd,
@@ -229,6 +235,17 @@ ec_writev(call_frame_t *frame, xlator_t *this, uintptr_t target,
           struct iovec *vector, int32_t count, off_t offset, uint32_t flags,
           struct iobref *iobref, dict_t *xdata);
 
+gf_boolean_t
+ec_writev_coalesce(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   struct iovec *vector, int32_t count, off_t offset,
+                   uint32_t flags, struct iobref *iobref, dict_t *xdata);
+
+void
+ec_writev_coalesce_send(xlator_t *this, struct list_head *list);
+
+void
+ec_writev_coalesce_flush(xlator_t *this, inode_t *inode);
+
 void
 ec_xattrop(call_frame_t *frame, xlator_t *this, uintptr_t target,
            uint32_t fop_flags, fop_xattrop_cbk_t func, void *data, loc_t *loc,
@@ -167,9 +167,8 @@ ec_heal_check(ec_fop_data_t *fop, uintptr_t *pgood)
 }
 
 void
-ec_heal_update(ec_fop_data_t *fop, int32_t is_open)
+ec_heal_update(ec_heal_t *heal, ec_fop_data_t *fop, int32_t is_open)
 {
-    ec_heal_t *heal = fop->data;
     uintptr_t good, bad;
 
     bad = ec_heal_check(fop, &good);
@@ -187,9 +186,8 @@ ec_heal_update(ec_fop_data_t *fop, int32_t is_open)
 }
 
 void
-ec_heal_avoid(ec_fop_data_t *fop)
+ec_heal_avoid(ec_heal_t *heal, ec_fop_data_t *fop)
 {
-    ec_heal_t *heal = fop->data;
     uintptr_t bad;
 
     bad = ec_heal_check(fop, NULL);
@@ -303,14 +301,20 @@ ec_heal_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                    struct iatt *postbuf, dict_t *xdata)
 {
     ec_fop_data_t *fop = cookie;
-    ec_heal_t *heal = fop->data;
+    ec_heal_window_t *window = fop->data;
+    ec_heal_t *heal = window->heal;
+    ec_t *ec = heal->xl->private;
 
     ec_trace("WRITE_CBK", cookie, "ret=%d, errno=%d", op_ret, op_errno);
 
     gf_msg_debug(fop->xl->name, op_errno, "%s: write op_ret %d at %" PRIu64,
-                 uuid_utoa(heal->fd->inode->gfid), op_ret, heal->offset);
+                 uuid_utoa(heal->fd->inode->gfid), op_ret, window->offset);
 
-    ec_heal_update(cookie, 0);
+    ec_heal_update(heal, fop, 0);
+
+    if (op_ret > 0) {
+        GF_ATOMIC_ADD(ec->stats.shd.healed_bytes, op_ret);
+    }
 
     return 0;
 }
@@ -322,29 +326,34 @@ ec_heal_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                   dict_t *xdata)
 {
     ec_fop_data_t *fop = cookie;
-    ec_heal_t *heal = fop->data;
+    ec_heal_window_t *window = fop->data;
+    ec_heal_t *heal = window->heal;
 
     ec_trace("READ_CBK", fop, "ret=%d, errno=%d", op_ret, op_errno);
 
-    ec_heal_avoid(fop);
+    ec_heal_avoid(heal, fop);
 
     if (op_ret > 0) {
         gf_msg_debug(fop->xl->name, 0,
                      "%s: read succeeded, proceeding "
                      "to write at %" PRIu64,
-                     uuid_utoa(heal->fd->inode->gfid), heal->offset);
+                     uuid_utoa(heal->fd->inode->gfid), window->offset);
         ec_writev(heal->fop->frame, heal->xl, heal->bad, EC_MINIMUM_ONE,
-                  ec_heal_writev_cbk, heal, heal->fd, vector, count,
-                  heal->offset, 0, iobref, NULL);
+                  ec_heal_writev_cbk, window, heal->fd, vector, count,
+                  window->offset, 0, iobref, NULL);
     } else {
+        LOCK(&heal->lock);
+
         if (op_ret < 0) {
             gf_msg_debug(fop->xl->name, op_errno,
                          "%s: read failed, failing "
                          "to heal block at %" PRIu64,
-                         uuid_utoa(heal->fd->inode->gfid), heal->offset);
+                         uuid_utoa(heal->fd->inode->gfid), window->offset);
             heal->bad = 0;
         }
         heal->done = 1;
+
+        UNLOCK(&heal->lock);
     }
 
     return 0;
@@ -353,13 +362,28 @@ ec_heal_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 void
 ec_heal_data_block(ec_heal_t *heal)
 {
+    ec_heal_window_t *window;
+    uint32_t i;
+
     ec_trace("DATA", heal->fop, "good=%lX, bad=%lX", heal->good, heal->bad);
 
     if ((heal->good != 0) && (heal->bad != 0) &&
         (heal->iatt.ia_type == IA_IFREG)) {
-        ec_readv(heal->fop->frame, heal->xl, heal->good, EC_MINIMUM_MIN,
-                 ec_heal_readv_cbk, heal, heal->fd, heal->size, heal->offset, 0,
-                 NULL);
+        /* All windows are children of the same heal fop, so they are read
+         * and written in parallel under the lock it holds, and the fop
+         * doesn't progress until all of them have completed. */
+        for (i = 0; i < heal->depth; i++) {
+            window = &heal->windows[i];
+            window->offset = heal->offset + i * heal->size;
+            if ((i > 0) && ((window->offset >= heal->total_size) ||
+                            (window->offset >= heal->end))) {
+                break;
+            }
+            window->size = min(heal->size, heal->end - window->offset);
+            ec_readv(heal->fop->frame, heal->xl, heal->good, EC_MINIMUM_MIN,
+                     ec_heal_readv_cbk, window, heal->fd, window->size,
+                     window->offset, 0, NULL);
+        }
     }
 }
 
@@ -2054,12 +2078,77 @@ ec_sync_heal_block(call_frame_t *frame, xlator_t *this, ec_heal_t *heal)
     return 0;
 }
 
+static void
+ec_heal_data_account_start(ec_t *ec)
+{
+    LOCK(&ec->lock);
+
+    if (ec->data_healers++ == 0) {
+        timespec_now(&ec->data_heal_start);
+    }
+
+    UNLOCK(&ec->lock);
+}
+
+static void
+ec_heal_data_account_end(ec_t *ec)
+{
+    struct timespec now;
+
+    LOCK(&ec->lock);
+
+    if (--ec->data_healers == 0) {
+        timespec_now(&now);
+        GF_ATOMIC_ADD(ec->stats.shd.heal_time,
+                      gf_tsdiff(&ec->data_heal_start, &now) / 1000);
+    }
+
+    UNLOCK(&ec->lock);
+}
+
+/* Finds the next segment of data at or after heal->offset, looking at the
+ * fragments stored in the brick @source, and sets heal->offset and
+ * heal->end to the stripes that contain it. Returns 0 if there's no more
+ * data. */
+static int
+ec_heal_data_segment(ec_t *ec, ec_heal_t *heal, int source)
+{
+    off_t offset;
+    size_t len = 0;
+    int ret;
+
+    /* heal->offset is always aligned to a stripe. */
+    offset = heal->offset / ec->fragments;
+    ret = syncop_seek_data_segment(ec->xl_list[source], heal->fd, &offset,
+                                   &len);
+    if (ret < 0) {
+        gf_msg_debug(ec->xl->name, -ret,
+                     "%s: unable to find data segments, rebuilding the rest "
+                     "of the file",
+                     uuid_utoa(heal->fd->inode->gfid));
+        heal->end = heal->total_size;
+        ec_adjust_size_up(ec, &heal->end, _gf_false);
+        return 1;
+    }
+    if (ret == 0) {
+        return 0;
+    }
+
+    heal->offset = (offset - offset % ec->fragment_size) * ec->fragments;
+    heal->end = (offset + len + ec->fragment_size - 1) / ec->fragment_size *
+                ec->stripe_size;
+
+    return heal->offset < heal->total_size;
+}
+
 int
 ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
-                unsigned char *sources, unsigned char *healed_sinks)
+                unsigned char *sources, unsigned char *healed_sinks,
+                int sparse)
 {
     ec_heal_t *heal = NULL;
     int ret = 0;
+    uint32_t i;
     syncbarrier_t barrier;
 
     if (syncbarrier_init(&barrier))
@@ -2080,10 +2169,29 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
     heal->bad = ec_char_array_to_mask(healed_sinks, ec->nodes);
     heal->good = ec_char_array_to_mask(sources, ec->nodes);
     heal->iatt.ia_type = IA_IFREG;
+    heal->depth = ec->self_heal_pipeline_depth;
+    if (heal->depth == 0) {
+        heal->depth = 1;
+    }
+    heal->windows = alloca0(sizeof(*heal->windows) * heal->depth);
+    for (i = 0; i < heal->depth; i++) {
+        heal->windows[i].heal = heal;
+    }
     LOCK_INIT(&heal->lock);
 
+    /* If the file is sparse, only its data segments are rebuilt. The sinks
+     * have been emptied, so they already have the holes. */
+    heal->end = 0;
+    if (sparse < 0) {
+        heal->end = size;
+        ec_adjust_size_up(ec, &heal->end, _gf_false);
+    }
+
+    ec_heal_data_account_start(ec);
+
     for (heal->offset = 0; (heal->offset < size) && !heal->done;
-         heal->offset += heal->size) {
+         heal->offset = min(heal->offset + heal->size * heal->depth,
+                            heal->end)) {
         /* We immediately abort any heal if a shutdown request has been
          * received to avoid delays. The healing of this file will be
          * restarted by another SHD or other client that accesses the
@@ -2096,16 +2204,25 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
             break;
         }
 
+        if ((heal->offset >= heal->end) &&
+            (ec_heal_data_segment(ec, heal, sparse) == 0)) {
+            break;
+        }
+
         gf_msg_debug(ec->xl->name, 0,
                      "%s: sources: %d, sinks: "
-                     "%d, offset: %" PRIu64 " bsize: %" PRIu64,
+                     "%d, offset: %" PRIu64 " bsize: %" PRIu64
+                     " depth: %" PRIu32,
                      uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
                      EC_COUNT(healed_sinks, ec->nodes), heal->offset,
-                     heal->size);
+                     heal->size, heal->depth);
         ret = ec_sync_heal_block(frame, ec->xl, heal);
         if (ret < 0)
             break;
     }
+
+    ec_heal_data_account_end(ec);
+
     memset(healed_sinks, 0, ec->nodes);
     ec_mask_to_char_array(heal->bad, healed_sinks, ec->nodes);
     fd_unref(heal->fd);
@@ -2117,6 +2234,63 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
     return ret;
 }
 
+/* Truncates the sinks to the final size of the file and punches a hole
+ * over all their contents, so that only the data segments of a sparse file
+ * need to be rebuilt. The sinks never lose their size while this happens.
+ * Returns 1 if the hole couldn't be punched on some sink, in which case the
+ * whole file needs to be rebuilt. */
+int
+__ec_heal_empty_sinks(call_frame_t *frame, ec_t *ec, fd_t *fd,
+                      unsigned char *healed_sinks, uint64_t size)
+{
+    default_args_cbk_t *replies = NULL;
+    unsigned char *output = NULL;
+    int ret = 0;
+    int i = 0;
+    off_t trim_offset = 0;
+
+    EC_REPLIES_ALLOC(replies, ec->nodes);
+    output = alloca0(ec->nodes);
+
+    trim_offset = size;
+    ec_adjust_offset_up(ec, &trim_offset, _gf_true);
+
+    ret = cluster_ftruncate(ec->xl_list, healed_sinks, ec->nodes, replies,
+                            output, frame, ec->xl, fd, trim_offset, NULL);
+    for (i = 0; i < ec->nodes; i++) {
+        if (!output[i])
+            healed_sinks[i] = 0;
+    }
+    cluster_replies_wipe(replies, ec->nodes);
+
+    ret = 0;
+    if (EC_COUNT(healed_sinks, ec->nodes) == 0) {
+        ret = -ENOTCONN;
+        goto out;
+    }
+
+    if (trim_offset > 0) {
+        cluster_discard(ec->xl_list, healed_sinks, ec->nodes, replies, output,
+                        frame, ec->xl, fd, 0, trim_offset, NULL);
+        for (i = 0; i < ec->nodes; i++) {
+            if (healed_sinks[i] && !output[i]) {
+                gf_msg_debug(ec->xl->name, replies[i].op_errno,
+                             "%s: unable to punch a hole in the sink %d, "
+                             "rebuilding the whole file",
+                             uuid_utoa(fd->inode->gfid), i);
+                ret = 1;
+            }
+        }
+    }
+
+out:
+    cluster_replies_wipe(replies, ec->nodes);
+    if (ret < 0)
+        gf_msg_debug(ec->xl->name, -ret, "%s: heal failed",
+                     uuid_utoa(fd->inode->gfid));
+    return ret;
+}
+
 int
 __ec_heal_trim_sinks(call_frame_t *frame, ec_t *ec, fd_t *fd,
                      unsigned char *healed_sinks, unsigned char *trim,
@@ -2356,8 +2530,10 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
     uint64_t *size = NULL;
     unsigned char *trim = NULL;
     default_args_cbk_t *replies = NULL;
+    struct iatt stbuf = {0};
     int ret = 0;
     int source = 0;
+    int sparse = -1;
 
     locked_on = alloca0(ec->nodes);
     output = alloca0(ec->nodes);
@@ -2381,7 +2557,7 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
         }
 
         ret = __ec_heal_data_prepare(frame, ec, fd, locked_on, versions, dirty,
-                                     size, sources, healed_sinks, trim, NULL);
+                                     size, sources, healed_sinks, trim, &stbuf);
         if (ret < 0)
             goto unlock;
 
@@ -2396,8 +2572,19 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
         if (ret < 0)
             goto unlock;
 
-        ret = __ec_heal_trim_sinks(frame, ec, fd, healed_sinks, trim,
-                                   size[source]);
+        /* stbuf is the fragment of the source, so it only has holes if
+         * the file has them. */
+        if ((stbuf.ia_blocks * 512) < stbuf.ia_size) {
+            ret = __ec_heal_empty_sinks(frame, ec, fd, healed_sinks,
+                                        size[source]);
+            if (ret == 0)
+                sparse = source;
+            else if (ret > 0)
+                ret = 0;
+        } else {
+            ret = __ec_heal_trim_sinks(frame, ec, fd, healed_sinks, trim,
+                                       size[source]);
+        }
     }
 unlock:
     cluster_uninodelk(ec->xl_list, locked_on, ec->nodes, replies, output, frame,
@@ -2414,7 +2601,8 @@ unlock:
                  uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
                  EC_COUNT(healed_sinks, ec->nodes));
 
-    ret = ec_rebuild_data(frame, ec, fd, size[source], sources, healed_sinks);
+    ret = ec_rebuild_data(frame, ec, fd, size[source], sources, healed_sinks,
+                          sparse);
     if (ret < 0)
         goto out;
 
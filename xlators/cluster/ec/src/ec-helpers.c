@@ -715,6 +715,7 @@ __ec_inode_get(inode_t *inode, xlator_t *xl)
             memset(ctx, 0, sizeof(*ctx));
             INIT_LIST_HEAD(&ctx->heal);
             INIT_LIST_HEAD(&ctx->stripe_cache.lru);
+            INIT_LIST_HEAD(&ctx->coalesce);
             ctx->heal_count = 0;
             value = (uint64_t)(uintptr_t)ctx;
             if (__inode_ctx_set(inode, xl, &value) != 0) {
@@ -836,6 +837,7 @@ ec_is_data_fop(glusterfs_fop_t fop)
         case GF_FOP_FALLOCATE:
         case GF_FOP_DISCARD:
         case GF_FOP_ZEROFILL:
+        case GF_FOP_COPY_FILE_RANGE:
             return _gf_true;
         default:
             return _gf_false;
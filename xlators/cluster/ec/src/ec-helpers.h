@@ -19,6 +19,10 @@
 
 #define EC_ALIGN_CHECK(_ptr, _align) ((((uintptr_t)(_ptr)) & ((_align)-1)) == 0)
 
+/* Buffer of the encoded fragments of a write fop. It's placed after the
+ * data in fop->vector. */
+#define EC_WRITEV_FRAGMENTS(_fop) (&(_fop)->vector[(_fop)->int32 - 1])
+
 const char *
 ec_bin(char *str, size_t size, uint64_t value, int32_t digits);
 const char *
@@ -1327,6 +1327,10 @@ ec_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
             ec_cbk_set_error(cbk, EIO, _gf_true);
         }
 
+        if (fop->hedging && (op_ret >= 0)) {
+            ec_hedge_answer(fop, idx);
+        }
+
         ec_combine(cbk, ec_combine_readv);
     }
 
@@ -1375,7 +1379,7 @@ ec_manager_readv(ec_fop_data_t *fop, int32_t state)
             if (ec->read_mask) {
                 fop->mask &= ec->read_mask;
             }
-            ec_dispatch_min(fop);
+            ec_dispatch_hedged(fop);
 
             return EC_STATE_PREPARE_ANSWER;
 
@@ -8,6 +8,9 @@
   cases as published by the Free Software Foundation.
 */
 
+#include <glusterfs/call-stub.h>
+
+#include "ec.h"
 #include "ec-messages.h"
 #include "ec-helpers.h"
 #include "ec-common.h"
@@ -1087,6 +1090,277 @@ out:
     }
 }
 
+/*********************************************************************
+ *
+ * File Operation : copy_file_range
+ *
+ *********************************************************************/
+
+int32_t
+ec_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                       struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                       dict_t *xdata)
+{
+    ec_fop_data_t *fop = NULL;
+    ec_cbk_data_t *cbk = NULL;
+    int32_t idx = (int32_t)(uintptr_t)cookie;
+
+    VALIDATE_OR_GOTO(this, out);
+    GF_VALIDATE_OR_GOTO(this->name, frame, out);
+    GF_VALIDATE_OR_GOTO(this->name, frame->local, out);
+    GF_VALIDATE_OR_GOTO(this->name, this->private, out);
+
+    fop = frame->local;
+
+    ec_trace("CBK", fop, "idx=%d, frame=%p, op_ret=%d, op_errno=%d", idx, frame,
+             op_ret, op_errno);
+
+    cbk = ec_cbk_data_allocate(frame, this, fop, GF_FOP_COPY_FILE_RANGE, idx,
+                               op_ret, op_errno);
+    if (cbk == NULL) {
+        goto out;
+    }
+
+    if (op_ret >= 0) {
+        cbk->iatt[0] = *stbuf;
+        cbk->iatt[1] = *prebuf_dst;
+        cbk->iatt[2] = *postbuf_dst;
+    }
+    if (xdata != NULL) {
+        cbk->xdata = dict_ref(xdata);
+    }
+
+    ec_combine(cbk, ec_combine_write);
+
+out:
+    if (fop != NULL) {
+        ec_complete(fop);
+    }
+
+    return 0;
+}
+
+void
+ec_wind_copy_file_range(ec_t *ec, ec_fop_data_t *fop, int32_t idx)
+{
+    ec_trace("WIND", fop, "idx=%d", idx);
+
+    STACK_WIND_COOKIE(fop->frame, ec_copy_file_range_cbk,
+                      (void *)(uintptr_t)idx, ec->xl_list[idx],
+                      ec->xl_list[idx]->fops->copy_file_range, fop->fd_in,
+                      fop->offset_in / ec->fragments, fop->fd,
+                      fop->offset / ec->fragments, fop->size / ec->fragments,
+                      fop->uint32, fop->xdata);
+}
+
+/* Bricks copy whole stripes, so a copy whose length is not a multiple of the
+ * stripe size also copies the padding of the last stripe of the source. That
+ * is only allowed when the copy reaches the end of the source and nothing
+ * after it in the destination needs to be preserved. */
+static int32_t
+ec_copy_file_range_adjust(ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+    uint64_t size_in, size_out;
+
+    /* These shouldn't fail because both inodes are locked. */
+    GF_ASSERT(ec_get_inode_size(fop, fop->fd_in->inode, &size_in));
+    GF_ASSERT(ec_get_inode_size(fop, fop->fd->inode, &size_out));
+
+    if (fop->offset_in >= size_in) {
+        fop->user_size = 0;
+    } else if (fop->offset_in + fop->user_size > size_in) {
+        fop->user_size = size_in - fop->offset_in;
+    }
+
+    fop->size = fop->user_size;
+    if (ec_adjust_size_up(ec, &fop->size, _gf_false) != 0) {
+        if ((fop->offset_in + fop->user_size < size_in) ||
+            (fop->offset + fop->user_size < size_out)) {
+            return EXDEV;
+        }
+    }
+
+    return 0;
+}
+
+int32_t
+ec_manager_copy_file_range(ec_fop_data_t *fop, int32_t state)
+{
+    ec_t *ec = fop->xl->private;
+    ec_cbk_data_t *cbk = NULL;
+    uint64_t size;
+    int32_t err;
+
+    switch (state) {
+        case EC_STATE_INIT:
+            /* Source and destination ranges of the same file could be in
+             * the same stripe. Let the caller do a regular copy instead. */
+            if ((fop->fd_in->inode == fop->fd->inode) ||
+                ((fop->offset_in % ec->stripe_size) != 0) ||
+                ((fop->offset % ec->stripe_size) != 0)) {
+                ec_fop_set_error(fop, EXDEV);
+                return EC_STATE_REPORT;
+            }
+            fop->user_size = fop->size;
+            ec_adjust_size_up(ec, &fop->size, _gf_false);
+
+            /* Fall through */
+
+        case EC_STATE_LOCK:
+            ec_lock_prepare_fd(fop, fop->fd_in, EC_QUERY_INFO, fop->offset_in,
+                               fop->size);
+            ec_lock_prepare_fd(fop, fop->fd,
+                               EC_UPDATE_DATA | EC_UPDATE_META | EC_QUERY_INFO,
+                               fop->offset, fop->size);
+            ec_lock(fop);
+
+            return EC_STATE_DISPATCH;
+
+        case EC_STATE_DISPATCH:
+            err = ec_copy_file_range_adjust(fop);
+            if (err != 0) {
+                ec_fop_set_error(fop, err);
+                return EC_STATE_REPORT;
+            }
+
+            ec_dispatch_all(fop);
+
+            return EC_STATE_PREPARE_ANSWER;
+
+        case EC_STATE_PREPARE_ANSWER:
+            cbk = ec_fop_prepare_answer(fop, _gf_false);
+            if (cbk != NULL) {
+                ec_iatt_rebuild(ec, cbk->iatt, 3, cbk->count);
+
+                if (fop->error == 0) {
+                    cbk->op_ret *= ec->fragments;
+                    if (cbk->op_ret > fop->user_size) {
+                        cbk->op_ret = fop->user_size;
+                    }
+                }
+
+                /* These shouldn't fail because we have the inodes locked. */
+                GF_ASSERT(ec_get_inode_size(fop, fop->fd_in->inode,
+                                            &cbk->iatt[0].ia_size));
+
+                LOCK(&fop->fd->inode->lock);
+                {
+                    GF_ASSERT(__ec_get_inode_size(fop, fop->fd->inode,
+                                                  &cbk->iatt[1].ia_size));
+                    cbk->iatt[2].ia_size = cbk->iatt[1].ia_size;
+                    size = fop->offset + cbk->op_ret;
+                    if ((fop->error == 0) && (size > cbk->iatt[1].ia_size)) {
+                        GF_ASSERT(
+                            __ec_set_inode_size(fop, fop->fd->inode, size));
+                        cbk->iatt[2].ia_size = size;
+                    }
+                }
+                UNLOCK(&fop->fd->inode->lock);
+            }
+
+            return EC_STATE_REPORT;
+
+        case EC_STATE_REPORT:
+            cbk = fop->answer;
+
+            GF_ASSERT(cbk != NULL);
+
+            if (fop->cbks.copy_file_range != NULL) {
+                QUORUM_CBK(fop->cbks.copy_file_range, fop, fop->req_frame, fop,
+                           fop->xl, cbk->op_ret, cbk->op_errno, &cbk->iatt[0],
+                           &cbk->iatt[1], &cbk->iatt[2], cbk->xdata);
+            }
+
+            return EC_STATE_LOCK_REUSE;
+
+        case -EC_STATE_INIT:
+        case -EC_STATE_LOCK:
+        case -EC_STATE_DISPATCH:
+        case -EC_STATE_PREPARE_ANSWER:
+        case -EC_STATE_REPORT:
+            GF_ASSERT(fop->error != 0);
+
+            if (fop->cbks.copy_file_range != NULL) {
+                fop->cbks.copy_file_range(fop->req_frame, fop, fop->xl, -1,
+                                          fop->error, NULL, NULL, NULL, NULL);
+            }
+
+            return EC_STATE_LOCK_REUSE;
+
+        case -EC_STATE_LOCK_REUSE:
+        case EC_STATE_LOCK_REUSE:
+            ec_lock_reuse(fop);
+
+            return EC_STATE_UNLOCK;
+
+        case -EC_STATE_UNLOCK:
+        case EC_STATE_UNLOCK:
+            ec_unlock(fop);
+
+            return EC_STATE_END;
+
+        default:
+            gf_msg(fop->xl->name, GF_LOG_ERROR, EINVAL, EC_MSG_UNHANDLED_STATE,
+                   "Unhandled state %d for %s", state, ec_fop_name(fop->id));
+
+            return EC_STATE_END;
+    }
+}
+
+void
+ec_copy_file_range(call_frame_t *frame, xlator_t *this, uintptr_t target,
+                   uint32_t fop_flags, fop_copy_file_range_cbk_t func,
+                   void *data, fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                   off_t off_out, size_t len, uint32_t flags, dict_t *xdata)
+{
+    ec_cbk_t callback = {.copy_file_range = func};
+    ec_fop_data_t *fop = NULL;
+    int32_t error = ENOMEM;
+
+    gf_msg_trace("ec", 0, "EC(COPY_FILE_RANGE) %p", frame);
+
+    VALIDATE_OR_GOTO(this, out);
+    GF_VALIDATE_OR_GOTO(this->name, frame, out);
+    GF_VALIDATE_OR_GOTO(this->name, this->private, out);
+
+    fop = ec_fop_data_allocate(frame, this, GF_FOP_COPY_FILE_RANGE, 0, target,
+                               fop_flags, ec_wind_copy_file_range,
+                               ec_manager_copy_file_range, callback, data);
+    if (fop == NULL) {
+        goto out;
+    }
+
+    fop->use_fd = 1;
+    fop->offset_in = off_in;
+    fop->offset = off_out;
+    fop->size = len;
+    fop->uint32 = flags;
+
+    fop->fd_in = fd_ref(fd_in);
+    fop->fd = fd_ref(fd_out);
+
+    if (xdata != NULL) {
+        fop->xdata = dict_ref(xdata);
+        if (fop->xdata == NULL) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, EC_MSG_DICT_REF_FAIL,
+                   "Failed to reference a "
+                   "dictionary.");
+            goto out;
+        }
+    }
+
+    error = 0;
+
+out:
+    if (fop != NULL) {
+        ec_manager(fop, error);
+    } else {
+        func(frame, NULL, this, -1, error, NULL, NULL, NULL, NULL);
+    }
+}
+
 /*********************************************************************
  *
  * File Operation : Discard
@@ -1821,13 +2095,38 @@ out:
     return -1;
 }
 
+/* The data of the user can be encoded in place if it only contains full
+ * stripes and each of its buffers is properly aligned. The encoder processes
+ * one stripe at a time, so the data doesn't need to be contiguous. */
+static gf_boolean_t
+ec_writev_in_place(ec_t *ec, ec_fop_data_t *fop)
+{
+    int32_t i;
+
+    if ((fop->head != 0) || (fop->size > fop->user_size)) {
+        return _gf_false;
+    }
+
+    for (i = 0; i < fop->int32; i++) {
+        if (!EC_ALIGN_CHECK(fop->vector[i].iov_base, EC_METHOD_WORD_SIZE) ||
+            ((fop->vector[i].iov_len % ec->stripe_size) != 0)) {
+            return _gf_false;
+        }
+    }
+
+    return _gf_true;
+}
+
+/* After this function, fop->vector contains the data to write followed by
+ * an additional entry for the buffer of the encoded fragments. fop->int32
+ * is updated to the total number of entries. */
 static int32_t
 ec_writev_prepare_buffers(ec_t *ec, ec_fop_data_t *fop)
 {
     struct iobref *iobref = NULL;
     struct iovec *iov;
     void *ptr;
-    int32_t err;
+    int32_t err, count;
 
     fop->user_size = iov_length(fop->vector, fop->int32);
     fop->head = ec_adjust_offset_down(ec, &fop->offset, _gf_false);
@@ -1836,8 +2135,8 @@ ec_writev_prepare_buffers(ec_t *ec, ec_fop_data_t *fop)
     ec_adjust_size_up(ec, &fop->size, _gf_false);
     fop->frag_range.last = fop->frag_range.first + fop->size / ec->fragments;
 
-    if ((fop->int32 != 1) || (fop->head != 0) || (fop->size > fop->user_size) ||
-        !EC_ALIGN_CHECK(fop->vector[0].iov_base, EC_METHOD_WORD_SIZE)) {
+    count = fop->int32;
+    if (!ec_writev_in_place(ec, fop)) {
         err = ec_buffer_alloc(ec->xl, fop->size, &iobref, &ptr);
         if (err != 0) {
             goto out;
@@ -1848,28 +2147,28 @@ ec_writev_prepare_buffers(ec_t *ec, ec_fop_data_t *fop)
 
         fop->vector[0].iov_base = ptr;
         fop->vector[0].iov_len = fop->size;
+        count = 1;
 
         iobref_unref(fop->buffers);
         fop->buffers = iobref;
     }
 
-    if (fop->int32 != 2) {
-        iov = GF_MALLOC(VECTORSIZE(2), gf_common_mt_iovec);
-        if (iov == NULL) {
-            err = -ENOMEM;
-
-            goto out;
-        }
-        iov[0].iov_base = fop->vector[0].iov_base;
-        iov[0].iov_len = fop->vector[0].iov_len;
+    iov = GF_MALLOC(VECTORSIZE(count + 1), gf_common_mt_iovec);
+    if (iov == NULL) {
+        err = -ENOMEM;
 
-        GF_FREE(fop->vector);
-        fop->vector = iov;
+        goto out;
     }
+    memcpy(iov, fop->vector, VECTORSIZE(count));
+
+    GF_FREE(fop->vector);
+    fop->vector = iov;
+    fop->int32 = count + 1;
 
-    fop->vector[1].iov_len = fop->size / ec->fragments;
-    err = ec_buffer_alloc(ec->xl, fop->vector[1].iov_len * ec->nodes,
-                          &fop->buffers, &fop->vector[1].iov_base);
+    iov = EC_WRITEV_FRAGMENTS(fop);
+    iov->iov_len = fop->size / ec->fragments;
+    err = ec_buffer_alloc(ec->xl, iov->iov_len * ec->nodes, &fop->buffers,
+                          &iov->iov_base);
     if (err != 0) {
         goto out;
     }
@@ -2111,9 +2410,9 @@ ec_wind_writev(ec_t *ec, ec_fop_data_t *fop, int32_t idx)
     struct iovec vector[1];
     size_t size;
 
-    size = fop->vector[1].iov_len;
+    size = EC_WRITEV_FRAGMENTS(fop)->iov_len;
 
-    vector[0].iov_base = fop->vector[1].iov_base + idx * size;
+    vector[0].iov_base = EC_WRITEV_FRAGMENTS(fop)->iov_base + idx * size;
     vector[0].iov_len = size;
 
     STACK_WIND_COOKIE(fop->frame, ec_writev_cbk, (void *)(uintptr_t)idx,
@@ -2128,13 +2427,18 @@ ec_writev_encode(ec_fop_data_t *fop)
     ec_t *ec = fop->xl->private;
     void *blocks[ec->nodes];
     uint32_t i;
+    int32_t j;
 
-    blocks[0] = fop->vector[1].iov_base;
+    blocks[0] = EC_WRITEV_FRAGMENTS(fop)->iov_base;
     for (i = 1; i < ec->nodes; i++) {
-        blocks[i] = blocks[i - 1] + fop->vector[1].iov_len;
+        blocks[i] = blocks[i - 1] + EC_WRITEV_FRAGMENTS(fop)->iov_len;
+    }
+    /* ec_method_encode() advances the pointers in 'blocks', so each buffer
+     * is encoded just after the previous one. */
+    for (j = 0; j < fop->int32 - 1; j++) {
+        ec_method_encode(&ec->matrix, fop->vector[j].iov_len,
+                         fop->vector[j].iov_base, blocks);
     }
-    ec_method_encode(&ec->matrix, fop->vector[0].iov_len,
-                     fop->vector[0].iov_base, blocks);
 }
 
 int32_t
@@ -2367,3 +2671,267 @@ out:
         func(frame, NULL, this, -1, error, NULL, NULL, NULL);
     }
 }
+
+/* Write coalescing.
+ *
+ * A write that doesn't cover full stripes needs to read the partial stripes
+ * before encoding them. Small sequential writes to the same stripe are also
+ * serialized by the lock, so each of them pays for the read. When another
+ * operation on the inode is already in progress, such a write is held in the
+ * inode context instead of being processed, and the writes that come later
+ * and are contiguous to it are merged with it. The held writes are sent as a
+ * single write when an owner of the inode lock finishes, when they end on a
+ * stripe boundary, when a write that can't be merged arrives, or on fsync or
+ * flush. Writes are only merged when they carry the same xdata, which is sent
+ * with the merged write, and its answer is given to all of them. The original
+ * writes are only answered when the merged one has completed, so this doesn't
+ * change what the application sees. */
+
+struct _ec_write_batch {
+    struct list_head stubs;
+    off_t offset;
+};
+
+typedef struct _ec_write_batch ec_write_batch_t;
+
+static int32_t
+ec_writev_coalesce_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                       struct iatt *postbuf, dict_t *xdata)
+{
+    ec_write_batch_t *batch = frame->local;
+    call_stub_t *stub, *tmp;
+    uint64_t size, pos;
+    int32_t ret;
+
+    frame->local = NULL;
+
+    list_for_each_entry_safe(stub, tmp, &batch->stubs, list)
+    {
+        list_del_init(&stub->list);
+
+        /* Each write is answered with the part of the merged write that
+         * covers it. */
+        ret = op_ret;
+        if (op_ret >= 0) {
+            size = iov_length(stub->args.vector, stub->args.count);
+            pos = stub->args.offset - batch->offset;
+            ret = 0;
+            if (op_ret > pos) {
+                ret = min(op_ret - pos, size);
+            }
+        }
+
+        STACK_UNWIND_STRICT(writev, stub->frame, ret, op_errno, prebuf,
+                            postbuf, xdata);
+
+        call_stub_destroy(stub);
+    }
+
+    GF_FREE(batch);
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+static int32_t
+ec_writev_coalesce_wind(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        struct iovec *vector, int32_t count, off_t offset,
+                        uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+    ec_writev(frame, this, -1, EC_MINIMUM_MIN, default_writev_cbk, NULL, fd,
+              vector, count, offset, flags, iobref, xdata);
+
+    return 0;
+}
+
+void
+ec_writev_coalesce_send(xlator_t *this, struct list_head *list)
+{
+    ec_t *ec = this->private;
+    ec_write_batch_t *batch = NULL;
+    call_stub_t *stub, *tmp, *first;
+    call_frame_t *frame = NULL;
+    struct iobref *iobref = NULL;
+    struct iovec *vector = NULL;
+    int32_t count;
+
+    if (list_empty(list)) {
+        return;
+    }
+
+    first = list_first_entry(list, call_stub_t, list);
+    if (first->list.next == list) {
+        /* Nothing to merge. */
+        call_resume(first);
+
+        return;
+    }
+
+    count = 0;
+    list_for_each_entry(stub, list, list)
+    {
+        count += stub->args.count;
+    }
+
+    batch = GF_MALLOC(sizeof(*batch), ec_mt_ec_write_batch_t);
+    vector = GF_MALLOC(VECTORSIZE(count), gf_common_mt_iovec);
+    iobref = iobref_new();
+    frame = copy_frame(first->frame);
+    if ((batch == NULL) || (vector == NULL) || (iobref == NULL) ||
+        (frame == NULL)) {
+        goto failed;
+    }
+
+    count = 0;
+    list_for_each_entry(stub, list, list)
+    {
+        memcpy(vector + count, stub->args.vector,
+               VECTORSIZE(stub->args.count));
+        count += stub->args.count;
+
+        if ((stub->args.iobref != NULL) &&
+            (iobref_merge(iobref, stub->args.iobref) != 0)) {
+            goto failed;
+        }
+    }
+
+    INIT_LIST_HEAD(&batch->stubs);
+    list_splice_init(list, &batch->stubs);
+    batch->offset = first->args.offset;
+
+    frame->local = batch;
+
+    GF_ATOMIC_INC(ec->stats.write_coalesce.batches);
+
+    /* The merged write goes through ec_gf_writev() again, but it won't be
+     * held because it's wound from ec itself. */
+    STACK_WIND(frame, ec_writev_coalesce_cbk, this, this->fops->writev,
+               first->args.fd, vector, count, batch->offset, first->args.flags,
+               iobref, first->args.xdata);
+
+    iobref_unref(iobref);
+    GF_FREE(vector);
+
+    return;
+
+failed:
+    if (frame != NULL) {
+        STACK_DESTROY(frame->root);
+    }
+    if (iobref != NULL) {
+        iobref_unref(iobref);
+    }
+    GF_FREE(vector);
+    GF_FREE(batch);
+
+    /* Send the writes one by one. */
+    list_for_each_entry_safe(stub, tmp, list, list)
+    {
+        call_resume(stub);
+    }
+}
+
+gf_boolean_t
+ec_writev_coalesce(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   struct iovec *vector, int32_t count, off_t offset,
+                   uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+    struct list_head list;
+    ec_t *ec = this->private;
+    ec_inode_t *ctx;
+    call_stub_t *stub, *first;
+    uint64_t size;
+    gf_boolean_t held = _gf_false;
+
+    if (!ec->write_coalesce || (fd == NULL) || ((fd->flags & O_APPEND) != 0)) {
+        return _gf_false;
+    }
+
+    /* Merged writes sent by ec_writev_coalesce_send(). */
+    if ((frame->parent != NULL) && (frame->parent->this == this)) {
+        return _gf_false;
+    }
+
+    size = iov_length(vector, count);
+    if ((size == 0) || (size >= EC_WRITE_COALESCE_MAX_SIZE) ||
+        (((offset % ec->stripe_size) == 0) &&
+         (((offset + size) % ec->stripe_size) == 0))) {
+        return _gf_false;
+    }
+
+    INIT_LIST_HEAD(&list);
+
+    LOCK(&fd->inode->lock);
+
+    ctx = __ec_inode_get(fd->inode, this);
+    if (ctx == NULL) {
+        goto unlock;
+    }
+
+    if (!list_empty(&ctx->coalesce)) {
+        first = list_first_entry(&ctx->coalesce, call_stub_t, list);
+        if ((first->args.fd != fd) || (first->args.flags != flags) ||
+            (ctx->coalesce_end != offset) ||
+            (ctx->coalesce_size + size > EC_WRITE_COALESCE_MAX_SIZE) ||
+            !are_dicts_equal(first->args.xdata, xdata, NULL, NULL)) {
+            /* This write can't be merged. The held writes are sent before
+             * it. */
+            list_splice_init(&ctx->coalesce, &list);
+            goto unlock;
+        }
+    } else if ((ctx->inode_lock == NULL) ||
+               list_empty(&ctx->inode_lock->owners)) {
+        /* Nothing is in progress, so there's no reason to wait. */
+        goto unlock;
+    } else {
+        ctx->coalesce_size = 0;
+    }
+
+    stub = fop_writev_stub(frame, ec_writev_coalesce_wind, fd, vector, count,
+                           offset, flags, iobref, xdata);
+    if (stub == NULL) {
+        list_splice_init(&ctx->coalesce, &list);
+        goto unlock;
+    }
+
+    list_add_tail(&stub->list, &ctx->coalesce);
+    ctx->coalesce_end = offset + size;
+    ctx->coalesce_size += size;
+    held = _gf_true;
+
+    if ((ctx->coalesce_end % ec->stripe_size) == 0) {
+        list_splice_init(&ctx->coalesce, &list);
+    }
+
+unlock:
+    UNLOCK(&fd->inode->lock);
+
+    if (held) {
+        GF_ATOMIC_INC(ec->stats.write_coalesce.held);
+    }
+
+    ec_writev_coalesce_send(this, &list);
+
+    return held;
+}
+
+void
+ec_writev_coalesce_flush(xlator_t *this, inode_t *inode)
+{
+    struct list_head list;
+    ec_inode_t *ctx;
+
+    INIT_LIST_HEAD(&list);
+
+    LOCK(&inode->lock);
+
+    ctx = __ec_inode_get(inode, this);
+    if (ctx != NULL) {
+        list_splice_init(&ctx->coalesce, &list);
+    }
+
+    UNLOCK(&inode->lock);
+
+    ec_writev_coalesce_send(this, &list);
+}
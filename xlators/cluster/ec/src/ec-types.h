@@ -114,6 +114,9 @@ typedef struct _ec_matrix_list ec_matrix_list_t;
 struct _ec_heal;
 typedef struct _ec_heal ec_heal_t;
 
+struct _ec_heal_window;
+typedef struct _ec_heal_window ec_heal_window_t;
+
 struct _ec_self_heald;
 typedef struct _ec_self_heald ec_self_heald_t;
 
@@ -186,6 +189,9 @@ struct _ec_inode {
     struct list_head heal;
     ec_stripe_list_t stripe_cache;
     uint64_t bad_version;
+    struct list_head coalesce; /* Stubs of the writes held to be merged. */
+    uint64_t coalesce_end;     /* Offset where the held writes end. */
+    uint64_t coalesce_size;    /* Total size of the held writes. */
 };
 
 typedef int32_t (*fop_heal_cbk_t)(call_frame_t *, void *, xlator_t *, int32_t,
@@ -197,6 +203,7 @@ typedef int32_t (*fop_fheal_cbk_t)(call_frame_t *, void *, xlator_t *, int32_t,
 
 union _ec_cbk {
     fop_access_cbk_t access;
+    fop_copy_file_range_cbk_t copy_file_range;
     fop_create_cbk_t create;
     fop_discard_cbk_t discard;
     fop_entrylk_cbk_t entrylk;
@@ -378,6 +385,8 @@ struct _ec_fop_data {
     inode_t *inode;
     fd_t *fd; /* FD of the file on which FOP is
                  being carried upon */
+    fd_t *fd_in;     /* Source FD of copy_file_range */
+    off_t offset_in; /* Offset in fd_in */
     struct iatt iatt;
     char *str[2];
     loc_t loc[2]; /* Holds the location details for
@@ -388,6 +397,11 @@ struct _ec_fop_data {
     gf_seek_what_t seek;
     ec_fragment_range_t frag_range; /* This will hold the range of stripes
                                         affected by the fop. */
+    gf_boolean_t hedging;           /* Read that can be hedged. */
+    uint32_t hedge_idx;             /* Brick of the hedged request. */
+    struct timespec hedge_start[2]; /* Time of the dispatch and of the
+                                       hedged request. */
+    gf_timer_t *hedge_timer;        /* Deadline of the read. */
     char *errstr;                   /*String of fop name, path and gfid
                                      to be used in gf_msg. */
 };
@@ -585,6 +599,16 @@ struct _ec_heal {
     uint64_t total_size;
     uint64_t version[2];
     uint64_t raw_size;
+    uint64_t end;              /* End of the data being rebuilt. */
+    ec_heal_window_t *windows; /* Blocks being healed in parallel. */
+    uint32_t depth;            /* Number of entries in 'windows'. */
+};
+
+/* A block of a file that is being healed. */
+struct _ec_heal_window {
+    ec_heal_t *heal;
+    uint64_t offset;
+    uint64_t size;
 };
 
 struct subvol_healer {
@@ -625,10 +649,23 @@ struct _ec_statistics {
                                 requests. (Basically memory allocation
                                 errors). */
     } stripe_cache;
+    struct {
+        gf_atomic_t held;    /* Writes held to be merged with others. */
+        gf_atomic_t batches; /* Writes sent merging several held ones. */
+    } write_coalesce;
+    struct {
+        gf_atomic_t sent; /* Reads sent to an extra brick because the
+                             others were late. */
+        gf_atomic_t won;  /* Hedged reads completed without waiting for
+                             the late brick. */
+    } hedge;
     struct {
         gf_atomic_t attempted; /*Number of heals attempted on
                                 files/directories*/
         gf_atomic_t completed; /*Number of heals complted on files/directories*/
+        gf_atomic_t healed_bytes; /* Data written to bad bricks. */
+        gf_atomic_t heal_time;    /* Time (in microseconds) during which
+                                     at least one data heal was running. */
     } shd;
 };
 
@@ -636,6 +673,8 @@ struct _ec {
     xlator_t *xl;
     int32_t healers;
     int32_t heal_waiters;
+    int32_t data_healers; /* Files whose data is being rebuilt. */
+    struct timespec data_heal_start;
     int32_t nodes; /* Total number of bricks(n) */
     int32_t bits_for_nodes;
     int32_t fragments;      /* Data bricks(k) */
@@ -658,6 +697,7 @@ struct _ec {
     uintptr_t read_mask;         /*Stores user defined read-mask*/
     gf_atomic_t async_fop_count; /* Number of on going asynchronous fops. */
     xlator_t **xl_list;
+    cluster_read_latency_t *read_latency; /* Per brick, for hedged reads. */
     gf_lock_t lock;
     gf_timer_t *timer;
     gf_boolean_t shutdown;
@@ -665,11 +705,14 @@ struct _ec {
     gf_boolean_t other_eager_lock;
     gf_boolean_t optimistic_changelog;
     gf_boolean_t parallel_writes;
+    gf_boolean_t write_coalesce;
+    gf_boolean_t hedge_reads;
     uint32_t stripe_cache;
     uint32_t quorum_count;
     uint32_t background_heals;
     uint32_t heal_wait_qlen;
     uint32_t self_heal_window_size; /* max size of read/writes */
+    uint32_t self_heal_pipeline_depth; /* windows healed in parallel */
     time_t eager_lock_timeout;
     time_t other_eager_lock_timeout;
     struct list_head pending_fops;
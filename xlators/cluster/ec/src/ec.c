@@ -107,11 +107,20 @@ ec_prepare_childs(xlator_t *this)
 
         return ENOMEM;
     }
+    ec->read_latency = GF_CALLOC(count, sizeof(ec->read_latency[0]),
+                                 ec_mt_read_latency_t);
+    if (ec->read_latency == NULL) {
+        gf_msg(this->name, GF_LOG_ERROR, ENOMEM, EC_MSG_NO_MEMORY,
+               "Allocation of read latencies failed");
+
+        return ENOMEM;
+    }
     ec->xl_up = 0;
     ec->xl_up_count = 0;
 
     count = 0;
     for (child = this->children; child != NULL; child = child->next) {
+        cluster_read_latency_init(&ec->read_latency[count]);
         ec->xl_list[count++] = child->xlator;
     }
 
@@ -151,6 +160,7 @@ void
 __ec_destroy_private(xlator_t *this)
 {
     ec_t *ec = this->private;
+    int32_t i;
 
     if (ec != NULL) {
         LOCK(&ec->lock);
@@ -178,6 +188,14 @@ __ec_destroy_private(xlator_t *this)
             ec->xl_list = NULL;
         }
 
+        if (ec->read_latency != NULL) {
+            for (i = 0; i < ec->nodes; i++) {
+                cluster_read_latency_fini(&ec->read_latency[i]);
+            }
+            GF_FREE(ec->read_latency);
+            ec->read_latency = NULL;
+        }
+
         if (ec->fop_pool != NULL) {
             mem_pool_destroy(ec->fop_pool);
         }
@@ -270,6 +288,8 @@ reconfigure(xlator_t *this, dict_t *options)
                      failed);
     GF_OPTION_RECONF("self-heal-window-size", ec->self_heal_window_size,
                      options, uint32, failed);
+    GF_OPTION_RECONF("self-heal-pipeline-depth", ec->self_heal_pipeline_depth,
+                     options, uint32, failed);
     GF_OPTION_RECONF("heal-timeout", ec->shd.timeout, options, time, failed);
     ec_configure_background_heal_opts(ec, background_heals, heal_wait_qlen);
     GF_OPTION_RECONF("shd-max-threads", ec->shd.max_threads, options, uint32,
@@ -284,6 +304,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("parallel-writes", ec->parallel_writes, options, bool,
                      failed);
     GF_OPTION_RECONF("stripe-cache", ec->stripe_cache, options, uint32, failed);
+    GF_OPTION_RECONF("write-coalesce", ec->write_coalesce, options, bool,
+                     failed);
+    GF_OPTION_RECONF("hedge-reads", ec->hedge_reads, options, bool, failed);
     GF_OPTION_RECONF("quorum-count", ec->quorum_count, options, uint32, failed);
     ret = 0;
     if (ec_assign_read_policy(ec, read_policy)) {
@@ -709,8 +732,14 @@ ec_statistics_init(ec_t *ec)
     GF_ATOMIC_INIT(ec->stats.stripe_cache.evicts, 0);
     GF_ATOMIC_INIT(ec->stats.stripe_cache.allocs, 0);
     GF_ATOMIC_INIT(ec->stats.stripe_cache.errors, 0);
+    GF_ATOMIC_INIT(ec->stats.write_coalesce.held, 0);
+    GF_ATOMIC_INIT(ec->stats.write_coalesce.batches, 0);
+    GF_ATOMIC_INIT(ec->stats.hedge.sent, 0);
+    GF_ATOMIC_INIT(ec->stats.hedge.won, 0);
     GF_ATOMIC_INIT(ec->stats.shd.attempted, 0);
     GF_ATOMIC_INIT(ec->stats.shd.completed, 0);
+    GF_ATOMIC_INIT(ec->stats.shd.healed_bytes, 0);
+    GF_ATOMIC_INIT(ec->stats.shd.heal_time, 0);
 }
 
 static int
@@ -854,6 +883,8 @@ init(xlator_t *this)
     GF_OPTION_INIT("heal-wait-qlength", ec->heal_wait_qlen, uint32, failed);
     GF_OPTION_INIT("self-heal-window-size", ec->self_heal_window_size, uint32,
                    failed);
+    GF_OPTION_INIT("self-heal-pipeline-depth", ec->self_heal_pipeline_depth,
+                   uint32, failed);
     ec_configure_background_heal_opts(ec, ec->background_heals,
                                       ec->heal_wait_qlen);
     GF_OPTION_INIT("read-policy", read_policy, str, failed);
@@ -867,6 +898,8 @@ init(xlator_t *this)
                    failed);
     GF_OPTION_INIT("parallel-writes", ec->parallel_writes, bool, failed);
     GF_OPTION_INIT("stripe-cache", ec->stripe_cache, uint32, failed);
+    GF_OPTION_INIT("write-coalesce", ec->write_coalesce, bool, failed);
+    GF_OPTION_INIT("hedge-reads", ec->hedge_reads, bool, failed);
     GF_OPTION_INIT("quorum-count", ec->quorum_count, uint32, failed);
     GF_OPTION_INIT("ec-read-mask", read_mask_str, str, failed);
 
@@ -985,9 +1018,23 @@ ec_gf_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
     return 0;
 }
 
+int32_t
+ec_gf_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                      off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                      uint32_t flags, dict_t *xdata)
+{
+    ec_copy_file_range(frame, this, -1, EC_MINIMUM_MIN,
+                       default_copy_file_range_cbk, NULL, fd_in, off_in, fd_out,
+                       off_out, len, flags, xdata);
+
+    return 0;
+}
+
 int32_t
 ec_gf_flush(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 {
+    ec_writev_coalesce_flush(this, fd->inode);
+
     ec_flush(frame, this, -1, EC_MINIMUM_MIN, default_flush_cbk, NULL, fd,
              xdata);
 
@@ -998,6 +1045,8 @@ int32_t
 ec_gf_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
             dict_t *xdata)
 {
+    ec_writev_coalesce_flush(this, fd->inode);
+
     ec_fsync(frame, this, -1, EC_MINIMUM_MIN, default_fsync_cbk, NULL, fd,
              datasync, xdata);
 
@@ -1427,6 +1476,11 @@ ec_gf_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
              struct iovec *vector, int32_t count, off_t offset, uint32_t flags,
              struct iobref *iobref, dict_t *xdata)
 {
+    if (ec_writev_coalesce(frame, this, fd, vector, count, offset, flags,
+                           iobref, xdata)) {
+        return 0;
+    }
+
     ec_writev(frame, this, -1, EC_MINIMUM_MIN, default_writev_cbk, NULL, fd,
               vector, count, offset, flags, iobref, xdata);
 
@@ -1490,6 +1544,7 @@ ec_gf_forget(xlator_t *this, inode_t *inode)
         /* We can only forget an inode if it has been unlocked, so the stripe
          * cache should also be empty. */
         GF_ASSERT(list_empty(&ctx->stripe_cache.lru));
+        GF_ASSERT(list_empty(&ctx->coalesce));
         GF_FREE(ctx);
     }
 
@@ -1531,6 +1586,8 @@ ec_dump_private(xlator_t *this)
     ec_t *ec = NULL;
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
     char tmp[65];
+    struct timespec now;
+    uint64_t healed_bytes, heal_time;
 
     GF_ASSERT(this);
 
@@ -1555,10 +1612,14 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heal-wait-qlength", "%d", ec->heal_wait_qlen);
     gf_proc_dump_write("self-heal-window-size", "%" PRIu32,
                        ec->self_heal_window_size);
+    gf_proc_dump_write("self-heal-pipeline-depth", "%" PRIu32,
+                       ec->self_heal_pipeline_depth);
     gf_proc_dump_write("healers", "%d", ec->healers);
     gf_proc_dump_write("heal-waiters", "%d", ec->heal_waiters);
     gf_proc_dump_write("read-policy", "%s", ec_read_policies[ec->read_policy]);
     gf_proc_dump_write("parallel-writes", "%d", ec->parallel_writes);
+    gf_proc_dump_write("write-coalesce", "%d", ec->write_coalesce);
+    gf_proc_dump_write("hedge-reads", "%d", ec->hedge_reads);
     gf_proc_dump_write("quorum-count", "%u", ec->quorum_count);
 
     snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.stripe_cache",
@@ -1579,11 +1640,35 @@ ec_dump_private(xlator_t *this)
                        GF_ATOMIC_GET(ec->stats.stripe_cache.allocs));
     gf_proc_dump_write("errors", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(ec->stats.stripe_cache.errors));
+    gf_proc_dump_write("coalesce-held", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.write_coalesce.held));
+    gf_proc_dump_write("coalesce-batches", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.write_coalesce.batches));
+    gf_proc_dump_write("hedges-sent", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.hedge.sent));
+    gf_proc_dump_write("hedges-won", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.hedge.won));
     gf_proc_dump_write("heals-attempted", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(ec->stats.shd.attempted));
     gf_proc_dump_write("heals-completed", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(ec->stats.shd.completed));
 
+    LOCK(&ec->lock);
+    {
+        healed_bytes = GF_ATOMIC_GET(ec->stats.shd.healed_bytes);
+        heal_time = GF_ATOMIC_GET(ec->stats.shd.heal_time);
+        if (ec->data_healers > 0) {
+            timespec_now(&now);
+            heal_time += gf_tsdiff(&ec->data_heal_start, &now) / 1000;
+        }
+    }
+    UNLOCK(&ec->lock);
+    gf_proc_dump_write("heal-bytes", "%" PRIu64, healed_bytes);
+    gf_proc_dump_write("heal-time-usec", "%" PRIu64, heal_time);
+    /* Bytes per second while data heals were running. */
+    gf_proc_dump_write("heal-throughput", "%" PRIu64,
+                       heal_time ? healed_bytes * 1000000 / heal_time : 0);
+
     return 0;
 }
 
@@ -1628,6 +1713,7 @@ struct xlator_fops fops = {.lookup = ec_gf_lookup,
                            .setattr = ec_gf_setattr,
                            .fsetattr = ec_gf_fsetattr,
                            .fallocate = ec_gf_fallocate,
+                           .copy_file_range = ec_gf_copy_file_range,
                            .discard = ec_gf_discard,
                            .zerofill = ec_gf_zerofill,
                            .seek = ec_gf_seek,
@@ -1781,7 +1867,7 @@ struct volume_options options[] = {
                     " that can wait in SHD per subvolume"},
     {.key = {"cpu-extensions"},
      .type = GF_OPTION_TYPE_STR,
-     .value = {"none", "auto", "x64", "sse", "avx"},
+     .value = {"none", "auto", "x64", "sse", "avx", "avx512"},
      .default_value = "auto",
      .op_version = {GD_OP_VERSION_3_9_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
@@ -1798,6 +1884,19 @@ struct volume_options options[] = {
      .tags = {"disperse"},
      .description = "Maximum number blocks(128KB) per file for which "
                     "self-heal process would be applied simultaneously."},
+    {.key = {"self-heal-pipeline-depth"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "1",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Number of self-heal windows of a file that are read "
+                    "from the healthy bricks and written to the bad ones in "
+                    "parallel. Each file being healed can use up to this "
+                    "many windows of memory. Combined with shd-max-threads, "
+                    "this controls the number of heal requests in flight."},
     {.key = {"optimistic-change-log"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
@@ -1833,6 +1932,30 @@ struct volume_options options[] = {
                     "specially for sequential writes. However, this will also"
                     "lead to extra memory consumption, maximum "
                     "(cache size * stripe size) Bytes per open file."},
+    {.key = {"write-coalesce"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Writes that don't cover full stripes, issued while "
+                    "another operation on the same file is in progress, are "
+                    "held and merged with the contiguous writes that follow "
+                    "them. This avoids reading the partial stripes for each "
+                    "of them. Writes are only answered once the merged write "
+                    "has completed."},
+    {.key = {"hedge-reads"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "If some of the bricks of a read take longer than 95% "
+                    "of their recent reads, send the read also to one of "
+                    "the remaining bricks and decode the data from the "
+                    "first fragments that arrive. This reduces the tail "
+                    "latency caused by a slow brick at the cost of some "
+                    "extra reads."},
     {
         .key = {"quorum-count"},
         .type = GF_OPTION_TYPE_INT,
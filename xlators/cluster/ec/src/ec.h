@@ -21,6 +21,8 @@
 #define EC_XATTR_HEAL_NEW EC_XATTR_PREFIX "heal-new"
 #define EC_XATTR_DIRTY EC_XATTR_PREFIX "dirty"
 #define EC_STRIPE_CACHE_MAX_SIZE 10
+/* Maximum size of the writes merged by write coalescing. */
+#define EC_WRITE_COALESCE_MAX_SIZE (128 * 1024)
 #define EC_VERSION_SIZE 2
 #define EC_SHD_INODE_LRU_LIMIT 10
 
@@ -124,6 +124,10 @@ struct ios_lat {
     double max;
     double avg;
     uint64_t total;
+    /* Percentiles, only computed when the stats are dumped. */
+    double p50;
+    double p99;
+    double p999;
 };
 
 struct ios_global_stats {
@@ -154,6 +158,11 @@ struct ios_conf {
     struct ios_global_stats cumulative;
     uint64_t increment;
     struct ios_global_stats incremental;
+    /* Distributions of the latencies of each fop, from which the
+     * percentiles of the cumulative and incremental stats are taken. They
+     * are updated without taking the lock. */
+    gf_latency_t cumulative_lat[GF_FOP_MAXVALUE];
+    gf_latency_t incremental_lat[GF_FOP_MAXVALUE];
     gf_boolean_t dump_fd_stats;
     gf_boolean_t count_fop_hits;
     gf_boolean_t measure_latency;
@@ -776,6 +785,9 @@ io_stats_dump_global_to_json_logfp(xlator_t *this,
     float fop_lat_ave;
     float fop_lat_min;
     float fop_lat_max;
+    float fop_lat_p50;
+    float fop_lat_p99;
+    float fop_lat_p999;
     double interval_sec;
     double fop_ave_usec = 0.0;
     double fop_ave_usec_sum = 0.0;
@@ -852,11 +864,18 @@ io_stats_dump_global_to_json_logfp(xlator_t *this,
         fop_lat_ave = 0.0;
         fop_lat_min = 0.0;
         fop_lat_max = 0.0;
+        fop_lat_p50 = 0.0;
+        fop_lat_p99 = 0.0;
+        fop_lat_p999 = 0.0;
+        /* Latencies are measured in ns, but these keys are in us. */
         if (fop_hits) {
             if (stats->latency[i].avg) {
-                fop_lat_ave = stats->latency[i].avg;
-                fop_lat_min = stats->latency[i].min;
-                fop_lat_max = stats->latency[i].max;
+                fop_lat_ave = stats->latency[i].avg / GF_US_IN_NS;
+                fop_lat_min = stats->latency[i].min / GF_US_IN_NS;
+                fop_lat_max = stats->latency[i].max / GF_US_IN_NS;
+                fop_lat_p50 = stats->latency[i].p50 / GF_US_IN_NS;
+                fop_lat_p99 = stats->latency[i].p99 / GF_US_IN_NS;
+                fop_lat_p999 = stats->latency[i].p999 / GF_US_IN_NS;
             }
         }
         if (interval == -1) {
@@ -874,6 +893,12 @@ io_stats_dump_global_to_json_logfp(xlator_t *this,
                 key_prefix, str_prefix, lc_fop_name, fop_lat_min);
         ios_log(this, logfp, "\"%s.%s.fop.%s.latency_max_usec\": %0.2lf,",
                 key_prefix, str_prefix, lc_fop_name, fop_lat_max);
+        ios_log(this, logfp, "\"%s.%s.fop.%s.latency_p50_usec\": %0.2lf,",
+                key_prefix, str_prefix, lc_fop_name, fop_lat_p50);
+        ios_log(this, logfp, "\"%s.%s.fop.%s.latency_p99_usec\": %0.2lf,",
+                key_prefix, str_prefix, lc_fop_name, fop_lat_p99);
+        ios_log(this, logfp, "\"%s.%s.fop.%s.latency_p999_usec\": %0.2lf,",
+                key_prefix, str_prefix, lc_fop_name, fop_lat_p999);
 
         fop_ave_usec_sum += fop_lat_ave;
         weighted_fop_ave_usec_sum += fop_hits * fop_lat_ave;
@@ -1366,10 +1391,12 @@ io_stats_dump_global_to_logfp(xlator_t *this, struct ios_global_stats *stats,
         ios_log(this, logfp, "%s\n", str_write);
     }
 
-    ios_log(this, logfp, "%-13s %10s %14s %14s %14s", "Fop", "Call Count",
-            "Avg-Latency", "Min-Latency", "Max-Latency");
-    ios_log(this, logfp, "%-13s %10s %14s %14s %14s", "---", "----------",
-            "-----------", "-----------", "-----------");
+    ios_log(this, logfp, "%-13s %10s %14s %14s %14s %14s %14s %14s", "Fop",
+            "Call Count", "Avg-Latency", "Min-Latency", "Max-Latency",
+            "P50-Latency", "P99-Latency", "P99.9-Latency");
+    ios_log(this, logfp, "%-13s %10s %14s %14s %14s %14s %14s %14s", "---",
+            "----------", "-----------", "-----------", "-----------",
+            "-----------", "-----------", "-------------");
 
     for (i = 0; i < GF_FOP_MAXVALUE; i++) {
         fop_hits = GF_ATOMIC_GET(stats->fop_hits[i]);
@@ -1377,15 +1404,18 @@ io_stats_dump_global_to_logfp(xlator_t *this, struct ios_global_stats *stats,
             ios_log(this, logfp,
                     "%-13s %10" GF_PRI_ATOMIC
                     " %11s "
-                    "us %11s us %11s us",
-                    gf_fop_list[i], fop_hits, "0", "0", "0");
+                    "ns %11s ns %11s ns %11s ns %11s ns %11s ns",
+                    gf_fop_list[i], fop_hits, "0", "0", "0", "0", "0", "0");
         else if (fop_hits && stats->latency[i].avg)
             ios_log(this, logfp,
                     "%-13s %10" GF_PRI_ATOMIC
                     " "
-                    "%11.2lf us %11.2lf us %11.2lf us",
+                    "%11.2lf ns %11.2lf ns %11.2lf ns %11.2lf ns %11.2lf ns "
+                    "%11.2lf ns",
                     gf_fop_list[i], fop_hits, stats->latency[i].avg,
-                    stats->latency[i].min, stats->latency[i].max);
+                    stats->latency[i].min, stats->latency[i].max,
+                    stats->latency[i].p50, stats->latency[i].p99,
+                    stats->latency[i].p999);
     }
 
     for (i = 0; i < GF_UPCALL_FLAGS_MAXVALUE; i++) {
@@ -1394,8 +1424,9 @@ io_stats_dump_global_to_logfp(xlator_t *this, struct ios_global_stats *stats,
             ios_log(this, logfp,
                     "%-13s %10" PRId64
                     " %11s "
-                    "us %11s us %11s us",
-                    gf_upcall_list[i], fop_hits, "0", "0", "0");
+                    "ns %11s ns %11s ns %11s ns %11s ns %11s ns",
+                    gf_upcall_list[i], fop_hits, "0", "0", "0", "0", "0",
+                    "0");
     }
 
     ios_log(this, logfp,
@@ -1586,6 +1617,33 @@ io_stats_dump_global_to_dict(xlator_t *this, struct ios_global_stats *stats,
                    gf_fop_list[i], interval, stats->latency[i].max);
             goto out;
         }
+        snprintf(key, sizeof(key), "%d-%d-p50latency", interval, i);
+        ret = dict_set_double(dict, key, stats->latency[i].p50);
+        if (ret) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "failed to set %s "
+                   "p50latency(%d) with %f",
+                   gf_fop_list[i], interval, stats->latency[i].p50);
+            goto out;
+        }
+        snprintf(key, sizeof(key), "%d-%d-p99latency", interval, i);
+        ret = dict_set_double(dict, key, stats->latency[i].p99);
+        if (ret) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "failed to set %s "
+                   "p99latency(%d) with %f",
+                   gf_fop_list[i], interval, stats->latency[i].p99);
+            goto out;
+        }
+        snprintf(key, sizeof(key), "%d-%d-p999latency", interval, i);
+        ret = dict_set_double(dict, key, stats->latency[i].p999);
+        if (ret) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "failed to set %s "
+                   "p999latency(%d) with %f",
+                   gf_fop_list[i], interval, stats->latency[i].p999);
+            goto out;
+        }
     }
     for (i = 0; i < GF_UPCALL_FLAGS_MAXVALUE; i++) {
         fop_hits = GF_ATOMIC_GET(stats->upcall_hits[i]);
@@ -1675,6 +1733,34 @@ ios_global_stats_clear(struct ios_global_stats *stats, time_t now)
     stats->started_at = now;
 }
 
+static void
+ios_latency_clear(gf_latency_t *lat)
+{
+    int i;
+
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        gf_latency_reset(&lat[i]);
+    }
+}
+
+static void
+ios_latency_percentiles(struct ios_global_stats *stats, gf_latency_t *lat)
+{
+    static const double pct[] = {0.5, 0.99, 0.999};
+    uint64_t values[3];
+    int i;
+
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        if (lat[i].count == 0)
+            continue;
+
+        gf_latency_percentiles(&lat[i], pct, values, 3);
+        stats->latency[i].p50 = values[0];
+        stats->latency[i].p99 = values[1];
+        stats->latency[i].p999 = values[2];
+    }
+}
+
 int
 io_stats_dump(xlator_t *this, struct ios_dump_args *args, ios_info_op_t op,
               gf_boolean_t is_peek)
@@ -1695,17 +1781,21 @@ io_stats_dump(xlator_t *this, struct ios_dump_args *args, ios_info_op_t op,
 
     LOCK(&conf->lock);
     {
-        if (op == GF_IOS_INFO_ALL || op == GF_IOS_INFO_CUMULATIVE)
+        if (op == GF_IOS_INFO_ALL || op == GF_IOS_INFO_CUMULATIVE) {
             cumulative = conf->cumulative;
+            ios_latency_percentiles(&cumulative, conf->cumulative_lat);
+        }
 
         if (op == GF_IOS_INFO_ALL || op == GF_IOS_INFO_INCREMENTAL) {
             incremental = conf->incremental;
+            ios_latency_percentiles(&incremental, conf->incremental_lat);
             increment = conf->increment;
 
             if (!is_peek) {
                 increment = conf->increment++;
 
                 ios_global_stats_clear(&conf->incremental, now);
+                ios_latency_clear(conf->incremental_lat);
             }
         }
     }
@@ -1856,6 +1946,10 @@ update_ios_latency(struct ios_conf *conf, call_frame_t *frame,
 
     update_ios_latency_stats(&conf->cumulative, elapsed, op);
     update_ios_latency_stats(&conf->incremental, elapsed, op);
+    if (elapsed >= 0) {
+        gf_latency_add(&conf->cumulative_lat[op], elapsed);
+        gf_latency_add(&conf->incremental_lat[op], elapsed);
+    }
     collect_ios_latency_sample(conf, op, elapsed, frame);
 
     return 0;
@@ -3677,6 +3771,8 @@ io_stats_clear(struct ios_conf *conf)
     {
         ios_global_stats_clear(&conf->cumulative, now);
         ios_global_stats_clear(&conf->incremental, now);
+        ios_latency_clear(conf->cumulative_lat);
+        ios_latency_clear(conf->incremental_lat);
         conf->increment = 0;
     }
     UNLOCK(&conf->lock);
@@ -3691,6 +3787,8 @@ io_priv(xlator_t *this)
     char key_prefix_incremental[GF_DUMP_MAX_BUF_LEN];
     double min, max, avg;
     uint64_t count, total;
+    static const double pct[] = {0.5, 0.99, 0.999};
+    uint64_t values[3];
     struct ios_conf *conf = NULL;
 
     conf = this->private;
@@ -3721,24 +3819,32 @@ io_priv(xlator_t *this)
         min = conf->cumulative.latency[i].min;
         max = conf->cumulative.latency[i].max;
         avg = conf->cumulative.latency[i].avg;
+        gf_latency_percentiles(&conf->cumulative_lat[i], pct, values, 3);
 
         gf_proc_dump_build_key(key, key_prefix_cumulative, "%s",
                                (char *)gf_fop_list[i]);
 
-        gf_proc_dump_write(key, "%" PRId64 ",%" PRId64 ",%.03f,%.03f,%.03f",
-                           count, total, min, max, avg);
+        gf_proc_dump_write(key,
+                           "%" PRId64 ",%" PRId64 ",%.03f,%.03f,%.03f,%" PRIu64
+                           ",%" PRIu64 ",%" PRIu64,
+                           count, total, min, max, avg, values[0], values[1],
+                           values[2]);
 
         count = GF_ATOMIC_GET(conf->incremental.fop_hits[i]);
         total = conf->incremental.latency[i].total;
         min = conf->incremental.latency[i].min;
         max = conf->incremental.latency[i].max;
         avg = conf->incremental.latency[i].avg;
+        gf_latency_percentiles(&conf->incremental_lat[i], pct, values, 3);
 
         gf_proc_dump_build_key(key, key_prefix_incremental, "%s",
                                (char *)gf_fop_list[i]);
 
-        gf_proc_dump_write(key, "%" PRId64 ",%" PRId64 ",%.03f,%.03f,%.03f",
-                           count, total, min, max, avg);
+        gf_proc_dump_write(key,
+                           "%" PRId64 ",%" PRId64 ",%.03f,%.03f,%.03f,%" PRIu64
+                           ",%" PRIu64 ",%" PRIu64,
+                           count, total, min, max, avg, values[0], values[1],
+                           values[2]);
     }
 
     return 0;
@@ -3974,9 +4080,15 @@ gf_dnscache_deinit(struct dnscache *cache)
 void
 ios_conf_destroy(struct ios_conf *conf)
 {
+    int i;
+
     if (!conf)
         return;
 
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        gf_latency_destroy(&conf->cumulative_lat[i]);
+        gf_latency_destroy(&conf->incremental_lat[i]);
+    }
     ios_destroy_top_stats(conf);
     _ios_destroy_dump_thread(conf);
     ios_destroy_sample_buf(conf->ios_sample_buf);
@@ -4093,6 +4205,8 @@ init(xlator_t *this)
 
     ios_init_stats(&conf->cumulative);
     ios_init_stats(&conf->incremental);
+    ios_latency_clear(conf->cumulative_lat);
+    ios_latency_clear(conf->incremental_lat);
 
     ret = ios_init_top_stats(conf);
     if (ret)
@@ -82,6 +82,10 @@ int32_t
 cdc_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
           off_t offset, uint32_t flags, dict_t *xdata)
 {
+    /* The data needs to be in memory to be compressed. */
+    if (xdata)
+        dict_del_sizen(xdata, GLUSTERFS_READV_PIPE_PAYLOAD);
+
     STACK_WIND(frame, cdc_readv_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->readv, fd, size, offset, flags, xdata);
     return 0;
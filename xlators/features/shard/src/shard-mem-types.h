@@ -19,6 +19,7 @@ enum gf_shard_mem_types_ {
     gf_shard_mt_iovec,
     gf_shard_mt_int64_t,
     gf_shard_mt_uint64_t,
+    gf_shard_mt_copy_chunk_t,
     gf_shard_mt_end
 };
 #endif
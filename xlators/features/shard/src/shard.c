@@ -541,6 +541,14 @@ shard_local_wipe(shard_local_t *local)
 
     GF_FREE(local->inode_list);
 
+    if (local->copy_fd)
+        fd_unref(local->copy_fd);
+    for (i = 0; i < local->copy_num_blocks; i++) {
+        if (local->copy_inode_list[i])
+            inode_unref(local->copy_inode_list[i]);
+    }
+    GF_FREE(local->copy_inode_list);
+
     GF_FREE(local->vector);
     if (local->iobref)
         iobref_unref(local->iobref);
@@ -845,6 +853,10 @@ shard_common_failure_unwind(glusterfs_fop_t fop, call_frame_t *frame,
             SHARD_STACK_UNWIND(discard, frame, op_ret, op_errno, NULL, NULL,
                                NULL);
             break;
+        case GF_FOP_COPY_FILE_RANGE:
+            SHARD_STACK_UNWIND(copy_file_range, frame, op_ret, op_errno, NULL,
+                               NULL, NULL, NULL);
+            break;
         case GF_FOP_READ:
             SHARD_STACK_UNWIND(readv, frame, op_ret, op_errno, NULL, -1, NULL,
                                NULL, NULL);
@@ -907,6 +919,7 @@ shard_common_inode_write_success_unwind(glusterfs_fop_t fop,
 
     struct iatt *prebuf = ((local) ? &local->prebuf : NULL);
     struct iatt *postbuf = ((local) ? &local->postbuf : NULL);
+    struct iatt *copy_stbuf = ((local) ? &local->copy_stbuf : NULL);
     dict_t *xattr_rsp = ((local) ? local->xattr_rsp : NULL);
 
     switch (fop) {
@@ -926,6 +939,10 @@ shard_common_inode_write_success_unwind(glusterfs_fop_t fop,
             SHARD_STACK_UNWIND(discard, frame, op_ret, 0, prebuf, postbuf,
                                xattr_rsp);
             break;
+        case GF_FOP_COPY_FILE_RANGE:
+            SHARD_STACK_UNWIND(copy_file_range, frame, op_ret, 0, copy_stbuf,
+                               prebuf, postbuf, xattr_rsp);
+            break;
         default:
             gf_msg(THIS->name, GF_LOG_WARNING, 0, SHARD_MSG_INVALID_FOP,
                    "Invalid fop id = %d", fop);
@@ -2411,6 +2428,7 @@ shard_common_lookup_shards_cbk(call_frame_t *frame, void *cookie,
             case GF_FOP_ZEROFILL:
             case GF_FOP_DISCARD:
             case GF_FOP_FALLOCATE:
+            case GF_FOP_COPY_FILE_RANGE:
                 if ((!local->first_lookup_done) && (op_errno == ENOENT)) {
                     LOCK(&frame->lock);
                     {
@@ -5591,6 +5609,171 @@ shard_common_inode_write_do_cbk(call_frame_t *frame, void *cookie,
     return 0;
 }
 
+/* State of the copy of the range of one destination shard. */
+typedef struct shard_copy_chunk {
+    fd_t *src_fd; /* NULL if the rest of the source shard is a hole */
+    fd_t *dst_fd;
+    off_t src_offset;
+    off_t dst_offset;
+    size_t size;
+    size_t copied;
+    struct iatt prebuf;
+    struct iatt postbuf;
+} shard_copy_chunk_t;
+
+static void
+shard_copy_chunk_wind(call_frame_t *frame, xlator_t *this,
+                      shard_copy_chunk_t *chunk);
+
+static void
+shard_copy_chunk_done(call_frame_t *frame, xlator_t *this,
+                      shard_copy_chunk_t *chunk, int32_t op_ret,
+                      int32_t op_errno, dict_t *xdata)
+{
+    if (op_ret >= 0)
+        op_ret = chunk->size;
+
+    if (chunk->src_fd)
+        fd_unref(chunk->src_fd);
+
+    /* The reference on dst_fd is released by the common callback. */
+    shard_common_inode_write_do_cbk(frame, chunk->dst_fd, this, op_ret,
+                                    op_errno, &chunk->prebuf, &chunk->postbuf,
+                                    xdata);
+    GF_FREE(chunk);
+}
+
+static void
+shard_copy_chunk_update(shard_copy_chunk_t *chunk, size_t size,
+                        struct iatt *prebuf, struct iatt *postbuf)
+{
+    if (chunk->copied == 0)
+        chunk->prebuf = *prebuf;
+    chunk->postbuf = *postbuf;
+
+    chunk->copied += size;
+    chunk->src_offset += size;
+    chunk->dst_offset += size;
+}
+
+static int
+shard_copy_chunk_discard_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *prebuf, struct iatt *postbuf,
+                             dict_t *xdata)
+{
+    shard_copy_chunk_t *chunk = cookie;
+
+    if (op_ret >= 0)
+        shard_copy_chunk_update(chunk, chunk->size - chunk->copied, prebuf,
+                                postbuf);
+
+    shard_copy_chunk_done(frame, this, chunk, op_ret, op_errno, xdata);
+    return 0;
+}
+
+static int
+shard_copy_chunk_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                     struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                     dict_t *xdata)
+{
+    shard_copy_chunk_t *chunk = cookie;
+
+    if (op_ret < 0) {
+        shard_copy_chunk_done(frame, this, chunk, op_ret, op_errno, xdata);
+        return 0;
+    }
+
+    shard_copy_chunk_update(chunk, op_ret, prebuf_dst, postbuf_dst);
+    if (chunk->copied == chunk->size) {
+        shard_copy_chunk_done(frame, this, chunk, op_ret, op_errno, xdata);
+        return 0;
+    }
+
+    /* A source shard is shorter than the block size when the end of the
+     * shard is a hole. */
+    if ((op_ret == 0) || (chunk->src_offset >= stbuf->ia_size)) {
+        fd_unref(chunk->src_fd);
+        chunk->src_fd = NULL;
+    }
+
+    shard_copy_chunk_wind(frame, this, chunk);
+    return 0;
+}
+
+/* Holes of the source are copied by punching a hole in the destination,
+ * which may contain data. */
+static void
+shard_copy_chunk_wind(call_frame_t *frame, xlator_t *this,
+                      shard_copy_chunk_t *chunk)
+{
+    shard_local_t *local = frame->local;
+
+    if (chunk->src_fd == NULL) {
+        STACK_WIND_COOKIE(frame, shard_copy_chunk_discard_cbk, chunk,
+                          FIRST_CHILD(this), FIRST_CHILD(this)->fops->discard,
+                          chunk->dst_fd, chunk->dst_offset,
+                          chunk->size - chunk->copied, local->xattr_req);
+    } else {
+        STACK_WIND_COOKIE(frame, shard_copy_chunk_cbk, chunk,
+                          FIRST_CHILD(this),
+                          FIRST_CHILD(this)->fops->copy_file_range,
+                          chunk->src_fd, chunk->src_offset, chunk->dst_fd,
+                          chunk->dst_offset, chunk->size - chunk->copied,
+                          local->flags, local->xattr_req);
+    }
+}
+
+/* Destination shard @fd gets its data from the source shard with the same
+ * position in the copied range. */
+static void
+shard_copy_file_range_wind(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                           off_t shard_offset, size_t size)
+{
+    int i = 0;
+    uint64_t src_block = 0;
+    inode_t *src_inode = NULL;
+    shard_copy_chunk_t *chunk = NULL;
+    shard_local_t *local = frame->local;
+
+    chunk = GF_CALLOC(1, sizeof(*chunk), gf_shard_mt_copy_chunk_t);
+    if (!chunk) {
+        shard_common_inode_write_do_cbk(frame, fd, this, -1, ENOMEM, NULL,
+                                        NULL, NULL);
+        return;
+    }
+
+    if (fd != local->fd) {
+        while ((i < local->num_blocks - 1) &&
+               (local->inode_list[i] != fd->inode))
+            i++;
+    }
+
+    src_block = get_lowest_block(local->copy_offset, local->block_size) + i;
+    if (src_block == 0) {
+        chunk->src_fd = fd_ref(local->copy_fd);
+    } else {
+        src_inode = local->copy_inode_list[i];
+        if (src_inode) {
+            chunk->src_fd = fd_anonymous(src_inode);
+            if (!chunk->src_fd) {
+                GF_FREE(chunk);
+                shard_common_inode_write_do_cbk(frame, fd, this, -1, ENOMEM,
+                                                NULL, NULL, NULL);
+                return;
+            }
+        }
+    }
+
+    chunk->dst_fd = fd;
+    chunk->src_offset = shard_offset;
+    chunk->dst_offset = shard_offset;
+    chunk->size = size;
+
+    shard_copy_chunk_wind(frame, this, chunk);
+}
+
 int
 shard_common_inode_write_wind(call_frame_t *frame, xlator_t *this, fd_t *fd,
                               struct iovec *vec, int count, off_t shard_offset,
@@ -5625,6 +5808,9 @@ shard_common_inode_write_wind(call_frame_t *frame, xlator_t *this, fd_t *fd,
                               FIRST_CHILD(this)->fops->discard, fd,
                               shard_offset, size, local->xattr_req);
             break;
+        case GF_FOP_COPY_FILE_RANGE:
+            shard_copy_file_range_wind(frame, this, fd, shard_offset, size);
+            break;
         default:
             gf_msg(this->name, GF_LOG_WARNING, 0, SHARD_MSG_INVALID_FOP,
                    "Invalid fop id = %d", local->fop);
@@ -7271,6 +7457,251 @@ shard_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     return 0;
 }
 
+int
+shard_copy_file_range_post_lookup_dst_handler(call_frame_t *frame,
+                                              xlator_t *this)
+{
+    shard_local_t *local = frame->local;
+
+    if (local->op_ret < 0) {
+        shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame,
+                                    local->op_ret, local->op_errno);
+        return 0;
+    }
+
+    if (local->total_size == 0) {
+        local->postbuf = local->prebuf;
+        shard_common_inode_write_success_unwind(GF_FOP_COPY_FILE_RANGE, frame,
+                                                0);
+        return 0;
+    }
+
+    shard_common_inode_write_post_lookup_handler(frame, this);
+    return 0;
+}
+
+/* Once the source shards are known, the destination is handled like the
+ * target of any other write: local->fd becomes the destination and the
+ * source is kept in the copy_* members of local. */
+static void
+shard_copy_file_range_resolve_dst(call_frame_t *frame, xlator_t *this)
+{
+    fd_t *fd = NULL;
+    off_t offset = 0;
+    shard_local_t *local = frame->local;
+
+    local->copy_stbuf = local->prebuf;
+    local->copy_inode_list = local->inode_list;
+    local->copy_num_blocks = local->num_blocks;
+    local->inode_list = NULL;
+    local->num_blocks = 0;
+    local->call_count = 0;
+    local->create_count = 0;
+    local->eexist_count = 0;
+    local->first_lookup_done = _gf_false;
+    loc_wipe(&local->dot_shard_loc);
+
+    fd = local->fd;
+    local->fd = local->copy_fd;
+    local->copy_fd = fd;
+    offset = local->offset;
+    local->offset = local->copy_offset;
+    local->copy_offset = offset;
+
+    loc_wipe(&local->loc);
+    local->loc.inode = inode_ref(local->fd->inode);
+    gf_uuid_copy(local->loc.gfid, local->fd->inode->gfid);
+    local->resolver_base_inode = local->fd->inode;
+
+    shard_refresh_base_file(frame, this, NULL, local->fd,
+                            shard_copy_file_range_post_lookup_dst_handler);
+}
+
+int
+shard_copy_file_range_post_lookup_shards_src_handler(call_frame_t *frame,
+                                                     xlator_t *this)
+{
+    shard_local_t *local = frame->local;
+
+    if (local->op_ret < 0) {
+        shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame,
+                                    local->op_ret, local->op_errno);
+        return 0;
+    }
+
+    /* Missing source shards are holes. They are not created, the
+     * corresponding range of the destination is punched instead. */
+    local->create_count = 0;
+    shard_copy_file_range_resolve_dst(frame, this);
+    return 0;
+}
+
+int
+shard_copy_file_range_post_resolve_src_handler(call_frame_t *frame,
+                                               xlator_t *this)
+{
+    shard_local_t *local = frame->local;
+
+    if (local->op_ret < 0) {
+        if (local->op_errno != ENOENT) {
+            shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame,
+                                        local->op_ret, local->op_errno);
+            return 0;
+        }
+        /* No .shard directory: only the base file of the source has data. */
+        local->op_ret = 0;
+        local->op_errno = 0;
+        shard_copy_file_range_resolve_dst(frame, this);
+        return 0;
+    }
+
+    if (local->call_count) {
+        shard_common_lookup_shards(
+            frame, this, local->resolver_base_inode,
+            shard_copy_file_range_post_lookup_shards_src_handler);
+    } else {
+        shard_copy_file_range_resolve_dst(frame, this);
+    }
+    return 0;
+}
+
+int
+shard_copy_file_range_post_lookup_src_handler(call_frame_t *frame,
+                                              xlator_t *this)
+{
+    int ret = 0;
+    shard_local_t *local = frame->local;
+    shard_priv_t *priv = this->private;
+
+    if (local->op_ret < 0) {
+        shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame,
+                                    local->op_ret, local->op_errno);
+        return 0;
+    }
+
+    if (local->offset >= local->prebuf.ia_size) {
+        local->total_size = 0;
+        shard_copy_file_range_resolve_dst(frame, this);
+        return 0;
+    }
+
+    local->total_size = local->req_size;
+    if (local->offset + local->total_size > local->prebuf.ia_size)
+        local->total_size = local->prebuf.ia_size - local->offset;
+
+    local->first_block = get_lowest_block(local->offset, local->block_size);
+    local->last_block = get_highest_block(local->offset, local->total_size,
+                                          local->block_size);
+    local->num_blocks = local->last_block - local->first_block + 1;
+    local->resolver_base_inode = local->loc.inode;
+
+    local->inode_list = GF_CALLOC(local->num_blocks, sizeof(inode_t *),
+                                  gf_shard_mt_inode_list);
+    if (!local->inode_list)
+        goto err;
+
+    local->dot_shard_loc.inode = inode_find(this->itable, priv->dot_shard_gfid);
+    if (!local->dot_shard_loc.inode) {
+        ret = shard_init_internal_dir_loc(this, local,
+                                          SHARD_INTERNAL_DIR_DOT_SHARD);
+        if (ret)
+            goto err;
+        shard_lookup_internal_dir(
+            frame, this, shard_copy_file_range_post_resolve_src_handler,
+            SHARD_INTERNAL_DIR_DOT_SHARD);
+    } else {
+        local->post_res_handler =
+            shard_copy_file_range_post_resolve_src_handler;
+        shard_refresh_internal_dir(frame, this, SHARD_INTERNAL_DIR_DOT_SHARD);
+    }
+    return 0;
+err:
+    shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame, -1, ENOMEM);
+    return 0;
+}
+
+/* Sharded files are copied shard by shard: the source shards are resolved
+ * first and then the destination goes through the same path as writes, with
+ * each destination shard copied from the source shard at the same position.
+ * This needs both files to have the same block size and the ranges to start
+ * at the same offset inside a block. Otherwise EXDEV is returned so that the
+ * caller falls back to read and write. */
+int32_t
+shard_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                      off64_t off_in, fd_t *fd_out, off64_t off_out,
+                      size_t len, uint32_t flags, dict_t *xdata)
+{
+    int ret = 0;
+    uint64_t block_size = 0;
+    uint64_t dst_block_size = 0;
+    shard_local_t *local = NULL;
+
+    if (frame->root->pid == GF_CLIENT_PID_GSYNCD)
+        goto wind;
+
+    ret = shard_inode_ctx_get_block_size(fd_in->inode, this, &block_size);
+    if (!ret)
+        ret = shard_inode_ctx_get_block_size(fd_out->inode, this,
+                                             &dst_block_size);
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, SHARD_MSG_INODE_CTX_GET_FAILED,
+               "Failed to get block size of %s or %s from its inode ctx",
+               uuid_utoa(fd_in->inode->gfid), uuid_utoa(fd_out->inode->gfid));
+        goto err;
+    }
+
+    if (!block_size && !dst_block_size)
+        goto wind;
+
+    if ((block_size != dst_block_size) || (fd_in->inode == fd_out->inode) ||
+        ((off_in % block_size) != (off_out % block_size))) {
+        shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame, -1, EXDEV);
+        return 0;
+    }
+
+    if (!this->itable)
+        this->itable = fd_in->inode->table;
+
+    local = mem_get0(this->local_pool);
+    if (!local)
+        goto err;
+
+    frame->local = local;
+
+    ret = syncbarrier_init(&local->barrier);
+    if (ret)
+        goto err;
+    local->xattr_req = (xdata) ? dict_ref(xdata) : dict_new();
+    if (!local->xattr_req)
+        goto err;
+
+    local->fop = GF_FOP_COPY_FILE_RANGE;
+    local->fd = fd_ref(fd_in);
+    local->offset = off_in;
+    local->copy_fd = fd_ref(fd_out);
+    local->copy_offset = off_out;
+    local->req_size = len;
+    local->flags = flags;
+    local->block_size = block_size;
+    GF_ATOMIC_INIT(local->delta_blocks, 0);
+
+    local->loc.inode = inode_ref(fd_in->inode);
+    gf_uuid_copy(local->loc.gfid, fd_in->inode->gfid);
+
+    shard_refresh_base_file(frame, this, NULL, fd_in,
+                            shard_copy_file_range_post_lookup_src_handler);
+    return 0;
+
+wind:
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+    return 0;
+err:
+    shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame, -1, ENOMEM);
+    return 0;
+}
+
 int32_t
 shard_seek(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
            gf_seek_what_t what, dict_t *xdata)
@@ -7630,6 +8061,7 @@ struct xlator_fops fops = {
     .fallocate = shard_fallocate,
     .discard = shard_discard,
     .zerofill = shard_zerofill,
+    .copy_file_range = shard_copy_file_range,
     .readdir = shard_readdir,
     .readdirp = shard_readdirp,
     .create = shard_create,
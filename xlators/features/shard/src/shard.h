@@ -330,6 +330,13 @@ typedef struct shard_local {
     gf_boolean_t cleanup_required;
     uuid_t base_gfid;
     char *name;
+    /* copy_file_range: the file that is not local->fd. It's the destination
+     * while the source shards are resolved and the source after that. */
+    fd_t *copy_fd;
+    off_t copy_offset;
+    inode_t **copy_inode_list;
+    uint64_t copy_num_blocks;
+    struct iatt copy_stbuf;
 } shard_local_t;
 
 typedef struct shard_inode_ctx {
@@ -488,3 +488,48 @@ fail:
         default_getxattr_failure_cbk(frame, ENOMEM);
     return 0;
 }
+
+void
+cluster_read_latency_init(cluster_read_latency_t *lat)
+{
+    memset(lat, 0, sizeof(*lat));
+    gf_latency_reset(&lat->latency);
+}
+
+void
+cluster_read_latency_fini(cluster_read_latency_t *lat)
+{
+    gf_latency_destroy(&lat->latency);
+}
+
+void
+cluster_read_latency_add(cluster_read_latency_t *lat, struct timespec *start)
+{
+    static const double pct = CLUSTER_READ_LATENCY_PCT;
+    struct timespec now;
+    uint64_t deadline = 0;
+    uint64_t count;
+
+    timespec_now(&now);
+    gf_latency_update(&lat->latency, start, &now);
+
+    count = __atomic_load_n(&lat->latency.count, __ATOMIC_RELAXED);
+    if ((count % CLUSTER_READ_LATENCY_PERIOD) != 0)
+        return;
+
+    gf_latency_percentiles(&lat->latency, &pct, &deadline, 1);
+    if (deadline < CLUSTER_READ_DEADLINE_MIN)
+        deadline = CLUSTER_READ_DEADLINE_MIN;
+    __atomic_store_n(&lat->deadline, deadline, __ATOMIC_RELAXED);
+
+    /* Concurrent updates may be lost, which doesn't matter for an
+     * estimation. */
+    if (count >= CLUSTER_READ_LATENCY_WINDOW)
+        gf_latency_reset(&lat->latency);
+}
+
+uint64_t
+cluster_read_deadline(cluster_read_latency_t *lat)
+{
+    return __atomic_load_n(&lat->deadline, __ATOMIC_RELAXED);
+}
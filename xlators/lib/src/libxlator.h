@@ -143,4 +143,36 @@ gf_get_min_stime(xlator_t *this, dict_t *dst, char *key, data_t *value);
 int
 gf_get_max_stime(xlator_t *this, dict_t *dst, char *key, data_t *value);
 
+/* Latency of the reads answered by a subvolume, used by cluster xlators to
+ * detect a read that is late compared to the recent ones and ask another
+ * subvolume for the same data (hedged reads).
+ *
+ * The deadline is the 95th percentile of the latencies. It's recomputed
+ * every CLUSTER_READ_LATENCY_PERIOD reads and the histogram is restarted
+ * every CLUSTER_READ_LATENCY_WINDOW reads, so that it follows the changes of
+ * the load. It's 0 until the first period is complete. */
+#define CLUSTER_READ_LATENCY_PERIOD 64
+#define CLUSTER_READ_LATENCY_WINDOW 4096
+#define CLUSTER_READ_LATENCY_PCT 0.95
+
+/* Hedging faster than this costs more than it can save. */
+#define CLUSTER_READ_DEADLINE_MIN (1000 * 1000)
+
+typedef struct _cluster_read_latency {
+    gf_latency_t latency;
+    uint64_t deadline; /* nanoseconds */
+} cluster_read_latency_t;
+
+void
+cluster_read_latency_init(cluster_read_latency_t *lat);
+
+void
+cluster_read_latency_fini(cluster_read_latency_t *lat);
+
+void
+cluster_read_latency_add(cluster_read_latency_t *lat, struct timespec *start);
+
+uint64_t
+cluster_read_deadline(cluster_read_latency_t *lat);
+
 #endif /* !_LIBXLATOR_H */
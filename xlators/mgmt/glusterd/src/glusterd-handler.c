@@ -6141,6 +6141,8 @@ glusterd_get_state(rpcsvc_request_t *req, dict_t *dict)
         fprintf(fp, "Volume%d.rebalance.data: %s\n", count, rebal_data);
         fprintf(fp, "Volume%d.time_left: %ld\n", count,
                 volinfo->rebal.time_left);
+        fprintf(fp, "Volume%d.rebalance.throughput: %" PRIu64 "\n", count,
+                volinfo->rebal.throughput);
 
         GF_FREE(rebal_data);
 
@@ -8799,6 +8799,7 @@ glusterd_volinfo_reset_defrag_stats(glusterd_volinfo_t *volinfo)
     rebal->rebalance_failures = 0;
     rebal->rebalance_time = 0;
     rebal->skipped_files = 0;
+    rebal->throughput = 0;
 }
 
 gf_boolean_t
@@ -8875,6 +8876,8 @@ glusterd_defrag_volume_status_update(glusterd_volinfo_t *volinfo,
     uint64_t promoted = 0;
     uint64_t demoted = 0;
     time_t time_left = 0;
+    uint64_t throughput = 0;
+    int ret3 = 0;
 
     ret = dict_get_uint64(rsp_dict, "files", &files);
     if (ret)
@@ -8917,6 +8920,10 @@ glusterd_defrag_volume_status_update(glusterd_volinfo_t *volinfo,
     if (ret2)
         gf_msg_trace(this->name, 0, "failed to get time left");
 
+    ret3 = dict_get_uint64(rsp_dict, "throughput", &throughput);
+    if (ret3)
+        gf_msg_trace(this->name, 0, "failed to get throughput");
+
     if (files)
         volinfo->rebal.rebalance_files = files;
     if (size)
@@ -8933,6 +8940,8 @@ glusterd_defrag_volume_status_update(glusterd_volinfo_t *volinfo,
         volinfo->rebal.rebalance_time = run_time;
     if (!ret2)
         volinfo->rebal.time_left = time_left;
+    if (!ret3)
+        volinfo->rebal.throughput = throughput;
 
     return ret;
 }
@@ -10141,6 +10150,16 @@ glusterd_volume_rebalance_use_rsp_dict(dict_t *aggr, dict_t *rsp_dict)
             gf_msg_debug(this->name, 0, "failed to set time-left");
         }
     }
+
+    snprintf(key, sizeof(key), "throughput-%d", index);
+    ret = dict_get_uint64(rsp_dict, key, &value);
+    if (!ret) {
+        snprintf(key, sizeof(key), "throughput-%d", current_index);
+        ret = dict_set_uint64(ctx_dict, key, value);
+        if (ret) {
+            gf_msg_debug(this->name, 0, "failed to set throughput");
+        }
+    }
     snprintf(key, sizeof(key), "demoted-%d", index);
     ret = dict_get_uint64(rsp_dict, key, &value);
     if (!ret) {
@@ -10705,6 +10724,12 @@ glusterd_defrag_volume_node_rsp(dict_t *req_dict, dict_t *rsp_dict,
         gf_msg(THIS->name, GF_LOG_ERROR, -ret, GD_MSG_DICT_SET_FAILED,
                "failed to set time left");
 
+    snprintf(key, sizeof(key), "throughput-%d", i);
+    ret = dict_set_uint64(op_ctx, key, volinfo->rebal.throughput);
+    if (ret)
+        gf_msg(THIS->name, GF_LOG_ERROR, -ret, GD_MSG_DICT_SET_FAILED,
+               "failed to set throughput");
+
 out:
     return ret;
 }
@@ -853,6 +853,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/distribute",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.readdir-fan-out",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.rsync-hash-regex",
      .voltype = "cluster/distribute",
      .type = NO_DOC,
@@ -885,6 +889,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .validate_fn = validate_defrag_throttle_option,
         .flags = VOLOPT_FLAG_CLIENT_OPT,
     },
+    {
+        .key = "cluster.rebal-migration-streams",
+        .voltype = "cluster/distribute",
+        .op_version = GD_OP_VERSION_10_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
+    {
+        .key = "cluster.rebal-resume",
+        .voltype = "cluster/distribute",
+        .op_version = GD_OP_VERSION_10_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
 
     {
         .key = "cluster.lock-migration",
@@ -955,6 +971,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/replicate",
      .op_version = 2,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.read-stripe-size",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.hedge-reads",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.changelog-batch",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.background-self-heal-count",
      .voltype = "cluster/replicate",
      .op_version = 1,
@@ -1247,6 +1275,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "performance/io-threads",
      .option = "watchdog-secs",
      .op_version = GD_OP_VERSION_4_1_0},
+    {.key = "performance.iot-numa-pin",
+     .voltype = "performance/io-threads",
+     .option = "numa-pin",
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "performance.iot-cleanup-disconnected-reqs",
      .voltype = "performance/io-threads",
      .option = "cleanup-disconnected-reqs",
@@ -1448,6 +1480,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .flags = VOLOPT_FLAG_CLIENT_OPT,
      .description = "A comma separated list of xattrs that shall be "
                     "cached by md-cache. The only wildcard allowed is '*'"},
+    {.key = "performance.md-cache-prefetch",
+     .voltype = "performance/md-cache",
+     .option = "md-cache-prefetch",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.md-cache-prefetch-limit",
+     .voltype = "performance/md-cache",
+     .option = "md-cache-prefetch-limit",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.nl-cache-pass-through",
      .voltype = "performance/nl-cache",
      .option = "pass-through",
@@ -1515,6 +1557,13 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .op_version = GD_OP_VERSION_3_10_2,
      .value = "9",
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "client.io-uring",
+     .voltype = "protocol/client",
+     .option = "transport.socket.io-uring",
+     .op_version = GD_OP_VERSION_10_0,
+     .description = "Use io_uring to receive and send data on the "
+                    "connections to the bricks. Ignored when SSL is enabled.",
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "client.strict-locks",
      .voltype = "protocol/client",
      .option = "strict-locks",
@@ -1643,6 +1692,21 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .voltype = "protocol/server",
         .op_version = GD_OP_VERSION_3_7_0,
     },
+    {
+        .key = "server.event-threads-numa-pin",
+        .voltype = "protocol/server",
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .key = "server.event-threads-sharding",
+        .voltype = "protocol/server",
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .key = "server.event-threads-balance",
+        .voltype = "protocol/server",
+        .op_version = GD_OP_VERSION_10_0,
+    },
     {
         .key = "server.tcp-user-timeout",
         .voltype = "protocol/server",
@@ -1670,6 +1734,24 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .op_version = GD_OP_VERSION_3_10_2,
         .value = "9",
     },
+    {
+        .key = "server.zero-copy-read",
+        .voltype = "protocol/server",
+        .option = "transport.socket.zero-copy-read",
+        .op_version = GD_OP_VERSION_10_0,
+        .description = "Send the data of read replies directly from the page "
+                       "cache of the brick, without copying it to user space. "
+                       "Ignored when SSL is enabled.",
+    },
+    {
+        .key = "server.io-uring",
+        .voltype = "protocol/server",
+        .option = "transport.socket.io-uring",
+        .op_version = GD_OP_VERSION_10_0,
+        .description = "Use io_uring to receive and send data on the "
+                       "connections from clients. Ignored when SSL is "
+                       "enabled.",
+    },
     {
         .key = "transport.listen-backlog",
         .voltype = "protocol/server",
@@ -2333,6 +2415,9 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     {.key = "storage.linux-io_uring",
      .voltype = "storage/posix",
      .op_version = GD_OP_VERSION_9_0},
+    {.key = "storage.io-framework",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "storage.batch-fsync-mode",
      .voltype = "storage/posix",
      .op_version = 3},
@@ -2785,6 +2870,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/disperse",
      .op_version = GD_OP_VERSION_3_11_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.self-heal-pipeline-depth",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.use-compound-fops",
      .voltype = "cluster/replicate",
      .value = "off",
@@ -2987,6 +3076,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .type = NO_DOC,
      .op_version = GD_OP_VERSION_3_13_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.write-coalesce",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.hedge-reads",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "disperse.quorum-count",
      .voltype = "cluster/disperse",
      .type = NO_DOC,
@@ -326,6 +326,7 @@ struct glusterd_rebalance_ {
     uuid_t rebalance_id;
     double rebalance_time;
     time_t time_left;
+    uint64_t throughput; /* bytes/sec */
     dict_t *dict; /* Dict to store misc information
                    * like list of bricks being removed */
     glusterd_op_t op;
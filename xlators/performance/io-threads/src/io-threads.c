@@ -22,6 +22,7 @@
 #include <glusterfs/locking.h>
 #include "io-threads-messages.h"
 #include <glusterfs/timespec.h>
+#include <glusterfs/gf-numa.h>
 
 static void *
 iot_worker(void *arg);
@@ -167,6 +168,11 @@ iot_worker(void *data)
     this = conf->this;
     THIS = this;
 
+    /* Workers are spread across the nodes as they are created. Bind before
+     * allocating anything so that the per-thread pools are node local. */
+    if (conf->numa_pin)
+        (void)gf_numa_thread_bind(gf_numa_node_next());
+
     for (;;) {
         pthread_mutex_lock(&conf->mutex);
         {
@@ -1148,6 +1154,8 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("cleanup-disconnected-reqs",
                      conf->cleanup_disconnected_reqs, options, bool, out);
 
+    GF_OPTION_RECONF("numa-pin", conf->numa_pin, options, bool, out);
+
     GF_OPTION_RECONF("watchdog-secs", conf->watchdog_secs, options, int32, out);
 
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
@@ -1230,6 +1238,8 @@ init(xlator_t *this)
     GF_OPTION_INIT("cleanup-disconnected-reqs", conf->cleanup_disconnected_reqs,
                    bool, out);
 
+    GF_OPTION_INIT("numa-pin", conf->numa_pin, bool, out);
+
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
     conf->this = this;
@@ -1550,6 +1560,15 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
      .tags = {"io-threads"},
      .description = "Enable/Disable io threads translator"},
+    {.key = {"numa-pin"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-threads"},
+     .description = "Restrict each worker thread to the CPUs of a single "
+                    "NUMA node, distributing new threads evenly across the "
+                    "nodes. Only affects threads started after it's set."},
     {
         .key = {NULL},
     },
@@ -70,6 +70,7 @@ struct iot_conf {
     xlator_t *this;
     int32_t watchdog_secs;
     gf_boolean_t cleanup_disconnected_reqs;
+    gf_boolean_t numa_pin; /* bind workers to NUMA nodes */
 };
 
 typedef struct iot_conf iot_conf_t;
@@ -19,6 +19,7 @@
 #include <glusterfs/upcall-utils.h>
 #include <assert.h>
 #include <sys/time.h>
+#include <sched.h>
 #include "md-cache-messages.h"
 #include <glusterfs/statedump.h>
 #include <glusterfs/atomic.h>
@@ -54,7 +55,47 @@ struct mdc_statistics {
     gf_atomic_t xattr_invals; /* No. of invalidates received from upcall */
     gf_atomic_t need_lookup;  /* No. of lookups issued, because other
                                  xlators requested for explicit lookup */
-};
+
+    gf_atomic_t prefetches;     /* No. of directories read ahead */
+    gf_atomic_t prefetched;     /* No. of entries cached ahead */
+    gf_atomic_t prefetch_hit;   /* No. of lookups served from them */
+    gf_atomic_t prefetch_waste; /* No. of them forgotten without use */
+} __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
+
+/* The statistics are split in stripes, and each thread always updates the
+ * same one, so that the threads don't bounce the cache lines of the
+ * counters between them. */
+#define MDC_STAT_STRIPES 8
+
+/* Stripe of the statistics updated by the current thread, plus one. */
+static __thread int mdc_stat_stripe = 0;
+
+static unsigned int mdc_stat_next_stripe = 0;
+
+static inline int
+mdc_stat_stripe_get(void)
+{
+    if (mdc_stat_stripe == 0) {
+        mdc_stat_stripe = __atomic_fetch_add(&mdc_stat_next_stripe, 1,
+                                             __ATOMIC_RELAXED) %
+                              MDC_STAT_STRIPES +
+                          1;
+    }
+
+    return mdc_stat_stripe - 1;
+}
+
+#define MDC_STAT_INC(conf, name)                                               \
+    GF_ATOMIC_INC((conf)->mdc_counter[mdc_stat_stripe_get()].name)
+
+#define MDC_STAT_GET(conf, name)                                               \
+    ({                                                                         \
+        int64_t __sum = 0;                                                     \
+        int __i;                                                               \
+        for (__i = 0; __i < MDC_STAT_STRIPES; __i++)                           \
+            __sum += GF_ATOMIC_GET((conf)->mdc_counter[__i].name);             \
+        __sum;                                                                 \
+    })
 
 struct mdc_conf {
     time_t timeout;
@@ -71,11 +112,15 @@ struct mdc_conf {
 
     time_t last_child_down;
     gf_lock_t lock;
-    struct mdc_statistics mdc_counter;
+    struct mdc_statistics mdc_counter[MDC_STAT_STRIPES];
     gf_boolean_t cache_statfs;
     struct mdc_statfs_cache statfs_cache;
     char *mdc_xattr_str;
     gf_atomic_uint32_t generation;
+
+    gf_boolean_t prefetch;
+    int32_t prefetch_limit;
+    gf_atomic_t prefetch_pending; /* entries cached ahead and not used */
 };
 
 struct mdc_local;
@@ -109,7 +154,7 @@ struct md_cache {
     uint64_t md_size;
     uint64_t md_blocks;
     uint64_t generation;
-    dict_t *xattr;
+    dict_t *xattr; /* never modified once cached, only replaced */
     char *linkname;
     time_t ia_time;
     time_t xa_time;
@@ -117,9 +162,59 @@ struct md_cache {
     gf_boolean_t valid;
     gf_boolean_t gen_rollover;
     gf_boolean_t invalidation_rollover;
+    uint32_t seq;
+
+    /* Detection of directory scans, see mdc_prefetch_check(). */
+    time_t scan_time;
+    time_t opendir_time;
+    time_t prefetch_time;
+    uint32_t scan_misses;
+    gf_boolean_t prefetching;
+    gf_boolean_t prefetched; /* cached ahead and not looked up yet */
+    off_t prefetch_off;      /* d_off of a prefetched entry. For a directory,
+                                the one of the last prefetched entry that was
+                                looked up, where the next prefetch starts. */
+
     gf_lock_t lock;
 };
 
+/* The iatt, ia_time, valid and generation of a md_cache are changed with
+ * the lock held, between MDC_IATT_LOCK() and MDC_IATT_UNLOCK(), which make
+ * seq odd while the change is in progress. Readers don't take the lock:
+ * they copy what they need and retry if seq was odd or has changed (see
+ * mdc_seq_begin() and mdc_seq_retry()). */
+#define MDC_IATT_LOCK(mdc)                                                     \
+    do {                                                                       \
+        LOCK(&(mdc)->lock);                                                    \
+        __atomic_store_n(&(mdc)->seq, (mdc)->seq + 1, __ATOMIC_RELAXED);       \
+        __atomic_thread_fence(__ATOMIC_RELEASE);                               \
+    } while (0)
+
+#define MDC_IATT_UNLOCK(mdc)                                                   \
+    do {                                                                       \
+        __atomic_store_n(&(mdc)->seq, (mdc)->seq + 1, __ATOMIC_RELEASE);       \
+        UNLOCK(&(mdc)->lock);                                                  \
+    } while (0)
+
+static inline uint32_t
+mdc_seq_begin(struct md_cache *mdc)
+{
+    uint32_t seq;
+
+    while (((seq = __atomic_load_n(&mdc->seq, __ATOMIC_ACQUIRE)) & 1) != 0)
+        sched_yield();
+
+    return seq;
+}
+
+static inline gf_boolean_t
+mdc_seq_retry(struct md_cache *mdc, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&mdc->seq, __ATOMIC_RELAXED) != seq;
+}
+
 struct mdc_local {
     loc_t loc;
     loc_t loc2;
@@ -154,6 +249,14 @@ mdc_inode_ctx_get(xlator_t *this, inode_t *inode, struct md_cache **mdc_p)
     if (!inode)
         goto out;
 
+    /* The context is set once by mdc_inode_prep() and only removed on
+     * forget, so once it's there it can be read without the lock. */
+    ret = __mdc_inode_ctx_get(this, inode, mdc_p);
+    if (ret == 0) {
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        goto out;
+    }
+
     LOCK(&inode->lock);
     {
         ret = __mdc_inode_ctx_get(this, inode, mdc_p);
@@ -197,11 +300,11 @@ mdc_inc_generation(xlator_t *this, inode_t *inode)
     mdc_inode_ctx_get(this, inode, &mdc);
 
     if (mdc) {
-        LOCK(&mdc->lock);
+        MDC_IATT_LOCK(mdc);
         {
             gen = __mdc_inc_generation(this, mdc);
         }
-        UNLOCK(&mdc->lock);
+        MDC_IATT_UNLOCK(mdc);
     } else {
         gen = GF_ATOMIC_INC(conf->generation);
         if (gen == 0) {
@@ -218,17 +321,17 @@ mdc_get_generation(xlator_t *this, inode_t *inode)
     struct mdc_conf *conf = NULL;
     uint64_t gen = 0;
     struct md_cache *mdc = NULL;
+    uint32_t seq;
 
     conf = this->private;
 
     mdc_inode_ctx_get(this, inode, &mdc);
 
     if (mdc) {
-        LOCK(&mdc->lock);
-        {
+        do {
+            seq = mdc_seq_begin(mdc);
             gen = mdc->generation;
-        }
-        UNLOCK(&mdc->lock);
+        } while (mdc_seq_retry(mdc, seq));
     } else
         gen = GF_ATOMIC_GET(conf->generation);
 
@@ -317,6 +420,13 @@ mdc_inode_wipe(xlator_t *this, inode_t *inode)
 
     mdc = (void *)(long)mdc_int;
 
+    if (mdc->prefetched) {
+        struct mdc_conf *conf = this->private;
+
+        MDC_STAT_INC(conf, prefetch_waste);
+        GF_ATOMIC_DEC(conf->prefetch_pending);
+    }
+
     if (mdc->xattr)
         dict_unref(mdc->xattr);
 
@@ -350,6 +460,8 @@ mdc_inode_prep(xlator_t *this, inode_t *inode)
 
         LOCK_INIT(&mdc->lock);
 
+        /* Pairs with the fence of the lockless mdc_inode_ctx_get(). */
+        __atomic_thread_fence(__ATOMIC_RELEASE);
         ret = __mdc_inode_ctx_set(this, inode, mdc);
         if (ret) {
             gf_msg(this->name, GF_LOG_ERROR, ENOMEM, MD_CACHE_MSG_NO_MEMORY,
@@ -407,7 +519,7 @@ is_md_cache_iatt_valid(xlator_t *this, struct md_cache *mdc)
 {
     gf_boolean_t ret = _gf_true;
 
-    LOCK(&mdc->lock);
+    MDC_IATT_LOCK(mdc);
     {
         if (mdc->valid == _gf_false) {
             ret = mdc->valid;
@@ -419,23 +531,7 @@ is_md_cache_iatt_valid(xlator_t *this, struct md_cache *mdc)
             }
         }
     }
-    UNLOCK(&mdc->lock);
-
-    return ret;
-}
-
-static gf_boolean_t
-is_md_cache_xatt_valid(xlator_t *this, struct md_cache *mdc)
-{
-    gf_boolean_t ret = _gf_true;
-
-    LOCK(&mdc->lock);
-    {
-        ret = __is_cache_valid(this, mdc->xa_time);
-        if (ret == _gf_false)
-            mdc->xa_time = 0;
-    }
-    UNLOCK(&mdc->lock);
+    MDC_IATT_UNLOCK(mdc);
 
     return ret;
 }
@@ -495,7 +591,7 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
     rollover = incident_time >> 32;
     incident_time = (incident_time & 0xffffffff);
 
-    LOCK(&mdc->lock);
+    MDC_IATT_LOCK(mdc);
     {
         if (!iatt || !iatt->ia_ctime) {
             mdc->ia_time = 0;
@@ -503,7 +599,7 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
 
             gen = __mdc_inc_generation(this, mdc);
             mdc->generation = (gen & 0xffffffff);
-            UNLOCK(&mdc->lock);
+            MDC_IATT_UNLOCK(mdc);
             gf_msg_callingfn("md-cache", GF_LOG_TRACE, 0, 0,
                              "invalidating iatt(NULL)"
                              "(%s)",
@@ -520,7 +616,7 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
          * changes, hence check for ctime only.
          */
         if (mdc->md_ctime > iatt->ia_ctime) {
-            UNLOCK(&mdc->lock);
+            MDC_IATT_UNLOCK(mdc);
             gf_msg_callingfn(this->name, GF_LOG_DEBUG, EINVAL,
                              MD_CACHE_MSG_DISCARD_UPDATE,
                              "discarding the iatt validate "
@@ -531,7 +627,7 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
         }
         if ((mdc->md_ctime == iatt->ia_ctime) &&
             (mdc->md_ctime_nsec > iatt->ia_ctime_nsec)) {
-            UNLOCK(&mdc->lock);
+            MDC_IATT_UNLOCK(mdc);
             gf_msg_callingfn(this->name, GF_LOG_DEBUG, EINVAL,
                              MD_CACHE_MSG_DISCARD_UPDATE,
                              "discarding the iatt validate "
@@ -598,7 +694,7 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
                              (unsigned long long)incident_time);
         }
     }
-    UNLOCK(&mdc->lock);
+    MDC_IATT_UNLOCK(mdc);
 
 out:
     return mdc;
@@ -617,6 +713,9 @@ mdc_inode_iatt_get(xlator_t *this, inode_t *inode, struct iatt *iatt)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
+    gf_boolean_t valid = _gf_false;
+    time_t ia_time = 0;
+    uint32_t seq;
 
     if (mdc_inode_ctx_get(this, inode, &mdc) != 0) {
         gf_msg_trace("md-cache", 0, "mdc_inode_ctx_get failed (%s)",
@@ -624,18 +723,22 @@ mdc_inode_iatt_get(xlator_t *this, inode_t *inode, struct iatt *iatt)
         goto out;
     }
 
-    if (!is_md_cache_iatt_valid(this, mdc)) {
+    do {
+        seq = mdc_seq_begin(mdc);
+        valid = mdc->valid;
+        ia_time = mdc->ia_time;
+        mdc_to_iatt(mdc, iatt);
+    } while (mdc_seq_retry(mdc, seq));
+
+    if (!valid || !__is_cache_valid(this, ia_time)) {
+        /* Let is_md_cache_iatt_valid() reset the expired cache. */
+        if (valid)
+            is_md_cache_iatt_valid(this, mdc);
         gf_msg_trace("md-cache", 0, "iatt cache not valid for (%s)",
                      uuid_utoa(inode->gfid));
         goto out;
     }
 
-    LOCK(&mdc->lock);
-    {
-        mdc_to_iatt(mdc, iatt);
-    }
-    UNLOCK(&mdc->lock);
-
     gf_uuid_copy(iatt->ia_gfid, inode->gfid);
     iatt->ia_ino = gfid_to_ino(inode->gfid);
     iatt->ia_dev = 42;
@@ -816,6 +919,9 @@ mdc_inode_xatt_update(xlator_t *this, inode_t *inode, dict_t *dict)
     int ret = -1;
     struct md_cache *mdc = NULL;
 
+    dict_t *newdict = NULL;
+    dict_t *olddict = NULL;
+
     mdc = mdc_inode_prep(this, inode);
     if (!mdc)
         goto out;
@@ -823,18 +929,34 @@ mdc_inode_xatt_update(xlator_t *this, inode_t *inode, dict_t *dict)
     if (!dict)
         goto out;
 
+    /* The cached dict can be in use by the fops that got it from
+     * mdc_inode_xatt_get(), so it's replaced by an updated copy. */
     LOCK(&mdc->lock);
     {
-        ret = mdc_dict_update(&mdc->xattr, dict);
+        if (mdc->xattr) {
+            newdict = dict_copy_with_ref(mdc->xattr, NULL);
+            if (!newdict) {
+                UNLOCK(&mdc->lock);
+                goto out;
+            }
+        }
+        ret = mdc_dict_update(&newdict, dict);
         if (ret < 0) {
             UNLOCK(&mdc->lock);
             goto out;
         }
+        olddict = mdc->xattr;
+        mdc->xattr = newdict;
+        newdict = NULL;
     }
     UNLOCK(&mdc->lock);
 
     ret = 0;
 out:
+    if (newdict)
+        dict_unref(newdict);
+    if (olddict)
+        dict_unref(olddict);
     return ret;
 }
 
@@ -843,20 +965,36 @@ mdc_inode_xatt_unset(xlator_t *this, inode_t *inode, char *name)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
+    dict_t *newdict = NULL;
+    dict_t *olddict = NULL;
 
     mdc = mdc_inode_prep(this, inode);
     if (!mdc)
         goto out;
 
-    if (!name || !mdc->xattr)
+    if (!name)
         goto out;
 
+    /* See mdc_inode_xatt_update(). */
     LOCK(&mdc->lock);
     {
-        dict_del(mdc->xattr, name);
+        if (mdc->xattr && dict_get(mdc->xattr, name)) {
+            newdict = dict_copy_with_ref(mdc->xattr, NULL);
+            if (newdict) {
+                dict_del(newdict, name);
+            } else {
+                /* Without a copy, forget the whole cache. */
+                mdc->xa_time = 0;
+            }
+            olddict = mdc->xattr;
+            mdc->xattr = newdict;
+        }
     }
     UNLOCK(&mdc->lock);
 
+    if (olddict)
+        dict_unref(olddict);
+
     ret = 0;
 out:
     return ret;
@@ -874,14 +1012,15 @@ mdc_inode_xatt_get(xlator_t *this, inode_t *inode, dict_t **dict)
         goto out;
     }
 
-    if (!is_md_cache_xatt_valid(this, mdc)) {
-        gf_msg_trace("md-cache", 0, "xattr cache not valid for (%s)",
-                     uuid_utoa(inode->gfid));
-        goto out;
-    }
-
     LOCK(&mdc->lock);
     {
+        if (!__is_cache_valid(this, mdc->xa_time)) {
+            mdc->xa_time = 0;
+            gf_msg_trace("md-cache", 0, "xattr cache not valid for (%s)",
+                         uuid_utoa(inode->gfid));
+            goto unlock;
+        }
+
         ret = 0;
         /* Missing xattr only means no keys were there, i.e
            a negative cache for the "loaded" keys
@@ -911,12 +1050,10 @@ mdc_inode_reset_need_lookup(xlator_t *this, inode_t *inode)
     if (mdc_inode_ctx_get(this, inode, &mdc) != 0)
         goto out;
 
-    LOCK(&mdc->lock);
-    {
-        need = mdc->need_lookup;
-        mdc->need_lookup = _gf_false;
-    }
-    UNLOCK(&mdc->lock);
+    /* Checked on every lookup, so avoid writing it when it's not set. */
+    if (__atomic_load_n(&mdc->need_lookup, __ATOMIC_RELAXED))
+        need = __atomic_exchange_n(&mdc->need_lookup, _gf_false,
+                                   __ATOMIC_ACQ_REL);
 
 out:
     return need;
@@ -930,11 +1067,7 @@ mdc_inode_set_need_lookup(xlator_t *this, inode_t *inode, gf_boolean_t need)
     if (mdc_inode_ctx_get(this, inode, &mdc) != 0)
         goto out;
 
-    LOCK(&mdc->lock);
-    {
-        mdc->need_lookup = need;
-    }
-    UNLOCK(&mdc->lock);
+    __atomic_store_n(&mdc->need_lookup, need, __ATOMIC_RELEASE);
 
 out:
     return;
@@ -951,13 +1084,13 @@ mdc_inode_iatt_invalidate(xlator_t *this, inode_t *inode)
 
     gen = mdc_inc_generation(this, inode) & 0xffffffff;
 
-    LOCK(&mdc->lock);
+    MDC_IATT_LOCK(mdc);
     {
         mdc->ia_time = 0;
         mdc->valid = _gf_false;
         mdc->generation = gen;
     }
-    UNLOCK(&mdc->lock);
+    MDC_IATT_UNLOCK(mdc);
 
 out:
     return;
@@ -1150,6 +1283,317 @@ mdc_prepare_request(xlator_t *this, mdc_local_t *local, dict_t *xdata)
     return xdata;
 }
 
+/* Speculative prefetch of the entries of a directory (md-cache-prefetch).
+ *
+ * Successful lookups that miss the cache are counted on their parent
+ * directory. When there are enough of them within the same second, or a
+ * couple of them right after the directory was opened, the application is
+ * probably walking the directory one name at a time. A synctask then reads
+ * the directory with readdirp and links its entries in the inode table, with
+ * their iatt and the cached xattrs, so that the next lookups are served from
+ * the cache. The read starts after the last prefetched entry that has been
+ * looked up, which is close to where the walk is.
+ *
+ * The entries cached ahead that haven't been looked up yet are limited to
+ * md-cache-prefetch-limit. When the limit stops a read, the walk starts
+ * another one once it gets past the cached entries. They are counted as hits
+ * when a lookup uses them, and as waste when they are forgotten or expire
+ * without being used. */
+
+#define MDC_PREFETCH_MISSES 8
+#define MDC_PREFETCH_MISSES_OPENDIR 2
+#define MDC_PREFETCH_OPENDIR_WINDOW 2 /* seconds */
+#define MDC_PREFETCH_READ_SIZE (128 * 1024)
+
+struct mdc_prefetch {
+    xlator_t *this;
+    inode_t *inode;       /* the directory */
+    off_t offset;         /* where the readdirp starts */
+    gf_boolean_t partial; /* stopped by md-cache-prefetch-limit */
+    uid_t uid;
+    gid_t gid;
+};
+
+static gf_boolean_t
+mdc_prefetch_entry(xlator_t *this, inode_t *parent, gf_dirent_t *entry,
+                   uint64_t incident_time, gf_boolean_t update_cache)
+{
+    struct mdc_conf *conf = this->private;
+    struct md_cache *mdc = NULL;
+    inode_t *inode = NULL;
+    struct iatt iatt;
+    gf_boolean_t cached = _gf_false;
+
+    if (!entry->inode || gf_uuid_is_null(entry->d_stat.ia_gfid) ||
+        (strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0))
+        return _gf_false;
+
+    inode = inode_grep(parent->table, parent, entry->d_name);
+    if (inode) {
+        cached = (mdc_inode_iatt_get(this, inode, &iatt) == 0);
+        inode_unref(inode);
+        if (cached)
+            return _gf_false;
+    }
+
+    /* The inode is not inode_lookup()'d because nobody above knows about
+     * it. It stays in the lru list, so the table can purge it. */
+    inode = inode_link(entry->inode, parent, entry->d_name, &entry->d_stat);
+    if (!inode)
+        return _gf_false;
+
+    mdc = mdc_inode_iatt_set(this, inode, &entry->d_stat, incident_time);
+    if (mdc && update_cache)
+        mdc_inode_xatt_set(this, inode, entry->dict, mdc);
+    if (mdc) {
+        LOCK(&mdc->lock);
+        {
+            mdc->prefetch_off = entry->d_off;
+        }
+        UNLOCK(&mdc->lock);
+    }
+    if (mdc &&
+        !__atomic_exchange_n(&mdc->prefetched, _gf_true, __ATOMIC_ACQ_REL)) {
+        GF_ATOMIC_INC(conf->prefetch_pending);
+        cached = _gf_true;
+    }
+
+    inode_unref(inode);
+
+    return cached;
+}
+
+static int
+mdc_prefetch_task(void *data)
+{
+    struct mdc_prefetch *pf = data;
+    xlator_t *this = pf->this;
+    struct mdc_conf *conf = this->private;
+    gf_dirent_t entries;
+    gf_dirent_t *entry = NULL;
+    loc_t loc = {
+        0,
+    };
+    fd_t *fd = NULL;
+    dict_t *xdata = NULL;
+    gf_boolean_t update_cache = _gf_false;
+    uint64_t incident_time = 0;
+    off_t offset = pf->offset;
+    int ret = 0;
+
+    SYNCTASK_SETID(pf->uid, pf->gid);
+
+    INIT_LIST_HEAD(&entries.list);
+
+    loc.inode = inode_ref(pf->inode);
+    gf_uuid_copy(loc.gfid, pf->inode->gfid);
+
+    fd = fd_create(pf->inode, 0);
+    if (!fd)
+        goto out;
+
+    ret = syncop_opendir(FIRST_CHILD(this), &loc, fd, NULL, NULL);
+    if (ret < 0)
+        goto out;
+
+    xdata = dict_new();
+    if (xdata)
+        update_cache = mdc_load_reqs(this, xdata);
+
+    MDC_STAT_INC(conf, prefetches);
+
+    while (GF_ATOMIC_GET(conf->prefetch_pending) < conf->prefetch_limit) {
+        incident_time = mdc_get_generation(this, pf->inode);
+        ret = syncop_readdirp(FIRST_CHILD(this), fd, MDC_PREFETCH_READ_SIZE,
+                              offset, &entries, xdata, NULL);
+        if (ret <= 0)
+            break;
+
+        list_for_each_entry(entry, &entries.list, list)
+        {
+            offset = entry->d_off;
+            if (GF_ATOMIC_GET(conf->prefetch_pending) >= conf->prefetch_limit)
+                break;
+            if (mdc_prefetch_entry(this, pf->inode, entry, incident_time,
+                                   update_cache))
+                MDC_STAT_INC(conf, prefetched);
+        }
+        gf_dirent_free(&entries);
+    }
+
+    pf->partial = (GF_ATOMIC_GET(conf->prefetch_pending) >=
+                   conf->prefetch_limit);
+
+out:
+    if (xdata)
+        dict_unref(xdata);
+    if (fd)
+        fd_unref(fd);
+    loc_wipe(&loc);
+
+    return 0;
+}
+
+static int
+mdc_prefetch_done(int ret, call_frame_t *frame, void *data)
+{
+    struct mdc_prefetch *pf = data;
+    struct md_cache *mdc = NULL;
+
+    if (mdc_inode_ctx_get(pf->this, pf->inode, &mdc) == 0) {
+        LOCK(&mdc->lock);
+        {
+            /* The rest of the directory hasn't been read. The walk can
+             * start another prefetch once it gets there. */
+            if (pf->partial)
+                mdc->prefetch_time = 0;
+            __atomic_store_n(&mdc->prefetching, _gf_false, __ATOMIC_RELEASE);
+        }
+        UNLOCK(&mdc->lock);
+    }
+
+    inode_unref(pf->inode);
+    GF_FREE(pf);
+
+    return 0;
+}
+
+/* Called for each successful lookup that missed the cache. */
+static void
+mdc_prefetch_check(call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+    struct mdc_conf *conf = this->private;
+    struct mdc_prefetch *pf = NULL;
+    struct md_cache *mdc = NULL;
+    gf_boolean_t start = _gf_false;
+    uint32_t misses = 0;
+    off_t offset = 0;
+    time_t now = 0;
+
+    if (!conf->prefetch || !loc->parent || !loc->name)
+        return;
+
+    if (GF_ATOMIC_GET(conf->prefetch_pending) >= conf->prefetch_limit)
+        return;
+
+    mdc = mdc_inode_prep(this, loc->parent);
+    if (!mdc)
+        return;
+
+    now = gf_time();
+    LOCK(&mdc->lock);
+    {
+        if (mdc->scan_time != now) {
+            mdc->scan_time = now;
+            mdc->scan_misses = 0;
+        }
+        mdc->scan_misses++;
+
+        misses = MDC_PREFETCH_MISSES;
+        if (now - mdc->opendir_time <= MDC_PREFETCH_OPENDIR_WINDOW)
+            misses = MDC_PREFETCH_MISSES_OPENDIR;
+
+        /* A directory read recently is still in the cache. */
+        if (!mdc->prefetching && (mdc->scan_misses >= misses) &&
+            (now >= mdc->prefetch_time + conf->timeout)) {
+            mdc->prefetching = _gf_true;
+            mdc->prefetch_time = now;
+            offset = mdc->prefetch_off;
+            start = _gf_true;
+        }
+    }
+    UNLOCK(&mdc->lock);
+
+    if (!start)
+        return;
+
+    pf = GF_CALLOC(1, sizeof(*pf), gf_mdc_mt_mdc_prefetch_t);
+    if (!pf)
+        goto err;
+    pf->this = this;
+    pf->inode = inode_ref(loc->parent);
+    pf->offset = offset;
+    pf->uid = frame->root->uid;
+    pf->gid = frame->root->gid;
+
+    if (synctask_new(this->ctx->env, mdc_prefetch_task, mdc_prefetch_done,
+                     NULL, pf) != 0) {
+        inode_unref(pf->inode);
+        GF_FREE(pf);
+        goto err;
+    }
+
+    gf_msg_debug(this->name, 0, "prefetching directory %s from %" PRId64,
+                 uuid_utoa(loc->parent->gfid), (int64_t)offset);
+
+    return;
+
+err:
+    __atomic_store_n(&mdc->prefetching, _gf_false, __ATOMIC_RELEASE);
+}
+
+static void
+mdc_prefetch_opendir(xlator_t *this, inode_t *inode)
+{
+    struct mdc_conf *conf = this->private;
+    struct md_cache *mdc = NULL;
+
+    if (!conf->prefetch)
+        return;
+
+    mdc = mdc_inode_prep(this, inode);
+    if (!mdc)
+        return;
+
+    LOCK(&mdc->lock);
+    {
+        mdc->opendir_time = gf_time();
+    }
+    UNLOCK(&mdc->lock);
+}
+
+/* Called when a prefetched entry is looked up. If the lookup had to go to
+ * the bricks anyway (@hit is false), the prefetch was a waste. */
+static void
+mdc_prefetch_used(xlator_t *this, inode_t *inode, inode_t *parent,
+                  gf_boolean_t hit)
+{
+    struct mdc_conf *conf = this->private;
+    struct md_cache *mdc = NULL;
+    struct md_cache *pmdc = NULL;
+    off_t offset = 0;
+
+    if (mdc_inode_ctx_get(this, inode, &mdc) != 0)
+        return;
+
+    if (!__atomic_load_n(&mdc->prefetched, __ATOMIC_RELAXED) ||
+        !__atomic_exchange_n(&mdc->prefetched, _gf_false, __ATOMIC_ACQ_REL))
+        return;
+
+    GF_ATOMIC_DEC(conf->prefetch_pending);
+    if (!hit) {
+        MDC_STAT_INC(conf, prefetch_waste);
+        return;
+    }
+    MDC_STAT_INC(conf, prefetch_hit);
+
+    /* The walk of the directory has reached this entry. */
+    if (!parent || (mdc_inode_ctx_get(this, parent, &pmdc) != 0))
+        return;
+
+    LOCK(&mdc->lock);
+    {
+        offset = mdc->prefetch_off;
+    }
+    UNLOCK(&mdc->lock);
+
+    LOCK(&pmdc->lock);
+    {
+        pmdc->prefetch_off = offset;
+    }
+    UNLOCK(&pmdc->lock);
+}
+
 int
 mdc_statfs_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                int32_t op_ret, int32_t op_errno, struct statvfs *buf,
@@ -1238,7 +1682,7 @@ mdc_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 
     if (op_ret != 0) {
         if (op_errno == ENOENT)
-            GF_ATOMIC_INC(conf->mdc_counter.negative_lookup);
+            MDC_STAT_INC(conf, negative_lookup);
 
         if (op_errno == ESTALE) {
             /* if op_errno is ENOENT, fuse-bridge will unlink the
@@ -1264,7 +1708,10 @@ mdc_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         if (local->update_cache) {
             mdc_inode_xatt_set(this, local->loc.inode, dict, mdc);
         }
+        mdc_prefetch_used(this, local->loc.inode, NULL, _gf_false);
     }
+
+    mdc_prefetch_check(frame, this, &local->loc);
 out:
     MDC_STACK_UNWIND(lookup, frame, op_ret, op_errno, inode, stbuf, dict,
                      postparent);
@@ -1287,42 +1734,43 @@ mdc_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
 
     local = mdc_local_get(frame, loc->inode);
     if (!local) {
-        GF_ATOMIC_INC(conf->mdc_counter.stat_miss);
+        MDC_STAT_INC(conf, stat_miss);
         goto uncached;
     }
 
     loc_copy(&local->loc, loc);
 
     if (!inode_is_linked(loc->inode)) {
-        GF_ATOMIC_INC(conf->mdc_counter.stat_miss);
+        MDC_STAT_INC(conf, stat_miss);
         goto uncached;
     }
 
     if (mdc_inode_reset_need_lookup(this, loc->inode)) {
-        GF_ATOMIC_INC(conf->mdc_counter.need_lookup);
+        MDC_STAT_INC(conf, need_lookup);
         goto uncached;
     }
 
     ret = mdc_inode_iatt_get(this, loc->inode, &stbuf);
     if (ret != 0) {
-        GF_ATOMIC_INC(conf->mdc_counter.stat_miss);
+        MDC_STAT_INC(conf, stat_miss);
         goto uncached;
     }
 
     if (xdata) {
         ret = mdc_inode_xatt_get(this, loc->inode, &xattr_rsp);
         if (ret != 0) {
-            GF_ATOMIC_INC(conf->mdc_counter.xattr_miss);
+            MDC_STAT_INC(conf, xattr_miss);
             goto uncached;
         }
 
         if (!mdc_xattr_satisfied(this, xdata, xattr_rsp)) {
-            GF_ATOMIC_INC(conf->mdc_counter.xattr_miss);
+            MDC_STAT_INC(conf, xattr_miss);
             goto uncached;
         }
     }
 
-    GF_ATOMIC_INC(conf->mdc_counter.stat_hit);
+    MDC_STAT_INC(conf, stat_hit);
+    mdc_prefetch_used(this, loc->inode, loc->parent, _gf_true);
     MDC_STACK_UNWIND(lookup, frame, 0, 0, loc->inode, &stbuf, xattr_rsp,
                      &postparent);
 
@@ -1392,7 +1840,7 @@ mdc_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
     loc_copy(&local->loc, loc);
 
     if (!inode_is_linked(loc->inode)) {
-        GF_ATOMIC_INC(conf->mdc_counter.stat_miss);
+        MDC_STAT_INC(conf, stat_miss);
         goto uncached;
     }
 
@@ -1400,7 +1848,7 @@ mdc_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
     if (ret != 0)
         goto uncached;
 
-    GF_ATOMIC_INC(conf->mdc_counter.stat_hit);
+    MDC_STAT_INC(conf, stat_hit);
     MDC_STACK_UNWIND(stat, frame, 0, 0, &stbuf, xdata);
 
     return 0;
@@ -1408,7 +1856,7 @@ mdc_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
 uncached:
     xdata = mdc_prepare_request(this, local, xdata);
 
-    GF_ATOMIC_INC(conf->mdc_counter.stat_miss);
+    MDC_STAT_INC(conf, stat_miss);
     STACK_WIND(frame, mdc_stat_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->stat, loc, xdata);
 
@@ -1467,7 +1915,7 @@ mdc_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
     if (ret != 0)
         goto uncached;
 
-    GF_ATOMIC_INC(conf->mdc_counter.stat_hit);
+    MDC_STAT_INC(conf, stat_hit);
     MDC_STACK_UNWIND(fstat, frame, 0, 0, &stbuf, xdata);
 
     return 0;
@@ -1475,7 +1923,7 @@ mdc_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 uncached:
     xdata = mdc_prepare_request(this, local, xdata);
 
-    GF_ATOMIC_INC(conf->mdc_counter.stat_miss);
+    MDC_STAT_INC(conf, stat_miss);
     STACK_WIND(frame, mdc_fstat_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->fstat, fd, xdata);
 
@@ -2529,7 +2977,7 @@ mdc_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, const char *key,
         op_errno = ENODATA;
     }
 
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_hit);
+    MDC_STAT_INC(conf, xattr_hit);
     MDC_STACK_UNWIND(getxattr, frame, ret, op_errno, xattr, xdata);
 
     if (xattr)
@@ -2542,7 +2990,7 @@ uncached:
         xdata = mdc_prepare_request(this, local, xdata);
     }
 
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_miss);
+    MDC_STAT_INC(conf, xattr_miss);
     STACK_WIND(frame, mdc_getxattr_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->getxattr, loc, key, xdata);
 
@@ -2617,7 +3065,7 @@ mdc_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *key,
         op_errno = ENODATA;
     }
 
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_hit);
+    MDC_STAT_INC(conf, xattr_hit);
     MDC_STACK_UNWIND(fgetxattr, frame, ret, op_errno, xattr, xdata);
 
     if (xattr)
@@ -2630,7 +3078,7 @@ uncached:
         xdata = mdc_prepare_request(this, local, xdata);
     }
 
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_miss);
+    MDC_STAT_INC(conf, xattr_miss);
     STACK_WIND(frame, mdc_fgetxattr_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->fgetxattr, fd, key, xdata);
 
@@ -2716,7 +3164,7 @@ mdc_removexattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
     if (ret != 0)
         goto uncached;
 
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_hit);
+    MDC_STAT_INC(conf, xattr_hit);
 
     if (!xattr || !dict_get(xattr, (char *)name)) {
         ret = -1;
@@ -2734,7 +3182,7 @@ mdc_removexattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
     return 0;
 
 uncached:
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_miss);
+    MDC_STAT_INC(conf, xattr_miss);
     STACK_WIND(frame, mdc_removexattr_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->removexattr, loc, name, xdata);
     return 0;
@@ -2816,7 +3264,7 @@ mdc_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
     if (ret != 0)
         goto uncached;
 
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_hit);
+    MDC_STAT_INC(conf, xattr_hit);
 
     if (!xattr || !dict_get(xattr, (char *)name)) {
         ret = -1;
@@ -2834,7 +3282,7 @@ mdc_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
     return 0;
 
 uncached:
-    GF_ATOMIC_INC(conf->mdc_counter.xattr_miss);
+    MDC_STAT_INC(conf, xattr_miss);
     STACK_WIND(frame, mdc_fremovexattr_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->fremovexattr, fd, name, xdata);
     return 0;
@@ -2850,8 +3298,10 @@ mdc_opendir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     if (!local)
         goto out;
 
-    if (op_ret == 0)
+    if (op_ret == 0) {
+        mdc_prefetch_opendir(this, local->loc.inode);
         goto out;
+    }
 
     if ((op_errno == ESTALE) || (op_errno == ENOENT))
         mdc_inode_iatt_invalidate(this, local->loc.inode);
@@ -3271,21 +3721,33 @@ mdc_priv_dump(xlator_t *this)
     gf_proc_dump_add_section("%s", key_prefix);
 
     gf_proc_dump_write("stat_hit_count", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.stat_hit));
+                       MDC_STAT_GET(conf, stat_hit));
     gf_proc_dump_write("stat_miss_count", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.stat_miss));
+                       MDC_STAT_GET(conf, stat_miss));
     gf_proc_dump_write("xattr_hit_count", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.xattr_hit));
+                       MDC_STAT_GET(conf, xattr_hit));
     gf_proc_dump_write("xattr_miss_count", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.xattr_miss));
+                       MDC_STAT_GET(conf, xattr_miss));
     gf_proc_dump_write("nameless_lookup_count", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.nameless_lookup));
+                       MDC_STAT_GET(conf, nameless_lookup));
     gf_proc_dump_write("negative_lookup_count", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.negative_lookup));
+                       MDC_STAT_GET(conf, negative_lookup));
     gf_proc_dump_write("stat_invalidations_received", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.stat_invals));
+                       MDC_STAT_GET(conf, stat_invals));
     gf_proc_dump_write("xattr_invalidations_received", "%" PRId64,
-                       GF_ATOMIC_GET(conf->mdc_counter.xattr_invals));
+                       MDC_STAT_GET(conf, xattr_invals));
+    gf_proc_dump_write("md-cache-prefetch", "%d", conf->prefetch);
+    gf_proc_dump_write("md-cache-prefetch-limit", "%d", conf->prefetch_limit);
+    gf_proc_dump_write("prefetch_count", "%" PRId64,
+                       MDC_STAT_GET(conf, prefetches));
+    gf_proc_dump_write("prefetched_entries", "%" PRId64,
+                       MDC_STAT_GET(conf, prefetched));
+    gf_proc_dump_write("prefetch_hit_count", "%" PRId64,
+                       MDC_STAT_GET(conf, prefetch_hit));
+    gf_proc_dump_write("prefetch_waste_count", "%" PRId64,
+                       MDC_STAT_GET(conf, prefetch_waste));
+    gf_proc_dump_write("prefetch_pending", "%" PRId64,
+                       GF_ATOMIC_GET(conf->prefetch_pending));
 
     return 0;
 }
@@ -3300,21 +3762,29 @@ mdc_dump_metrics(xlator_t *this, int fd)
         goto out;
 
     dprintf(fd, "%s.stat_cache_hit_count %" PRId64 "\n", this->name,
-            GF_ATOMIC_GET(conf->mdc_counter.stat_hit));
+            MDC_STAT_GET(conf, stat_hit));
     dprintf(fd, "%s.stat_cache_miss_count %" PRId64 "\n", this->name,
-            GF_ATOMIC_GET(conf->mdc_counter.stat_miss));
+            MDC_STAT_GET(conf, stat_miss));
     dprintf(fd, "%s.xattr_cache_hit_count %" PRId64 "\n", this->name,
-            GF_ATOMIC_GET(conf->mdc_counter.xattr_hit));
+            MDC_STAT_GET(conf, xattr_hit));
     dprintf(fd, "%s.xattr_cache_miss_count %" PRId64 "\n", this->name,
-            GF_ATOMIC_GET(conf->mdc_counter.xattr_miss));
+            MDC_STAT_GET(conf, xattr_miss));
     dprintf(fd, "%s.nameless_lookup_count %" PRId64 "\n", this->name,
-            GF_ATOMIC_GET(conf->mdc_counter.nameless_lookup));
+            MDC_STAT_GET(conf, nameless_lookup));
     dprintf(fd, "%s.negative_lookup_count %" PRId64 "\n", this->name,
-            GF_ATOMIC_GET(conf->mdc_counter.negative_lookup));
+            MDC_STAT_GET(conf, negative_lookup));
     dprintf(fd, "%s.stat_cache_invalidations_received %" PRId64 "\n",
-            this->name, GF_ATOMIC_GET(conf->mdc_counter.stat_invals));
+            this->name, MDC_STAT_GET(conf, stat_invals));
     dprintf(fd, "%s.xattr_cache_invalidations_received %" PRId64 "\n",
-            this->name, GF_ATOMIC_GET(conf->mdc_counter.xattr_invals));
+            this->name, MDC_STAT_GET(conf, xattr_invals));
+    dprintf(fd, "%s.prefetch_count %" PRId64 "\n", this->name,
+            MDC_STAT_GET(conf, prefetches));
+    dprintf(fd, "%s.prefetched_entries %" PRId64 "\n", this->name,
+            MDC_STAT_GET(conf, prefetched));
+    dprintf(fd, "%s.prefetch_hit_count %" PRId64 "\n", this->name,
+            MDC_STAT_GET(conf, prefetch_hit));
+    dprintf(fd, "%s.prefetch_waste_count %" PRId64 "\n", this->name,
+            MDC_STAT_GET(conf, prefetch_waste));
 out:
     return 0;
 }
@@ -3471,7 +3941,7 @@ mdc_invalidate(xlator_t *this, void *data)
         (UP_NLINK | UP_RENAME_FLAGS | UP_FORGET | UP_INVAL_ATTR)) {
         mdc_inode_iatt_invalidate(this, inode);
         mdc_inode_xatt_invalidate(this, inode);
-        GF_ATOMIC_INC(conf->mdc_counter.stat_invals);
+        MDC_STAT_INC(conf, stat_invals);
         goto out;
     }
 
@@ -3487,7 +3957,7 @@ mdc_invalidate(xlator_t *this, void *data)
             ret = -1;
             goto out;
         }
-        GF_ATOMIC_INC(conf->mdc_counter.stat_invals);
+        MDC_STAT_INC(conf, stat_invals);
     }
 
     if (up_ci->flags & UP_XATTR) {
@@ -3496,13 +3966,13 @@ mdc_invalidate(xlator_t *this, void *data)
         else
             ret = mdc_inode_xatt_invalidate(this, inode);
 
-        GF_ATOMIC_INC(conf->mdc_counter.xattr_invals);
+        MDC_STAT_INC(conf, xattr_invals);
     } else if (up_ci->flags & UP_XATTR_RM) {
         tmp.inode = inode;
         tmp.this = this;
         ret = dict_foreach(up_ci->dict, mdc_inval_xatt, &tmp);
 
-        GF_ATOMIC_INC(conf->mdc_counter.xattr_invals);
+        MDC_STAT_INC(conf, xattr_invals);
     }
 
 out:
@@ -3676,6 +4146,11 @@ mdc_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("md-cache-statfs", conf->cache_statfs, options, bool, out);
 
+    GF_OPTION_RECONF("md-cache-prefetch", conf->prefetch, options, bool, out);
+
+    GF_OPTION_RECONF("md-cache-prefetch-limit", conf->prefetch_limit, options,
+                     int32, out);
+
     GF_OPTION_RECONF("xattr-cache-list", tmp_str, options, str, out);
 
     ret = mdc_xattr_list_populate(conf, tmp_str);
@@ -3710,6 +4185,7 @@ mdc_init(xlator_t *this)
     struct mdc_conf *conf = NULL;
     time_t timeout = 0;
     char *tmp_str = NULL;
+    int i;
 
     conf = GF_CALLOC(sizeof(*conf), 1, gf_mdc_mt_mdc_conf_t);
     if (!conf) {
@@ -3751,6 +4227,11 @@ mdc_init(xlator_t *this)
     pthread_mutex_init(&conf->statfs_cache.lock, NULL);
     GF_OPTION_INIT("md-cache-statfs", conf->cache_statfs, bool, out);
 
+    GF_OPTION_INIT("md-cache-prefetch", conf->prefetch, bool, out);
+
+    GF_OPTION_INIT("md-cache-prefetch-limit", conf->prefetch_limit, int32,
+                   out);
+
     GF_OPTION_INIT("xattr-cache-list", tmp_str, str, out);
     mdc_xattr_list_populate(conf, tmp_str);
 
@@ -3758,15 +4239,22 @@ mdc_init(xlator_t *this)
     conf->statfs_cache.last_refreshed = (time_t)-1;
 
     /* initialize gf_atomic_t counters */
-    GF_ATOMIC_INIT(conf->mdc_counter.stat_hit, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.stat_miss, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.xattr_hit, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.xattr_miss, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.negative_lookup, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.nameless_lookup, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.stat_invals, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.xattr_invals, 0);
-    GF_ATOMIC_INIT(conf->mdc_counter.need_lookup, 0);
+    for (i = 0; i < MDC_STAT_STRIPES; i++) {
+        GF_ATOMIC_INIT(conf->mdc_counter[i].stat_hit, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].stat_miss, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].xattr_hit, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].xattr_miss, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].negative_lookup, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].nameless_lookup, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].stat_invals, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].xattr_invals, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].need_lookup, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].prefetches, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].prefetched, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].prefetch_hit, 0);
+        GF_ATOMIC_INIT(conf->mdc_counter[i].prefetch_waste, 0);
+    }
+    GF_ATOMIC_INIT(conf->prefetch_pending, 0);
     GF_ATOMIC_INIT(conf->generation, 0);
 
     /* If timeout is greater than 60s (default before the patch that added
@@ -4026,6 +4514,28 @@ struct volume_options mdc_options[] = {
         .description = "A comma separated list of xattrs that shall be "
                        "cached by md-cache. The only wildcard allowed is '*'",
     },
+    {
+        .key = {"md-cache-prefetch"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "When the lookups on the entries of a directory miss "
+                       "the cache one after the other, read the directory "
+                       "with readdirp and cache the entries that haven't "
+                       "been looked up yet",
+    },
+    {
+        .key = {"md-cache-prefetch-limit"},
+        .type = GF_OPTION_TYPE_INT,
+        .min = 0,
+        .max = 1048576,
+        .default_value = "16384",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "Maximum number of entries cached ahead by "
+                       "md-cache-prefetch that haven't been looked up yet",
+    },
     {.key = {"pass-through"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "false",
@@ -3808,6 +3808,215 @@ out:
     return ret;
 }
 
+/* A GF_IPC_TARGET_XATTROP_BATCH ipc carries xattrops on many inodes (see
+ * afr_xattrop_batch_send()). Each one is wound to the brick graph as a
+ * normal xattrop, so that index, locks and the other xlators see it like
+ * any other, and the answers are returned together in the reply. The ones
+ * the client sends on an fd are wound as fxattrops on an anonymous fd. */
+typedef struct _server_xattrop_batch {
+    call_frame_t *frame; /* frame of the ipc */
+    dict_t *rsp;
+    gf_atomic_t pending;
+} server_xattrop_batch_t;
+
+static void
+server_xattrop_batch_set(server_xattrop_batch_t *batch, int32_t idx,
+                         int32_t op_ret, int32_t op_errno, dict_t *xattr)
+{
+    char key[64];
+    char *buf = NULL;
+    u_int len = 0;
+
+    snprintf(key, sizeof(key), GF_XATTROP_BATCH_RET, idx);
+    if (dict_set_int32(batch->rsp, key, op_ret) != 0)
+        return;
+    snprintf(key, sizeof(key), GF_XATTROP_BATCH_ERRNO, idx);
+    if (dict_set_int32(batch->rsp, key, gf_errno_to_error(op_errno)) != 0)
+        return;
+
+    if ((op_ret < 0) || !xattr)
+        return;
+
+    if (dict_allocate_and_serialize(xattr, &buf, &len) != 0)
+        return;
+    snprintf(key, sizeof(key), GF_XATTROP_BATCH_XATTR, idx);
+    if (dict_set_dynptr(batch->rsp, key, buf, len) != 0)
+        GF_FREE(buf);
+}
+
+static void
+server_xattrop_batch_unref(server_xattrop_batch_t *batch)
+{
+    call_frame_t *frame = batch->frame;
+
+    if (GF_ATOMIC_DEC(batch->pending) != 0)
+        return;
+
+    server4_ipc_cbk(frame, NULL, frame->this, 0, 0, batch->rsp);
+
+    dict_unref(batch->rsp);
+    GF_FREE(batch);
+}
+
+static int
+server_xattrop_batch_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, dict_t *dict,
+                         dict_t *xdata)
+{
+    server_xattrop_batch_t *batch = frame->local;
+
+    frame->local = NULL;
+    server_xattrop_batch_set(batch, (long)cookie, op_ret, op_errno, dict);
+
+    gf_client_unref(frame->root->client);
+    STACK_DESTROY(frame->root);
+
+    server_xattrop_batch_unref(batch);
+
+    return 0;
+}
+
+static int
+server_xattrop_batch_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno, dict_t *dict,
+                            dict_t *xdata)
+{
+    /* The gfid handle is gone if the file has been unlinked, but the
+     * client may still have it open. It then sends the fxattrop on its own
+     * fd. */
+    if ((op_ret < 0) && (op_errno == ENOENT))
+        op_errno = ESTALE;
+
+    return server_xattrop_batch_cbk(frame, cookie, this, op_ret, op_errno,
+                                    dict, xdata);
+}
+
+static int
+server_xattrop_batch_wind(server_xattrop_batch_t *batch, xlator_t *bound_xl,
+                          dict_t *xdata, int32_t idx)
+{
+    server_state_t *state = CALL_STATE(batch->frame);
+    call_frame_t *frame = NULL;
+    dict_t *xattr = NULL;
+    fd_t *fd = NULL;
+    loc_t loc = {
+        0,
+    };
+    char key[64];
+    void *buf = NULL;
+    int len = 0;
+    int32_t optype = 0;
+    int32_t on_fd = 0;
+    int op_errno = EINVAL;
+
+    snprintf(key, sizeof(key), GF_XATTROP_BATCH_GFID, idx);
+    if (dict_get_gfuuid(xdata, key, &loc.gfid) != 0)
+        goto err;
+    snprintf(key, sizeof(key), GF_XATTROP_BATCH_OPTYPE, idx);
+    if (dict_get_int32(xdata, key, &optype) != 0)
+        goto err;
+    snprintf(key, sizeof(key), GF_XATTROP_BATCH_XATTR, idx);
+    if (dict_get_ptr_and_len(xdata, key, &buf, &len) != 0)
+        goto err;
+    snprintf(key, sizeof(key), GF_XATTROP_BATCH_FD, idx);
+    (void)dict_get_int32(xdata, key, &on_fd);
+
+    op_errno = ENOMEM;
+    xattr = dict_new();
+    if (!xattr)
+        goto err;
+    if (dict_unserialize(buf, len, &xattr) != 0) {
+        op_errno = EINVAL;
+        goto err;
+    }
+
+    /* The client keeps the inode in use while its transaction runs, so it
+     * should be in the table. If it isn't, the client sends the xattrop on
+     * its own, which resolves the inode. */
+    loc.inode = inode_find(state->itable, loc.gfid);
+    if (!loc.inode) {
+        op_errno = ESTALE;
+        goto err;
+    }
+
+    op_errno = ENOMEM;
+    if (on_fd) {
+        fd = fd_anonymous(loc.inode);
+        if (!fd)
+            goto err;
+    }
+
+    frame = copy_frame(batch->frame);
+    if (!frame)
+        goto err;
+    frame->root->client = gf_client_ref(batch->frame->root->client);
+    frame->local = batch;
+
+    if (fd) {
+        frame->root->op = GF_FOP_FXATTROP;
+        STACK_WIND_COOKIE(frame, server_xattrop_batch_fd_cbk,
+                          (void *)(long)idx, bound_xl,
+                          bound_xl->fops->fxattrop, fd, optype, xattr, NULL);
+        fd_unref(fd);
+    } else {
+        frame->root->op = GF_FOP_XATTROP;
+        STACK_WIND_COOKIE(frame, server_xattrop_batch_cbk, (void *)(long)idx,
+                          bound_xl, bound_xl->fops->xattrop, &loc, optype,
+                          xattr, NULL);
+    }
+
+    loc_wipe(&loc);
+    dict_unref(xattr);
+
+    return 0;
+
+err:
+    if (fd)
+        fd_unref(fd);
+    loc_wipe(&loc);
+    if (xattr)
+        dict_unref(xattr);
+
+    server_xattrop_batch_set(batch, idx, -1, op_errno, NULL);
+
+    return -1;
+}
+
+static void
+server_xattrop_batch(call_frame_t *frame, xlator_t *bound_xl, dict_t *xdata)
+{
+    server_xattrop_batch_t *batch = NULL;
+    int32_t count = 0;
+    int32_t i;
+
+    if (!xdata ||
+        (dict_get_int32(xdata, GF_XATTROP_BATCH_COUNT, &count) != 0) ||
+        (count <= 0) || (count > GF_XATTROP_BATCH_MAX)) {
+        server4_ipc_cbk(frame, NULL, frame->this, -1, EINVAL, NULL);
+        return;
+    }
+
+    batch = GF_CALLOC(1, sizeof(*batch), gf_server_mt_xattrop_batch_t);
+    if (batch)
+        batch->rsp = dict_new();
+    if (!batch || !batch->rsp) {
+        GF_FREE(batch);
+        server4_ipc_cbk(frame, NULL, frame->this, -1, ENOMEM, NULL);
+        return;
+    }
+    batch->frame = frame;
+
+    /* One extra reference is kept while the xattrops are being wound. */
+    GF_ATOMIC_INIT(batch->pending, count + 1);
+
+    for (i = 0; i < count; i++) {
+        if (server_xattrop_batch_wind(batch, bound_xl, xdata, i) != 0)
+            GF_ATOMIC_DEC(batch->pending);
+    }
+
+    server_xattrop_batch_unref(batch);
+}
+
 int
 server4_0_ipc(rpcsvc_request_t *req)
 {
@@ -3834,6 +4043,10 @@ server4_0_ipc(rpcsvc_request_t *req)
         goto out;
     }
     ret = 0;
+    if (args.op == GF_IPC_TARGET_XATTROP_BATCH) {
+        server_xattrop_batch(frame, bound_xl, state->xdata);
+        goto out;
+    }
     STACK_WIND(frame, server4_ipc_cbk, bound_xl, bound_xl->fops->ipc, args.op,
                state->xdata);
 
@@ -4040,6 +4253,18 @@ server4_0_readv(rpcsvc_request_t *req)
         goto out;
     }
 
+    /* Only the transport knows if it can send the reply from a pipe. */
+    if (state->xdata)
+        dict_del_sizen(state->xdata, GLUSTERFS_READV_PIPE_PAYLOAD);
+    if (req->trans->pipe_payload) {
+        if (!state->xdata)
+            state->xdata = dict_new();
+        if (state->xdata &&
+            dict_set_int32_sizen(state->xdata, GLUSTERFS_READV_PIPE_PAYLOAD,
+                                 1))
+            gf_msg_debug(THIS->name, 0, "failed to request a pipe payload");
+    }
+
     ret = 0;
     resolve_and_resume(frame, server4_readv_resume);
 out:
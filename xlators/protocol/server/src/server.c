@@ -775,6 +775,17 @@ server_check_event_threads(xlator_t *this, server_conf_t *conf, int32_t new)
     return gf_event_reconfigure_threads(pool, target);
 }
 
+static event_balance_t
+server_event_balance(const char *name)
+{
+    if (strcmp(name, "least-loaded") == 0)
+        return EVENT_BALANCE_LEAST_LOADED;
+    if (strcmp(name, "incoming-cpu") == 0)
+        return EVENT_BALANCE_INCOMING_CPU;
+
+    return EVENT_BALANCE_ROUND_ROBIN;
+}
+
 int
 server_reconfigure(xlator_t *this, dict_t *options)
 {
@@ -789,10 +800,12 @@ server_reconfigure(xlator_t *this, dict_t *options)
     int ret = 0;
     char *statedump_path = NULL;
     int32_t new_nthread = 0;
+    char *balance = NULL;
     char *auth_path = NULL;
     char *xprt_path = NULL;
     xlator_t *oldTHIS;
     xlator_t *kid;
+    struct event_pool *pool = NULL;
 
     /*
      * Since we're not a fop, we can't really count on THIS being set
@@ -1004,6 +1017,14 @@ do_rpc:
     if (ret)
         goto out;
 
+    pool = this->ctx->event_pool;
+    GF_OPTION_RECONF("event-threads-numa-pin", pool->numa_pin, options, bool,
+                     out);
+    GF_OPTION_RECONF("event-threads-balance", balance, options, str, out);
+    pool->balance = server_event_balance(balance);
+    GF_OPTION_RECONF("event-threads-sharding", pool->sharded, options, bool,
+                     out);
+
 out:
     THIS = oldTHIS;
     gf_msg_debug("", 0, "returning %d", ret);
@@ -1112,6 +1133,8 @@ server_init(xlator_t *this)
     char *transport_type = NULL;
     char *statedump_path = NULL;
     int total_transport = 0;
+    struct event_pool *pool = NULL;
+    char *balance = NULL;
 
     GF_VALIDATE_OR_GOTO("init", this, err);
 
@@ -1140,6 +1163,12 @@ server_init(xlator_t *this)
     if (ret)
         goto err;
 
+    pool = this->ctx->event_pool;
+    GF_OPTION_INIT("event-threads-numa-pin", pool->numa_pin, bool, err);
+    GF_OPTION_INIT("event-threads-balance", balance, str, err);
+    pool->balance = server_event_balance(balance);
+    GF_OPTION_INIT("event-threads-sharding", pool->sharded, bool, err);
+
     ret = server_build_config(this, conf);
     if (ret)
         goto err;
@@ -1916,6 +1945,41 @@ struct volume_options server_options[] = {
                     "faster, depending on available processing power.",
      .op_version = {GD_OP_VERSION_3_7_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_RANGE},
+    {.key = {"event-threads-numa-pin"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Restrict each event thread to the CPUs of a single NUMA "
+                    "node, distributing the threads evenly across the nodes. "
+                    "Threads already running are pinned when they process "
+                    "their next event. Disabling it doesn't unpin them. "
+                    "Threads bound to CPUs by event-threads-balance "
+                    "'incoming-cpu' are not pinned.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"event-threads-sharding"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Give each event thread its own epoll instance. New "
+                    "connections are assigned to a single thread, chosen "
+                    "as configured by event-threads-balance, which avoids "
+                    "re-arming the connection after every message. "
+                    "Connections established before enabling it keep using "
+                    "the shared epoll instance.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"event-threads-balance"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"round-robin", "least-loaded", "incoming-cpu"},
+     .default_value = "round-robin",
+     .description = "How new connections are distributed among the event "
+                    "threads when event-threads-sharding is enabled. "
+                    "'incoming-cpu' uses the CPU that received the packets "
+                    "of the connection (SO_INCOMING_CPU) and binds each "
+                    "event thread to the CPUs whose connections it "
+                    "receives. This takes precedence over "
+                    "event-threads-numa-pin.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"dynamic-auth"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
@@ -44,6 +44,7 @@
 #include <glusterfs/locking.h>
 #include "posix-aio.h"
 #include "posix-io-uring.h"
+#include "posix-gf-io.h"
 #include <glusterfs/glusterfs-acl.h>
 #include "posix-messages.h"
 #include <glusterfs/events.h>
@@ -117,6 +118,8 @@ posix_priv(xlator_t *this)
     gf_proc_dump_write("max_read", "%" PRId64, GF_ATOMIC_GET(priv->read_value));
     gf_proc_dump_write("max_write", "%" PRId64,
                        GF_ATOMIC_GET(priv->write_value));
+    gf_proc_dump_write("rchecksum_xxh64x2", "%" PRId64,
+                       GF_ATOMIC_GET(priv->rchecksum_xxh64x2));
 
     return 0;
 }
@@ -399,6 +402,14 @@ posix_reconfigure(xlator_t *this, dict_t *options)
     else
         posix_io_uring_off(this);
 
+    GF_OPTION_RECONF("io-framework", priv->gf_io_configured, options, bool,
+                     out);
+
+    if (priv->gf_io_configured)
+        posix_gf_io_on(this);
+    else
+        posix_gf_io_off(this);
+
     GF_OPTION_RECONF("update-link-count-parent", priv->update_pgfid_nlinks,
                      options, bool, out);
 
@@ -898,6 +909,7 @@ posix_init(xlator_t *this)
     LOCK_INIT(&_private->lock);
     GF_ATOMIC_INIT(_private->read_value, 0);
     GF_ATOMIC_INIT(_private->write_value, 0);
+    GF_ATOMIC_INIT(_private->rchecksum_xxh64x2, 0);
 
     _private->export_statfs = 1;
     tmp_data = dict_get(this->options, "export-statfs-size");
@@ -1107,6 +1119,14 @@ posix_init(xlator_t *this)
         }
     }
 
+    GF_OPTION_INIT("io-framework", _private->gf_io_configured, bool, out);
+    if (_private->gf_io_configured) {
+        op_ret = posix_gf_io_on(this);
+        if (op_ret < 0) {
+            _private->gf_io_configured = _gf_false;
+        }
+    }
+
     GF_OPTION_INIT("node-uuid-pathinfo", _private->node_uuid_pathinfo, bool,
                    out);
     if (_private->node_uuid_pathinfo &&
@@ -1394,6 +1414,15 @@ struct volume_options posix_options[] = {
      .description = "Support for Linux io_uring",
      .op_version = {GD_OP_VERSION_9_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"io-framework"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Execute open, fstat, fgetxattr, fsetxattr, fallocate, "
+                    "unlink and rename through the I/O framework of the "
+                    "brick process (see --io-engine) instead of blocking "
+                    "the calling thread.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"brick-uid"},
      .type = GF_OPTION_TYPE_INT,
      .min = -1,
@@ -1577,7 +1606,9 @@ struct volume_options posix_options[] = {
      .flags = OPT_FLAG_SETTABLE,
      .tags = {"posix"},
      .description = "If enabled, posix_rchecksum uses the FIPS compliant"
-                    "SHA256 checksum. MD5 otherwise."},
+                    " SHA256 checksum. Otherwise it uses MD5, or xxh64x2 "
+                    "(two XXH64 hashes with different seeds) if the client "
+                    "requests it."},
     {.key = {"ctime"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
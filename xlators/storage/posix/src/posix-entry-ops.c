@@ -128,7 +128,7 @@ out:
     return ret;
 }
 
-static dict_t *
+dict_t *
 posix_dict_set_nlink(dict_t *req, dict_t *res, int32_t nlink)
 {
     int ret = -1;
@@ -398,7 +398,7 @@ nameless_lookup_unlink_dir_out:
     return 0;
 }
 
-static int32_t
+int32_t
 posix_set_gfid2path_xattr(xlator_t *this, const char *path, uuid_t pgfid,
                           const char *bname)
 {
@@ -1297,7 +1297,7 @@ posix_skip_non_linkto_unlink(dict_t *xdata, loc_t *loc, char *key,
     return skip_unlink;
 }
 
-static int32_t
+int32_t
 posix_remove_gfid2path_xattr(xlator_t *this, const char *path, uuid_t pgfid,
                              const char *bname)
 {
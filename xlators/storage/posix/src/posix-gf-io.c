@@ -0,0 +1,1348 @@
+/*
+   Copyright (c) 2021 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#include <libgen.h>
+
+#include "posix.h"
+#include "posix-messages.h"
+#include "posix-handle.h"
+#include "posix-metadata.h"
+#include "posix-gfid-path.h"
+#include "posix-gf-io.h"
+
+#include <glusterfs/glusterfs-acl.h>
+#include <glusterfs/gf-io.h>
+
+#ifdef HAVE_STATX
+
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+/* Fops are executed in stages. Each stage sends one or more requests to the
+ * I/O framework in a single batch. Once all requests of a stage have been
+ * completed, the function of the next stage is called from the context of
+ * the I/O worker that has processed the last completion.
+ *
+ * Only the common cases of each fop are handled here. Whenever something
+ * special is requested (cloudsync, dht internal keys, durability, ...) or
+ * some precondition is not met, the regular synchronous implementation is
+ * used. */
+
+struct posix_gf_io;
+typedef void(posix_gf_io_next_f)(struct posix_gf_io *);
+
+struct posix_gf_io_req {
+    gf_io_request_t req;
+    struct posix_gf_io *pio;
+    int32_t res;
+};
+
+struct posix_gf_io {
+    call_frame_t *frame;
+    xlator_t *this;
+    fd_t *fd;
+    loc_t loc;
+    loc_t newloc;
+    dict_t *xdata;
+    dict_t *rsp_xdata;
+
+    char *path;
+    char *par_path;
+    char *newpath;
+    char *newpar_path;
+    char *handle;
+    char *name;
+    char *value;
+
+    struct iatt stbuf;
+    struct iatt prebuf;
+    struct iatt postbuf;
+    struct iatt preparent;
+    struct iatt postparent;
+    struct iatt prenewparent;
+    struct iatt postnewparent;
+    struct statx stx[3];
+
+    char *keys[POSIX_GF_IO_MAX_REQS];
+    data_t *values[POSIX_GF_IO_MAX_REQS];
+    int32_t keys_count;
+    int32_t key;
+
+    posix_inode_ctx_t *ctx;
+
+    posix_gf_io_next_f *next;
+    int32_t pending;
+    int32_t flags;
+    int32_t nlink;
+    int32_t op_ret;
+    int32_t op_errno;
+    int _fd;
+    uint16_t personality;
+    gf_boolean_t was_present;
+    uuid_t victim;
+
+    struct posix_gf_io_req reqs[POSIX_GF_IO_MAX_REQS];
+};
+
+/* Requests are executed with the same credentials as the synchronous fops.
+ * When these switch to the fsuid and fsgid of the caller, a personality is
+ * registered for each pair so that the ring uses them too, whichever thread
+ * flushes the SQ. The submitter also switches, since some requests may be
+ * executed inline. Otherwise all requests use the credentials of the brick
+ * and access checks are done by upper xlators, as for the synchronous
+ * fops. */
+#undef HAVE_SET_FSID
+#ifdef HAVE_SET_FSID
+
+#define DECLARE_OLD_FS_ID_VAR                                                  \
+    uid_t old_fsuid;                                                           \
+    gid_t old_fsgid;
+
+#define SET_FS_ID(uid, gid)                                                    \
+    do {                                                                       \
+        old_fsuid = setfsuid(uid);                                             \
+        old_fsgid = setfsgid(gid);                                             \
+    } while (0)
+
+#define SET_TO_OLD_FS_ID()                                                     \
+    do {                                                                       \
+        setfsuid(old_fsuid);                                                   \
+        setfsgid(old_fsgid);                                                   \
+    } while (0)
+
+/* Registered personalities are kept until the ring is destroyed. When the
+ * slot of a pair is already taken by another one, the synchronous fop is
+ * used. */
+#define POSIX_GF_IO_PERSONALITIES 1024
+
+struct posix_gf_io_cred {
+    uid_t uid;
+    gid_t gid;
+    uint16_t personality;
+};
+
+static struct posix_gf_io_cred posix_gf_io_creds[POSIX_GF_IO_PERSONALITIES];
+static pthread_mutex_t posix_gf_io_creds_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int32_t
+posix_gf_io_personality(call_frame_t *frame)
+{
+    struct posix_gf_io_cred *cred = NULL;
+    uid_t uid = frame->root->uid;
+    gid_t gid = frame->root->gid;
+    int32_t res = -EBUSY;
+    DECLARE_OLD_FS_ID_VAR;
+
+    if ((uid == 0) && (gid == 0))
+        return 0;
+
+    cred = &posix_gf_io_creds[(uid * 31 + gid) % POSIX_GF_IO_PERSONALITIES];
+
+    pthread_mutex_lock(&posix_gf_io_creds_lock);
+    {
+        if (cred->personality == 0) {
+            SET_FS_ID(uid, gid);
+            res = gf_io_personality_register();
+            SET_TO_OLD_FS_ID();
+            if (res > 0) {
+                cred->uid = uid;
+                cred->gid = gid;
+                cred->personality = res;
+            }
+        } else if ((cred->uid == uid) && (cred->gid == gid)) {
+            res = cred->personality;
+        }
+    }
+    pthread_mutex_unlock(&posix_gf_io_creds_lock);
+
+    return res;
+}
+
+#else
+
+#define DECLARE_OLD_FS_ID_VAR
+#define SET_FS_ID(uid, gid)
+#define SET_TO_OLD_FS_ID()
+
+static int32_t
+posix_gf_io_personality(call_frame_t *frame)
+{
+    return 0;
+}
+
+#endif
+
+static struct posix_gf_io *
+posix_gf_io_new(call_frame_t *frame, xlator_t *this, dict_t *xdata)
+{
+    struct posix_gf_io *pio = NULL;
+    int32_t personality;
+
+    personality = posix_gf_io_personality(frame);
+    if (personality < 0)
+        return NULL;
+
+    pio = GF_CALLOC(1, sizeof(*pio), gf_posix_mt_gf_io);
+    if (!pio)
+        return NULL;
+
+    pio->frame = frame;
+    pio->this = this;
+    pio->personality = personality;
+    pio->_fd = -1;
+    if (xdata)
+        pio->xdata = dict_ref(xdata);
+
+    return pio;
+}
+
+static void
+posix_gf_io_free(struct posix_gf_io *pio)
+{
+    int32_t i;
+
+    for (i = 0; i < pio->keys_count; i++) {
+        GF_FREE(pio->keys[i]);
+        data_unref(pio->values[i]);
+    }
+    if (pio->fd)
+        fd_unref(pio->fd);
+    loc_wipe(&pio->loc);
+    loc_wipe(&pio->newloc);
+    if (pio->xdata)
+        dict_unref(pio->xdata);
+    if (pio->rsp_xdata)
+        dict_unref(pio->rsp_xdata);
+
+    GF_FREE(pio->path);
+    GF_FREE(pio->par_path);
+    GF_FREE(pio->newpath);
+    GF_FREE(pio->newpar_path);
+    GF_FREE(pio->handle);
+    GF_FREE(pio->name);
+    GF_FREE(pio->value);
+    GF_FREE(pio);
+}
+
+GF_IO_CBK(posix_gf_io_cbk, op, res, static)
+{
+    struct posix_gf_io_req *req = op->data;
+    struct posix_gf_io *pio = req->pio;
+
+    req->res = res;
+    if (uatomic_sub_return(&pio->pending, 1) == 0) {
+        THIS = pio->this;
+        pio->next(pio);
+    }
+}
+
+/* Returns the next request of the batch being built. */
+static struct posix_gf_io_req *
+posix_gf_io_req(struct posix_gf_io *pio, gf_io_batch_t *batch)
+{
+    struct posix_gf_io_req *req = &pio->reqs[batch->count];
+
+    req->pio = pio;
+    req->res = 0;
+
+    return req;
+}
+
+/* Submits all the requests of the current stage. 'pio' may have already
+ * been released when this function returns. */
+static void
+posix_gf_io_submit(struct posix_gf_io *pio, gf_io_batch_t *batch,
+                   posix_gf_io_next_f *next)
+{
+    gf_io_request_t *req = NULL;
+    DECLARE_OLD_FS_ID_VAR;
+
+    if (pio->personality != 0) {
+        list_for_each_entry(req, &batch->requests, list)
+        {
+            gf_io_request_personality(req, pio->personality);
+        }
+    }
+
+    pio->next = next;
+    uatomic_set(&pio->pending, batch->count);
+
+    SET_FS_ID(pio->frame->root->uid, pio->frame->root->gid);
+    gf_io_batch_submit(batch);
+    SET_TO_OLD_FS_ID();
+
+    gf_io_flush();
+}
+
+static void
+posix_gf_io_statx_add(struct posix_gf_io *pio, gf_io_batch_t *batch, int dfd,
+                      const char *path, struct statx *buf)
+{
+    struct posix_gf_io_req *req = posix_gf_io_req(pio, batch);
+    int32_t flags = AT_SYMLINK_NOFOLLOW;
+
+    if (dfd >= 0)
+        flags |= AT_EMPTY_PATH;
+
+    gf_io_statx_prepare(&req->req, posix_gf_io_cbk, dfd, path, flags,
+                        STATX_BASIC_STATS, buf, req);
+    gf_io_batch_add(batch, &req->req, NULL);
+}
+
+static void
+posix_gf_io_stat_from_statx(struct stat *st, struct statx *stx)
+{
+    memset(st, 0, sizeof(*st));
+
+    st->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+    st->st_ino = stx->stx_ino;
+    st->st_mode = stx->stx_mode;
+    st->st_nlink = stx->stx_nlink;
+    st->st_uid = stx->stx_uid;
+    st->st_gid = stx->stx_gid;
+    st->st_rdev = makedev(stx->stx_rdev_major, stx->stx_rdev_minor);
+    st->st_size = stx->stx_size;
+    st->st_blksize = stx->stx_blksize;
+    st->st_blocks = stx->stx_blocks;
+    st->st_atim.tv_sec = stx->stx_atime.tv_sec;
+    st->st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+    st->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+    st->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+    st->st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+    st->st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+}
+
+/* Equivalent to posix_fdstat() (when 'path' is NULL) or posix_pstat() with
+ * 'fetch_time' set, using the result of a previous statx request. If 'gfid'
+ * is not known, it's read from the file. */
+static int
+posix_gf_io_iatt(xlator_t *this, struct statx *stx, inode_t *inode,
+                 uuid_t gfid, const char *path, int fd, struct iatt *buf)
+{
+    struct posix_private *priv = this->private;
+    struct stat st;
+    int ret = 0;
+
+    posix_gf_io_stat_from_statx(&st, stx);
+
+    if (st.st_nlink && !S_ISDIR(st.st_mode))
+        st.st_nlink--;
+
+    memset(buf, 0, sizeof(*buf));
+    iatt_from_stat(buf, &st);
+
+    if (priv->ctime) {
+        if (inode)
+            ret = posix_get_mdata_xattr(this, path, fd, inode, buf);
+        else
+            ret = __posix_get_mdata_xattr(this, path, fd, NULL, buf);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_GETMDATA_FAILED,
+                   "posix get mdata failed on %s",
+                   path ? path : uuid_utoa(inode->gfid));
+            return -1;
+        }
+    }
+
+    if (gfid && !gf_uuid_is_null(gfid))
+        gf_uuid_copy(buf->ia_gfid, gfid);
+    else if (path)
+        sys_lgetxattr(path, GFID_XATTR_KEY, buf->ia_gfid, 16);
+    else
+        sys_fgetxattr(fd, GFID_XATTR_KEY, buf->ia_gfid, 16);
+    buf->ia_flags |= IATT_GFID;
+
+    if (gf_uuid_is_null(buf->ia_gfid)) {
+        buf->ia_ino = -1;
+    } else {
+        buf->ia_flags |= IATT_INO;
+        buf->ia_ino = gfid_to_ino(buf->ia_gfid);
+    }
+
+    return 0;
+}
+
+static gf_boolean_t
+posix_gf_io_allowed(call_frame_t *frame)
+{
+    return gf_io_running();
+}
+
+static gf_boolean_t
+posix_gf_io_cs_requested(dict_t *xdata)
+{
+    return xdata && (dict_get_sizen(xdata, GF_CS_OBJECT_STATUS) ||
+                     dict_get_sizen(xdata, GF_CS_OBJECT_REPAIR));
+}
+
+/* open */
+
+static void
+posix_gf_io_open_done(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    struct posix_fd *pfd = NULL;
+    int32_t res = pio->reqs[0].res;
+
+    if (res < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_FILE_OP_FAILED,
+               "open on gfid-handle %s (path: %s), flags: %d", pio->path,
+               pio->loc.path, pio->flags);
+        goto err;
+    }
+
+    posix_set_ctime(pio->frame, this, pio->path, -1, pio->loc.inode,
+                    &pio->stbuf);
+
+    pfd = GF_CALLOC(1, sizeof(*pfd), gf_posix_mt_posix_fd);
+    if (!pfd) {
+        sys_close(res);
+        res = -ENOMEM;
+        goto err;
+    }
+
+    pfd->flags = pio->flags;
+    pfd->fd = res;
+
+    if (fd_ctx_set(pio->fd, this, (uint64_t)(long)pfd))
+        gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_FD_PATH_SETTING_FAILED,
+               "failed to set the fd context gfid-handle=%s path=%s fd=%p",
+               pio->path, pio->loc.path, pio->fd);
+
+    STACK_UNWIND_STRICT(open, pio->frame, 0, 0, pio->fd, NULL);
+    posix_gf_io_free(pio);
+    return;
+
+err:
+    STACK_UNWIND_STRICT(open, pio->frame, -1, -res, pio->fd, NULL);
+    posix_gf_io_free(pio);
+}
+
+static int32_t
+posix_gf_io_open(call_frame_t *frame, xlator_t *this, loc_t *loc,
+                 int32_t flags, fd_t *fd, dict_t *xdata)
+{
+    struct posix_private *priv = this->private;
+    struct posix_gf_io *pio = NULL;
+    struct posix_gf_io_req *req = NULL;
+    gf_io_batch_t batch;
+    char *real_path = NULL;
+    struct iatt stbuf = {
+        0,
+    };
+    int32_t op_ret = -1;
+
+    if (!posix_gf_io_allowed(frame) || (flags & O_CREAT) || !loc->inode ||
+        IA_ISBLK(loc->inode->ia_type) || IA_ISCHR(loc->inode->ia_type) ||
+        posix_gf_io_cs_requested(xdata))
+        goto sync;
+
+    MAKE_INODE_HANDLE(real_path, this, loc, &stbuf);
+    if ((op_ret < 0) || !real_path || IA_ISLNK(stbuf.ia_type))
+        goto sync;
+
+    pio = posix_gf_io_new(frame, this, xdata);
+    if (!pio)
+        goto sync;
+
+    pio->fd = fd_ref(fd);
+    pio->path = gf_strdup(real_path);
+    if (!pio->path || loc_copy(&pio->loc, loc))
+        goto free;
+
+    pio->stbuf = stbuf;
+    pio->flags = flags;
+    if (priv->o_direct)
+        pio->flags |= O_DIRECT;
+
+    gf_io_batch_init(&batch);
+
+    req = posix_gf_io_req(pio, &batch);
+    gf_io_openat_prepare(&req->req, posix_gf_io_cbk, AT_FDCWD, pio->path,
+                         pio->flags, priv->force_create_mode, req);
+    gf_io_batch_add(&batch, &req->req, NULL);
+
+    posix_gf_io_submit(pio, &batch, posix_gf_io_open_done);
+
+    return 0;
+
+free:
+    posix_gf_io_free(pio);
+sync:
+    return posix_open(frame, this, loc, flags, fd, xdata);
+}
+
+/* fstat */
+
+static void
+posix_gf_io_fstat_done(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    inode_t *inode = pio->fd->inode;
+    int32_t res = pio->reqs[0].res;
+
+    if (res < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_FSTAT_FAILED,
+               "fstat failed on fd=%p", pio->fd);
+        goto err;
+    }
+
+    if (posix_gf_io_iatt(this, &pio->stx[0], inode, inode->gfid, NULL,
+                         pio->_fd, &pio->stbuf)) {
+        res = -errno;
+        goto err;
+    }
+
+    if (pio->xdata)
+        pio->rsp_xdata = posix_xattr_fill(this, NULL, NULL, pio->fd, pio->_fd,
+                                          pio->xdata, &pio->stbuf);
+
+    STACK_UNWIND_STRICT(fstat, pio->frame, 0, 0, &pio->stbuf, pio->rsp_xdata);
+    posix_gf_io_free(pio);
+    return;
+
+err:
+    memset(&pio->stbuf, 0, sizeof(pio->stbuf));
+    STACK_UNWIND_STRICT(fstat, pio->frame, -1, -res, &pio->stbuf, NULL);
+    posix_gf_io_free(pio);
+}
+
+static int32_t
+posix_gf_io_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  dict_t *xdata)
+{
+    struct posix_gf_io *pio = NULL;
+    struct posix_fd *pfd = NULL;
+    gf_io_batch_t batch;
+    int32_t op_errno = 0;
+
+    if (!posix_gf_io_allowed(frame) || posix_gf_io_cs_requested(xdata))
+        goto sync;
+
+    if (posix_fd_ctx_get(fd, this, &pfd, &op_errno) < 0)
+        goto sync;
+
+    pio = posix_gf_io_new(frame, this, xdata);
+    if (!pio)
+        goto sync;
+
+    pio->fd = fd_ref(fd);
+    pio->_fd = pfd->fd;
+
+    gf_io_batch_init(&batch);
+    posix_gf_io_statx_add(pio, &batch, pio->_fd, "", &pio->stx[0]);
+    posix_gf_io_submit(pio, &batch, posix_gf_io_fstat_done);
+
+    return 0;
+
+sync:
+    return posix_fstat(frame, this, fd, xdata);
+}
+
+/* fgetxattr */
+
+static void
+posix_gf_io_fgetxattr_done(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    dict_t *dict = NULL;
+    char *value = NULL;
+    int32_t res = pio->reqs[0].res;
+    int32_t op_ret = -1;
+    int32_t op_errno = 0;
+
+    if (res == -ERANGE) {
+        /* The value doesn't fit in the default buffer. Let the regular
+         * implementation deal with it. */
+        posix_fgetxattr(pio->frame, this, pio->fd, pio->name, pio->xdata);
+        posix_gf_io_free(pio);
+        return;
+    }
+
+    dict = dict_new();
+    if (!dict) {
+        op_errno = ENOMEM;
+        goto out;
+    }
+
+    if (res < 0) {
+        op_errno = -res;
+        if ((op_errno == ENODATA) || (op_errno == ENOATTR)) {
+            gf_msg_debug(this->name, op_errno, "fgetxattr failed on key %s",
+                         pio->name);
+        } else {
+            gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_XATTR_FAILED,
+                   "fgetxattr failed on key %s", pio->name);
+        }
+        goto done;
+    }
+
+    value = GF_MALLOC(res + 1, gf_posix_mt_char);
+    if (!value) {
+        op_errno = ENOMEM;
+        goto out;
+    }
+    memcpy(value, pio->value, res);
+    value[res] = '\0';
+
+    if (dict_set_dynptr(dict, pio->name, value, res) < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_DICT_SET_FAILED,
+               "dict set operation on key %s failed", pio->name);
+        GF_FREE(value);
+        op_errno = ENOMEM;
+        goto out;
+    }
+
+    op_ret = res;
+
+    if (pio->xdata)
+        pio->rsp_xdata = posix_xattr_fill(this, NULL, NULL, pio->fd, pio->_fd,
+                                          pio->xdata, &pio->stbuf);
+
+done:
+    dict_del(dict, GFID_XATTR_KEY);
+    dict_del(dict, GF_XATTR_VOL_ID_KEY);
+
+out:
+    STACK_UNWIND_STRICT(fgetxattr, pio->frame, op_ret, op_errno, dict,
+                        pio->rsp_xdata);
+
+    if (dict)
+        dict_unref(dict);
+
+    posix_gf_io_free(pio);
+}
+
+static int32_t
+posix_gf_io_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      const char *name, dict_t *xdata)
+{
+    struct posix_gf_io *pio = NULL;
+    struct posix_gf_io_req *req = NULL;
+    struct posix_fd *pfd = NULL;
+    gf_io_batch_t batch;
+    int32_t op_errno = 0;
+
+    if (!posix_gf_io_allowed(frame) || !name ||
+        !strcmp(name, GLUSTERFS_OPEN_FD_COUNT) ||
+        !strncmp(name, GLUSTERFS_GET_OBJECT_SIGNATURE,
+                 SLEN(GLUSTERFS_GET_OBJECT_SIGNATURE)))
+        goto sync;
+
+    if (posix_fd_ctx_get(fd, this, &pfd, &op_errno) < 0)
+        goto sync;
+
+    pio = posix_gf_io_new(frame, this, xdata);
+    if (!pio)
+        goto sync;
+
+    pio->fd = fd_ref(fd);
+    pio->_fd = pfd->fd;
+    pio->name = gf_strdup(name);
+    pio->value = GF_MALLOC(XATTR_VAL_BUF_SIZE, gf_posix_mt_char);
+    if (!pio->name || !pio->value) {
+        posix_gf_io_free(pio);
+        goto sync;
+    }
+
+    gf_io_batch_init(&batch);
+
+    req = posix_gf_io_req(pio, &batch);
+    gf_io_fgetxattr_prepare(&req->req, posix_gf_io_cbk, pio->_fd, pio->name,
+                            pio->value, XATTR_VAL_BUF_SIZE - 1, req);
+    gf_io_batch_add(&batch, &req->req, NULL);
+
+    posix_gf_io_submit(pio, &batch, posix_gf_io_fgetxattr_done);
+
+    return 0;
+
+sync:
+    return posix_fgetxattr(frame, this, fd, name, xdata);
+}
+
+/* fsetxattr */
+
+static void
+posix_gf_io_fsetxattr_post(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    dict_t *xattr = NULL;
+    int32_t res = pio->reqs[0].res;
+
+    if ((res < 0) || posix_gf_io_iatt(this, &pio->stx[0], pio->fd->inode,
+                                      pio->fd->inode->gfid, NULL, pio->_fd,
+                                      &pio->postbuf)) {
+        pio->op_errno = (res < 0) ? -res : errno;
+        gf_msg(this->name, GF_LOG_ERROR, pio->op_errno, P_MSG_XATTR_FAILED,
+               "fsetxattr (fstat) failed on fd=%p", pio->fd);
+        pio->op_ret = -1;
+        goto out;
+    }
+
+    xattr = dict_new();
+    if (xattr)
+        posix_set_iatt_in_dict(xattr, &pio->prebuf, &pio->postbuf);
+
+out:
+    STACK_UNWIND_STRICT(fsetxattr, pio->frame, pio->op_ret, pio->op_errno,
+                        xattr);
+
+    if (xattr)
+        dict_unref(xattr);
+
+    posix_gf_io_free(pio);
+}
+
+static void
+posix_gf_io_fsetxattr_next(struct posix_gf_io *pio);
+
+static void
+posix_gf_io_fsetxattr_done(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    int32_t res = pio->reqs[0].res;
+
+    /* Same as posix_fhandle_pair(). The first failure stops the update of
+     * the remaining keys. */
+    if (res < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_XATTR_FAILED,
+               "fd=%d: key:%s", pio->_fd, pio->keys[pio->key]);
+        pio->op_ret = -1;
+        pio->op_errno = -res;
+    } else {
+        posix_set_ctime(pio->frame, this, NULL, pio->_fd, pio->fd->inode,
+                        NULL);
+        pio->key++;
+    }
+
+    posix_gf_io_fsetxattr_next(pio);
+}
+
+/* Keys are set one by one, in the same order as posix_fsetxattr() does. */
+static void
+posix_gf_io_fsetxattr_next(struct posix_gf_io *pio)
+{
+    struct posix_gf_io_req *req = NULL;
+    gf_io_batch_t batch;
+    int32_t i;
+
+    gf_io_batch_init(&batch);
+
+    if ((pio->op_ret == 0) && (pio->key < pio->keys_count)) {
+        i = pio->key;
+        req = posix_gf_io_req(pio, &batch);
+        gf_io_fsetxattr_prepare(&req->req, posix_gf_io_cbk, pio->_fd,
+                                pio->keys[i], pio->values[i]->data,
+                                pio->values[i]->len, pio->flags, req);
+        gf_io_batch_add(&batch, &req->req, NULL);
+
+        posix_gf_io_submit(pio, &batch, posix_gf_io_fsetxattr_done);
+        return;
+    }
+
+    posix_gf_io_statx_add(pio, &batch, pio->_fd, "", &pio->stx[0]);
+    posix_gf_io_submit(pio, &batch, posix_gf_io_fsetxattr_post);
+}
+
+static int
+posix_gf_io_fsetxattr_add(dict_t *dict, char *key, data_t *value, void *data)
+{
+    struct posix_gf_io *pio = data;
+
+    if (XATTR_IS_PATHINFO(key) || posix_is_gfid2path_xattr(key))
+        return -1;
+
+    /* ACLs are not set on dht link files, as in posix_fhandle_pair(). */
+    if (!strncmp(key, POSIX_ACL_ACCESS_XATTR, SLEN(POSIX_ACL_ACCESS_XATTR)) &&
+        IS_DHT_LINKFILE_MODE(&pio->prebuf))
+        return 0;
+
+    if (pio->keys_count == POSIX_GF_IO_MAX_REQS)
+        return -1;
+
+    pio->keys[pio->keys_count] = gf_strdup(key);
+    if (!pio->keys[pio->keys_count])
+        return -1;
+    pio->values[pio->keys_count++] = data_ref(value);
+
+    return 0;
+}
+
+static int32_t
+posix_gf_io_fsetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      dict_t *dict, int flags, dict_t *xdata)
+{
+    struct posix_private *priv = this->private;
+    struct posix_gf_io *pio = NULL;
+    struct posix_fd *pfd = NULL;
+    int32_t op_errno = 0;
+
+    if (!posix_gf_io_allowed(frame) || !dict || priv->disk_space_full ||
+        (xdata && dict_get(xdata, GLUSTERFS_DURABLE_OP)))
+        goto sync;
+
+    /* These keys are always ignored. */
+    dict_del(dict, GFID_XATTR_KEY);
+    dict_del(dict, GF_XATTR_VOL_ID_KEY);
+
+    if ((dict->count == 0) || (dict->count > POSIX_GF_IO_MAX_REQS))
+        goto sync;
+
+    if (posix_fd_ctx_get(fd, this, &pfd, &op_errno) < 0)
+        goto sync;
+
+    pio = posix_gf_io_new(frame, this, xdata);
+    if (!pio)
+        goto sync;
+
+    pio->fd = fd_ref(fd);
+    pio->_fd = pfd->fd;
+    pio->flags = flags;
+
+    if (posix_fdstat(this, fd->inode, pio->_fd, &pio->prebuf, _gf_true) ||
+        (dict_foreach(dict, posix_gf_io_fsetxattr_add, pio) < 0)) {
+        posix_gf_io_free(pio);
+        goto sync;
+    }
+
+    posix_gf_io_fsetxattr_next(pio);
+
+    return 0;
+
+sync:
+    return posix_fsetxattr(frame, this, fd, dict, flags, xdata);
+}
+
+/* fallocate */
+
+static void
+posix_gf_io_fallocate_post(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    int32_t res = pio->reqs[0].res;
+
+    if ((res < 0) || posix_gf_io_iatt(this, &pio->stx[0], pio->fd->inode,
+                                      pio->fd->inode->gfid, NULL, pio->_fd,
+                                      &pio->postbuf)) {
+        res = (res < 0) ? res : -errno;
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_FSTAT_FAILED,
+               "fallocate (fstat) failed on fd=%p", pio->fd);
+        goto err;
+    }
+
+    posix_set_ctime(pio->frame, this, NULL, pio->_fd, pio->fd->inode,
+                    &pio->postbuf);
+
+    STACK_UNWIND_STRICT(fallocate, pio->frame, 0, 0, &pio->prebuf,
+                        &pio->postbuf, NULL);
+    posix_gf_io_free(pio);
+    return;
+
+err:
+    STACK_UNWIND_STRICT(fallocate, pio->frame, -1, -res, NULL, NULL, NULL);
+    posix_gf_io_free(pio);
+}
+
+static void
+posix_gf_io_fallocate_done(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    gf_io_batch_t batch;
+    int32_t res = pio->reqs[0].res;
+
+    if (res < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_FALLOCATE_FAILED,
+               "fallocate failed on %s, flags: %d",
+               uuid_utoa(pio->fd->inode->gfid), pio->flags);
+        STACK_UNWIND_STRICT(fallocate, pio->frame, -1, -res, NULL, NULL,
+                            NULL);
+        posix_gf_io_free(pio);
+        return;
+    }
+
+    gf_io_batch_init(&batch);
+    posix_gf_io_statx_add(pio, &batch, pio->_fd, "", &pio->stx[0]);
+    posix_gf_io_submit(pio, &batch, posix_gf_io_fallocate_post);
+}
+
+static int32_t
+posix_gf_io_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      int32_t keep_size, off_t offset, size_t len,
+                      dict_t *xdata)
+{
+    struct posix_private *priv = this->private;
+    struct posix_gf_io *pio = NULL;
+    struct posix_gf_io_req *req = NULL;
+    struct posix_fd *pfd = NULL;
+    gf_io_batch_t batch;
+    int32_t op_errno = 0;
+
+    if (!posix_gf_io_allowed(frame) || posix_gf_io_cs_requested(xdata) ||
+        (xdata && dict_get(xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC)))
+        goto sync;
+
+    if (priv->disk_reserve)
+        posix_disk_space_check(priv);
+
+    /* Running out of space requires special handling. */
+    if (priv->disk_space_full)
+        goto sync;
+
+    if (posix_fd_ctx_get(fd, this, &pfd, &op_errno) < 0)
+        goto sync;
+
+    pio = posix_gf_io_new(frame, this, xdata);
+    if (!pio)
+        goto sync;
+
+    pio->fd = fd_ref(fd);
+    pio->_fd = pfd->fd;
+#ifdef FALLOC_FL_KEEP_SIZE
+    if (keep_size)
+        pio->flags = FALLOC_FL_KEEP_SIZE;
+#endif /* FALLOC_FL_KEEP_SIZE */
+
+    gf_io_batch_init(&batch);
+
+    req = posix_gf_io_req(pio, &batch);
+    gf_io_fallocate_prepare(&req->req, posix_gf_io_cbk, pio->_fd, pio->flags,
+                            offset, len, req);
+    gf_io_batch_add(&batch, &req->req, NULL);
+
+    posix_gf_io_submit(pio, &batch, posix_gf_io_fallocate_done);
+
+    return 0;
+
+sync:
+    return posix_glfallocate(frame, this, fd, keep_size, offset, len, xdata);
+}
+
+/* unlink */
+
+static void
+posix_gf_io_unlink_post(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    loc_t *loc = &pio->loc;
+    int32_t res = pio->reqs[0].res;
+
+    if ((res < 0) ||
+        posix_gf_io_iatt(this, &pio->stx[0], loc->parent, loc->pargfid,
+                         pio->par_path, -1, &pio->postparent)) {
+        res = (res < 0) ? res : -errno;
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_LSTAT_FAILED,
+               "post-operation lstat on parent %s failed", pio->par_path);
+        goto err;
+    }
+
+    posix_set_parent_ctime(pio->frame, this, pio->par_path, -1, loc->parent,
+                           &pio->postparent);
+
+    pio->rsp_xdata = posix_dict_set_nlink(pio->xdata, pio->rsp_xdata,
+                                          pio->stbuf.ia_nlink);
+
+    STACK_UNWIND_STRICT(unlink, pio->frame, 0, 0, &pio->preparent,
+                        &pio->postparent, pio->rsp_xdata);
+    posix_gf_io_free(pio);
+    return;
+
+err:
+    memset(&pio->postparent, 0, sizeof(pio->postparent));
+    STACK_UNWIND_STRICT(unlink, pio->frame, -1, -res, &pio->preparent,
+                        &pio->postparent, pio->rsp_xdata);
+    posix_gf_io_free(pio);
+}
+
+static void
+posix_gf_io_unlink_done(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    gf_io_batch_t batch;
+    int32_t res;
+
+    /* Same as posix_handle_unset(). A failure is not fatal. */
+    res = pio->reqs[0].res;
+    if ((res < 0) && (res != -ENOENT)) {
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_UNLINK_FAILED,
+               "unlink of gfid handle failed for path:%s with gfid %s",
+               pio->path, uuid_utoa(pio->stbuf.ia_gfid));
+    }
+
+    res = pio->reqs[1].res;
+    if (res < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_UNLINK_FAILED,
+               "unlink of %s failed", pio->path);
+        STACK_UNWIND_STRICT(unlink, pio->frame, -1, -res, &pio->preparent,
+                            &pio->postparent, pio->rsp_xdata);
+        posix_gf_io_free(pio);
+        return;
+    }
+
+    gf_io_batch_init(&batch);
+    posix_gf_io_statx_add(pio, &batch, AT_FDCWD, pio->par_path, &pio->stx[0]);
+    posix_gf_io_submit(pio, &batch, posix_gf_io_unlink_post);
+}
+
+static int32_t
+posix_gf_io_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
+                   dict_t *xdata)
+{
+    struct posix_private *priv = this->private;
+    struct posix_gf_io *pio = NULL;
+    struct posix_gf_io_req *req = NULL;
+    gf_io_batch_t batch;
+    char *real_path = NULL;
+    char *par_path = NULL;
+    char *handle = NULL;
+    struct iatt stbuf = {
+        0,
+    };
+    int32_t op_ret = -1;
+    int dfd = -1;
+    gf_boolean_t busy;
+
+    /* Only the plain removal of the last link of a regular file that is not
+     * open is handled here. */
+    if (!posix_gf_io_allowed(frame) || !loc->inode ||
+        !IA_ISREG(loc->inode->ia_type) || priv->background_unlink ||
+        (xdata && (dict_get_sizen(xdata, DHT_SKIP_OPEN_FD_UNLINK) ||
+                   dict_get_sizen(xdata, DHT_SKIP_NON_LINKTO_UNLINK) ||
+                   dict_get_sizen(xdata, DHT_IATT_IN_XDATA_KEY) ||
+                   dict_get_sizen(xdata, GET_LINK_COUNT))))
+        goto sync;
+
+    MAKE_ENTRY_HANDLE(real_path, par_path, this, loc, &stbuf);
+    if ((op_ret < 0) || !real_path || !par_path || (stbuf.ia_nlink != 1) ||
+        gf_uuid_is_null(stbuf.ia_gfid))
+        goto sync;
+
+    LOCK(&loc->inode->lock);
+    busy = (loc->inode->fd_count != 0);
+    UNLOCK(&loc->inode->lock);
+    if (busy)
+        goto sync;
+
+    pio = posix_gf_io_new(frame, this, xdata);
+    if (!pio)
+        goto sync;
+
+    if (posix_pstat(this, loc->parent, loc->pargfid, par_path,
+                    &pio->preparent, _gf_false, _gf_true))
+        goto free;
+
+    MAKE_HANDLE_ABSPATH_FD(handle, this, stbuf.ia_gfid, dfd);
+
+    pio->stbuf = stbuf;
+    pio->path = gf_strdup(real_path);
+    pio->par_path = gf_strdup(par_path);
+    pio->handle = gf_strdup(handle);
+    pio->rsp_xdata = dict_new();
+    if (!pio->path || !pio->par_path || !pio->handle || !pio->rsp_xdata ||
+        loc_copy(&pio->loc, loc))
+        goto free;
+
+    if (xdata && dict_get_sizen(xdata, GF_GET_FILE_BLOCK_COUNT)) {
+        if (dict_set_uint64(pio->rsp_xdata, GF_GET_FILE_BLOCK_COUNT,
+                            stbuf.ia_blocks))
+            gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_SET_XDATA_FAIL,
+                   "Failed to set %s in rsp dict", GF_GET_FILE_BLOCK_COUNT);
+    }
+
+    gf_io_batch_init(&batch);
+
+    req = posix_gf_io_req(pio, &batch);
+    gf_io_unlinkat_prepare(&req->req, posix_gf_io_cbk, dfd, pio->handle, 0,
+                           req);
+    gf_io_batch_add(&batch, &req->req, NULL);
+
+    req = posix_gf_io_req(pio, &batch);
+    gf_io_unlinkat_prepare(&req->req, posix_gf_io_cbk, AT_FDCWD, pio->path, 0,
+                           req);
+    gf_io_batch_add(&batch, &req->req, NULL);
+
+    posix_gf_io_submit(pio, &batch, posix_gf_io_unlink_done);
+
+    return 0;
+
+free:
+    posix_gf_io_free(pio);
+sync:
+    return posix_unlink(frame, this, loc, xflag, xdata);
+}
+
+/* rename */
+
+static void
+posix_gf_io_rename_post(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    loc_t *oldloc = &pio->loc;
+    loc_t *newloc = &pio->newloc;
+    const char *path = NULL;
+    int32_t res;
+
+    res = pio->reqs[0].res;
+    path = pio->newpath;
+    if ((res < 0) ||
+        posix_gf_io_iatt(this, &pio->stx[0], newloc->inode, oldloc->inode->gfid,
+                         path, -1, &pio->stbuf))
+        goto err;
+
+    /* Since the same inode is later used and dst inode is not present,
+     * update ctime on source inode. */
+    posix_set_ctime(pio->frame, this, pio->newpath, -1, oldloc->inode,
+                    &pio->stbuf);
+
+    res = pio->reqs[1].res;
+    path = pio->par_path;
+    if ((res < 0) ||
+        posix_gf_io_iatt(this, &pio->stx[1], oldloc->parent, oldloc->pargfid,
+                         path, -1, &pio->postparent))
+        goto err;
+
+    posix_set_parent_ctime(pio->frame, this, pio->par_path, -1,
+                           oldloc->parent, &pio->postparent);
+
+    res = pio->reqs[2].res;
+    path = pio->newpar_path;
+    if ((res < 0) ||
+        posix_gf_io_iatt(this, &pio->stx[2], newloc->parent, newloc->pargfid,
+                         path, -1, &pio->postnewparent))
+        goto err;
+
+    posix_set_parent_ctime(pio->frame, this, pio->newpar_path, -1,
+                           newloc->parent, &pio->postnewparent);
+
+    if (pio->was_present)
+        pio->rsp_xdata = posix_dict_set_nlink(pio->xdata, pio->rsp_xdata,
+                                              pio->nlink);
+
+    STACK_UNWIND_STRICT(rename, pio->frame, 0, 0, &pio->stbuf,
+                        &pio->preparent, &pio->postparent, &pio->prenewparent,
+                        &pio->postnewparent, pio->rsp_xdata);
+    posix_gf_io_free(pio);
+    return;
+
+err:
+    res = (res < 0) ? res : -errno;
+    gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_LSTAT_FAILED,
+           "post-operation lstat on %s failed", path);
+    STACK_UNWIND_STRICT(rename, pio->frame, -1, -res, &pio->stbuf,
+                        &pio->preparent, &pio->postparent, &pio->prenewparent,
+                        &pio->postnewparent, pio->rsp_xdata);
+    posix_gf_io_free(pio);
+}
+
+static gf_boolean_t
+posix_gf_io_has_gfid(const char *path, uuid_t gfid)
+{
+    uuid_t current;
+
+    return (sys_lgetxattr(path, GFID_XATTR_KEY, current, sizeof(current)) ==
+            sizeof(current)) &&
+           (gf_uuid_compare(current, gfid) == 0);
+}
+
+/* The rename is not done under pgfid_lock, so renames of the same inode can
+ * complete in any order. Each name is updated according to what it refers
+ * to once the lock is taken. The last update of a name then always matches
+ * its final state, whatever the order of the completions. */
+static void
+posix_gf_io_rename_gfid2path(struct posix_gf_io *pio)
+{
+    xlator_t *this = pio->this;
+    loc_t *oldloc = &pio->loc;
+    loc_t *newloc = &pio->newloc;
+    char *gfid_path = NULL;
+
+    MAKE_HANDLE_ABSPATH(gfid_path, this, oldloc->inode->gfid);
+
+    pthread_mutex_lock(&pio->ctx->pgfid_lock);
+    {
+        if (!posix_gf_io_has_gfid(pio->path, oldloc->inode->gfid))
+            posix_remove_gfid2path_xattr(this, gfid_path, oldloc->pargfid,
+                                         oldloc->name);
+        if (posix_gf_io_has_gfid(pio->newpath, oldloc->inode->gfid))
+            posix_set_gfid2path_xattr(this, gfid_path, newloc->pargfid,
+                                      newloc->name);
+    }
+    pthread_mutex_unlock(&pio->ctx->pgfid_lock);
+}
+
+static void
+posix_gf_io_rename_done(struct posix_gf_io *pio)
+{
+    struct posix_private *priv = pio->this->private;
+    xlator_t *this = pio->this;
+    gf_io_batch_t batch;
+    int32_t res = pio->reqs[0].res;
+
+    if (res < 0) {
+        if (res == -ENOTEMPTY) {
+            gf_msg_debug(this->name, -res, "rename of %s to %s failed",
+                         pio->path, pio->newpath);
+        } else {
+            gf_msg(this->name, GF_LOG_ERROR, -res, P_MSG_RENAME_FAILED,
+                   "rename of %s to %s failed", pio->path, pio->newpath);
+        }
+        STACK_UNWIND_STRICT(rename, pio->frame, -1, -res, &pio->stbuf,
+                            &pio->preparent, &pio->postparent,
+                            &pio->prenewparent, &pio->postnewparent,
+                            pio->rsp_xdata);
+        posix_gf_io_free(pio);
+        return;
+    }
+
+    if (pio->was_present && (pio->nlink == 1))
+        posix_handle_unset(this, pio->victim, NULL);
+
+    if (priv->gfid2path)
+        posix_gf_io_rename_gfid2path(pio);
+
+    gf_io_batch_init(&batch);
+    posix_gf_io_statx_add(pio, &batch, AT_FDCWD, pio->newpath, &pio->stx[0]);
+    posix_gf_io_statx_add(pio, &batch, AT_FDCWD, pio->par_path, &pio->stx[1]);
+    posix_gf_io_statx_add(pio, &batch, AT_FDCWD, pio->newpar_path,
+                          &pio->stx[2]);
+    posix_gf_io_submit(pio, &batch, posix_gf_io_rename_post);
+}
+
+static int32_t
+posix_gf_io_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+                   loc_t *newloc, dict_t *xdata)
+{
+    struct posix_private *priv = this->private;
+    struct posix_gf_io *pio = NULL;
+    struct posix_gf_io_req *req = NULL;
+    posix_inode_ctx_t *ctx = NULL;
+    gf_io_batch_t batch;
+    char *real_oldpath = NULL;
+    char *real_newpath = NULL;
+    char *par_oldpath = NULL;
+    char *par_newpath = NULL;
+    struct iatt stbuf = {
+        0,
+    };
+    int32_t op_ret = -1;
+
+    /* Directories and parent gfid link counts require additional handling
+     * while holding locks. They are not processed here. */
+    if (!posix_gf_io_allowed(frame) || !oldloc->inode ||
+        IA_ISDIR(oldloc->inode->ia_type) || priv->update_pgfid_nlinks ||
+        (xdata && dict_get(xdata, GET_LINK_COUNT)))
+        goto sync;
+
+    MAKE_ENTRY_HANDLE(real_oldpath, par_oldpath, this, oldloc, NULL);
+    if (!real_oldpath || !par_oldpath)
+        goto sync;
+
+    MAKE_ENTRY_HANDLE(real_newpath, par_newpath, this, newloc, &stbuf);
+    if (!real_newpath || !par_newpath)
+        goto sync;
+
+    pio = posix_gf_io_new(frame, this, xdata);
+    if (!pio)
+        goto sync;
+
+    if (posix_pstat(this, oldloc->parent, oldloc->pargfid, par_oldpath,
+                    &pio->preparent, _gf_false, _gf_true) ||
+        posix_pstat(this, newloc->parent, newloc->pargfid, par_newpath,
+                    &pio->prenewparent, _gf_false, _gf_false))
+        goto free;
+
+    op_ret = posix_pstat(this, newloc->inode, NULL, real_newpath, &pio->stbuf,
+                         _gf_false, _gf_false);
+    if (op_ret == 0) {
+        if (IA_ISDIR(pio->stbuf.ia_type))
+            goto free;
+        pio->was_present = _gf_true;
+        pio->nlink = pio->stbuf.ia_nlink;
+        gf_uuid_copy(pio->victim, pio->stbuf.ia_gfid);
+    } else if (errno != ENOENT) {
+        goto free;
+    }
+
+    pio->path = gf_strdup(real_oldpath);
+    pio->par_path = gf_strdup(par_oldpath);
+    pio->newpath = gf_strdup(real_newpath);
+    pio->newpar_path = gf_strdup(par_newpath);
+    pio->rsp_xdata = dict_new();
+    if (!pio->path || !pio->par_path || !pio->newpath || !pio->newpar_path ||
+        !pio->rsp_xdata || loc_copy(&pio->loc, oldloc) ||
+        loc_copy(&pio->newloc, newloc))
+        goto free;
+
+    if (posix_inode_ctx_get_all(oldloc->inode, this, &ctx) < 0)
+        goto free;
+    pio->ctx = ctx;
+
+    gf_io_batch_init(&batch);
+    req = posix_gf_io_req(pio, &batch);
+    gf_io_renameat_prepare(&req->req, posix_gf_io_cbk, AT_FDCWD, pio->path,
+                           AT_FDCWD, pio->newpath, 0, req);
+    gf_io_batch_add(&batch, &req->req, NULL);
+
+    posix_gf_io_submit(pio, &batch, posix_gf_io_rename_done);
+
+    return 0;
+
+free:
+    posix_gf_io_free(pio);
+sync:
+    return posix_rename(frame, this, oldloc, newloc, xdata);
+}
+
+int
+posix_gf_io_on(xlator_t *this)
+{
+    if (!gf_io_running()) {
+        gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_POSIX_GF_IO,
+               "I/O framework is not running in this process. "
+               "Continuing with synchronous IO");
+        return -1;
+    }
+
+    this->fops->open = posix_gf_io_open;
+    this->fops->fstat = posix_gf_io_fstat;
+    this->fops->fgetxattr = posix_gf_io_fgetxattr;
+    this->fops->fsetxattr = posix_gf_io_fsetxattr;
+    this->fops->fallocate = posix_gf_io_fallocate;
+    this->fops->unlink = posix_gf_io_unlink;
+    this->fops->rename = posix_gf_io_rename;
+
+    return 0;
+}
+
+#else /* !HAVE_STATX */
+
+int
+posix_gf_io_on(xlator_t *this)
+{
+    gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_POSIX_GF_IO,
+           "statx() not available at build-time. "
+           "Continuing with synchronous IO");
+    return -1;
+}
+
+#endif /* HAVE_STATX */
+
+int
+posix_gf_io_off(xlator_t *this)
+{
+    this->fops->open = posix_open;
+    this->fops->fstat = posix_fstat;
+    this->fops->fgetxattr = posix_fgetxattr;
+    this->fops->fsetxattr = posix_fsetxattr;
+    this->fops->fallocate = posix_glfallocate;
+    this->fops->unlink = posix_unlink;
+    this->fops->rename = posix_rename;
+
+    return 0;
+}
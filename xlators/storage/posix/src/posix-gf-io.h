@@ -0,0 +1,23 @@
+/*
+   Copyright (c) 2021 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_GF_IO_H
+#define _POSIX_GF_IO_H
+
+/* Maximum number of requests that a single fop can send to the I/O
+ * framework at the same time. */
+#define POSIX_GF_IO_MAX_REQS 8
+
+int
+posix_gf_io_on(xlator_t *this);
+
+int
+posix_gf_io_off(xlator_t *this);
+
+#endif /* _POSIX_GF_IO_H */
@@ -25,6 +25,7 @@
 #include <sys/stat.h>
 #include <signal.h>
 #include <sys/uio.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <regex.h>
 
@@ -1713,6 +1714,71 @@ out:
     return 0;
 }
 
+/* Reads up to @size bytes of @fd at @offset and moves them into a pipe from
+ * the pool. Splicing the file would only reference the page cache, so a
+ * later write could change the reply before it's sent. Instead the data is
+ * copied once into private pages, which are gifted to the pipe and unmapped
+ * here. After that, only the pipe and the network stack reference them, so
+ * they are never reused while a retransmission could still need them. The
+ * socket then sends them without another copy. On success the pipe is
+ * returned in @gpipe along with the number of bytes it holds. On failure,
+ * or when no pipe is available, -1 is returned and the caller is expected
+ * to fall back to a regular read. */
+static ssize_t
+posix_readv_pipe(int fd, size_t size, off_t offset, struct gf_pipe *gpipe)
+{
+#ifdef GF_LINUX_HOST_OS
+    struct iovec iov;
+    size_t page_size = getpagesize();
+    size_t len = (size + page_size - 1) & ~(page_size - 1);
+    void *buf = NULL;
+    ssize_t done = -1;
+    ssize_t ret = 0;
+
+    /* The whole payload must fit in the pipe since no one will drain it
+     * until the reply is sent. */
+    if (gf_pipe_get(gpipe, len) != 0)
+        return -1;
+
+    buf = mmap(NULL, len, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (buf == MAP_FAILED) {
+        gf_pipe_put(gpipe);
+        return -1;
+    }
+
+    ret = sys_pread(fd, buf, size, offset);
+    if (ret < 0)
+        goto out;
+
+    iov.iov_base = buf;
+    iov.iov_len = ret;
+    done = 0;
+    while (iov.iov_len > 0) {
+        ret = vmsplice(gpipe->fds[1], &iov, 1,
+                       SPLICE_F_GIFT | SPLICE_F_NONBLOCK);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            done = -1;
+            goto out;
+        }
+        iov.iov_base = (char *)iov.iov_base + ret;
+        iov.iov_len -= ret;
+        done += ret;
+    }
+
+out:
+    munmap(buf, len);
+    if (done < 0)
+        gf_pipe_put(gpipe);
+
+    return done;
+#else
+    return -1;
+#endif
+}
+
 int
 posix_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
             off_t offset, uint32_t flags, dict_t *xdata)
@@ -1734,6 +1800,7 @@ posix_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         0,
     };
     int ret = -1;
+    struct gf_pipe gpipe;
     dict_t *rsp_xdata = NULL;
     gf_boolean_t cs_obj_status, cs_obj_repair;
 
@@ -1768,12 +1835,6 @@ posix_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         goto out;
     }
 
-    iobuf = iobuf_get_page_aligned(this->ctx->iobuf_pool, size, ALIGN_SIZE);
-    if (!iobuf) {
-        op_errno = ENOMEM;
-        goto out;
-    }
-
     _fd = pfd->fd;
 
     if (xdata) {
@@ -1801,26 +1862,59 @@ posix_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
             posix_update_iatt_buf(&preop, _fd, NULL);
     }
 
-    op_ret = sys_pread(_fd, iobuf->ptr, size, offset);
-    if (op_ret == -1) {
-        op_errno = errno;
-        gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_READ_FAILED,
-               "read failed on gfid=%s, "
-               "fd=%p, offset=%" PRIu64 " size=%" GF_PRI_SIZET
-               ", "
-               "buf=%p",
-               uuid_utoa(fd->inode->gfid), fd, offset, size, iobuf->ptr);
-        goto out;
+    /* The transport can send the data straight from a pipe, so avoid
+     * copying it again when it's sent. O_DIRECT fds keep bypassing the
+     * page cache through a regular read. */
+    if (xdata && !pfd->odirect &&
+        dict_get_sizen(xdata, GLUSTERFS_READV_PIPE_PAYLOAD)) {
+        op_ret = posix_readv_pipe(_fd, size, offset, &gpipe);
+        if (op_ret > 0) {
+            iobref = iobref_new();
+            if (!iobref) {
+                gf_pipe_put(&gpipe);
+                op_ret = -1;
+                op_errno = ENOMEM;
+                goto out;
+            }
+            iobref_set_pipe(iobref, &gpipe);
+
+            vec.iov_base = NULL;
+            vec.iov_len = op_ret;
+        } else if (op_ret == 0) {
+            gf_pipe_put(&gpipe);
+        }
     }
 
-    GF_ATOMIC_ADD(priv->read_value, op_ret);
+    if (!iobref) {
+        iobuf = iobuf_get_page_aligned(this->ctx->iobuf_pool, size,
+                                       ALIGN_SIZE);
+        if (!iobuf) {
+            op_ret = -1;
+            op_errno = ENOMEM;
+            goto out;
+        }
 
-    vec.iov_base = iobuf->ptr;
-    vec.iov_len = op_ret;
+        op_ret = sys_pread(_fd, iobuf->ptr, size, offset);
+        if (op_ret == -1) {
+            op_errno = errno;
+            gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_READ_FAILED,
+                   "read failed on gfid=%s, "
+                   "fd=%p, offset=%" PRIu64 " size=%" GF_PRI_SIZET
+                   ", "
+                   "buf=%p",
+                   uuid_utoa(fd->inode->gfid), fd, offset, size, iobuf->ptr);
+            goto out;
+        }
 
-    iobref = iobref_new();
+        vec.iov_base = iobuf->ptr;
+        vec.iov_len = op_ret;
 
-    iobref_add(iobref, iobuf);
+        iobref = iobref_new();
+
+        iobref_add(iobref, iobuf);
+    }
+
+    GF_ATOMIC_ADD(priv->read_value, op_ret);
 
     /*
      *  readv successful, and we need to get the stat of the file
@@ -6011,6 +6105,7 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     unsigned char *checksum = NULL;
     struct posix_private *priv = NULL;
     dict_t *rsp_xdata = NULL;
+    char *type = NULL;
     gf_boolean_t buf_has_zeroes = _gf_false;
     struct iatt preop = {
         0,
@@ -6117,6 +6212,23 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         checksum = strong_checksum;
         gf_rsync_strong_checksum((unsigned char *)buf, (size_t)bytes_read,
                                  (unsigned char *)checksum);
+    } else if (xdata && (dict_get_str_sizen(xdata, GF_RCHECKSUM_TYPE,
+                                            &type) == 0) &&
+               (strcmp(type, GF_RCHECKSUM_XXH64X2) == 0) &&
+               (gf_rsync_xxh64x2_checksum((unsigned char *)buf,
+                                          (size_t)bytes_read,
+                                          strong_checksum) == 0)) {
+        GF_ATOMIC_INC(priv->rchecksum_xxh64x2);
+        ret = dict_set_sizen_str_sizen(rsp_xdata, GF_RCHECKSUM_TYPE,
+                                       GF_RCHECKSUM_XXH64X2);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_DICT_SET_FAILED,
+                   "%s: Failed to set "
+                   "dictionary value for key: %s",
+                   uuid_utoa(fd->inode->gfid), GF_RCHECKSUM_TYPE);
+            goto out;
+        }
+        checksum = strong_checksum;
     } else {
         checksum = md5_checksum;
         gf_rsync_md5_checksum((unsigned char *)buf, (size_t)bytes_read,
@@ -35,12 +35,14 @@ struct posix_uring_ctx {
             struct iovec *iov;
             int count;
             off_t offset;
+            int slot;
         } write;
 
         struct {
             struct iobuf *iobuf;
             struct iovec iovec;
             off_t offset;
+            int slot;
         } read;
 
         struct {
@@ -195,18 +197,36 @@ out:
     posix_io_uring_ctx_free(ctx);
 }
 
+/* Called with sq_mutex held, so the registered state of the slot can't
+ * change until the sqe is submitted. */
+static gf_boolean_t
+posix_io_uring_slot_fixed(struct posix_uring_ctx *ctx, int slot)
+{
+    struct posix_private *priv = ctx->frame->this->private;
+
+    return (slot >= 0) && (priv->uring_bufs[slot] != NULL);
+}
+
 static void
 posix_prep_readv(struct io_uring_sqe *sqe, struct posix_uring_ctx *ctx)
 {
+    if (posix_io_uring_slot_fixed(ctx, ctx->fop.read.slot)) {
+        io_uring_prep_read_fixed(sqe, ctx->_fd, ctx->fop.read.iovec.iov_base,
+                                 ctx->fop.read.iovec.iov_len,
+                                 ctx->fop.read.offset, ctx->fop.read.slot);
+    } else {
+        io_uring_prep_readv(sqe, ctx->_fd, &ctx->fop.read.iovec, 1,
+                            ctx->fop.read.offset);
+    }
+    /* The prep helpers reset the flags, so this must come after them. */
     sqe->flags |= IOSQE_ASYNC;
-    io_uring_prep_readv(sqe, ctx->_fd, &ctx->fop.read.iovec, 1,
-                        ctx->fop.read.offset);
 }
 
 int
 posix_io_uring_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                      off_t offset, uint32_t flags, dict_t *xdata)
 {
+    struct posix_private *priv = this->private;
     struct posix_uring_ctx *ctx = NULL;
     int32_t op_errno = ENOMEM;
     struct iobuf *iobuf = NULL;
@@ -219,12 +239,19 @@ posix_io_uring_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         goto err;
     }
 
-    iobuf = iobuf_get2(this->ctx->iobuf_pool, size);
+    /* When the arenas are registered as fixed buffers, read into an arena
+     * even for small sizes so that the kernel doesn't need to pin and unpin
+     * the pages for each request. */
+    if (priv->uring_notifier)
+        iobuf = iobuf_get_from_arena(this->ctx->iobuf_pool, size);
+    else
+        iobuf = iobuf_get2(this->ctx->iobuf_pool, size);
     if (!iobuf) {
         op_errno = ENOMEM;
         goto err;
     }
     ctx->fop.read.iobuf = iobuf;
+    ctx->fop.read.slot = iobuf_arena_slot(iobuf);
     ctx->fop.read.iovec.iov_base = iobuf_ptr(iobuf);
     ctx->fop.read.iovec.iov_len = size;
     ctx->fop.read.offset = offset;
@@ -314,8 +341,14 @@ out:
 static void
 posix_prep_writev(struct io_uring_sqe *sqe, struct posix_uring_ctx *ctx)
 {
-    io_uring_prep_writev(sqe, ctx->_fd, ctx->fop.write.iov,
-                         ctx->fop.write.count, ctx->fop.write.offset);
+    if (posix_io_uring_slot_fixed(ctx, ctx->fop.write.slot)) {
+        io_uring_prep_write_fixed(sqe, ctx->_fd, ctx->fop.write.iov[0].iov_base,
+                                  ctx->fop.write.iov[0].iov_len,
+                                  ctx->fop.write.offset, ctx->fop.write.slot);
+    } else {
+        io_uring_prep_writev(sqe, ctx->_fd, ctx->fop.write.iov,
+                             ctx->fop.write.count, ctx->fop.write.offset);
+    }
 }
 
 int
@@ -337,6 +370,12 @@ posix_io_uring_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
     ctx->fop.write.iov = iov;
     ctx->fop.write.count = count;
     ctx->fop.write.offset = offset;
+    ctx->fop.write.slot = -1;
+    /* WRITE_FIXED only takes a single buffer, so only single vector writes
+     * whose data lives in a registered arena can use it. */
+    if ((count == 1) && iobref)
+        ctx->fop.write.slot = iobref_arena_slot(iobref, iov[0].iov_base,
+                                                iov[0].iov_len);
 
     ret = posix_io_uring_submit(this, ctx);
     if (ret < 0) {
@@ -511,6 +550,73 @@ posix_io_uring_thread(void *data)
     return NULL;
 }
 
+static void
+posix_io_uring_arena_notify(void *data, int slot, void *base, size_t size)
+{
+    xlator_t *this = data;
+    struct posix_private *priv = this->private;
+    struct iovec iov = {
+        .iov_base = base,
+        .iov_len = size,
+    };
+    int ret = 0;
+
+    pthread_mutex_lock(&priv->sq_mutex);
+    {
+        ret = io_uring_register_buffers_update_tag(&priv->ring, slot, &iov,
+                                                   NULL, 1);
+        if (ret < 0) {
+            gf_msg_debug(this->name, -ret,
+                         "Unable to update fixed buffer in slot %d", slot);
+            base = NULL;
+        }
+        priv->uring_bufs[slot] = base;
+    }
+    pthread_mutex_unlock(&priv->sq_mutex);
+}
+
+/* Registers a sparse table of fixed buffers with one entry per iobuf arena
+ * slot. Entries are filled and cleared by the iobuf pool notifier as arenas
+ * are mapped and unmapped. If the kernel doesn't support it, readv and
+ * writev requests are used as before. */
+static void
+posix_io_uring_fixed_init(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct iovec iov[GF_IOBUF_ARENA_SLOTS] = {
+        {
+            0,
+        },
+    };
+    int ret = 0;
+
+    ret = io_uring_register_buffers(&priv->ring, iov, GF_IOBUF_ARENA_SLOTS);
+    if (ret < 0) {
+        gf_msg(this->name, GF_LOG_INFO, -ret, P_MSG_POSIX_IO_URING,
+               "io_uring fixed buffers not available.");
+        return;
+    }
+
+    priv->uring_notifier = iobuf_pool_notifier_add(
+        this->ctx->iobuf_pool, posix_io_uring_arena_notify, this);
+    if (!priv->uring_notifier)
+        io_uring_unregister_buffers(&priv->ring);
+}
+
+static void
+posix_io_uring_fixed_fini(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+
+    if (!priv->uring_notifier)
+        return;
+
+    iobuf_pool_notifier_del(this->ctx->iobuf_pool, priv->uring_notifier);
+    priv->uring_notifier = NULL;
+    memset(priv->uring_bufs, 0, sizeof(priv->uring_bufs));
+    io_uring_unregister_buffers(&priv->ring);
+}
+
 int
 posix_io_uring_init(xlator_t *this)
 {
@@ -528,9 +634,11 @@ posix_io_uring_init(xlator_t *this)
 
     pthread_mutex_init(&priv->sq_mutex, NULL);
     pthread_mutex_init(&priv->cq_mutex, NULL);
+    posix_io_uring_fixed_init(this);
     ret = gf_thread_create(&priv->uring_thread, NULL, posix_io_uring_thread,
                            this, "posix-iouring");
     if (ret != 0) {
+        posix_io_uring_fixed_fini(this);
         io_uring_queue_exit(&priv->ring);
         pthread_mutex_destroy(&priv->sq_mutex);
         pthread_mutex_destroy(&priv->cq_mutex);
@@ -567,6 +675,7 @@ posix_io_uring_fini(xlator_t *this)
 
     posix_io_uring_drain(priv);
     (void)pthread_join(priv->uring_thread, NULL);
+    posix_io_uring_fixed_fini(this);
     io_uring_queue_exit(&priv->ring);
     pthread_mutex_destroy(&priv->sq_mutex);
     pthread_mutex_destroy(&priv->cq_mutex);
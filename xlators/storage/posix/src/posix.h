@@ -170,6 +170,7 @@ struct posix_private {
 
     gf_atomic_t read_value;  /* Total read, from init */
     gf_atomic_t write_value; /* Total write, from init */
+    gf_atomic_t rchecksum_xxh64x2; /* rchecksums answered with xxh64x2 */
 
     /* janitor task which cleans up /.trash (created by replicate) */
     struct gf_tw_timer_list *janitor;
@@ -285,6 +286,9 @@ struct posix_private {
 
     gf_boolean_t io_uring_configured;
 
+    /* execute some fops through the I/O framework of the process */
+    gf_boolean_t gf_io_configured;
+
     /*io_uring related.*/
 #ifdef HAVE_LIBURING
     gf_boolean_t io_uring_init_done;
@@ -294,6 +298,10 @@ struct posix_private {
     pthread_t uring_thread;
     pthread_mutex_t sq_mutex;
     pthread_mutex_t cq_mutex;
+    /* Base address of the iobuf arena registered as fixed buffer in each
+     * slot, NULL if the slot can't be used with READ_FIXED/WRITE_FIXED. */
+    void *uring_bufs[GF_IOBUF_ARENA_SLOTS];
+    struct iobuf_arena_notifier *uring_notifier;
 #endif
     void *pxl;
 };
@@ -713,4 +721,15 @@ posix_is_layout_stale(dict_t *xdata, char *par_path, xlator_t *this);
 int
 posix_delete_user_xattr(dict_t *dict, char *k, data_t *v, void *data);
 
+dict_t *
+posix_dict_set_nlink(dict_t *req, dict_t *res, int32_t nlink);
+
+int32_t
+posix_set_gfid2path_xattr(xlator_t *this, const char *path, uuid_t pgfid,
+                          const char *bname);
+
+int32_t
+posix_remove_gfid2path_xattr(xlator_t *this, const char *path, uuid_t pgfid,
+                             const char *bname);
+
 #endif /* _POSIX_H */